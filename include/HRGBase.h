@@ -7,12 +7,14 @@
  */
 #include "HRGBase/BilinearSplineFunction.h"
 #include "HRGBase/NumericalIntegration.h"
+#include "HRGBase/Profiling.h"
 #include "HRGBase/SplineFunction.h"
 #include "HRGBase/ThermalModelIdeal.h"
 #include "HRGBase/ThermalModelBase.h"
 #include "HRGBase/ThermalModelCanonical.h"
 #include "HRGBase/ThermalModelCanonicalCharm.h"
 #include "HRGBase/ThermalModelCanonicalStrangeness.h"
+#include "HRGBase/ThermalModelState.h"
 #include "HRGBase/ThermalParticle.h"
 #include "HRGBase/ThermalParticleSystem.h"
 #include "HRGBase/Utility.h"
@@ -194,7 +194,8 @@ namespace thermalfist {
      * then the Jacobian will be computed using finite
      * differences.
      */
-    Broyden(BroydenEquations *eqs = NULL, BroydenJacobian *jaco = NULL) : m_Equations(eqs), m_Jacobian(jaco), m_Iterations(0), m_MaxDifference(0.), m_UseNewton(false) { }
+    Broyden(BroydenEquations *eqs = NULL, BroydenJacobian *jaco = NULL) : m_Equations(eqs), m_Jacobian(jaco), m_Iterations(0), m_MaxIterations(MAX_ITERS), m_MaxDifference(0.), m_UseNewton(false),
+      m_ReuseJacobian(false), m_JacobianStored(false), m_NumberOfUpdates(0) { ResetCounters(); }
     
     /**
      * \brief Destroy the Broyden object
@@ -209,6 +210,12 @@ namespace thermalfist {
      * Will use the Newton's method [https://en.wikipedia.org/wiki/Newton%27s_method](https://en.wikipedia.org/wiki/Newton%27s_method) 
      * if the corresponding flag was set with the UseNewton(bool) method.
      * 
+     * The Jacobian is LU-factorized once and the Broyden's updates
+     * of its inverse are applied as a sequence of rank-one corrections,
+     * i.e. the inverse Jacobian is never computed explicitly.
+     * The work arrays are kept between the calls, thus repeated calls on the same
+     * Broyden object do not reallocate them.
+     * 
      * \param x0 A vector of starting values of the variables.
      * \param solcrit Criterium used to determine whether the desired accuracy is achieved. 
      * \param max_iterations Maximum number of iterations before the Broyden's method terminates.
@@ -216,6 +223,12 @@ namespace thermalfist {
      */
     virtual std::vector<double> Solve(const std::vector<double> &x0, BroydenSolutionCriterium *solcrit = NULL, int max_iterations = MAX_ITERS);
 
+    /// Sets the equations to be solved
+    void SetEquations(BroydenEquations *eqs) { m_Equations = eqs; }
+
+    /// Sets the Jacobian used by the solver. If NULL, finite differences are used.
+    void SetJacobian(BroydenJacobian *jaco) { m_Jacobian = jaco; }
+
     /**
      * Returns number of Broyden/Newton iterations
      * used to obtain the solution.
@@ -254,13 +267,85 @@ namespace thermalfist {
      */
     bool UseNewton() const { return m_UseNewton; }
 
+    /**
+     * Specify whether to start each Solve() from the (inverse) Jacobian
+     * approximation obtained at the end of the previous Solve() call,
+     * instead of evaluating the Jacobian anew.
+     * 
+     * This is useful when a sequence of similar systems is solved,
+     * e.g. when the parameters change slightly from one call to the next.
+     * If the solution is not found with the reused Jacobian,
+     * the Jacobian is re-evaluated and the procedure is repeated.
+     * The stored Jacobian is also re-evaluated once many Broyden's updates are accumulated.
+     * 
+     * \param flag Reuse the Jacobian if true, evaluate the Jacobian in each call otherwise.
+     */
+    void ReuseJacobian(bool flag) { m_ReuseJacobian = flag; }
+
+    /**
+     * \return true The Jacobian is carried over between Solve() calls
+     * \return false The Jacobian is evaluated in each Solve() call
+     */
+    bool ReuseJacobian() const { return m_ReuseJacobian; }
+
+    /// Discards the Jacobian stored from the previous Solve() call
+    void ResetJacobian() { m_JacobianStored = false; m_NumberOfUpdates = 0; }
+
+    //@{
+    /**
+     * Counters accumulated over all the Solve() calls since
+     * the construction or the last ResetCounters() call:
+     * the total number of iterations, of the evaluations of the equations,
+     * and of the Jacobian evaluations.
+     * The evaluations of the equations needed for the finite difference
+     * Jacobian are not included in EquationsEvaluations().
+     */
+    int TotalIterations() const { return m_TotalIterations; }
+    int EquationsEvaluations() const { return m_EquationsEvaluations; }
+    int JacobianEvaluations() const { return m_JacobianEvaluations; }
+    void ResetCounters() { m_TotalIterations = m_EquationsEvaluations = m_JacobianEvaluations = 0; }
+    //@}
+
   protected:
+    /**
+     * Performs the Broyden/Newton iterations.
+     * 
+     * \param x0 A vector of starting values of the variables.
+     * \param jaco The Jacobian to use.
+     * \param solcrit Criterium used to determine whether the desired accuracy is achieved.
+     * \param max_iterations Maximum number of iterations.
+     * \param jac0 If not NULL, the Jacobian at x0 in RowMajor ordering, already evaluated by the caller.
+     * \return std::vector<double> A vector of the variables' values which solve the equations.
+     */
+    std::vector<double> Iterate(const std::vector<double> &x0, BroydenJacobian *jaco, BroydenSolutionCriterium *solcrit, int max_iterations, const std::vector<double> *jac0 = NULL);
+
     BroydenEquations *m_Equations; 
     BroydenJacobian  *m_Jacobian;   
     int m_Iterations;              
     int m_MaxIterations;      
     double m_MaxDifference;         
     bool m_UseNewton;
+    bool m_ReuseJacobian;
+
+    int m_TotalIterations;
+    int m_EquationsEvaluations;
+    int m_JacobianEvaluations;
+
+  private:
+    /// LU-factorizes the Jacobian, returns false if it is singular
+    bool FactorizeJacobian(const std::vector<double> &jac);
+
+    /// Applies the current inverse Jacobian approximation to vector in, writes the result to out
+    void ApplyInverseJacobian(const double *in, double *out);
+
+    /// Work arrays kept between the calls
+    std::vector<double> m_LU;             ///< LU factors of the Jacobian, column-major
+    std::vector<int>    m_Permutation;    ///< Row permutation of the LU factorization
+    std::vector<double> m_UpdatesP;       ///< Broyden's rank-one updates of the inverse Jacobian, (I + p x^T)
+    std::vector<double> m_UpdatesX;
+    std::vector<double> m_xold, m_fold, m_xdelta, m_fdelta, m_step;
+    bool m_JacobianStored;
+    int  m_NumberOfUpdates;
   };
 
 } // namespace thermalfist
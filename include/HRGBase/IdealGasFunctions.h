@@ -28,17 +28,38 @@ namespace thermalfist {
      * \brief Identifies the thermodynamic function.
      * 
      */
-    enum Quantity { ParticleDensity, EnergyDensity, EntropyDensity, Pressure, chi2, chi3, chi4, ScalarDensity };
+    enum Quantity { ParticleDensity, EnergyDensity, EntropyDensity, Pressure, chi2, chi3, chi4, ScalarDensity, dndT };
     /**
      * \brief Identifies whether quantum statistics
      *        are to be computed using the cluster expansion
      *        or numerical integration using 32-point Gauss-Legendre quadratures.
-     * 
+     *
+     * The Adaptive method chooses the cheapest of the available methods which
+     * provides the requested relative accuracy, see SelectQStatsMethod().
+     *
+     */
+    enum QStatsCalculationType { ClusterExpansion, Quadratures, Adaptive };
+
+    /**
+     * \brief Method actually used to evaluate a thermodynamic function
+     *        with the Adaptive calculation type.
+     *
+     */
+    enum QStatsMethodType { MethodBoltzmann, MethodClusterExpansion, MethodQuadratures };
+
+    /**
+     * \brief The method chosen by SelectQStatsMethod().
+     *
      */
-    enum QStatsCalculationType { ClusterExpansion, Quadratures };
+    struct QStatsMethod {
+      QStatsMethodType type;  ///< The chosen method
+      int order;              ///< Number of terms in the cluster expansion or number of quadrature nodes
+    };
 
     /// \brief Whether \mu > m Bose-Einstein condensation issue was encountered for a Bose gas
-    extern bool calculationHadBECIssue;
+    ///
+    /// The flag is thread-local: it reflects the calculations performed in the calling thread only.
+    extern thread_local bool calculationHadBECIssue;
 
     /**
      * \brief Computes the particle number density of a Maxwell-Boltzmann gas.
@@ -94,6 +115,19 @@ namespace thermalfist {
      * \return Scalar density [fm-3].
      */
     double BoltzmannScalarDensity(double T, double mu, double m, double deg);  // TODO: Check for correctness
+
+    /**
+     * \brief Computes the temperature derivative of the particle number density of a Maxwell-Boltzmann gas.
+     * 
+     * Computes \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ for a Maxwell-Boltzmann gas.
+     * 
+     * \param T Temperature [GeV].
+     * \param mu Chemical potential [GeV].
+     * \param m  Particle's mass [GeV].
+     * \param deg Internal degeneracy factor.
+     * \return \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ [GeV-1 fm-3].
+     */
+    double BoltzmanndndT(double T, double mu, double m, double deg);
     
     /**
      * \brief Computes the chemical potential derivative of density for a Maxwell-Boltzmann gas.
@@ -189,6 +223,19 @@ namespace thermalfist {
      * \return \f$ T \frac{\partial n}{\partial mu} \f$ [GeV fm-3].
      */
     double QuantumClusterExpansionTdndmu(int N, int statistics, double T, double mu, double m, double deg, int order = 1);
+
+    /**
+     * \brief Computes the temperature derivative of the particle number density of a quantum ideal gas using cluster expansion.
+     * 
+     * Computes \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ for a quantum ideal gas using cluster expansion.
+     * 
+     * \param T Temperature [GeV].
+     * \param mu Chemical potential [GeV].
+     * \param m  Particle's mass [GeV].
+     * \param deg Internal degeneracy factor.
+     * \return \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ [GeV-1 fm-3].
+     */
+    double QuantumClusterExpansiondndT(int statistics, double T, double mu, double m, double deg, int order = 1);
     
     /**
      * \brief Computes the n-th order susceptibility for a quantum ideal gas using cluster expansion.
@@ -263,6 +310,17 @@ namespace thermalfist {
     double QuantumNumericalIntegrationT2dn2dmu2(int statistics, double T, double mu, double m, double deg);
     double QuantumNumericalIntegrationT3dn3dmu3(int statistics, double T, double mu, double m, double deg);
     double QuantumNumericalIntegrationTdndmu(int N, int statistics, double T, double mu, double m, double deg);
+
+    /**
+     * \brief Computes the temperature derivative of the particle number density of a quantum ideal gas using 32-point Gauss-Laguerre quadratures.
+     * 
+     * \param T Temperature [GeV].
+     * \param mu Chemical potential [GeV].
+     * \param m  Particle's mass [GeV].
+     * \param deg Internal degeneracy factor.
+     * \return \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ [GeV-1 fm-3].
+     */
+    double QuantumNumericalIntegrationdndT(int statistics, double T, double mu, double m, double deg);
     
     /**
      * \brief Computes the n-th order susceptibility for a quantum ideal gas using 32-point Gauss-Laguerre quadratures.
@@ -363,6 +421,18 @@ namespace thermalfist {
     double FermiNumericalIntegrationLargeMuT2dn2dmu2(double T, double mu, double m, double deg);
     double FermiNumericalIntegrationLargeMuT3dn3dmu3(double T, double mu, double m, double deg);
     double FermiNumericalIntegrationLargeMuTdndmu(int N, double T, double mu, double m, double deg);
+
+    /**
+     * \brief Computes the temperature derivative of the particle number density of a Fermi-Dirac ideal gas 
+     *        at mu > m.
+     * 
+     * \param T Temperature [GeV].
+     * \param mu Chemical potential [GeV].
+     * \param m  Particle's mass [GeV].
+     * \param deg Internal degeneracy factor.
+     * \return \f$ \left( \frac{\partial n}{\partial T} \right)_{\mu} \f$ [GeV-1 fm-3].
+     */
+    double FermiNumericalIntegrationLargeMudndT(double T, double mu, double m, double deg);
     
     /**
      * \brief Computes the n-th order susceptibility for a Fermi-Dirac ideal gas 
@@ -379,12 +449,37 @@ namespace thermalfist {
      */
     double FermiNumericalIntegrationLargeMuChiN(int N, double T, double mu, double m, double deg);
 
+    /**
+     * \brief Chooses the cheapest method to evaluate a thermodynamic function
+     *        of a quantum ideal gas with a given relative accuracy.
+     *
+     * The truncation error of the cluster expansion is estimated from the upper bound
+     * \f$ e^{(k-1)(\mu-m)/T} k^s \f$ on the magnitude of the k-th term relative to the first one,
+     * where the power s depends on the thermodynamic function.
+     * The leading term alone corresponds to Maxwell-Boltzmann statistics.
+     * The cluster expansion is used if the requested accuracy is reached with fewer terms
+     * than the cost of the quadratures, which are performed using 16 (at tolerance of 10^-4 or larger,
+     * and \f$ m - \mu \geq 2T \f$) or 32 Gauss-Laguerre nodes otherwise.
+     * The cluster expansion is not used for tolerance below the accuracy of the Bessel function
+     * approximations it relies upon (about 3*10^-7).
+     * Quadratures are always used for \f$ \mu \geq m \f$.
+     *
+     * \param quantity Identifies the thermodynamic function to calculate.
+     * \param statistics 0 -- Maxwell-Boltzmann, +1 -- Fermi-Dirac, -1 -- Bose-Einstein.
+     * \param T Temperature [GeV].
+     * \param mu Chemical potential [GeV].
+     * \param m Particle's mass [GeV].
+     * \param tolerance The requested relative accuracy.
+     * \return The chosen method.
+     */
+    QStatsMethod SelectQStatsMethod(Quantity quantity, int statistics, double T, double mu, double m, double tolerance);
+
     /**
      * \brief Calculation of a generic ideal gas function.
-     * 
+     *
      * Calculations of the ideal gas thermodynamic function
      * specified by \param quantity
-     * 
+     *
      * \param quantity Identifies the thermodynamic function to calculate.
      * \param calctype Method used to perform the calculation if quantum statistics used.
      * \param statistics 0 -- Maxwell-Boltzmann, +1 -- Fermi-Dirac, -1 -- Bose-Einstein.
@@ -393,9 +488,10 @@ namespace thermalfist {
      * \param m Particle's mass [GeV].
      * \param deg Internal degeneracy factor.
      * \param order Number of terms in the cluster expansion if this method is used.
+     * \param tolerance The requested relative accuracy if the Adaptive method is used.
      * \return Computed thermodynamic function.
      */
-    double IdealGasQuantity(Quantity quantity, QStatsCalculationType calctype, int statistics, double T, double mu, double m, double deg, int order = 1);
+    double IdealGasQuantity(Quantity quantity, QStatsCalculationType calctype, int statistics, double T, double mu, double m, double deg, int order = 1, double tolerance = 1.e-6);
   }
 
 } // namespace thermalfist
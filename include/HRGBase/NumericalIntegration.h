@@ -16,6 +16,7 @@
  */
 
 #include <vector>
+#include <complex>
 
 namespace thermalfist {
 
@@ -109,6 +110,24 @@ namespace thermalfist {
       0.0438709081857, 0.0387821679745, 0.0334601952825, 0.0279370069800,
       0.0222458491942, 0.0164210583819, 0.0104982845312, 0.00452127709853 };
 
+    /**
+     * \brief Nodes of the 16-point Gauss-Laguerre quadrature.
+     *
+     */
+    const double coefficients_xlag16[16] = { 0.0876494104789, 0.462696328915, 1.14105777483, 2.12928364510,
+      3.43708663389, 5.07801861455, 7.07033853505, 9.43831433639,
+      12.2142233689, 15.4415273688, 19.1801568568, 23.5159056940,
+      28.5787297429, 34.5833987023, 41.9404526477, 51.7011603395 };
+
+    /**
+     * \brief Weights of the 16-point Gauss-Laguerre quadrature.
+     *
+     */
+    const double coefficients_wlag16[16] = { 0.225036314864, 0.525836052762, 0.831961391687, 1.14609924096,
+      1.47175131697, 1.81313468738, 2.17551751969, 2.56576275017,
+      2.99321508637, 3.47123448310, 4.02004408644, 4.67251660773,
+      5.48742065799, 6.58536123329, 8.27635798436, 11.8242775517 };
+
     /**
      * \brief Nodes of the 32-point Gauss-Laguerre quadrature.
      * 
@@ -272,6 +291,21 @@ namespace thermalfist {
      */
     void GetCoefsIntegrateLaguerre32(std::vector<double> *x, std::vector<double> *w);
 
+    /**
+     * In-place multi-dimensional discrete Fourier transform
+     * \f$ X_{\bf k} = \sum_{\bf n} x_{\bf n} e^{\mp 2 \pi i\, {\bf k} \cdot {\bf n} / {\bf M}} \f$
+     * (no normalization) using the radix-2 fast Fourier transform.
+     * The sizes of all dimensions must be powers of 2, otherwise the data are left unchanged.
+     * 
+     * Used to evaluate the Fourier coefficients of periodic functions,
+     * for which the uniform grid (trapezoidal rule) integration converges exponentially.
+     * 
+     * \param [in,out] data Values on the grid, row-major (last dimension is contiguous).
+     * \param dims Sizes of each dimension.
+     * \param inverse If false, the exponent sign is negative, otherwise positive.
+     */
+    void FFT(std::vector< std::complex<double> > &data, const std::vector<int> &dims, bool inverse = false);
+
   }
 
 } // namespace thermalfist
@@ -0,0 +1,121 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef PROFILING_H
+#define PROFILING_H
+
+/**
+ * \file Profiling.h
+ *
+ * \brief Counters and timers of the computationally intensive parts of the library.
+ *
+ * The instrumentation is compiled in only if the library is built
+ * with the USE_PROFILING CMake option (USE_PROFILING preprocessor flag),
+ * otherwise the THERMALFIST_PROFILE_* macros expand to nothing and the
+ * counters stay zero.
+ *
+ * Each thread accumulates into its own block, no locks or atomic
+ * read-modify-write operations are performed on the hot paths.
+ * The block is returned for reuse when the thread terminates, its values are kept for the report.
+ * The report sums over all the threads which have contributed so far.
+ * The counters are global: a report includes all the models, fits
+ * and event generators used in the process since the last Reset().
+ */
+
+#include <cstdio>
+
+namespace thermalfist {
+
+  /// Contains the profiling counters and timers
+  namespace Profiling {
+
+    /// The quantities being counted
+    enum Counter {
+      IdealGasEvaluations,         ///< Calls of IdealGasFunctions::IdealGasQuantity()
+      BroydenSolves,               ///< Calls of Broyden::Solve()
+      BroydenIterations,           ///< Iterations of the Broyden's method
+      BroydenResidualEvaluations,  ///< Evaluations of the equations being solved by the Broyden's method
+      BroydenJacobianEvaluations,  ///< Evaluations of the Jacobian in the Broyden's method
+      PartitionFunctionNodes,      ///< Quadrature or FFT nodes in the canonical partition functions
+      FitChi2Evaluations,          ///< Evaluations of the chi2 in ThermalModelFit
+      EventsGenerated,             ///< Accepted multiplicity configurations in the event generator
+      EventsRejected,              ///< Configurations rejected because of a negative weight
+      MultiplicityTrials,          ///< Trial multiplicity samplings, including the ones rejected due to the exact charge conservation
+      DecaysPerformed,             ///< Decays of individual resonances in the event generator
+      NumberOfCounters
+    };
+
+    /// The timed code regions
+    enum Timer {
+      PrimordialDensitiesTimer,  ///< ThermalModelBase::CalculatePrimordialDensities() within CalculateDensities()
+      FeeddownTimer,             ///< ThermalModelBase::CalculateFeeddown()
+      FluctuationsTimer,         ///< CalculateFluctuations() of the models
+      PartitionFunctionsTimer,   ///< ThermalModelCanonical::CalculatePartitionFunctions()
+      BroydenTimer,              ///< Broyden::Solve()
+      FitTimer,                  ///< ThermalModelFit::PerformFit()
+      EventGenerationTimer,      ///< EventGeneratorBase::GetEvent(), including the decays
+      DecaysTimer,               ///< EventGeneratorBase::PerformDecays()
+      NumberOfTimers
+    };
+
+    /// Counters and timers summed over the threads
+    struct Report {
+      long long Counts[NumberOfCounters];
+      double Times[NumberOfTimers];       ///< Inclusive wall time in seconds
+      long long Calls[NumberOfTimers];    ///< Number of times each region was entered
+      int Threads;                        ///< Number of threads which have contributed
+    };
+
+    /// Whether the library was compiled with the profiling instrumentation
+    bool IsEnabled();
+
+    /// Adds n to a counter of the calling thread
+    void AddCount(Counter counter, long long n = 1);
+
+    /// Adds the time spent in a region by the calling thread
+    void AddTime(Timer timer, double seconds);
+
+    /// Sums the counters and timers over all threads.
+    /// Can be called while other threads are running, in that case
+    /// their values are snapshots taken at slightly different times.
+    Report GetReport();
+
+    /// Prints the report to a file (stdout by default)
+    void PrintReport(FILE *out = stdout);
+
+    /// Sets all counters and timers to zero. Should not be called while calculations are running in other threads.
+    void Reset();
+
+    /// Name of a counter for the report
+    const char* CounterName(Counter counter);
+
+    /// Name of a timer for the report
+    const char* TimerName(Timer timer);
+
+    /// Measures the wall time between its construction and destruction
+    class ScopedTimer {
+    public:
+      ScopedTimer(Timer timer);
+      ~ScopedTimer();
+    private:
+      Timer m_Timer;
+      double m_Start;
+    };
+
+  } // namespace Profiling
+
+} // namespace thermalfist
+
+#ifdef USE_PROFILING
+#define THERMALFIST_PROFILE_COUNT(counter, n) thermalfist::Profiling::AddCount(thermalfist::Profiling::counter, n)
+#define THERMALFIST_PROFILE_SCOPE(timer) thermalfist::Profiling::ScopedTimer thermalfist_profile_scope_##timer(thermalfist::Profiling::timer)
+#else
+#define THERMALFIST_PROFILE_COUNT(counter, n)
+#define THERMALFIST_PROFILE_SCOPE(timer)
+#endif
+
+#endif
@@ -9,10 +9,12 @@
 #define THERMALMODELBASE_H
 
 #include <string>
+#include <memory>
 
 #include "HRGBase/ThermalParticleSystem.h"
 #include "HRGBase/xMath.h"
 #include "HRGBase/Broyden.h"
+#include "HRGBase/ThermalModelState.h"
 
 
 namespace thermalfist {
@@ -24,6 +26,16 @@ namespace thermalfist {
    * The actual calculations of thermodynamic functions are implemented
    * in derived classes.
    * 
+   * The particle list, TPS(), is not owned by the model and can be shared
+   * between several model instances, e.g. created with Clone().
+   * The calculations of thermodynamic quantities do not modify the particle list,
+   * thus models sharing the same list can be evaluated concurrently from different threads.
+   * The settings which are stored in the particle list, namely SetUseWidth(), SetNormBratio(),
+   * SetStatistics(), SetCalculationType(), SetClusterExpansionOrder(), SetQuantumStatisticsTolerance(),
+   * SetResonanceWidthShape(), and SetResonanceWidthIntegrationType(),
+   * affect all the models sharing the list, including the copies made with Clone(),
+   * and should not be called while other models are being evaluated.
+   * 
    */
   class ThermalModelBase
   {
@@ -62,6 +74,50 @@ namespace thermalfist {
 
     virtual ~ThermalModelBase(void) { }
 
+    /**
+     * \brief Creates a copy of the model.
+     * 
+     * The copy shares the particle list TPS() with the original model
+     * but has its own copy of all the model parameters and calculated quantities.
+     * The two models can then be used independently, including concurrently from different threads.
+     * 
+     * All the models of the library implement this method.
+     * The default implementation, e.g. for user-defined models which do not
+     * override it, prints a warning and returns NULL.
+     * 
+     * \return ThermalModelBase* Pointer to the new model, to be deleted by the caller
+     */
+    virtual ThermalModelBase* Clone() const;
+
+    /**
+     * \brief Snapshot of the present internal state of the model.
+     * 
+     * Contains the thermal parameters, the chemical potentials,
+     * the calculated densities and fluctuations, and the
+     * model-specific solver variables, see ThermalModelState.
+     * 
+     * \return ThermalModelState The state
+     */
+    ThermalModelState GetState() const;
+
+    /**
+     * \brief Restores the internal state of the model obtained with GetState().
+     * 
+     * The calculated quantities become available without repeating the calculations.
+     * The state must originate from a model of the same type
+     * using the same particle list and settings.
+     * 
+     * \param state The state to restore
+     * \return true if the state was restored, false if it is incompatible with the model
+     */
+    bool SetState(const ThermalModelState &state);
+
+    /// Writes the present state of the model to a file, see GetState() and ThermalModelState::WriteToFile()
+    bool SaveState(const std::string &filename) const { return GetState().WriteToFile(filename); }
+
+    /// Restores the state of the model from a file written by SaveState()
+    bool LoadState(const std::string &filename);
+
     /// Number of different particle species in the list
     int ComponentsNumber() const { return static_cast<int>(m_densities.size()); }
 
@@ -88,6 +144,7 @@ namespace thermalfist {
      * scheme will be used.
      * 
      * \param useWidth Whether to use the finite resonance widths.
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
     void SetUseWidth(bool useWidth);
 
@@ -95,6 +152,7 @@ namespace thermalfist {
      * \brief Sets the finite resonance widths scheme to use.
      * 
      * \param type ThermalParticle::ResonanceWidthIntegration scheme
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
     void SetUseWidth(ThermalParticle::ResonanceWidthIntegration type);
 
@@ -103,13 +161,78 @@ namespace thermalfist {
        * \brief Whether branching ratios are renormalized to 100%.
        * 
        * \param normBratio  Whether branching ratios shoul be renormalized to 100%.
+       * \note Stored in the shared particle list, see ThermalModelBase.
        */
     void SetNormBratio(bool normBratio);
     bool NormBratio() const { return m_NormBratio; }
     //@}
 
-    /// OpenMP support. Currently not used.
+    //@{
+      /**
+       * \brief Whether the loops over particle species are
+       *        distributed among the OpenMP threads.
+       * 
+       * Only has effect if the library is compiled with OpenMP support.
+       * The summations over species are always performed in the same order,
+       * the results do not depend on the number of threads.
+       * 
+       * \param openMP Whether OpenMP is used
+       */
     void SetOMP(bool openMP) { m_useOpenMP = openMP; }
+    bool OMP() const { return m_useOpenMP; }
+    //@}
+
+    //@{
+      /**
+       * \brief Whether the Broyden solvers of the model start
+       *        from the Jacobian of the previous calculation.
+       * 
+       * Speeds up a sequence of calculations with slowly varying
+       * parameters, e.g. a scan over temperature.
+       * The Jacobian is evaluated anew whenever the solution
+       * is not found with the stored one.
+       * Used by the models with interactions (QvdW, crossterms excluded volume),
+       * by FixParameters() with fixed total charges,
+       * and by ThermalModelPCE.
+       * The solver of the conservation laws in ConstrainChemicalPotentials()
+       * evaluates the Jacobian in each call as it is used to check the constraints.
+       * 
+       * \param reuse Whether the Jacobian is carried over between the calculations.
+       */
+    void SetSolverJacobianReuse(bool reuse) { m_SolverJacobianReuse = reuse; }
+    bool SolverJacobianReuse() const { return m_SolverJacobianReuse; }
+    //@}
+
+    //@{
+      /**
+       * \brief Whether the chemical potentials constrained by
+       *        ConstrainChemicalPotentials() are continued from
+       *        the solution of the previous call.
+       *
+       * Intended for a sequence of calculations along a trajectory
+       * in the space of thermal parameters, e.g. a \f$ T-\mu_B \f$ scan or a thermal fit.
+       * The values of \f$ \mu_Q,\,\mu_S,\,\mu_C \f$ are predicted
+       * from the previous solution using their derivatives with respect to
+       * \f$ T \f$ and \f$ \mu_B \f$, given by the implicit function theorem
+       * in terms of the derivatives of the densities (susceptibilities).
+       * The prediction is refined by (at most three) quasi-Newton corrections.
+       * The full Broyden solution is performed if this does not
+       * satisfy the conservation laws to the required accuracy.
+       * The derivative with respect to \f$ T \f$ is evaluated only when \f$ T \f$ changes,
+       * which takes one more evaluation of the densities at the previous solution.
+       * The stored solution is discarded whenever the volume, the fugacity factors,
+       * the Q/B ratio, the statistics, the resonance widths, or the particle list change.
+       *
+       * Most efficient for the models where PrimordialDensitiesDerivative()
+       * is evaluated analytically, such as ThermalModelIdeal, where typically
+       * two evaluations of the densities per point are needed.
+       * Not used when \f$ \mu_B \f$ is constrained by the entropy per baryon.
+       *
+       * \param continuation Whether the continuation is used.
+       */
+    void SetChemicalPotentialsContinuation(bool continuation) { m_ChemContinuation = continuation; m_ChemContinuationValid = false; }
+    bool ChemicalPotentialsContinuation() const { return m_ChemContinuation; }
+    //@}
      
     //@{
       /**
@@ -344,8 +467,12 @@ namespace thermalfist {
     /// 0 - Boltzmann, 1 - Quantum
     bool QuantumStatistics() const { return m_QuantumStats; }
 
-    /// Set whether quantum statistics is used, 
-    /// 0 - Boltzmann, 1 - Quantum
+    /**
+     * \brief Set whether quantum statistics is used,
+     *        0 - Boltzmann, 1 - Quantum
+     * 
+     * \note Stored in the shared particle list, see ThermalModelBase.
+     */
     virtual void SetStatistics(bool stats);
 
     /**
@@ -353,8 +480,9 @@ namespace thermalfist {
      *        Calls the corresponding method in TPS().
      * 
      * \param type Method to evaluate quantum statistics.
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
-    virtual void SetCalculationType(IdealGasFunctions::QStatsCalculationType type) { m_TPS->SetCalculationType(type); }
+    virtual void SetCalculationType(IdealGasFunctions::QStatsCalculationType type) { m_TPS->SetCalculationType(type); ResetCalculatedFlags(); }
     
     /**
      * \brief Set the number of terms in the cluster expansion method.
@@ -365,8 +493,23 @@ namespace thermalfist {
      * use ThermalParticle::SetClusterExpansionOrder().
      * 
      * \param order Number of terms.
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
-    virtual void SetClusterExpansionOrder(int order) { m_TPS->SetClusterExpansionOrder(order); }
+    virtual void SetClusterExpansionOrder(int order) { m_TPS->SetClusterExpansionOrder(order); ResetCalculatedFlags(); }
+
+    /**
+     * \brief Set the relative accuracy of the quantum statistics calculations
+     *        with the IdealGasFunctions::Adaptive method.
+     *        Calls the corresponding method in TPS().
+     *
+     * Sets the same value for all particles.
+     * The method chosen for a particular particle can be obtained
+     * with ThermalParticle::QuantumStatisticsMethod().
+     *
+     * \param tolerance Relative accuracy.
+     * \note Stored in the shared particle list, see ThermalModelBase.
+     */
+    virtual void SetQuantumStatisticsTolerance(double tolerance) { m_TPS->SetQuantumStatisticsTolerance(tolerance); ResetCalculatedFlags(); }
     
     /**
      * \brief Set the ThermalParticle::ResonanceWidthShape for all particles.
@@ -376,8 +519,9 @@ namespace thermalfist {
      * by ThermalParticle::SetResonanceWidthShape().
      * 
      * \param shape ThermalParticle::ResonanceWidthShape
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
-    void SetResonanceWidthShape(ThermalParticle::ResonanceWidthShape shape) { m_TPS->SetResonanceWidthShape(shape); }
+    void SetResonanceWidthShape(ThermalParticle::ResonanceWidthShape shape) { m_TPS->SetResonanceWidthShape(shape); ResetCalculatedFlags(); }
     
     /**
      * \brief Set the ThermalParticle::ResonanceWidthIntegration scheme for
@@ -385,6 +529,7 @@ namespace thermalfist {
      *        Calls the corresponding method in TPS().
      * 
      * \param type ThermalParticle::ResonanceWidthIntegration
+     * \note Stored in the shared particle list, see ThermalModelBase.
      */
     void SetResonanceWidthIntegrationType(ThermalParticle::ResonanceWidthIntegration type);// { m_TPS->SetResonanceWidthIntegrationType(type); }
 
@@ -491,7 +636,7 @@ namespace thermalfist {
        * 
        * \param QB The electric-to-baryon charge ratio
        */
-    void SetQoverB(double QB) { m_QBgoal = QB; }
+    void SetQoverB(double QB) { m_QBgoal = QB; m_ChemContinuationValid = false; }
     double QoverB() const { return m_QBgoal; }
     //@}
 
@@ -500,7 +645,7 @@ namespace thermalfist {
      * 
      * \param Volume System volume (fm\f$^3\f$)
      */
-    void SetVolume(double Volume) { m_Volume = Volume; m_Parameters.V = Volume; }
+    void SetVolume(double Volume) { m_Volume = Volume; m_Parameters.V = Volume; m_ChemContinuationValid = false; }
     /// System volume (fm\f$^3\f$)
     double Volume() const { return m_Parameters.V; }
     
@@ -512,7 +657,7 @@ namespace thermalfist {
      * 
      * \param Volume System radius (fm)
      */
-    void SetVolumeRadius(double R) { m_Volume = 4. / 3.*xMath::Pi() * R * R * R; m_Parameters.V = m_Volume; }
+    void SetVolumeRadius(double R) { m_Volume = 4. / 3.*xMath::Pi() * R * R * R; m_Parameters.V = m_Volume; m_ChemContinuationValid = false; }
 
     /// The canonical correlation volume V\f$_c\f$ (fm\f$^3\f$)
     double CanonicalVolume() const { return m_Parameters.SVc; }
@@ -650,6 +795,56 @@ namespace thermalfist {
      */
     virtual void CalculateFeeddown();
 
+    /**
+     * \brief Calculates the derivatives of the primordial and total (after decays)
+     *        densities of all species with respect to the thermal parameters.
+     *
+     * The derivatives are total derivatives, i.e. they include the implicit
+     * dependence on the parameters through the chemical potentials
+     * which are fixed by the conservation laws (ConstrainMuQ(), ConstrainMuS(), ConstrainMuC()).
+     * The derivatives with respect to the volume are trivial and not computed.
+     *
+     * Presently supported for grand-canonical models only,
+     * provided that \f$ \mu_B \f$ is not constrained by the entropy per baryon
+     * and the branching ratios do not depend on the thermal parameters
+     * (eBW scheme for the resonance widths).
+     *
+     * \param params The thermal parameters for which the derivatives are to be computed.
+     *               All parameters listed in ThermalParameter::Name are used if empty.
+     * \return true if the derivatives were calculated, false if not supported for the present setup
+     */
+    virtual bool CalculateDensitiesDerivatives(const std::vector<ThermalParameter::Name> & params = std::vector<ThermalParameter::Name>());
+
+    /**
+     * \brief Derivatives of the primordial densities of all species
+     *        along a given direction in the space of thermal parameters.
+     *
+     * Computes \f$ \sum_j \frac{\partial n_i}{\partial \mu_j} \delta \mu_j + \frac{\partial n_i}{\partial T} \delta T \f$,
+     * where \f$ \mu_j \f$ are the chemical potentials of the individual species
+     * and the temperature derivative is taken at fixed \f$ \mu_j \f$ and fugacities.
+     * Conservation laws are not imposed here.
+     *
+     * The base class implementation uses central finite differences.
+     *
+     * \param dmu Variation \f$ \delta \mu_j \f$ of chemical potentials of all species
+     * \param dT  Variation \f$ \delta T \f$ of the temperature
+     * \return std::vector<double> Resulting variation of the primordial densities
+     */
+    virtual std::vector<double> PrimordialDensitiesDerivative(const std::vector<double> & dmu, double dT = 0.);
+
+    /**
+     * \brief Derivative of the particle number density of species
+     *        with a specified PDG ID and feeddown with respect to a thermal parameter
+     *
+     * Calls CalculateDensitiesDerivatives() if needed.
+     *
+     * \param PDGID    Particle Data Group ID of the needed specie
+     * \param feeddown Which decay feeddown contributions to take into account
+     * \param param    The thermal parameter
+     * \return Derivative of the particle number density
+     */
+    double GetDensityDerivative(long long PDGID, Feeddown::Type feeddown, ThermalParameter::Name param);
+
     /**
      * \brief Computes the fluctuation observables.
      * 
@@ -782,11 +977,28 @@ namespace thermalfist {
      * \,\partial(\mu_S/T)^m \,\partial(\mu_Q/T)^n\,\partial(\mu_C/T)^k} \f$
      * where i+j+k+l = 2.
      * 
+     * The base class implementation sums the particle number correlations,
+     * which must be calculated beforehand, see CalculateFluctuations().
      * The calculation results are accessible through Susc()
      * 
      */
     virtual void CalculateSusceptibilityMatrix();
 
+    /**
+     * \brief Calculates the 2nd order susceptibilities of conserved charges
+     *        with the least amount of work the model permits.
+     *
+     * Unlike CalculateSusceptibilityMatrix(), does not require the particle number correlations.
+     * The base class implementation falls back to CalculateFluctuations().
+     * Derived classes where the susceptibilities can be obtained directly,
+     * such as ThermalModelIdeal, override this method.
+     * Requires the primordial densities to be calculated.
+     *
+     * The calculation results are accessible through Susc() or Susceptibility()
+     *
+     */
+    virtual void CalculateConservedChargeSusceptibilities();
+
     /**
      * \brief Calculates the susceptibility matrix of conserved charges proxies.
      * 
@@ -871,7 +1083,11 @@ namespace thermalfist {
     double AbsoluteCharmDensity() { return CalculateAbsoluteCharmDensity(); }
 
     //@{
-    /// Implementation of the equation of state functions
+    /// Implementation of the equation of state functions.
+    /// The densities of the conserved charges and hadrons are sums over the primordial densities,
+    /// these calculate the primordial densities if needed but not the decay feeddown.
+    /// TotalDensities() are therefore not up to date afterwards, unlike in the earlier versions,
+    /// use CalculateDensities() or CalculateFeeddown() for these.
     virtual double CalculatePressure() = 0;
     virtual double CalculateEnergyDensity() = 0;
     virtual double CalculateEntropyDensity() = 0;
@@ -950,6 +1166,7 @@ namespace thermalfist {
     /// A pointer to the ThermalParticleSystem object
     /// with the particle list.
     ThermalParticleSystem* TPS() { return m_TPS; }
+    const ThermalParticleSystem* TPS() const { return m_TPS; }
 
     /// A vector with primordial particle number densities.
     /// Each entry corresponds to a density of single species,
@@ -992,6 +1209,10 @@ namespace thermalfist {
     /// the CalculateFluctuations() method
     bool IsFluctuationsCalculated() const { return m_FluctuationsCalculated; }
 
+    /// Whether the conserved charges susceptibilities are up to date,
+    /// either from CalculateFluctuations() or CalculateConservedChargeSusceptibilities()
+    bool IsSusceptibilitiesCalculated() const { return m_SusceptibilitiesCalculated; }
+
     /// Whether the grand-canonical ensemble particle
     /// number densities were calculated
     bool IsGCECalculated() const { return m_GCECalculated; }
@@ -1080,6 +1301,32 @@ namespace thermalfist {
      */
     double Susc(ConservedCharge::Name i, ConservedCharge::Name j) const { return m_Susc[i][j]; }
 
+    /**
+     * \brief A 2nd order susceptibility of conserved charges, computed on demand
+     *
+     * Same as Susc() but calculates the primordial densities and the susceptibilities
+     * through CalculateConservedChargeSusceptibilities() if these are not up to date.
+     * The particle number correlations and feeddown are not computed unless the model requires these.
+     *
+     * \param i First conserved charge
+     * \param j Second conserved charge
+     * \return  Susceptibility \f$ \chi_{11}^{c_i c_j} \f$
+     */
+    double Susceptibility(ConservedCharge::Name i, ConservedCharge::Name j);
+
+    /**
+     * \brief Cumulant ratio \f$ \chi_n \f$ of a conserved charge, computed on demand
+     *
+     * Evaluated with CalculateChargeFluctuations() on first request and cached
+     * until the parameters change. Higher orders than the ones already cached
+     * trigger a recalculation. Restricted to models implementing CalculateChargeFluctuations().
+     *
+     * \param chg   Conserved charge
+     * \param order Order of the susceptibility, from 1 to 4
+     * \return      Susceptibility \f$ \chi_n^{c} \f$
+     */
+    double ConservedChargeCumulant(ConservedCharge::Name chg, int order);
+
     /**
      * \brief A 2nd order susceptibility of conserved charges proxies
      * 
@@ -1169,7 +1416,9 @@ namespace thermalfist {
     bool m_Calculated;
     bool m_FeeddownCalculated;
     bool m_FluctuationsCalculated;
+    bool m_SusceptibilitiesCalculated;
     bool m_GCECalculated;
+    bool m_DensitiesDerivativesCalculated;
     bool m_UseWidth;
     bool m_NormBratio;
     bool m_QuantumStats;
@@ -1186,12 +1435,17 @@ namespace thermalfist {
 
     bool m_useOpenMP;
 
+    bool m_SolverJacobianReuse;
+
     std::vector<double> m_densities;
     std::vector<double> m_densitiestotal;
     //std::vector<double> m_densitiestotalweak;
     std::vector< std::vector<double> > m_densitiesbyfeeddown;
     std::vector<double> m_Chem;
 
+    // Derivatives of densities with respect to thermal parameters, indexed as [parameter][feeddown][specie]
+    std::vector< std::vector< std::vector<double> > > m_densitiesderivatives;
+
     // Scaled variance
     std::vector<double> m_wprim;
     std::vector<double> m_wtot;
@@ -1218,6 +1472,9 @@ namespace thermalfist {
     // Susceptibility matrix of net-p, net-Q, and net-K
     std::vector< std::vector<double> > m_ProxySusc;
 
+    // Cached cumulants of conserved charges evaluated by ConservedChargeCumulant(), empty if not calculated
+    std::vector< std::vector<double> > m_ChargeCumulants;
+
     // Cumulants of arbitrary charge calculation
     //std::vector< std::vector<double> > m_chi;
 
@@ -1236,11 +1493,117 @@ namespace thermalfist {
     /// Shift in chemical potential of particle species id due to interactions
     virtual double MuShift(int /*id*/) const { return 0.; }
 
+    /// Marks all quantities derived from the primordial densities
+    /// (feeddown, fluctuations, susceptibilities, cumulants) as outdated.
+    /// Called whenever the primordial densities are recalculated.
+    void ResetDerivedCalculatedFlags();
+
+    //@{
+    /// Bring the respective quantity, and all quantities it depends on, up to date if needed.
+    /// The dependency chain is: primordial densities -> feeddown -> fluctuations,
+    /// and primordial densities -> susceptibilities of conserved charges.
+    void RequirePrimordialDensities();
+    void RequireFeeddown();
+    void RequireFluctuations();
+    void RequireSusceptibilities();
+    //@}
+
+    /// Stores the internal variables of the model in the state, see GetState().
+    /// Derived classes with additional variables override it and call the base class implementation.
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// Restores the internal variables of the model from the state, see SetState().
+    /// Derived classes with additional variables override it and call the base class implementation.
+    virtual void ReadState(const ThermalModelState &state);
+
+    /**
+     * \brief Evaluates an ideal gas quantity for all particle species
+     *        at the given chemical potentials.
+     * 
+     * The species are distributed among the OpenMP threads if enabled by SetOMP().
+     * Each species is written to its own element, such that any subsequent
+     * summation over species is done in a fixed order.
+     * 
+     * \param type Ideal gas quantity
+     * \param mu   Chemical potentials of all species (GeV)
+     * \param ret  Values of the quantity for all species
+     */
+    void IdealGasQuantities(IdealGasFunctions::Quantity type, const std::vector<double> &mu, std::vector<double> &ret) const;
+
+    /// The decay contributions used in the feeddown and fluctuations calculations,
+    /// see ThermalParticleSystem::DecayContributionsByFeeddown().
+    /// These are taken from TPS() unless the thermal branching ratios (eBW scheme) are used.
+    const std::vector<ThermalParticleSystem::DecayContributionsToAllParticles>& DecayContributionsByFeeddown() const {
+      return m_ThermalDecays ? m_ThermalDecays->DecayContributionsByFeeddown : m_TPS->DecayContributionsByFeeddown();
+    }
+
+    /// The decay cumulants used in the fluctuations calculations, see ThermalParticleSystem::DecayCumulants()
+    const ThermalParticleSystem::DecayCumulantsContributionsToAllParticles& DecayCumulants() const {
+      return m_ThermalDecays ? m_ThermalDecays->DecayCumulants : m_TPS->DecayCumulants();
+    }
+
+    /// The final state distributions used in the fluctuations calculations, see ThermalParticleSystem::ResonanceFinalStatesDistributions()
+    const std::vector<ThermalParticleSystem::ResonanceFinalStatesDistribution>& ResonanceFinalStatesDistributions() const {
+      return m_ThermalDecays ? m_ThermalDecays->ResonanceFinalStatesDistributions : m_TPS->ResonanceFinalStatesDistributions();
+    }
+
+    /// Mean numbers of charged particles after decays of species i, see ThermalParticle::Nch()
+    const std::vector<double>& DecayNch(int i) const { return m_ThermalDecays ? m_ThermalDecays->Nch[i] : m_TPS->Particles()[i].Nch(); }
+
+    /// Variances of the numbers of charged particles after decays of species i, see ThermalParticle::DeltaNch()
+    const std::vector<double>& DecayDeltaNch(int i) const { return m_ThermalDecays ? m_ThermalDecays->DeltaNch[i] : m_TPS->Particles()[i].DeltaNch(); }
+
   private:
+    // Decay contributions evaluated using the thermal branching ratios
+    // at the present thermal parameters (eBW scheme only).
+    // Never modified once created, thus can be shared between the model copies.
+    std::shared_ptr<const ThermalParticleSystem::DecayData> m_ThermalDecays;
+
     void ResetChemicalPotentials();
 
     double GetDensity(long long PDGID, const std::vector<double> *dens);
 
+    /// Applies the decay feeddown to a vector of primordial quantities
+    /// of all species, for each feeddown type
+    void ApplyFeeddown(const std::vector<double> & primordial, std::vector< std::vector<double> > & byfeeddown) const;
+
+    /// The chemical potentials fixed by the conservation laws (muQ, muS, muC), together with
+    /// the charges of all species entering the corresponding constraints, which are
+    /// imposed as linear combinations of the densities.
+    /// The Q/B constraint is imposed as Q - (Q/B) * B = 0 to stay regular at muB = 0.
+    void ConstrainedChemicalPotentials(std::vector<ThermalParameter::Name> & constrParams, std::vector< std::vector<double> > & constrCharges) const;
+
+    /// Attempts to constrain the chemical potentials by continuation from the previous solution,
+    /// see SetChemicalPotentialsContinuation(). Returns false if the fallback to the full solution is needed.
+    bool ConstrainChemicalPotentialsContinuation();
+
+    /// Stores the present solution of the conservation laws and the derivatives
+    /// of the constrained chemical potentials with respect to muB used by the continuation.
+    /// The derivatives with respect to T are evaluated only once a change of T requires them.
+    void UpdateChemicalPotentialsContinuation();
+
+    /// Evaluates the derivatives of the constrained chemical potentials with respect to T
+    /// at the stored solution. Returns false if these cannot be determined.
+    bool CalculateChemicalPotentialsContinuationdMudT(const std::vector<ThermalParameter::Name> & constrParams, const std::vector< std::vector<double> > & constrCharges);
+
+    /// Derivatives dn_i / dmu_i of the primordial densities with respect to the chemical potentials of the same species,
+    /// evaluated through the scaled variances
+    void ChemicalPotentialsSusceptibilities(std::vector<double> & susc);
+
+    // State of the continuation of the constrained chemical potentials
+    bool m_ChemContinuation;
+    bool m_ChemContinuationValid;
+    std::vector<ThermalParameter::Name> m_ChemContinuationParams;
+    std::vector<double> m_ChemContinuationMu;
+    double m_ChemContinuationT;
+    double m_ChemContinuationMuB;
+    // Susceptibilities dn_i / dmu_i at the stored solution
+    std::vector<double> m_ChemContinuationSusc;
+    // Derivatives of the constrained chemical potentials with respect to T and muB
+    bool m_ChemContinuationdMudTValid;
+    std::vector<double> m_ChemContinuationdMudT;
+    std::vector<double> m_ChemContinuationdMudMuB;
+
     class BroydenEquationsChem : public BroydenEquations
     {
     public:
@@ -1262,8 +1625,9 @@ namespace thermalfist {
     class BroydenChem : public Broyden
     {
     public:
-      BroydenChem(ThermalModelBase *THM, BroydenEquations *eqs = NULL, BroydenJacobian *jaco = NULL) : Broyden(eqs, jaco) { m_THM = THM; }
+      BroydenChem(ThermalModelBase *THM = NULL, BroydenEquations *eqs = NULL, BroydenJacobian *jaco = NULL) : Broyden(eqs, jaco) { m_THM = THM; }
       ~BroydenChem(void) { }
+      void SetModel(ThermalModelBase *THM) { m_THM = THM; }
       std::vector<double> Solve(const std::vector<double> &x0, BroydenSolutionCriterium *solcrit = NULL, int max_iterations = MAX_ITERS);
     private:
       ThermalModelBase *m_THM;
@@ -1293,6 +1657,11 @@ namespace thermalfist {
       std::vector<double> m_Totals;
       ThermalModelBase *m_THM;
     };
+
+    /// Broyden's solvers of the conservation laws kept between the calculations,
+    /// the model pointer, the equations and the Jacobian are set in each call
+    BroydenChem m_BroydenChem;
+    Broyden m_BroydenChemTotals;
   };
 
 } // namespace thermalfist
@@ -79,6 +79,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelCanonical(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelCanonical* Clone() const;
+
     /**
      * \brief Calculates the range of quantum numbers values
      *        for which it is necessary to compute the 
@@ -106,6 +109,17 @@ namespace thermalfist {
      */
     virtual void CalculatePartitionFunctions(double Vc = -1.);
 
+    /**
+     * \brief 1-dimensional index of the combination
+     *        of quantum numbers in the vector of partition functions.
+     * 
+     * Charges which are treated grand-canonically are set to zero.
+     * 
+     * \return The index, or -1 if the quantum numbers
+     *         are outside the range set by CalculateQuantumNumbersRange()
+     */
+    int QuantumNumbersIndex(int B, int Q, int S, int C) const;
+
     /**
      * \brief Determines whether the specified ThermalParticle
      *        is treat canonically or grand-canonically in the present
@@ -181,6 +195,21 @@ namespace thermalfist {
      * \param The multiplier
      */
     void SetIntegrationIterationsMultiplier(int multiplier) { (multiplier > 0 ? m_IntegrationIterationsMultiplier = multiplier : m_IntegrationIterationsMultiplier = 1); }
+
+    /**
+     * \brief Whether the partition functions are evaluated with the fast Fourier transform.
+     *
+     * If true, the integrand of the canonical partition functions
+     * is sampled on a uniform grid of the phases, and the partition functions for all the
+     * needed quantum numbers are obtained at once by the multidimensional FFT.
+     * The grid size is chosen automatically from the range of quantum numbers
+     * and the mean multiplicities of the charged particles.
+     * Otherwise, the nested Gauss-Legendre quadratures are used.
+     *
+     * \param useFFT Whether to use the FFT
+     */
+    void SetUseFFT(bool useFFT) { m_UseFFT = useFFT; }
+    bool UseFFT() const { return m_UseFFT; }
     
 
     // Override functions begin
@@ -233,7 +262,22 @@ namespace thermalfist {
     void CleanModelGCE();    /**< Cleares the ThermalModelIdeal copy */
     //@}
 
+    /**
+     * \brief Evaluates the partition functions with the FFT, see SetUseFFT().
+     *
+     * \param Nsx Real parts of the single-particle partition functions of each quantum number class
+     * \param Nsy Imaginary parts of the single-particle partition functions of each quantum number class
+     * \return false if the required grid is too large, the quadratures are to be used then
+     */
+    bool CalculatePartitionFunctionsFFT(const std::vector<double> &Nsx, const std::vector<double> &Nsy);
+
   protected:
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
 
     /**
      * \brief A set of QuantumNumbers combinations
@@ -270,6 +314,28 @@ namespace thermalfist {
      */
     std::vector<double> m_PartialZ;
 
+    /**
+     * \brief Cluster densities of each particle species.
+     * 
+     * m_DensitiesCluster[i][n-1] is the contribution of
+     * the n-th term of the cluster expansion
+     * to the grand-canonical density of species i,
+     * as returned by ThermalParticle::DensityCluster().
+     * Filled by CalculatePartitionFunctions() for
+     * the canonically treated species.
+     * 
+     */
+    std::vector< std::vector<double> > m_DensitiesCluster;
+
+    /**
+     * \brief Indices of the quantum numbers of the n-particle clusters.
+     * 
+     * m_ClusterQNIndices[i][n-1] is the QuantumNumbersIndex() of
+     * the n-th cluster of species i, or -1 if out of range.
+     * 
+     */
+    std::vector< std::vector<int> > m_ClusterQNIndices;
+
     /**
      * \brief A multiplier to increase the number of iterations during the numerical integration used to calculate the partition functions.
      *
@@ -278,6 +344,9 @@ namespace thermalfist {
      */
     int m_IntegrationIterationsMultiplier;
 
+    /// Whether the partition functions are evaluated with the FFT
+    bool m_UseFFT;
+
     int m_BMAX, m_QMAX, m_SMAX, m_CMAX;
     int m_BMAX_list, m_QMAX_list, m_SMAX_list, m_CMAX_list;
 
@@ -47,6 +47,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelCanonicalCharm(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelCanonicalCharm* Clone() const;
+
     /// Calculates the grand-canonical energy densities
     void CalculateEnergyDensitiesGCE();
 
@@ -116,6 +119,13 @@ namespace thermalfist {
 
     // Override functions end
 
+  protected:
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
   private:
     std::vector<double> m_densitiesGCE;
     std::vector<double> m_energydensitiesGCE;
@@ -47,6 +47,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelCanonicalStrangeness(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelCanonicalStrangeness* Clone() const;
+
     /// Calculates the grand-canonical energy densities
     virtual void CalculateEnergyDensitiesGCE();
 
@@ -63,6 +66,28 @@ namespace thermalfist {
      */
     virtual void CalculateSums(double Vc);
 
+    /**
+     * \brief Evaluates the Bessel series for the partition functions
+     *        from the partial sums m_partialS.
+     * 
+     * The series is truncated adaptively depending on the magnitude
+     * of the partial sums. The terms are evaluated in log-space
+     * and weighted by \f$ e^{\lambda S} \f$ with \f$ \lambda \f$ from StrangenessSaddlePoint(),
+     * such that the sums do not underflow at large volumes.
+     * The partition functions are stored in m_Zsum
+     * divided by a common factor, the logarithm of which is stored in m_ZsumLogFactor.
+     */
+    void CalculateZsum();
+
+    /**
+     * \brief The value of \f$ \lambda \f$ for which the partial sums
+     *        weighted by \f$ e^{\lambda S} \f$ have vanishing net strangeness.
+     * 
+     * Corresponds to \f$ \mu_S / T \f$ in the grand-canonical limit.
+     * Zero if there are no strange or no antistrange hadrons.
+     */
+    double StrangenessSaddlePoint() const;
+
     /// A vector of the grand-canonical particle number densities
     const std::vector<double>& DensitiesGCE() const { return m_densitiesGCE; }
 
@@ -132,12 +157,19 @@ namespace thermalfist {
     // Override functions end
 
   protected:
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     std::vector<double> m_densitiesGCE;
     std::vector<double> m_energydensitiesGCE;
     std::vector<double> m_pressuresGCE;
     std::vector<int>    m_StrVals;
     std::map<int, int>  m_StrMap;
     std::vector<double> m_Zsum;
+    double              m_ZsumLogFactor;
     std::vector<double> m_partialS;
   };
 
@@ -33,14 +33,25 @@ namespace thermalfist {
      */
     virtual ~ThermalModelIdeal(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelIdeal* Clone() const;
+
     // Override functions begin
 
     virtual void CalculatePrimordialDensities();
 
+    virtual std::vector<double> PrimordialDensitiesDerivative(const std::vector<double> & dmu, double dT = 0.);
+
     virtual void CalculateTwoParticleCorrelations();
 
     virtual void CalculateFluctuations();
 
+    virtual void CalculateConservedChargeSusceptibilities();
+
+    /// The susceptibilities of the ideal gas do not need the particle number correlations,
+    /// same as CalculateConservedChargeSusceptibilities()
+    virtual void CalculateSusceptibilityMatrix();
+
     virtual std::vector<double> CalculateChargeFluctuations(const std::vector<double> &chgs, int order = 4);
 
     virtual double CalculateEnergyDensity();
@@ -10,6 +10,30 @@
 
 namespace thermalfist {
 
+  /**
+   *   \brief Thermal parameters with respect to which
+   *          the derivatives of particle number densities can be evaluated.
+   *
+   *   Used in ThermalModelBase::CalculateDensitiesDerivatives().
+   */
+  struct ThermalParameter {
+    /**
+     * \brief The list of thermal parameters.
+     *
+     */
+    enum Name {
+      Temperature = 0,                  ///< Temperature
+      BaryonChemicalPotential = 1,      ///< Baryon chemical potential
+      ElectricChemicalPotential = 2,    ///< Electric charge chemical potential
+      StrangenessChemicalPotential = 3, ///< Strangeness chemical potential
+      CharmChemicalPotential = 4,       ///< Charm chemical potential
+      Gammaq = 5,                       ///< Chemical non-equilibrium fugacity of light quarks
+      GammaS = 6,                       ///< Chemical non-equilibrium fugacity of strange quarks
+      GammaC = 7                        ///< Chemical non-equilibrium fugacity of charm quarks
+    };
+    static const int NumberOfTypes = 8;
+  };
+
   /**
    *   \brief Structure containing all thermal parameters of the model.
    * 
@@ -0,0 +1,98 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef THERMALMODELSTATE_H
+#define THERMALMODELSTATE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include "HRGBase/ThermalModelParameters.h"
+#include "HRGBase/ThermalParticleSystem.h"
+
+namespace thermalfist {
+
+  /**
+   * \brief Snapshot of the internal state of an HRG model.
+   *
+   * Contains the thermal parameters, the chemical potentials,
+   * the calculated densities and fluctuations, as well as
+   * the model-specific solver variables (e.g. the shifted
+   * chemical potentials of the QvdW model or the canonical partition functions).
+   * Obtained with ThermalModelBase::GetState() and restored
+   * with ThermalModelBase::SetState(), such that the model can
+   * return to a converged state without repeating the calculations.
+   *
+   * The model settings, such as the particle list, the interaction parameters,
+   * or the statistics, are not part of the state. A state can only be restored
+   * in a model of the same type configured in the same way.
+   *
+   * The state can be written to and read from a text file
+   * with WriteToFile() and ReadFromFile(), e.g. to resume an interrupted scan.
+   *
+   */
+  struct ThermalModelState {
+    /// Name of the model class the state was obtained from
+    std::string ModelTag;
+
+    /// Number of particle species in the list
+    int ComponentsNumber;
+
+    /// The thermal parameters
+    ThermalModelParameters Parameters;
+
+    /// Named scalar quantities, including flags
+    std::map<std::string, double> Scalars;
+
+    /// Named vectors, typically indexed by the particle species
+    std::map<std::string, std::vector<double> > Vectors;
+
+    /// Named matrices
+    std::map<std::string, std::vector< std::vector<double> > > Matrices;
+
+    /// Decay contributions evaluated with the thermal branching ratios (eBW scheme only).
+    /// Not written to file.
+    std::shared_ptr<const ThermalParticleSystem::DecayData> ThermalDecays;
+
+    ThermalModelState() : ComponentsNumber(0) { }
+
+    /// Whether the state is empty
+    bool Empty() const { return ModelTag.empty(); }
+
+    //@{
+    /// Retrieves a stored quantity. Returns false and leaves the argument unchanged if not present.
+    bool Get(const std::string &name, double &value) const;
+    bool Get(const std::string &name, bool &value) const;
+    bool Get(const std::string &name, std::vector<double> &value) const;
+    bool Get(const std::string &name, std::vector< std::vector<double> > &value) const;
+    //@}
+
+    /**
+     * \brief Writes the state to a text file.
+     *
+     * The numbers are written with full double precision,
+     * the state read with ReadFromFile() reproduces the original one.
+     *
+     * \param filename The output file
+     * \return true if successful, false otherwise
+     */
+    bool WriteToFile(const std::string &filename) const;
+
+    /**
+     * \brief Reads the state from a file written by WriteToFile().
+     *
+     * \param filename The input file
+     * \return true if successful, false otherwise
+     */
+    bool ReadFromFile(const std::string &filename);
+  };
+
+} // namespace thermalfist
+
+#endif
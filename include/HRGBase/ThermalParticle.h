@@ -600,6 +600,16 @@ namespace thermalfist {
      */
     void CalculateThermalBranchingRatios(const ThermalModelParameters &params, bool useWidth = 0, double mu = 0.);
 
+    /**
+     * \brief Same as CalculateThermalBranchingRatios() but returns
+     *        the average branching ratios instead of storing them.
+     *
+     * The particle is not modified.
+     *
+     * \return The average branching ratios, one per decay channel in Decays()
+     */
+    std::vector<double> ThermalBranchingRatios(const ThermalModelParameters &params, bool useWidth = 0, double mu = 0.) const;
+
     /**
      * \brief Sets the CalculationType() method to evaluate quantum statistics.
      * 
@@ -610,8 +620,9 @@ namespace thermalfist {
     /**
      * \brief Method to evaluate quantum statistics.
      * 
-     * Cluster expansion or numerical integration
-     * using the quadratures.
+     * Cluster expansion, numerical integration
+     * using the quadratures, or the adaptive choice
+     * between these, see QuantumStatisticsTolerance().
      * 
      * \return IdealGasFunctions::QStatsCalculationType 
      */
@@ -627,6 +638,26 @@ namespace thermalfist {
     /// Set ClusterExpansionOrder()
     void SetClusterExpansionOrder(int order) { m_ClusterExpansionOrder = order; }
 
+    /**
+     * \brief Relative accuracy targeted by the IdealGasFunctions::Adaptive calculation type.
+     *
+     * \return Relative accuracy of the quantum statistics calculations.
+     */
+    double QuantumStatisticsTolerance() const { return m_QuantumStatisticsTolerance; }
+
+    /// Set QuantumStatisticsTolerance()
+    void SetQuantumStatisticsTolerance(double tolerance) { m_QuantumStatisticsTolerance = tolerance; }
+
+    /**
+     * \brief The method used to evaluate the particle number density
+     *        at the pole mass with the current CalculationType().
+     *
+     * \param params   Structure containing the temperature value and the chemical factors.
+     * \param mu       Chemical potential.
+     * \return The method used.
+     */
+    IdealGasFunctions::QStatsMethod QuantumStatisticsMethod(const ThermalModelParameters &params, double mu = 0.) const;
+
     std::vector<double> BranchingRatioWeights(const std::vector<double> & ms) const;
 
     const std::vector<double>& Nch() const { return m_Nch; }
@@ -681,10 +712,15 @@ namespace thermalfist {
     double m_Mass;                /**< Mass (GeV) */
 
     /**
-     *   0 - Cluster expansion (default), 1 - Numerical integration
+     *   0 - Cluster expansion, 1 - Numerical integration (default), 2 - Adaptive
      */
     IdealGasFunctions::QStatsCalculationType m_QuantumStatisticsCalculationType;
 
+    /**
+     *   Relative accuracy targeted by the adaptive method. Default is 10^-6
+     */
+    double m_QuantumStatisticsTolerance;
+
     /**
      *   Number of terms in cluster expansion.
      *   Default is 10 for m < 200 MeV (pions), 5 for m < 1000 MeV, and 3 otherwise
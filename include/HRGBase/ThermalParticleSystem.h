@@ -208,6 +208,53 @@ namespace thermalfist {
      */
     const std::vector<ResonanceFinalStatesDistribution>& ResonanceFinalStatesDistributions() const { return m_ResonanceFinalStatesDistributions; }
 
+    /**
+     * \brief Decay contributions, decay cumulants, and final state distributions
+     *        of all the particles, evaluated for given branching ratios of the first decay.
+     *
+     * The particle list itself holds these quantities for the branching ratios
+     * returned by FirstDecayBranchingRatios(). An HRG model in the eBW scheme evaluates
+     * its own DecayData with the thermal branching ratios, see CalculateDecayData().
+     */
+    struct DecayData {
+      /// Same as DecayContributionsByFeeddown()
+      std::vector<DecayContributionsToAllParticles> DecayContributionsByFeeddown;
+
+      /// Same as DecayCumulants()
+      DecayCumulantsContributionsToAllParticles DecayCumulants;
+
+      /// Same as ResonanceFinalStatesDistributions()
+      std::vector<ResonanceFinalStatesDistribution> ResonanceFinalStatesDistributions;
+
+      /// Mean numbers of charged, positive, and negative particles after decays of each species, same as ThermalParticle::Nch()
+      std::vector< std::vector<double> > Nch;
+
+      /// Variances of these numbers, same as ThermalParticle::DeltaNch()
+      std::vector< std::vector<double> > DeltaNch;
+    };
+
+    /**
+     * \brief Branching ratios of the first decay of each particle used in ProcessDecays().
+     *
+     * These are the thermal ones (ParticleDecayChannel::mBratioAverage) in the eBW scheme,
+     * and the vacuum ones (ParticleDecayChannel::mBratio) otherwise.
+     * The subsequent decays always use the vacuum branching ratios.
+     */
+    std::vector< std::vector<double> > FirstDecayBranchingRatios() const;
+
+    /**
+     * \brief Evaluates the decay contributions, decay cumulants, and final state distributions
+     *        for given branching ratios of the first decay.
+     *
+     * The particle list is not modified, so that this method can be called concurrently
+     * by several HRG models sharing the list.
+     *
+     * \param firstBratios Branching ratios of the first decay, one vector per particle
+     *                     of the same size as ThermalParticle::Decays()
+     * \param data         The evaluated decay quantities
+     */
+    void CalculateDecayData(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const;
+
     /**
      * \brief Loads the particle list from file.
      *
@@ -341,6 +388,17 @@ namespace thermalfist {
      */
     void SetClusterExpansionOrder(int order);
 
+    /**
+     * \brief Set the relative accuracy targeted by the IdealGasFunctions::Adaptive method.
+     *
+     * Sets the same value for all particles.
+     * To set individually for each particle
+     * use ThermalParticle::SetQuantumStatisticsTolerance().
+     *
+     * \param tolerance Relative accuracy.
+     */
+    void SetQuantumStatisticsTolerance(double tolerance);
+
     //@{
     /**
      * \brief Set (or get) the ThermalParticle::ResonanceWidthShape for all particles.
@@ -435,7 +493,7 @@ namespace thermalfist {
      * \param pdgid PDG ID.
      * \return int  0-based particle id number.
      */
-    int  PdgToId(long long pdgid)    /*const*/ { return (m_PDGtoID.count(pdgid) > 0) ? m_PDGtoID[pdgid] : -1; }
+    int  PdgToId(long long pdgid)    const { std::map<long long, int>::const_iterator it = m_PDGtoID.find(pdgid); return (it != m_PDGtoID.end()) ? it->second : -1; }
     
     /**
      * \brief Transforms 0-based particle id number to a PDG ID.
@@ -531,15 +589,27 @@ namespace thermalfist {
     static const std::string flag_noexcitednuclei;
 
   private:
-    void GoResonance(int ind, int startind, double BR);
+    // Decay contributions according to the stability flags
+    void CalculateDecayContributions(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const;
+
+    // Decay contributions separately for weak, electromagnetic, and strong decay feeddown
+    void CalculateDecayContributionsByFeeddown(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const;
+
+    // Decay cumulants, final state distributions, and charged particle multiplicities,
+    // requires the decay contributions according to the stability flags
+    void CalculateDecayDistributions(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const;
 
-    void GoResonanceByFeeddown(int ind, int startind, double BR, Feeddown::Type feeddown);
+    // In the following, firstBratios are the branching ratios of the decay of particle ind,
+    // NULL for subsequent decays in the chain, which use the vacuum branching ratios
+    void GoResonance(int ind, int startind, double BR, const std::vector<double>* firstBratios, DecayContributionsToAllParticles& contributions) const;
 
-    std::vector<double> GoResonanceDecayProbs(int ind, int goalind, bool firstdecay = false);
+    void GoResonanceByFeeddown(int ind, int startind, double BR, Feeddown::Type feeddown, const std::vector<double>* firstBratios, std::vector<DecayContributionsToAllParticles>& contributions) const;
 
-    std::vector<double> GoResonanceDecayProbsCharge(int ind, int nch, bool firstdecay = false);
+    std::vector<double> GoResonanceDecayProbs(int ind, int goalind, const std::vector<double>* firstBratios = NULL) const;
 
-    ResonanceFinalStatesDistribution GoResonanceDecayDistributions(int ind, bool firstdecay = false);
+    std::vector<double> GoResonanceDecayProbsCharge(int ind, int nch, const std::vector<double>* firstBratios = NULL) const;
+
+    ResonanceFinalStatesDistribution GoResonanceDecayDistributions(int ind, const std::vector<double>* firstBratios, std::vector<ResonanceFinalStatesDistribution>& cache) const;
 
     bool AcceptParticle(const ThermalParticle& part, const std::set<std::string>& flags, double mcut = -1.) const;
 
@@ -590,13 +660,8 @@ namespace thermalfist {
 
     DecayCumulantsContributionsToAllParticles m_DecayCumulants;
 
-    DecayProbabilityDistributionsToAllParticles m_DecayProbabilities;
-
     std::vector<ResonanceFinalStatesDistribution> m_ResonanceFinalStatesDistributions;
 
-    // Map for DP-based calculations of decay distributions
-    std::vector<ResonanceFinalStatesDistribution> m_DecayDistributionsMap;
-
     SortModeType m_SortMode;
   };
 
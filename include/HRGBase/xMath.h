@@ -8,6 +8,8 @@
 #ifndef XMATH_H
 #define XMATH_H
 
+#include <vector>
+
 /**
  * \file xMath.h
  * 
@@ -65,6 +67,10 @@ namespace thermalfist {
     double BesselI1exp(double x);         // modified Bessel function I_1(x), divided by exponential factor
     double BesselIexp(int n, double x);   // integer order modified Bessel function I_n(x), divided by exponential factor
 
+    /// Modified Bessel functions I_n(x) for n = 0,...,nmax, divided by exponential factor,
+    /// computed at once by downward recurrence, normalized with \f$ I_0(x) + 2 \sum_{n \geq 1} I_n(x) = e^x \f$
+    std::vector<double> BesselIexpSequence(int nmax, double x);
+
 
     // Note that the functions Gamma and LogGamma are mutually dependent.
     double LogGamma(double);
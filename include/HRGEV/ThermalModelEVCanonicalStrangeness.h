@@ -50,6 +50,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelEVCanonicalStrangeness(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelEVCanonicalStrangeness* Clone() const;
+
     /// \copydoc thermalfist::ThermalModelEVDiagonal::FillVirialEV()
     void FillVirialEV(const std::vector<double> & vi = std::vector<double>(0));
 
@@ -100,9 +103,18 @@ namespace thermalfist {
     /// Clears m_modelEV
     void ClearModelEV();    
 
+    /// Chemical potentials of all hadrons shifted by the EV interactions with non-strange hadrons
+    std::vector<double> ShiftedChemicalPotentials() const;
+
     /// \copydoc thermalfist::ThermalModelEVDiagonal::MuShift()
     virtual double MuShift(int id) const;
 
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     ThermalModelEVDiagonal *m_modelEV; /**< Pointer to the diagonal EV model in the GCE with non-strange particles only */
     std::vector<double> m_v;   /**< Vector of eigenvolumes of all hadrons */
     double m_PNS;              /**< Pressure of all non-strange hadrons */
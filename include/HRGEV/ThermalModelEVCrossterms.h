@@ -50,6 +50,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelEVCrossterms(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelEVCrossterms* Clone() const;
+
     // Override functions begin
 
     virtual void FillVirial(const std::vector<double> & ri = std::vector<double>(0));
@@ -119,6 +122,25 @@ namespace thermalfist {
 
     virtual void CalculatePrimordialDensitiesIter();
 
+    /**
+     * \brief Groups the particle species with identical
+     *        excluded volume parameters into EV components.
+     * 
+     * The grouping is cached and only redone after the
+     * virial coefficients have been changed.
+     */
+    void FillEVComponentMaps();
+
+    /**
+     * \brief Calculates the particle number densities
+     *        and the entropy density from the solved partial pressures.
+     * 
+     * Species within the same EV component share the
+     * density correction factor, which is obtained by solving
+     * a single linear system of the dimension equal to the number of EV components.
+     */
+    void CalculateDensitiesFromPartialPressures();
+
     /**
      * \brief Solves the transcendental equation of 
      *        the corresponding diagonal EV model.
@@ -196,6 +218,12 @@ namespace thermalfist {
      */
     virtual double MuShift(int i) const;
 
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     std::vector<double> m_densitiesid;            /**< Vector of ideal gas densities with shifted chemical potentials */
     std::vector<double> m_Ps;                     /**< Vector of (solved) partial pressures */
     std::vector< std::vector<double> > m_Virial;  /**< Matrix of virial (excluded-volume) coefficients \f$ \tilde{b}_{ij} \f$ */
@@ -207,6 +235,12 @@ namespace thermalfist {
     std::vector<int> m_MapFromEVComponent;
     std::vector< std::vector<int> > m_EVComponentIndices;
 
+    /// Whether the EV component maps correspond to the current virial coefficients
+    bool m_EVComponentMapsValid;
+
+    /// Broyden's solver kept between the calculations, see SetSolverJacobianReuse()
+    Broyden m_Broyden;
+
   private:
     class BroydenEquationsCRS : public BroydenEquations
     {
@@ -39,7 +39,7 @@ namespace thermalfist {
    * 
    * The transcendental equation for the pressure
    * is solved
-   * using the Broyden's method.
+   * using the safeguarded Newton's (Halley's) method.
    * 
    */
   class ThermalModelEVDiagonal : public ThermalModelBase
@@ -59,6 +59,9 @@ namespace thermalfist {
      */
     virtual ~ThermalModelEVDiagonal(void);
 
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelEVDiagonal* Clone() const;
+
     /**
      * \brief Same as FillVirial() but uses the diagonal excluded-volume
      *        coefficients \f$ v_i \equiv b_{ii} \f$ as input instead of radii.
@@ -87,6 +90,20 @@ namespace thermalfist {
      */
     double CommonSuppressionFactor();
 
+    /**
+     * \brief Whether the pressure equation is solved
+     *        starting from the previously obtained pressure.
+     * 
+     * Reduces the number of iterations when the model is evaluated
+     * repeatedly for slowly changing T and/or chemical potentials,
+     * e.g. in fits or scans of the equation of state.
+     * The default is to start from the ideal gas pressure.
+     * 
+     * \param warmStart Whether the previous solution is used as initial guess
+     */
+    void SetPressureWarmStart(bool warmStart) { m_PressureWarmStart = warmStart; }
+    bool PressureWarmStart() const { return m_PressureWarmStart; }
+
     
     //@{
     /// Differential treatment of pair interactions 
@@ -196,6 +213,7 @@ namespace thermalfist {
      * 
      * Solves \f$ p(T,\mu) = \sum_i p_i^{\rm id} (T, \mu_i - v_i p). \f$
      * 
+     * Also fills the ideal gas densities m_densitiesid at the solved pressure.
      */
     virtual void SolvePressure();
 
@@ -207,6 +225,23 @@ namespace thermalfist {
      */
     double Pressure(double P);
 
+    /**
+     * \brief Computes the contribution of the species with
+     *        a non-zero eigenvolume to the l.h.s. of the transcendental
+     *        equation for the pressure and its derivatives with respect to P.
+     * 
+     * Evaluates the ideal gas functions of each species only once per call.
+     * The ideal gas densities at the given P are stored in m_densitiesid.
+     * The second derivative uses \f$ \partial n_i^{\rm id} / \partial \mu_i \simeq n_i^{\rm id} / T \f$,
+     * which is exact for the Boltzmann statistics.
+     * 
+     * \param P          Input pressure (GeV fm\f$^{-3}\f$)
+     * \param pressure   \f$ \sum_i p_i^{\rm id} (T, \mu_i - v_i P) \f$
+     * \param dpressure  First derivative with respect to P
+     * \param d2pressure Second derivative with respect to P
+     */
+    void EVPressureAndDerivatives(double P, double &pressure, double &dpressure, double &d2pressure);
+
     /**
      * \brief Calculate the ideal gas density of
      *        particle species i for the given pressure value.
@@ -250,47 +285,25 @@ namespace thermalfist {
      */
     virtual double MuShift(int i) const;
 
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     std::vector<double> m_densitiesid;             /**< Vector of ideal gas densities with shifted chemical potentials */
     std::vector<double> m_densitiesidnoshift;      /**< Vector of ideal gas densities without shifted chemical potentials */
+    std::vector<double> m_pressuresid;             /**< Vector of ideal gas pressures with shifted chemical potentials */
     std::vector<double> m_v;                       /**< Vector of eigenvolumes of all hadrons */
     double m_Suppression;                          /**< The common density suppression factor */
     double m_Pressure;                             /**< The solved pressure */
+    bool m_PressureWarmStart;                      /**< Whether the previous pressure is used as initial guess */
+    std::vector<int> m_EVSpecies;                  /**< Indices of species with non-zero eigenvolume */
     double m_Densityid;
     double m_TotalDensity;
     EVSolution m_sol;                              /**< Axuiliary */
 
   private:
-    class BroydenEquationsDEV : public BroydenEquations
-    {
-    public:
-      BroydenEquationsDEV(ThermalModelEVDiagonal *model) : BroydenEquations(), m_THM(model) { m_N = 1; m_mnc = 1.; }
-      std::vector<double> Equations(const std::vector<double> &x);
-      void SetMnc(double mnc) { m_mnc = mnc; }
-    private:
-      ThermalModelEVDiagonal *m_THM;
-      double m_mnc;
-    };
-
-    class BroydenJacobianDEV : public BroydenJacobian
-    {
-    public:
-      BroydenJacobianDEV(ThermalModelEVDiagonal *model) : BroydenJacobian(), m_THM(model) { m_mnc = 1.; }
-      std::vector<double> Jacobian(const std::vector<double> &x);
-      void SetMnc(double mnc) { m_mnc = mnc; }
-    private:
-      ThermalModelEVDiagonal *m_THM;
-      double m_mnc;
-    };
-
-    class BroydenSolutionCriteriumDEV : public Broyden::BroydenSolutionCriterium
-    {
-    public:
-      BroydenSolutionCriteriumDEV(ThermalModelEVDiagonal *model, double relative_error = Broyden::TOL) : Broyden::BroydenSolutionCriterium(relative_error), m_THM(model) { }
-      virtual bool IsSolved(const std::vector<double>& x, const std::vector<double>& f, const std::vector<double>& xdelta = std::vector<double>()) const;
-    protected:
-      ThermalModelEVDiagonal *m_THM;
-    };
-
     class BroydenEquationsDEVOrig : public BroydenEquations
     {
     public:
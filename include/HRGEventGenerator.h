@@ -6,12 +6,15 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGEventGenerator/Acceptance.h"
+#include "HRGEventGenerator/EventChunk.h"
 #include "HRGEventGenerator/EventGeneratorBase.h"
 #include "HRGEventGenerator/MomentumDistribution.h"
 #include "HRGEventGenerator/ParticleDecaysMC.h"
 #include "HRGEventGenerator/RandomGenerators.h"
+#include "HRGEventGenerator/ResonanceDecaySpectra.h"
 #include "HRGEventGenerator/SimpleEvent.h"
 #include "HRGEventGenerator/SimpleParticle.h"
+#include "HRGEventGenerator/SpectraAnalysis.h"
 #include "HRGEventGenerator/SREventGenerator.h"
 #include "HRGEventGenerator/SSHEventGenerator.h"
 #include "HRGEventGenerator/CracowFreezeoutEventGenerator.h"
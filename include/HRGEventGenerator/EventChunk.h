@@ -0,0 +1,134 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef EVENTCHUNK_H
+#define EVENTCHUNK_H
+
+#include <vector>
+
+#include "HRGEventGenerator/SimpleEvent.h"
+
+namespace thermalfist {
+
+  /**
+   * \brief A batch of events stored in a compact structure-of-arrays form.
+   *
+   * Only the final particles (SimpleEvent::Particles) are stored, each as
+   * its momentum, mass, and PDG code. The decay history, the space-time coordinates,
+   * and the decay photons/leptons are stored only if requested in the Config.
+   * The particles of event k occupy the range [EventOffset(k), EventOffset(k+1))
+   * of the per-particle arrays.
+   *
+   * Clear() keeps the allocated memory, so a chunk can be refilled
+   * with EventGeneratorBase::GenerateChunk() any number of times
+   * while the memory use stays bounded by the largest chunk:
+   *
+   *     EventChunk chunk;
+   *     for (long long i = 0; i < nevents; i += 10000) {
+   *       generator.GenerateChunk(chunk, 10000);
+   *       analysis.ProcessChunk(chunk);
+   *     }
+   */
+  class EventChunk
+  {
+  public:
+    /// What is stored in addition to the final particle momenta, masses and PDG codes
+    struct Config {
+      bool StoreCoordinates;      ///< Space-time coordinates r0, rx, ry, rz
+      bool StoreDecayHistory;     ///< Mother and primordial ancestor PDG codes, decay epoch
+      bool StorePhotonsLeptons;   ///< Decay photons and leptons, stored as separate arrays
+
+      Config() : StoreCoordinates(false), StoreDecayHistory(false), StorePhotonsLeptons(false) { }
+    };
+
+    /// Per-particle arrays of one particle collection
+    struct Particles {
+      std::vector<double> px, py, pz, m;          ///< Momentum (GeV) and mass (GeV)
+      std::vector<long long> PDGID;               ///< PDG code
+      std::vector<double> r0, rx, ry, rz;         ///< Space-time coordinates, if Config::StoreCoordinates
+      std::vector<long long> MotherPDGID;         ///< PDG code of the mother, 0 for primordial particles, if Config::StoreDecayHistory
+      std::vector<long long> PrimordialPDGID;     ///< PDG code of the primordial ancestor (0 for photons/leptons), if Config::StoreDecayHistory
+      std::vector<int> Epoch;                     ///< Number of decays before the particle was produced, if Config::StoreDecayHistory
+
+      /// Number of particles
+      size_t Size() const { return px.size(); }
+
+      /// Removes all the particles, keeping the allocated memory
+      void Clear();
+
+      /// Releases the allocated memory
+      void Release();
+
+      /// Energy of particle i (GeV)
+      double Energy(size_t i) const { return sqrt(m[i] * m[i] + px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]); }
+
+      /// Particle i as a SimpleParticle
+      SimpleParticle GetParticle(size_t i) const;
+    };
+
+    EventChunk(const Config& config = Config()) : m_Config(config) { Clear(); }
+
+    /// The storage configuration
+    const Config& GetConfig() const { return m_Config; }
+
+    /// Changes the storage configuration, clears the chunk
+    void SetConfig(const Config& config) { m_Config = config; Clear(); }
+
+    /// Removes all the events, keeping the allocated memory
+    void Clear();
+
+    /// Releases the allocated memory
+    void Release();
+
+    /// Reserves memory for a given number of events and final particles
+    void Reserve(size_t events, size_t particles);
+
+    /// Appends an event
+    void AddEvent(const SimpleEvent& evt);
+
+    /// Number of events
+    int NumberOfEvents() const { return static_cast<int>(m_Weights.size()); }
+
+    /// Index of the first final particle of event k, k = NumberOfEvents() gives the total number of particles
+    size_t EventOffset(int k) const { return m_EventOffsets[k]; }
+
+    /// Number of final particles in event k
+    size_t EventSize(int k) const { return m_EventOffsets[k + 1] - m_EventOffsets[k]; }
+
+    /// Weight of event k
+    double Weight(int k) const { return m_Weights[k]; }
+
+    /// Log of the weight of event k
+    double LogWeight(int k) const { return m_LogWeights[k]; }
+
+    /// Final particles of all events
+    const Particles& FinalParticles() const { return m_Particles; }
+
+    /// Decay photons and leptons of all events, if Config::StorePhotonsLeptons
+    const Particles& PhotonsLeptons() const { return m_PhotonsLeptons; }
+
+    /// Index of the first photon/lepton of event k
+    size_t PhotonsLeptonsOffset(int k) const { return m_PhotonsLeptonsOffsets[k]; }
+
+    /// Event k as a SimpleEvent. Only the stored information is restored, AllParticles and DecayMap are left empty.
+    SimpleEvent GetEvent(int k) const;
+
+    /// Approximate memory allocated by the chunk (in bytes)
+    size_t MemoryUsage() const;
+
+  private:
+    void AddParticles(Particles& out, const std::vector<SimpleParticle>& in, const SimpleEvent& evt, bool isFinal);
+
+    Config m_Config;
+    std::vector<double> m_Weights, m_LogWeights;
+    std::vector<size_t> m_EventOffsets, m_PhotonsLeptonsOffsets;
+    Particles m_Particles, m_PhotonsLeptons;
+  };
+
+} // namespace thermalfist
+
+#endif
@@ -12,6 +12,7 @@
 #include <sstream>
 
 #include "HRGEventGenerator/SimpleEvent.h"
+#include "HRGEventGenerator/EventChunk.h"
 #include "HRGEventGenerator/Acceptance.h"
 #include "HRGEventGenerator/RandomGenerators.h"
 #include "HRGBase/xMath.h"
@@ -93,7 +94,7 @@ namespace thermalfist {
   {
   public:
     /// Constructor
-    EventGeneratorBase() { m_THM = NULL; fCEAccepted = fCETotal = 0; }
+    EventGeneratorBase() : m_useOpenMP(false) { m_THM = NULL; fCEAccepted = fCETotal = 0; }
 
     /// Destructor
     virtual ~EventGeneratorBase();
@@ -150,6 +151,24 @@ namespace thermalfist {
      */
     virtual SimpleEvent SampleMomenta(const std::vector<int>& yields) const;
 
+    /**
+     * \brief Whether the momenta of the particles within an event are sampled in parallel.
+     *
+     * If enabled, the primordial particles are split into fixed blocks, each
+     * sampled with its own random number generator seeded from RandomGenerators::randgenMT,
+     * and the blocks are distributed among the OpenMP threads (if compiled with OpenMP).
+     * The generated events do not depend on the number of threads but differ from
+     * the ones generated with this option disabled.
+     * Only used if all the momentum generators support a separate random
+     * number generator, see RandomGenerators::ParticleMomentumGenerator::SupportsRandomGenerator().
+     * In this case the momenta are sampled with ParticleMomentumGenerator::GetMomentum(double, MTRand&),
+     * a custom generator overriding only GetMomentum(double) has to return false in SupportsRandomGenerator().
+     * Intended for very large events, disabled by default.
+     *
+     * \param openMP Whether to sample the momenta in parallel
+     */
+    void SetOMP(bool openMP) { m_useOpenMP = openMP; }
+
     /**
      * \brief Generates a single event.
      * 
@@ -162,6 +181,19 @@ namespace thermalfist {
      */
     virtual SimpleEvent GetEvent(bool PerformDecays = true) const;
 
+    /**
+     * \brief Generates a batch of events into a compact storage.
+     *
+     * The chunk is cleared first, its allocated memory is reused.
+     * Only one SimpleEvent exists at a time, thus generating a large sample
+     * chunk by chunk requires memory proportional to the chunk size only.
+     *
+     * \param chunk         The storage for the events, see EventChunk::Config for what is stored
+     * \param nevents       Number of events to generate
+     * \param PerformDecays Whether to perform the decays of unstable particles, see GetEvent()
+     */
+    void GenerateChunk(EventChunk& chunk, int nevents, bool PerformDecays = true) const;
+
     /**
      * \brief Performs decays of all unstable particles until only stable ones left.
      *
@@ -284,6 +316,17 @@ namespace thermalfist {
     /// Used if finite resonance widths are considered
     std::vector<RandomGenerators::ThermalBreitWignerGenerator*>  m_BWGens;
 
+    /**
+     * \brief Samples the mass and momentum of a primordial particle of species i
+     *
+     * If rangen is NULL, the global RandomGenerators::randgenMT is used, and the momentum is sampled with
+     * ParticleMomentumGenerator::GetMomentum(double), so that user-defined generators overriding only
+     * this method are honoured. Otherwise, ParticleMomentumGenerator::GetMomentum(double, MTRand&) is used.
+     */
+    SimpleParticle SamplePrimordialParticle(int i, MTRand* rangen = NULL) const;
+
+    bool m_useOpenMP;
+
   private:
 
     /// Currently not used
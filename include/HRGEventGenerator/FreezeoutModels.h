@@ -10,6 +10,7 @@
 
 //#include "HRGEventGenerator/RandomGenerators.h"
 #include <cmath>
+#include <vector>
 
 namespace thermalfist {
 
@@ -27,6 +28,14 @@ namespace thermalfist {
    */
   class BoostInvariantFreezeoutParametrization {
   public:
+    /// Transverse flow and hypersurface quantities at a given \zeta
+    struct ProfileValues {
+      double TanhEtaPerp;
+      double CoshEtaPerp;
+      double SinhEtaPerp;
+      double dRdZeta;
+      double dTaudZeta;
+    };
 
     BoostInvariantFreezeoutParametrization() : m_ProbabilityMaximumComputed(false), m_ProbabilityMaximum(1.) {}
     virtual ~BoostInvariantFreezeoutParametrization() {}
@@ -60,6 +69,14 @@ namespace thermalfist {
     virtual double coshetaperp(double zeta) const { return cosh(etaperp(zeta)); }
     virtual double tanhetaperp(double zeta) const { return sinhetaperp(zeta) / coshetaperp(zeta); }
 
+    /**
+     * \brief All the profile quantities at a given \zeta in a single call.
+     *
+     * Used by the Monte Carlo sampler for each sampled hadron.
+     * Derived classes can override it to share the common subexpressions.
+     */
+    virtual ProfileValues Profile(double zeta) const;
+
     /**
      * \brief Proportional to probability of having given \zeta value
      *
@@ -68,6 +85,13 @@ namespace thermalfist {
      */
     virtual double ZetaProbability(double zeta) const;// { return zeta; }
 
+    /**
+     * \brief Maximum of ZetaProbability(), used in the rejection sampling of \zeta.
+     *
+     * Computed on the first call, which is therefore not thread-safe.
+     * BoostInvariantMomentumGenerator calls it in the constructor whenever
+     * the rejection sampling is used.
+     */
     virtual double ProbabilityMaximum();
 
     /**
@@ -88,6 +112,28 @@ namespace thermalfist {
     */
     virtual double InverseZetaDistribution(double xi) const { return 0.; }
 
+    /**
+     * \brief Tabulates the cumulative distribution of \zeta for the inverse transform sampling.
+     *
+     * ZetaProbability() is evaluated on a uniform grid in \zeta and
+     * interpolated linearly between the nodes. The cumulative distribution
+     * of the interpolated density is inverted exactly.
+     *
+     * \param nodes Number of \zeta intervals
+     */
+    void TabulateZetaDistribution(int nodes = 1000);
+
+    /// Whether TabulateZetaDistribution() has been called
+    bool IsZetaDistributionTabulated() const { return !m_ZetaCDF.empty(); }
+
+    /**
+     * \brief Inverse of the tabulated \zeta distribution.
+     *
+     * \param xi Uniform random number in [0,1)
+     * \return   The corresponding \zeta value
+     */
+    double InverseZetaDistributionTabulated(double xi) const;
+
 
   protected:
     /**
@@ -108,6 +154,11 @@ namespace thermalfist {
 
     bool m_ProbabilityMaximumComputed;
     double m_ProbabilityMaximum;
+
+    // Density and cumulative distribution of \zeta at the nodes, and the index
+    // of the interval for each of the equal cumulative probability bins
+    std::vector<double> m_ZetaPDF, m_ZetaCDF;
+    std::vector<int> m_ZetaGuide;
   };
 
   /**
@@ -149,6 +200,8 @@ namespace thermalfist {
     virtual double coshetaperp(double zeta) const { return 1. / sqrt(1. - m_BetaS * m_BetaS * pow(zeta, 2. * m_n)); }
     virtual double tanhetaperp(double zeta) const { return m_BetaS * pow(zeta, m_n); }
 
+    virtual ProfileValues Profile(double zeta) const;
+
     virtual double ZetaProbability(double zeta) const;
 
   protected:
@@ -197,6 +250,8 @@ namespace thermalfist {
     virtual double sinhetaperp(double zeta) const { return zeta * m_RoverTauH; }
     virtual double coshetaperp(double zeta) const { return sqrt(1. + zeta * zeta * m_RoverTauH * m_RoverTauH); }
 
+    virtual ProfileValues Profile(double zeta) const;
+
     virtual double ZetaProbability(double zeta) const;
 
     //virtual double GetRandomZeta(MTRand& rangen = RandomGenerators::randgenMT);
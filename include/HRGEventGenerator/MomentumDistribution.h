@@ -44,7 +44,14 @@ namespace thermalfist {
     /// Transverse mass distribution
     virtual double dnmtdmt(double mt) const = 0;
 
-    /// 2D distribution density in rapidity and transverse momentum
+    /**
+     * \brief 2D distribution density in rapidity and transverse momentum.
+     *
+     * For a normalized distribution, see isNormalized(), it integrates to unity
+     * and its integral over rapidity equals \f$ p_T \f$ dnmtdmt().
+     * Otherwise the normalization is specific to the distribution
+     * and need not agree with the one of dndy() and dnmtdmt().
+     */
     virtual double d2ndptdy(double pt, double y) const = 0;
 
     /// Whether the distribution has been normalized to unity
@@ -193,10 +200,62 @@ namespace thermalfist {
 
     virtual double dnmtdmt(double mt) const;
 
+    /**
+     * \brief 2D distribution density in rapidity and transverse momentum.
+     *
+     * Without Normalize() the rapidity integral is
+     * \f$ 2 \cdot 2\eta_{\rm max} \, p_T \f$ dnmtdmt(): the factor 2 comes from the rapidity
+     * integral of a single fireball, \f$ 2\eta_{\rm max} \f$ from the space-time rapidities.
+     */
     virtual double d2ndptdy(double pt, double y) const;
 
     // Override functions end
 
+    /**
+     * \brief Transverse mass distribution at a set of points.
+     *
+     * Same as dnmtdmt(double) evaluated at each point.
+     * The freeze-out profile at the \f$ \zeta \f$ quadrature nodes is
+     * tabulated once on construction and shared by all the points.
+     *
+     * \param mts  Transverse mass values (in GeV)
+     * \return     The values of the distribution
+     */
+    std::vector<double> dnmtdmt(const std::vector<double>& mts) const;
+
+    /**
+     * \brief 2D distribution in rapidity and transverse momentum at a set of \f$ p_T \f$ points.
+     *
+     * Same as d2ndptdy(double, double) evaluated at each point. The
+     * Bessel functions depend only on \f$ p_T \f$ and \f$ \zeta \f$ and are
+     * evaluated once per point, not for every space-time rapidity node.
+     *
+     * \param pts  Transverse momentum values (in GeV)
+     * \param y    Rapidity
+     * \return     The values of the distribution
+     */
+    std::vector<double> d2ndptdy(const std::vector<double>& pts, double y) const;
+
+    /**
+     * \brief Transverse momentum spectra \f$ dN/dp_T \f$ of several species at a common set of points.
+     *
+     * Intended for the spectra fits where the spectra of many species
+     * are evaluated for each set of the freeze-out parameters.
+     * The \f$ I_0 \f$ and \f$ I_1 \f$ Bessel functions depend on the
+     * freeze-out profile and \f$ p_T \f$ but not on the mass, they are evaluated
+     * once for all the species with identical freeze-out profiles.
+     * The species can be distributed among the OpenMP threads (if compiled with OpenMP).
+     *
+     * \param distrs     The momentum distributions, NULL entries give empty spectra
+     * \param pts        Transverse momentum values (in GeV)
+     * \param useOpenMP  Whether to use OpenMP, off by default
+     * \return           The spectra, one vector per distribution
+     */
+    static std::vector< std::vector<double> > CalculatePtSpectra(
+      const std::vector<const BoostInvariantMomentumDistribution*>& distrs,
+      const std::vector<double>& pts,
+      bool useOpenMP = false);
+
   protected:
     virtual double ZetaIntegrandpTYSingleFireball(double zeta, double pt, double y) const;
     virtual double ZetaIntegrandpT(double zeta, double pt) const;
@@ -213,6 +272,22 @@ namespace thermalfist {
 
     virtual double dndpt(double pt, double y) const;
 
+    /// Freeze-out profile at a \f$ \zeta \f$ quadrature node
+    struct ProfileNode {
+      double WeightK;    ///< Quadrature weight times \f$ R \tau dR/d\zeta \f$
+      double WeightI;    ///< Quadrature weight times \f$ R \tau d\tau/d\zeta \f$
+      double CoshOverT;  ///< \f$ \cosh \eta_\perp / T \f$
+      double SinhOverT;  ///< \f$ \sinh \eta_\perp / T \f$
+    };
+
+    bool SameProfile(const BoostInvariantMomentumDistribution& other) const;
+
+    /// Bessel functions \f$ I_0(p_T \sinh \eta_\perp / T) \f$ and \f$ I_1 \f$, flat index ipt * nodes + inode
+    void TabulateBesselI(const std::vector<double>& pts, std::vector<double>& I0, std::vector<double>& I1) const;
+
+    /// Unnormalized \f$ dN/m_Tdm_T \f$ from the tabulated Bessel functions at the nodes
+    double dnmtdmtProfile(double mt, double pt, const double* I0, const double* I1) const;
+
     BoostInvariantFreezeoutParametrization* m_FreezeoutModel;
 
     double m_T;
@@ -222,6 +297,7 @@ namespace thermalfist {
     std::vector<double> m_xlegT, m_wlegT;
     std::vector<double> m_xlegY, m_wlegY;
     std::vector<double> m_xlegeta, m_wlegeta;
+    std::vector<ProfileNode> m_Profile;
 
     SplineFunction m_dndy, m_dndyint;
   };
@@ -13,6 +13,7 @@
 #include <map>
 
 #include "HRGEventGenerator/SimpleParticle.h"
+#include "HRGEventGenerator/RandomGenerators.h"
 
 namespace thermalfist {
 
@@ -57,9 +58,10 @@ namespace thermalfist {
      * \param m2  Mass of the first daughter particle
      * \param m3  Mass of the first daughter particle
      * \param fm12max The maximum of the \f$m_{12}\f$ probability density (precomputed with TernaryThreeBodym12Maximum())
+     * \param rangen  The random number generator to use
      * \return    The sampled value of \f$m_{12}\f$
      */
-    double GetRandomThreeBodym12(double M, double m1, double m2, double m3, double fm12max);
+    double GetRandomThreeBodym12(double M, double m1, double m2, double m3, double fm12max, MTRand& rangen = RandomGenerators::randgenMT);
 
     /**
      * \brief Lorentz boost of the 4-momentum of a particle
@@ -80,9 +82,10 @@ namespace thermalfist {
      * \param pdg1   Pdg code of the first daughter
      * \param m2     Mass of the second daughter (in GeV)
      * \param pdg2   Pdg code of the second daughter
+     * \param rangen The random number generator to use
      * \return std::vector<SimpleParticle> Two-component vector of decay products
      */
-    std::vector<SimpleParticle> TwoBodyDecay(const SimpleParticle & Mother, double m1, long long pdg1, double m2, long long pdg2);
+    std::vector<SimpleParticle> TwoBodyDecay(const SimpleParticle & Mother, double m1, long long pdg1, double m2, long long pdg2, MTRand& rangen = RandomGenerators::randgenMT);
     
     /**
      * \brief Samples the decay products of a many-body decay.
@@ -99,9 +102,33 @@ namespace thermalfist {
      * \param Mother The decaying particle
      * \param masses Masses of the decay products (in GeV)
      * \param pdgs   Pdg codes of the decay products
+     * \param rangen The random number generator to use
      * \return std::vector<SimpleParticle> 
      */
-    std::vector<SimpleParticle> ManyBodyDecay(const SimpleParticle & Mother, std::vector<double> masses, std::vector<long long> pdgs); // TODO: proper implementation for 4+ - body decays
+    std::vector<SimpleParticle> ManyBodyDecay(const SimpleParticle & Mother, const std::vector<double>& masses, const std::vector<long long>& pdgs, MTRand& rangen = RandomGenerators::randgenMT); // TODO: proper implementation for 4+ - body decays
+
+    /**
+     * \brief Samples the decay products of many particles decaying
+     *        through the same decay channel.
+     *
+     * The two- and three-body kinematics are evaluated for all the mothers at once,
+     * using structure-of-arrays loops that the compiler can vectorize.
+     * The random numbers are drawn beforehand, in a separate serial loop.
+     * (4+)-body decays are sampled with ManyBodyDecay() one mother at a time.
+     *
+     * The decay products of mother i occupy the range [i * N, (i + 1) * N) of the output,
+     * where N = out.size() / mothers.size() is the number of decay products per mother.
+     * For two- and three-body decays the products within this range follow the order of pdgs,
+     * a radiative decay (single listed daughter) yields the daughter followed by the photon.
+     * For (4+)-body decays the order within the range is random, see ShuffleDecayProducts().
+     *
+     * \param mothers The decaying particles
+     * \param masses  Masses of the decay products (in GeV)
+     * \param pdgs    Pdg codes of the decay products
+     * \param out     Output vector of the decay products. Its allocated memory is reused.
+     * \param rangen  The random number generator to use
+     */
+    void ManyBodyDecayBatch(const std::vector<SimpleParticle>& mothers, const std::vector<double>& masses, const std::vector<long long>& pdgs, std::vector<SimpleParticle>& out, MTRand& rangen = RandomGenerators::randgenMT);
 
 
     /**
@@ -112,8 +139,9 @@ namespace thermalfist {
      *
      * \param masses Masses of the decay products (in GeV)
      * \param pdgs   Pdg codes of the decay products
+     * \param rangen The random number generator to use
      */
-    void ShuffleDecayProducts(std::vector<double> &masses, std::vector<long long> &pdgs); // TODO: proper implementation for 4+ - body decays
+    void ShuffleDecayProducts(std::vector<double> &masses, std::vector<long long> &pdgs, MTRand& rangen = RandomGenerators::randgenMT); // TODO: proper implementation for 4+ - body decays
   }
 
 } // namespace thermalfist
@@ -108,6 +108,19 @@ namespace thermalfist {
       ///         and, additionally, the space-time Cartesian coordinates \f$r_0\f$, \f$r_x\f$, \f$r_y\f$, \f$r_z\f$
       ///         in the collision center-of-mass frame
       virtual std::vector<double> GetMomentum(double mass = -1.) const = 0;
+
+      /// Same as GetMomentum(double) but uses the provided random number generator.
+      /// The default implementation ignores rangen and calls GetMomentum(double),
+      /// see SupportsRandomGenerator()
+      virtual std::vector<double> GetMomentum(double mass, MTRand& /*rangen*/) const { return GetMomentum(mass); }
+
+      /// Whether GetMomentum(double, MTRand&) uses the provided random number generator.
+      /// If true, the momenta can be sampled concurrently from different threads,
+      /// each with its own generator.
+      /// A class derived from a generator returning true that overrides only GetMomentum(double)
+      /// must override this method to return false, otherwise its GetMomentum(double)
+      /// is bypassed by the parallel sampling in EventGeneratorBase::SampleMomenta()
+      virtual bool SupportsRandomGenerator() const { return false; }
     };
 
 
@@ -143,7 +156,7 @@ namespace thermalfist {
       *  \param mass Particle mass used for sampling.
       *              If a negative value is provided, the default (e.g. pole) mass is used.
       */
-      double GetP(double mass = -1.) const;
+      double GetP(double mass = -1., MTRand& rangen = RandomGenerators::randgenMT) const;
 
     private:
       /// Unnormalized probability density of x = exp(-p)
@@ -209,7 +222,11 @@ namespace thermalfist {
 
       // Override functions begin
 
-      virtual std::vector<double> GetMomentum(double mass = -1.) const;
+      virtual std::vector<double> GetMomentum(double mass = -1.) const { return GetMomentum(mass, RandomGenerators::randgenMT); }
+
+      virtual std::vector<double> GetMomentum(double mass, MTRand& rangen) const;
+
+      virtual bool SupportsRandomGenerator() const { return true; }
 
       // Override functions end
 
@@ -234,7 +251,7 @@ namespace thermalfist {
       /// Generates random momentum p from Siemens-Rasmussen distribution
       /// Initially x = exp(-p) is generated in [0,1] where p is given in GeV
       /// Then p is recovered as p = -log(x)
-      double GetRandom(double mass = -1.) const;
+      double GetRandom(double mass = -1., MTRand& rangen = RandomGenerators::randgenMT) const;
 
       double m_T;
       double m_Beta;
@@ -277,7 +294,11 @@ namespace thermalfist {
 
       // Override functions begin
 
-      virtual std::vector<double> GetMomentum(double mass = -1.) const;
+      virtual std::vector<double> GetMomentum(double mass = -1.) const { return GetMomentum(mass, RandomGenerators::randgenMT); }
+
+      virtual std::vector<double> GetMomentum(double mass, MTRand& rangen) const;
+
+      virtual bool SupportsRandomGenerator() const { return true; }
 
       // Override functions end
 
@@ -322,7 +343,11 @@ namespace thermalfist {
 
       // Override functions begin
 
-      virtual std::vector<double> GetMomentum(double mass = -1.) const;
+      virtual std::vector<double> GetMomentum(double mass = -1.) const { return GetMomentum(mass, RandomGenerators::randgenMT); }
+
+      virtual std::vector<double> GetMomentum(double mass, MTRand& rangen) const;
+
+      virtual bool SupportsRandomGenerator() const { return true; }
 
       // Override functions end
 
@@ -330,7 +355,9 @@ namespace thermalfist {
      /**
      * \brief Samples zeta for use in Monte Carlo event generator.
      *
-     * Uses rejection sampling.
+     * Uses the explicit inverse of the zeta distribution if available,
+     * otherwise the one tabulated on construction.
+     * Falls back to the rejection sampling if the distribution cannot be tabulated.
      *
      */
      virtual double GetRandomZeta(MTRand& rangen = RandomGenerators::randgenMT) const;
@@ -380,9 +407,10 @@ namespace thermalfist {
        *        relativistic Breit-Wigner distribution
        *        with a constant width
        * 
+       * \param rangen The random number generator
        * \return The sampled mass (in GeV)
        */
-      double GetRandom() const;
+      double GetRandom(MTRand& rangen = RandomGenerators::randgenMT) const;
 
     private:
       /// Unnormalized probability density of x
@@ -440,9 +468,10 @@ namespace thermalfist {
       /**
        * \brief Samples the mass.
        * 
+       * \param rangen The random number generator
        * \return double The sampled mass (in GeV)
        */
-      double GetRandom() const;
+      double GetRandom(MTRand& rangen = RandomGenerators::randgenMT) const;
 
     protected:
       /// Computes some auxiliary stuff needed for sampling
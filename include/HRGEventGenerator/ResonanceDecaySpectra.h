@@ -0,0 +1,186 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef RESONANCEDECAYSPECTRA_H
+#define RESONANCEDECAYSPECTRA_H
+
+#include <vector>
+#include <map>
+
+#include "HRGBase/ThermalParticleSystem.h"
+#include "HRGEventGenerator/MomentumDistribution.h"
+
+namespace thermalfist {
+
+  /**
+   * \brief Deterministic calculation of the momentum spectra
+   *        including the resonance decay feeddown.
+   *
+   * The primordial \f$ d^2N/dp_Tdy \f$ spectra of all species are tabulated
+   * on a uniform grid in \f$ p_T \f$ and \f$ y \f$ and normalized to the given yields,
+   * the normalization of the momentum distribution itself does not matter.
+   * The primordial spectra should thus fit into the grid. The decays are then
+   * performed along the decay chains of the particle list,
+   * each resonance after all of its mothers. Each decay channel is folded
+   * with the isotropic decay kinematics in the rest frame of the mother,
+   * evaluated by quadrature over the decay angles and, for decays into three
+   * or more particles, over the invariant mass of the other decay products
+   * weighted by the phase space.
+   *
+   * The decay kernels depend only on the mother and daughter masses and on the grid,
+   * and are cached. Since the daughter rapidity relative to the
+   * mother does not depend on the mother rapidity, a kernel
+   * is evaluated once per mother \f$ p_T \f$ bin.
+   *
+   * Resonances decay at their pole mass with the branching ratios
+   * from the particle list. Decay products outside the grid are lost,
+   * the grid should cover a somewhat larger range than the one of interest.
+   * A warning is printed if more than 0.1% of the decay products are lost.
+   *
+   * This gives the same spectra as the event generator with
+   * EventGeneratorBase::GetEvent() followed by histogramming,
+   * up to the discretization effects, without the statistical noise.
+   */
+  class ResonanceDecaySpectra
+  {
+  public:
+    /// Grid in \f$ p_T \f$ and \f$ y \f$
+    struct Grid {
+      int PtBins;     ///< Number of bins in \f$ p_T \f$
+      double PtMax;   ///< Upper limit in \f$ p_T \f$ (GeV), the lower limit is zero
+      int YBins;      ///< Number of bins in rapidity
+      double YMax;    ///< Rapidity range is [-YMax, YMax]
+      Grid() : PtBins(100), PtMax(3.), YBins(100), YMax(5.) { }
+    };
+
+    /// Number of quadrature points used for the decay kernels
+    struct Quadrature {
+      int CosThetaPoints;  ///< Polar angle of the daughter in the mother rest frame
+      int PhiPoints;       ///< Azimuthal angle of the daughter in the mother rest frame
+      int MassPoints;      ///< Invariant mass of the other decay products (three- and more body decays)
+      Quadrature() : CosThetaPoints(32), PhiPoints(16), MassPoints(12) { }
+    };
+
+    /**
+     * \brief Construct a new ResonanceDecaySpectra object
+     *
+     * \param TPS   The particle list with the decay channels
+     * \param grid  The grid in \f$ p_T \f$ and \f$ y \f$
+     * \param quad  Quadrature setup for the decay kernels
+     */
+    ResonanceDecaySpectra(ThermalParticleSystem *TPS, const Grid &grid = Grid(), const Quadrature &quad = Quadrature());
+
+    /**
+     * \brief Tabulates the primordial spectrum of a species.
+     *
+     * \param id      0-based index of the species in the particle list
+     * \param distr   Momentum distribution, its d2ndptdy() is evaluated at the bin centers
+     * \param yield   Mean primordial yield of the species, the tabulated spectrum is normalized to it
+     */
+    void SetPrimordialSpectrum(int id, const MomentumDistributionBase &distr, double yield);
+
+    /**
+     * \brief Tabulates the primordial spectra of all species.
+     *
+     * \param distrs  Momentum distributions of all species, NULL entries are skipped
+     * \param yields  Mean primordial yields of all species, the tabulated spectra are normalized to them
+     */
+    void SetPrimordialSpectra(const std::vector<MomentumDistributionBase*> &distrs, const std::vector<double> &yields);
+
+    /// Performs the resonance decays, see the class description
+    void CalculateFeeddown();
+
+    /// Whether CalculateFeeddown() was called after the last change of the primordial spectra
+    bool IsFeeddownCalculated() const { return m_FeeddownCalculated; }
+
+    /**
+     * \brief Spectrum \f$ d^2N/dp_Tdy \f$ of a species at grid point (ipt, iy).
+     *
+     * \param id        0-based index of the species
+     * \param ipt       Index of the \f$ p_T \f$ bin
+     * \param iy        Index of the rapidity bin
+     * \param feeddown  Whether to include the feeddown from resonance decays
+     */
+    double d2ndptdy(int id, int ipt, int iy, bool feeddown = true) const;
+
+    /// Spectrum \f$ dN/dp_T \f$ of a species integrated over the rapidity range of the grid
+    std::vector<double> dndpt(int id, bool feeddown = true) const;
+
+    /// Spectrum \f$ dN/dp_T \f$ of a species integrated over the rapidity interval [ymin, ymax], at the bin resolution
+    std::vector<double> dndpt(int id, double ymin, double ymax, bool feeddown = true) const;
+
+    /// Rapidity distribution \f$ dN/dy \f$ of a species integrated over the \f$ p_T \f$ range of the grid
+    std::vector<double> dndy(int id, bool feeddown = true) const;
+
+    /// Yield of a species within the grid
+    double Yield(int id, bool feeddown = true) const;
+
+    /// Centers of the \f$ p_T \f$ bins
+    std::vector<double> PtValues() const;
+
+    /// Centers of the rapidity bins
+    std::vector<double> YValues() const;
+
+    /// The grid
+    const Grid& GetGrid() const { return m_Grid; }
+
+    /// Number of distinct decay kernels evaluated so far
+    int NumberOfKernels() const { return static_cast<int>(m_Kernels.size()); }
+
+    /// Whether the calculations are distributed among the OpenMP threads (if compiled with OpenMP), off by default
+    void SetOMP(bool openMP) { m_useOpenMP = openMP; }
+
+  private:
+    /// Decay kernel: distribution of a daughter in pT and rapidity shift for each mother pT bin
+    struct DecayKernel {
+      bool Calculated;
+      double MotherMass;
+      double DaughterMass;
+      std::vector<double> OtherMasses;
+      std::vector<int> PtMin, PtMax, ShiftMin, ShiftMax;
+      std::vector< std::vector<double> > Weights;
+      DecayKernel() : Calculated(false), MotherMass(0.), DaughterMass(0.) { }
+    };
+
+    /// Contribution of a decay channel of a mother to a daughter species
+    struct DecayContribution {
+      int Mother;
+      int Daughter;
+      int Kernel;
+      double Weight;
+    };
+
+    void TabulateSpectrum(int id, const MomentumDistributionBase &distr, double yield);
+    int KernelIndex(double mass, double dmass, std::vector<double> others);
+    void CalculateKernel(DecayKernel &kernel) const;
+    /// Unstable species ordered along the decay chains, each one after all of its mothers
+    std::vector<int> DecayOrder() const;
+    void PrepareDecays();
+
+    ThermalParticleSystem *m_TPS;
+    Grid m_Grid;
+    Quadrature m_Quadrature;
+    double m_dPt, m_dY;
+
+    // Counts in each (pT, y) cell, flat index ipt * YBins + iy
+    std::vector< std::vector<double> > m_Primordial;
+    std::vector< std::vector<double> > m_Total;
+
+    // The decay contributions grouped by the mother, in the order given by DecayOrder()
+    std::vector< std::vector<DecayContribution> > m_Decays;
+    bool m_DecaysPrepared;
+
+    std::vector<DecayKernel> m_Kernels;
+    std::map< std::vector<double>, int > m_KernelMap;
+
+    bool m_FeeddownCalculated;
+    bool m_useOpenMP;
+  };
+
+} // namespace thermalfist
+
+#endif
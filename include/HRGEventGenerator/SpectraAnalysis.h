@@ -0,0 +1,293 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef SPECTRAANALYSIS_H
+#define SPECTRAANALYSIS_H
+
+#include <vector>
+#include <string>
+
+#include "HRGBase/ThermalParticleSystem.h"
+#include "HRGEventGenerator/SimpleEvent.h"
+#include "HRGEventGenerator/EventChunk.h"
+
+namespace thermalfist {
+
+  /**
+   * \brief Histogram with a fixed uniform binning, accumulated event-by-event.
+   *
+   * The entries of the current event are collected with Fill() and
+   * added to the event-averaged bin contents by FinishEvent().
+   * Only the bins filled in the current event are touched in FinishEvent(),
+   * the cost per event does not depend on the number of bins.
+   *
+   * Histograms with the same binning filled independently,
+   * e.g. in different threads, can be combined with Merge().
+   */
+  class SpectraHistogram1D
+  {
+  public:
+    /**
+     * \brief Construct a new histogram.
+     *
+     * \param xmin  Left edge of the first bin
+     * \param xmax  Right edge of the last bin
+     * \param bins  Number of bins
+     */
+    SpectraHistogram1D(double xmin = 0., double xmax = 1., int bins = 1);
+
+    /// Adds an entry to the current event. Entries outside the range are ignored.
+    void Fill(double x) { FillBin(Bin(x)); }
+
+    /// Completes the current event with a given weight
+    void FinishEvent(double weight = 1.);
+
+    /// Adds the contents of another histogram with the same binning, skipped otherwise
+    void Merge(const SpectraHistogram1D &other);
+
+    /// Whether another histogram has the same range and number of bins
+    bool SameBinning(const SpectraHistogram1D &other) const;
+
+    /// Clears all the contents, keeping the binning
+    void Reset();
+
+    /// Number of bins
+    int Bins() const { return m_Bins; }
+
+    /// Bin width
+    double BinWidth() const { return m_Step; }
+
+    /// Bin index for a given x, or -1 if outside the range
+    int Bin(double x) const;
+
+    /// Center of bin ind
+    double BinCenter(int ind) const { return m_XMin + (ind + 0.5) * m_Step; }
+
+    /// Number of completed events
+    long long Events() const { return m_Events; }
+
+    /// Event-averaged density of entries in bin ind, \f$ \langle dN/dx \rangle \f$
+    double Entry(int ind) const;
+
+    /// Statistical error of Entry()
+    double EntryError(int ind) const;
+
+    /// Bin centers
+    std::vector<double> GetXVector() const;
+
+    /// Event-averaged densities for all bins
+    std::vector<double> GetYVector() const;
+
+    /// Statistical errors for all bins
+    std::vector<double> GetYErrorVector() const;
+
+  protected:
+    friend class SpectraHistogram2D;
+
+    void FillBin(int ind);
+
+    double m_XMin;
+    double m_Step;
+    int m_Bins;
+
+    // Event-weighted sums of bin entries and squared bin entries
+    std::vector<double> m_Sum, m_Sum2;
+
+    // Entries of the current event and the list of bins filled in it
+    std::vector<int> m_EventCounts;
+    std::vector<int> m_EventBins;
+
+    double m_WeightSum, m_Weight2Sum;
+    long long m_Events;
+  };
+
+  /**
+   * \brief Two-dimensional analogue of SpectraHistogram1D.
+   *
+   * Bins are stored in a row-major order, the flat index is ix * BinsY() + iy.
+   * The bin centers are returned by GetXCenterVector() and GetYCenterVector(),
+   * the densities by GetZVector().
+   * The contents are kept in a one-dimensional histogram over the flat index,
+   * which is not exposed, so that a 2D histogram cannot be
+   * used, or merged, as a 1D one.
+   */
+  class SpectraHistogram2D
+  {
+  public:
+    SpectraHistogram2D(double xmin = 0., double xmax = 1., int binsx = 1,
+      double ymin = 0., double ymax = 1., int binsy = 1);
+
+    /// Adds an entry to the current event. Entries outside the range are ignored.
+    void Fill(double x, double y);
+
+    /// Completes the current event with a given weight
+    void FinishEvent(double weight = 1.) { m_Flat.FinishEvent(weight); }
+
+    /// Adds the contents of another histogram with the same binning, skipped otherwise
+    void Merge(const SpectraHistogram2D &other);
+
+    /// Whether another histogram has the same ranges and numbers of bins
+    bool SameBinning(const SpectraHistogram2D &other) const;
+
+    /// Clears all the contents, keeping the binning
+    void Reset() { m_Flat.Reset(); }
+
+    /// Total number of (flat) bins
+    int Bins() const { return m_BinsX * m_BinsY; }
+
+    /// Number of bins in x
+    int BinsX() const { return m_BinsX; }
+
+    /// Number of bins in y
+    int BinsY() const { return m_BinsY; }
+
+    /// Number of completed events
+    long long Events() const { return m_Flat.Events(); }
+
+    /// Event-averaged density of entries in (flat) bin ind, \f$ \langle d^2N/dxdy \rangle \f$
+    double Entry(int ind) const { return m_Flat.Entry(ind) / (m_StepX * m_StepY); }
+
+    /// Statistical error of Entry()
+    double EntryError(int ind) const { return m_Flat.EntryError(ind) / (m_StepX * m_StepY); }
+
+    /// Bin centers in x for all (flat) bins
+    std::vector<double> GetXCenterVector() const;
+
+    /// Bin centers in y for all (flat) bins
+    std::vector<double> GetYCenterVector() const;
+
+    /// Event-averaged densities for all (flat) bins
+    std::vector<double> GetZVector() const;
+
+    /// Statistical errors for all (flat) bins
+    std::vector<double> GetZErrorVector() const;
+
+  private:
+    // Contents over the flat index, with a unit bin width
+    SpectraHistogram1D m_Flat;
+
+    double m_XMin, m_StepX;
+    double m_YMin, m_StepY;
+    int m_BinsX, m_BinsY;
+  };
+
+  /**
+   * \brief Event-by-event analysis of the momentum spectra
+   *        and multiplicities of the particle species.
+   *
+   * For each analyzed species fills the \f$ dN/dp \f$, \f$ dN/dy \f$, \f$ dN/dm_T \f$,
+   * \f$ dN/dp_T \f$, and \f$ d^2N/dp_Tdy \f$ histograms
+   * and accumulates the moments of the multiplicity distribution and
+   * of the transverse momentum.
+   * The histograms are allocated in the constructor, together with
+   * a table of the analyzed PDG codes sorted for a binary search,
+   * which is the only lookup done per particle.
+   *
+   * An instance is not thread-safe. For a multi-threaded
+   * analysis each thread fills its own copy, the copies are
+   * then combined with Merge().
+   */
+  class SpectraAnalysis
+  {
+  public:
+    /// Binning of the histograms. Default values correspond to the GUI.
+    struct Binning {
+      int Bins;            ///< Number of bins in the 1D histograms
+      double PMax;         ///< Upper limit for p, in addition to the particle mass (GeV)
+      double YMax;         ///< Rapidity range is [-YMax, YMax]
+      double MtMax;        ///< Upper limit for mT - m (GeV)
+      double PtMax;        ///< Upper limit for pT, in addition to the particle mass (GeV)
+      int Bins2D;          ///< Number of bins in y and pT in the 2D histogram
+      double Pt2DMax;      ///< Upper limit for pT in the 2D histogram (GeV)
+      Binning() : Bins(500), PMax(2.), YMax(3.), MtMax(2.), PtMax(3.), Bins2D(40), Pt2DMax(2.) { }
+    };
+
+    /// Histograms and moments for a single particle species
+    struct Species {
+      long long PdgId;
+      double Mass;
+      SpectraHistogram1D dndp;
+      SpectraHistogram1D dndy;
+      SpectraHistogram1D dndmt;
+      SpectraHistogram1D dndpt;
+      SpectraHistogram2D d2ndptdy;
+
+      /// Event-weighted sums of \f$ N^k \f$, k = 1..4
+      double Moments[4];
+
+      /// Event-weighted sums of pT and pT^2 over all particles
+      double PtSum, Pt2Sum;
+
+      /// Multiplicity and pT sums in the current event
+      int EventCount;
+      double EventPtSum, EventPt2Sum;
+
+      Species(long long pdgid, double mass, const Binning &binning);
+    };
+
+    /**
+     * \brief Construct a new SpectraAnalysis object.
+     *
+     * \param TPS         The particle list. Only used in the constructor.
+     * \param binning     Binning of the histograms
+     * \param onlyStable  Analyze only the species marked stable in the list
+     */
+    SpectraAnalysis(const ThermalParticleSystem *TPS, const Binning &binning = Binning(), bool onlyStable = true);
+
+    /// Analyzes the final state particles of an event
+    void ProcessEvent(const SimpleEvent &evt);
+
+    /// Analyzes the final state particles of all the events in a chunk
+    void ProcessChunk(const EventChunk &chunk);
+
+    /**
+     * \brief Adds the results of another analysis of the same particle list.
+     *
+     * The other analysis must have the same species and binning,
+     * otherwise nothing is merged.
+     */
+    void Merge(const SpectraAnalysis &other);
+
+    /// Clears all the accumulated results
+    void Reset();
+
+    /// Number of analyzed species
+    int NumberOfSpecies() const { return static_cast<int>(m_Species.size()); }
+
+    /// 0-based index of the species with a given PDG code, -1 if not analyzed
+    int SpeciesIndex(long long pdgid) const;
+
+    /// Results for species ind
+    const Species& GetSpecies(int ind) const { return m_Species[ind]; }
+
+    /// Number of analyzed events
+    long long Events() const { return m_Events; }
+
+    /// Mean multiplicity of species ind
+    double MeanMultiplicity(int ind) const;
+
+    /// Scaled variance of the multiplicity distribution of species ind
+    double ScaledVariance(int ind) const;
+
+    /// Mean transverse momentum of species ind (GeV)
+    double MeanPt(int ind) const;
+
+  private:
+    void FillParticle(long long pdgid, double px, double py, double pz, double m);
+    void FinishEvent(double weight);
+
+    std::vector<Species> m_Species;
+    // Analyzed PDG codes in ascending order and the corresponding indices in m_Species
+    std::vector<long long> m_SortedPdgs;
+    std::vector<int> m_SortedSlots;
+    double m_WeightSum;
+    long long m_Events;
+  };
+
+} // namespace thermalfist
+
+#endif
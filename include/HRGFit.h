@@ -6,3 +6,4 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGFit/ThermalModelFit.h"
+#include "HRGFit/ThermalModelFitBatch.h"
@@ -318,6 +318,17 @@ namespace thermalfist {
     /// Sets the resonance width cut for freezeing the yields of long-lived resonances
     void SetPCEWidthCut(double WidthCut) { m_PCEWidthCut = WidthCut; }
 
+    //@{
+    /// Sets whether the analytic gradient of the \f$ \chi^2 \f$ function is provided to MINUIT.
+    /// The gradient is based on the derivatives of the densities computed by
+    /// ThermalModelBase::CalculateDensitiesDerivatives(), the parameter errors are then
+    /// evaluated from the finite differences of the gradient instead of MnHesse.
+    /// MnHesse is still used if the asymmetric errors are requested, MINOS relies on its covariance matrix.
+    /// Numerical derivatives are used if the analytic ones are not available for the present setup.
+    void UseAnalyticGradient(bool useGradient) { m_UseAnalyticGradient = useGradient; }
+    bool UseAnalyticGradient() const { return m_UseAnalyticGradient; }
+    //@}
+
     /// Returns a relative error of the data description (and its uncertainty estimate)
     std::pair< double, double > ModelDescriptionAccuracy() const;
 
@@ -355,6 +366,8 @@ namespace thermalfist {
     bool      m_SahaForNuclei;
     bool      m_PCEFreezeLongLived;
     double    m_PCEWidthCut;
+
+    bool      m_UseAnalyticGradient;
   };
 
 } // namespace thermalfist
@@ -0,0 +1,186 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef THERMALMODELFITBATCH_H
+#define THERMALMODELFITBATCH_H
+
+/**
+ * \file ThermalModelFitBatch.h
+ * \brief ThermalModelFitBatch class
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "HRGFit/ThermalModelFit.h"
+
+namespace thermalfist {
+
+  /**
+   * \brief A single data set (e.g. a centrality class) to be fitted by ThermalModelFitBatch.
+   */
+  struct FitDataset {
+    std::string name;                 ///< Label of the data set used in the output
+    std::vector<FittedQuantity> data; ///< The measurements to fit
+
+    FitDataset(const std::string& name_ = "", const std::vector<FittedQuantity>& data_ = std::vector<FittedQuantity>()) :
+      name(name_), data(data_) { }
+  };
+
+  /**
+   * \brief Class implementing thermal fits to multiple data sets.
+   *
+   * Performs a series of independent thermal fits, one for each
+   * data set provided through AddDataset(), within the same HRG model
+   * and the same particle list.
+   *
+   * The data sets are split into contiguous blocks which are
+   * distributed among the workers (OpenMP threads, if the library is compiled
+   * with OpenMP support). All workers share the particle list, each one
+   * operates on its own HRG model instance created by a user-provided factory function.
+   * Within a block the data sets are fitted in the order they were added.
+   * If the warm start is enabled (default), the fit to a data set starts from the fit result
+   * for the preceding one. The data sets should therefore be ordered
+   * such that the neighbouring ones are similar (e.g. adjacent centrality classes).
+   * With several workers, the first data set is fitted serially beforehand,
+   * the fits to the first data sets of all the other blocks start from its result.
+   * The remaining fits run concurrently.
+   *
+   * The results of all fits are collected in a single table, see PrintResultsTable().
+   */
+  class ThermalModelFitBatch
+  {
+  public:
+    /// A function creating a new HRG model instance for a given particle list.
+    /// All the model settings (ensemble, statistics, eigenvolumes, constraints, etc.)
+    /// should be applied here. The factory is called serially, once per worker, and
+    /// must apply the same list-wide settings (statistics, resonance widths) in each call
+    /// since the particle list is shared by all the workers.
+    typedef std::function<ThermalModelBase*(ThermalParticleSystem*)> ModelFactory;
+
+    /**
+     * \brief Construct a new ThermalModelFitBatch object
+     *
+     * \param TPS     Pointer to the particle list, shared by all the workers.
+     * \param factory Function creating the HRG model for a given particle list.
+     *                If empty, the ideal HRG model (ThermalModelIdeal) is used.
+     */
+    ThermalModelFitBatch(ThermalParticleSystem *TPS, const ModelFactory& factory = ModelFactory());
+
+    /// \brief Destroy the ThermalModelFitBatch object
+    ~ThermalModelFitBatch(void) { }
+
+    /// Sets the fit parameters (initial values, limits, and fit flags) shared by all the fits
+    void SetParameters(const ThermalModelFitParameters& params) { m_Parameters = params; }
+
+    /// Sets the fit parameter with a given name
+    void SetParameter(const std::string & name, double val, double err, double xmin, double xmax) { m_Parameters.SetParameter(name, val, err, xmin, xmax); }
+
+    /// Sets the (initial) value for the fit parameter with a given name
+    void SetParameterValue(const std::string & name, double value) { m_Parameters.SetParameterValue(name, value); }
+
+    /// Sets whether the fit parameter with a given name is fitted
+    void SetParameterFitFlag(const std::string & name, bool toFit) { m_Parameters.SetParameterFitFlag(name, toFit); }
+
+    /// The fit parameters shared by all the fits
+    const ThermalModelFitParameters& Parameters() const { return m_Parameters; }
+
+    /// Adds a data set to fit
+    void AddDataset(const std::string& name, const std::vector<FittedQuantity>& data) { m_Datasets.push_back(FitDataset(name, data)); }
+
+    /// Adds a data set to fit
+    void AddDataset(const FitDataset& dataset) { m_Datasets.push_back(dataset); }
+
+    /**
+     * \brief Adds a data set read from a file, see ThermalModelFit::loadExpDataFromFile()
+     *
+     * \param filename Path to the file with the data
+     * \param name     Label of the data set. If empty, the file name is used.
+     */
+    void AddDatasetFromFile(const std::string& filename, const std::string& name = "");
+
+    /// Removes all the data sets
+    void ClearDatasets() { m_Datasets.clear(); m_Results.clear(); }
+
+    /// The data sets to fit
+    const std::vector<FitDataset>& Datasets() const { return m_Datasets; }
+
+    //@{
+    /// The number of workers fitting the data sets concurrently.
+    /// By default equals the maximum number of OpenMP threads,
+    /// or 1 if the library is compiled without OpenMP.
+    void SetNumberOfWorkers(int workers) { m_Workers = workers; }
+    int NumberOfWorkers() const { return m_Workers; }
+    //@}
+
+    //@{
+    /// Whether the fit to each data set starts from the result
+    /// of the fit to the preceding data set, when available.
+    void UseWarmStart(bool warmStart) { m_WarmStart = warmStart; }
+    bool UseWarmStart() const { return m_WarmStart; }
+    //@}
+
+    //@{
+    /// Options passed to each ThermalModelFit,
+    /// see the corresponding methods of ThermalModelFit
+    void FixVcOverV(bool fix) { m_FixVcToV = fix; }
+    bool FixVcOverV() const { return m_FixVcToV; }
+    void SetVcOverV(double VcOverV) { m_VcOverV = VcOverV; }
+    double VcOverV() const { return m_VcOverV; }
+    void UseTkin(bool YieldsAtTkin) { m_YieldsAtTkin = YieldsAtTkin; }
+    bool UseTkin() const { return m_YieldsAtTkin; }
+    void UseAnalyticGradient(bool useGradient) { m_UseAnalyticGradient = useGradient; }
+    bool UseAnalyticGradient() const { return m_UseAnalyticGradient; }
+    //@}
+
+    /**
+     * \brief Performs the fits to all the data sets.
+     *
+     * \param verbose If true, a short summary of each fit is printed once it is finished
+     * \return The fit results, in the same order as the data sets
+     */
+    const std::vector<ThermalModelFitParameters>& PerformFits(bool verbose = true);
+
+    /// The fit results from the last call to PerformFits(), in the same order as the data sets
+    const std::vector<ThermalModelFitParameters>& Results() const { return m_Results; }
+
+    /**
+     * \brief Writes the results of all the fits into a single table.
+     *
+     * Each line corresponds to one data set and lists the \f$ \chi^2 \f$,
+     * the number of degrees of freedom,
+     * as well as the values and errors of all the parameters fitted in at least one of the data sets.
+     *
+     * \param filename Output file name. If empty, the table is printed to stdout.
+     */
+    void PrintResultsTable(const std::string& filename = "") const;
+
+  private:
+    /// Applies the fit options to a fitter
+    void ConfigureFitter(ThermalModelFit& fitter) const;
+
+    /// Fits data set ids, warm-started from the result for data set iprev (if iprev >= 0)
+    void PerformSingleFit(ThermalModelFit& fitter, int ids, int iprev, bool verbose);
+
+    ThermalParticleSystem *m_TPS;
+    ModelFactory m_Factory;
+    ThermalModelFitParameters m_Parameters;
+    std::vector<FitDataset> m_Datasets;
+    std::vector<ThermalModelFitParameters> m_Results;
+    int       m_Workers;
+    bool      m_WarmStart;
+    bool      m_FixVcToV;
+    double    m_VcOverV;
+    bool      m_YieldsAtTkin;
+    bool      m_UseAnalyticGradient;
+  };
+
+} // namespace thermalfist
+
+#endif
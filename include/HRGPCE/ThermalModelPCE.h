@@ -235,6 +235,10 @@ namespace thermalfist {
       int m_Mode;
     };
 
+    /// Broyden's solver kept between the calculations,
+    /// reuses the Jacobian if ThermalModelBase::SolverJacobianReuse() is set for the HRG model
+    Broyden m_Broyden;
+
   };
 
 } // namespace thermalfist
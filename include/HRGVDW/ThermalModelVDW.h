@@ -49,6 +49,9 @@ namespace thermalfist {
      * 
      */
     virtual ~ThermalModelVDW(void);
+
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelVDW* Clone() const;
     
     /**
      * \brief Same as FillVirial() but uses the matrix of excluded-volume
@@ -66,7 +69,7 @@ namespace thermalfist {
      * \param j    0-based index of the second particle species
      * \param dbdT \f$ d \tilde{b}_{ij} / dT \f$ in the units of fm\f$^3\f$ GeV\f$^{-1}\f$
      */
-    void SetVirialdT(int i, int j, double dbdT) { if (i >= 0 && i < static_cast<int>(m_VirialdT.size()) && j >= 0 && j < static_cast<int>(m_VirialdT[i].size())) m_VirialdT[i][j] = dbdT; }
+    void SetVirialdT(int i, int j, double dbdT) { if (i >= 0 && i < static_cast<int>(m_VirialdT.size()) && j >= 0 && j < static_cast<int>(m_VirialdT[i].size())) m_VirialdT[i][j] = dbdT; ResetCalculatedFlags(); }
     
     /**
      * \brief Set the temperature derivative
@@ -76,7 +79,7 @@ namespace thermalfist {
      * \param j    0-based index of the second particle species
      * \param dadT \f$ d a_{ij} / dT \f$ in the units of fm\f$^3\f$
      */
-    void SetAttractiondT(int i, int j, double dadT) { if (i >= 0 && i < static_cast<int>(m_AttrdT.size()) && j >= 0 && j < static_cast<int>(m_AttrdT[i].size()))     m_AttrdT[i][j] = dadT; }
+    void SetAttractiondT(int i, int j, double dadT) { if (i >= 0 && i < static_cast<int>(m_AttrdT.size()) && j >= 0 && j < static_cast<int>(m_AttrdT[i].size()))     m_AttrdT[i][j] = dadT; ResetCalculatedFlags(); }
 
     /**
      * \brief The temperature derivative
@@ -161,9 +164,9 @@ namespace thermalfist {
 
     virtual void WriteInteractionParameters(const std::string &filename);
 
-    void SetVirial(int i, int j, double b) { if (i >= 0 && i < static_cast<int>(m_Virial.size()) && j >= 0 && j < static_cast<int>(m_Virial[i].size())) m_Virial[i][j] = b; }
+    void SetVirial(int i, int j, double b) { if (i >= 0 && i < static_cast<int>(m_Virial.size()) && j >= 0 && j < static_cast<int>(m_Virial[i].size())) m_Virial[i][j] = b; ResetCalculatedFlags(); }
     
-    void SetAttraction(int i, int j, double a) { if (i >= 0 && i < static_cast<int>(m_Attr.size()) && j >= 0 && j < static_cast<int>(m_Attr[i].size()))     m_Attr[i][j] = a; }
+    void SetAttraction(int i, int j, double a) { if (i >= 0 && i < static_cast<int>(m_Attr.size()) && j >= 0 && j < static_cast<int>(m_Attr[i].size()))     m_Attr[i][j] = a; ResetCalculatedFlags(); }
 
     double VirialCoefficient(int i, int j) const;
 
@@ -250,6 +253,12 @@ namespace thermalfist {
      */
     virtual double MuShift(int id) const;
 
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     /// Vector of ideal gas densities with shifted chemical potentials
     std::vector<double> m_DensitiesId;
 
@@ -289,6 +298,9 @@ namespace thermalfist {
 
     std::vector< std::vector<int> > m_dMuStarIndices;
 
+    /// Broyden's solver kept between the calculations, see SetSolverJacobianReuse()
+    Broyden m_Broyden;
+
   private:
     std::vector< std::vector<double> > m_chi;
 
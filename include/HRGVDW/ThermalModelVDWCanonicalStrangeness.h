@@ -49,6 +49,9 @@ namespace thermalfist {
      * 
      */
     virtual ~ThermalModelVDWCanonicalStrangeness(void);
+
+    /// \copydoc thermalfist::ThermalModelBase::Clone()
+    virtual ThermalModelVDWCanonicalStrangeness* Clone() const;
     
     /// \copydoc thermalfist::ThermalModelVDW::FillVirialEV()
     void FillVirialEV(const std::vector< std::vector<double> > & bij = std::vector< std::vector<double> >(0));
@@ -113,6 +116,12 @@ namespace thermalfist {
     /// \copydoc thermalfist::ThermalModelVDW::MuShift()
     virtual double MuShift(int id) const;
 
+    /// \copydoc thermalfist::ThermalModelBase::WriteState()
+    virtual void WriteState(ThermalModelState &state) const;
+
+    /// \copydoc thermalfist::ThermalModelBase::ReadState()
+    virtual void ReadState(const ThermalModelState &state);
+
     ThermalModelVDWFull *m_modelVDW; /**< Pointer to the QvdW model in the GCE with non-strange particles only */
     std::vector< std::vector<double> > m_Virial; /**Matrix of the excluded volume coefficients \f$ \tilde{b}_{ij} \f$ */
     std::vector< std::vector<double> > m_Attr;   /**Matrix of the attractive QvdW coefficients \f$ a_{ij} \f$ */
@@ -0,0 +1,507 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <map>
+#include <algorithm>
+
+#include "HRGBase.h"
+#include "HRGEV.h"
+#include "HRGVDW.h"
+#include "HRGPCE.h"
+#include "HRGFit.h"
+#include "HRGEventGenerator.h"
+
+#include "ThermalFISTConfig.h"
+
+using namespace std;
+
+#ifdef ThermalFIST_USENAMESPACE
+using namespace thermalfist;
+#endif
+
+// The particle list used by all the benchmarks
+const string ListFile = "/list/PDG2020/list-withnuclei.dat";
+
+// A single benchmark: the set up is not timed, each call of Run() is
+class BenchmarkCase
+{
+public:
+	BenchmarkCase(const string &name) : m_Name(name) { }
+	virtual ~BenchmarkCase() { }
+	const string& Name() const { return m_Name; }
+	virtual void SetUp(ThermalParticleSystem *TPS) = 0;
+	// Performs one iteration, returns a quantity which should not change with optimizations
+	virtual double Run(int iteration) = 0;
+	virtual void TearDown() { }
+private:
+	string m_Name;
+};
+
+// Chemical freeze-out conditions for all model benchmarks,
+// the temperature is varied slightly between the iterations
+void SetFreezeoutConditions(ThermalModelBase *model, int iteration)
+{
+	model->SetTemperature(0.155 + 1.e-4 * (iteration % 10));
+	model->SetBaryonChemicalPotential(0.030);
+	model->SetVolumeRadius(8.);
+	model->SetQoverB(0.4);
+	model->ConstrainMuS(false);
+	model->ConstrainMuQ(false);
+	model->ConstrainMuC(false);
+}
+
+// Calculations within a given thermal model
+class ModelBenchmark : public BenchmarkCase
+{
+public:
+	enum ModelType { Ideal, Canonical, StrangenessCanonical, EVDiagonal, QvdW };
+	enum Calculation { PrimordialDensities, Densities, Fluctuations };
+
+	ModelBenchmark(const string &name, ModelType type, Calculation calc,
+		ThermalParticle::ResonanceWidthIntegration width = ThermalParticle::ZeroWidth, bool quantum = false) :
+		BenchmarkCase(name), m_Type(type), m_Calc(calc), m_Width(width), m_Quantum(quantum), m_Model(NULL) { }
+
+	void SetUp(ThermalParticleSystem *TPS)
+	{
+		if (m_Type == Ideal)
+			m_Model = new ThermalModelIdeal(TPS);
+		else if (m_Type == Canonical)
+			m_Model = new ThermalModelCanonical(TPS);
+		else if (m_Type == StrangenessCanonical)
+			m_Model = new ThermalModelCanonicalStrangeness(TPS);
+		else if (m_Type == EVDiagonal) {
+			ThermalModelEVDiagonal *modelEV = new ThermalModelEVDiagonal(TPS);
+			modelEV->SetRadius(0.3);
+			m_Model = modelEV;
+		}
+		else {
+			// QvdW interactions between baryons and between antibaryons
+			ThermalModelVDW *modelVDW = new ThermalModelVDW(TPS);
+			for (int i = 0; i < TPS->ComponentsNumber(); ++i) {
+				for (int j = 0; j < TPS->ComponentsNumber(); ++j) {
+					int B1 = TPS->Particle(i).BaryonCharge();
+					int B2 = TPS->Particle(j).BaryonCharge();
+					if ((B1 > 0 && B2 > 0) || (B1 < 0 && B2 < 0)) {
+						modelVDW->SetAttraction(i, j, 0.329);
+						modelVDW->SetVirial(i, j, 3.42);
+					}
+				}
+			}
+			m_Model = modelVDW;
+		}
+		m_Model->SetUseWidth(m_Width);
+		m_Model->SetStatistics(m_Quantum);
+		m_Model->SetOMP(false);
+	}
+
+	double Run(int iteration)
+	{
+		SetFreezeoutConditions(m_Model, iteration);
+		if (m_Calc == PrimordialDensities) {
+			m_Model->CalculatePrimordialDensities();
+			return m_Model->Pressure() + m_Model->EnergyDensity();
+		}
+		else if (m_Calc == Densities) {
+			m_Model->CalculateDensities();
+			return m_Model->Pressure() + m_Model->GetDensity(211, Feeddown::StabilityFlag);
+		}
+		m_Model->CalculateDensities();
+		m_Model->CalculateFluctuations();
+		return m_Model->Susc(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+	}
+
+	void TearDown()
+	{
+		delete m_Model;
+		m_Model = NULL;
+	}
+
+private:
+	ModelType m_Type;
+	Calculation m_Calc;
+	ThermalParticle::ResonanceWidthIntegration m_Width;
+	bool m_Quantum;
+	ThermalModelBase *m_Model;
+};
+
+// Partial chemical equilibrium from the chemical freeze-out down to T = 100 MeV
+class PCEBenchmark : public BenchmarkCase
+{
+public:
+	PCEBenchmark(const string &name) : BenchmarkCase(name), m_Model(NULL), m_PCE(NULL) { }
+
+	void SetUp(ThermalParticleSystem *TPS)
+	{
+		m_Model = new ThermalModelIdeal(TPS);
+		m_PCE = new ThermalModelPCE(m_Model);
+		m_PCE->FreezeLonglivedResonances(false);
+	}
+
+	double Run(int iteration)
+	{
+		ThermalModelParameters params;
+		params.T = 0.155 + 1.e-4 * (iteration % 10);
+		params.muB = 0.;
+		params.V = 4700.;
+		m_Model->SetParameters(params);
+		m_Model->FillChemicalPotentials();
+		m_PCE->SetChemicalFreezeout(params);
+		for (double T = params.T; T >= 0.100 - 1.e-9; T -= 0.005)
+			m_PCE->CalculatePCE(T);
+		return m_PCE->ThermalModel()->Volume();
+	}
+
+	void TearDown()
+	{
+		delete m_PCE;
+		delete m_Model;
+		m_PCE = NULL;
+		m_Model = NULL;
+	}
+
+private:
+	ThermalModelIdeal *m_Model;
+	ThermalModelPCE *m_PCE;
+};
+
+// Thermal fit of the ALICE 0-10% Pb-Pb 2.76 TeV yields, T and R fitted, muB = 0
+class FitBenchmark : public BenchmarkCase
+{
+public:
+	FitBenchmark(const string &name) : BenchmarkCase(name), m_Model(NULL) { }
+
+	void SetUp(ThermalParticleSystem *TPS)
+	{
+		m_Model = new ThermalModelIdeal(TPS);
+		m_Model->SetUseWidth(ThermalParticle::BWTwoGamma);
+		m_Model->SetOMP(false);
+		m_Quantities = ThermalModelFit::loadExpDataFromFile(string(ThermalFIST_INPUT_FOLDER) + "/data/ALICE-PbPb2.76TeV-0-10-all.dat");
+	}
+
+	double Run(int iteration)
+	{
+		ThermalModelFit fitter(m_Model);
+		fitter.SetQuantities(m_Quantities);
+		fitter.SetParameter("T", 0.150 + 1.e-3 * (iteration % 10), 0.020, 0.100, 0.180);
+		fitter.SetParameter("R", 10., 2., 0., 25.);
+		fitter.SetParameterFitFlag("muB", false);
+		fitter.SetParameterValue("muB", 0.);
+		ThermalModelFitParameters result = fitter.PerformFit(false);
+		return result.chi2;
+	}
+
+	void TearDown()
+	{
+		delete m_Model;
+		m_Model = NULL;
+	}
+
+private:
+	ThermalModelIdeal *m_Model;
+	vector<FittedQuantity> m_Quantities;
+};
+
+// Blast-wave event generation with resonance decays, several events per iteration
+class EventGeneratorBenchmark : public BenchmarkCase
+{
+public:
+	EventGeneratorBenchmark(const string &name, int events) : BenchmarkCase(name), m_Events(events), m_Generator(NULL) { }
+
+	void SetUp(ThermalParticleSystem *TPS)
+	{
+		EventGeneratorConfiguration config;
+		config.fEnsemble = EventGeneratorConfiguration::GCE;
+		config.fModelType = EventGeneratorConfiguration::PointParticle;
+		config.CFOParameters.T = 0.155;
+		config.CFOParameters.muB = 0.;
+		config.CFOParameters.V = 1000.;
+		m_Generator = new CylindricalBlastWaveEventGenerator(TPS, config, 0.120, 0.6, 0.5);
+		RandomGenerators::SetSeed(1);
+	}
+
+	double Run(int /*iteration*/)
+	{
+		double ret = 0.;
+		for (int i = 0; i < m_Events; ++i)
+			ret += m_Generator->GetEvent(true).Particles.size();
+		return ret / m_Events;
+	}
+
+	void TearDown()
+	{
+		delete m_Generator;
+		m_Generator = NULL;
+	}
+
+private:
+	int m_Events;
+	CylindricalBlastWaveEventGenerator *m_Generator;
+};
+
+struct BenchmarkResult
+{
+	string Name;
+	int Iterations;
+	double MeanTime, MinTime, StdDevTime; // in ms
+	double Checksum;
+};
+
+BenchmarkResult RunBenchmark(BenchmarkCase *bench, ThermalParticleSystem *TPS, double minTime, int minIterations)
+{
+	BenchmarkResult ret;
+	ret.Name = bench->Name();
+
+	bench->SetUp(TPS);
+
+	// Warm-up
+	ret.Checksum = bench->Run(0);
+
+	vector<double> times;
+	double total = 0.;
+	int iteration = 0;
+	while (iteration < minIterations || total < minTime) {
+		double wt1 = get_wall_time();
+		bench->Run(iteration);
+		double wt2 = get_wall_time();
+		times.push_back(wt2 - wt1);
+		total += wt2 - wt1;
+		iteration++;
+	}
+
+	bench->TearDown();
+
+	ret.Iterations = iteration;
+	ret.MeanTime = total / iteration;
+	ret.MinTime = *min_element(times.begin(), times.end());
+	double var = 0.;
+	for (size_t i = 0; i < times.size(); ++i)
+		var += (times[i] - ret.MeanTime) * (times[i] - ret.MeanTime);
+	ret.StdDevTime = (iteration > 1) ? sqrt(var / (iteration - 1)) : 0.;
+
+	ret.MeanTime *= 1.e3;
+	ret.MinTime *= 1.e3;
+	ret.StdDevTime *= 1.e3;
+	return ret;
+}
+
+void WriteJSON(const string &filename, const vector<BenchmarkResult> &results)
+{
+	FILE *f = fopen(filename.c_str(), "w");
+	if (f == NULL) {
+		printf("**ERROR** Cannot write to %s\n", filename.c_str());
+		return;
+	}
+
+	char date[64];
+	time_t now = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	int openmp = 0;
+#ifdef USE_OPENMP
+	openmp = 1;
+#endif
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"context\": {\n");
+	fprintf(f, "    \"date\": \"%s\",\n", date);
+	fprintf(f, "    \"library_version\": \"%d.%d.%d\",\n", ThermalFIST_VERSION_MAJOR, ThermalFIST_VERSION_MINOR, ThermalFIST_VERSION_DEVEL);
+	fprintf(f, "    \"particle_list\": \"%s\",\n", ListFile.c_str());
+	fprintf(f, "    \"openmp\": %s\n", openmp ? "true" : "false");
+	fprintf(f, "  },\n");
+	fprintf(f, "  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		fprintf(f, "    {\n");
+		fprintf(f, "      \"name\": \"%s\",\n", results[i].Name.c_str());
+		fprintf(f, "      \"iterations\": %d,\n", results[i].Iterations);
+		fprintf(f, "      \"real_time\": %.6E,\n", results[i].MeanTime);
+		fprintf(f, "      \"min_time\": %.6E,\n", results[i].MinTime);
+		fprintf(f, "      \"stddev_time\": %.6E,\n", results[i].StdDevTime);
+		fprintf(f, "      \"time_unit\": \"ms\",\n");
+		fprintf(f, "      \"checksum\": %.15E\n", results[i].Checksum);
+		fprintf(f, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(f, "  ]\n");
+	fprintf(f, "}\n");
+	fclose(f);
+}
+
+// Reads the name, real_time and checksum entries of a JSON file written by WriteJSON()
+map<string, BenchmarkResult> ReadJSON(const string &filename)
+{
+	map<string, BenchmarkResult> ret;
+	ifstream fin(filename.c_str());
+	if (!fin.is_open()) {
+		printf("**ERROR** Cannot read %s\n", filename.c_str());
+		return ret;
+	}
+	stringstream ss;
+	ss << fin.rdbuf();
+	string content = ss.str();
+
+	size_t pos = 0;
+	while ((pos = content.find("\"name\": \"", pos)) != string::npos) {
+		pos += 9;
+		size_t end = content.find("\"", pos);
+		BenchmarkResult res;
+		res.Name = content.substr(pos, end - pos);
+		size_t tpos = content.find("\"real_time\": ", end);
+		size_t cpos = content.find("\"checksum\": ", end);
+		if (tpos == string::npos || cpos == string::npos)
+			break;
+		res.MeanTime = atof(content.c_str() + tpos + 13);
+		res.Checksum = atof(content.c_str() + cpos + 12);
+		ret[res.Name] = res;
+		pos = end;
+	}
+	return ret;
+}
+
+// Compares the results with a baseline, returns the number of regressions
+// A benchmark is a regression if it is slower by more than threshold, or if its checksum
+// differs from the baseline by more than checksumTolerance (relative)
+int CompareWithBaseline(const vector<BenchmarkResult> &results, const string &filename, double threshold, double checksumTolerance)
+{
+	map<string, BenchmarkResult> baseline = ReadJSON(filename);
+
+	printf("\nComparison with %s\n", filename.c_str());
+	printf("%-45s%15s%15s%12s%20s\n", "benchmark", "base[ms]", "new[ms]", "new/base", "checksum rel. diff.");
+
+	int regressions = 0;
+	for (size_t i = 0; i < results.size(); ++i) {
+		map<string, BenchmarkResult>::const_iterator it = baseline.find(results[i].Name);
+		if (it == baseline.end()) {
+			printf("%-45s%15s\n", results[i].Name.c_str(), "n/a");
+			continue;
+		}
+		double ratio = results[i].MeanTime / it->second.MeanTime;
+		double diff = fabs(results[i].Checksum - it->second.Checksum);
+		if (it->second.Checksum != 0.)
+			diff /= fabs(it->second.Checksum);
+		string flag = "";
+		if (ratio > 1. + threshold)
+			flag += "  SLOWER";
+		if (!(diff <= checksumTolerance))
+			flag += "  CHECKSUM";
+		if (flag != "")
+			regressions++;
+		printf("%-45s%15.4lf%15.4lf%12.3lf%20E%s\n", results[i].Name.c_str(), it->second.MeanTime, results[i].MeanTime, ratio, diff, flag.c_str());
+	}
+	return regressions;
+}
+
+// Timing of the main computational paths of the library
+// Usage: LibraryBenchmarks [--filter=<substring>] [--min_time=<seconds>] [--out=<file.json>] [--compare=<baseline.json>] [--threshold=<fraction>] [--checksum_tolerance=<value>]
+int main(int argc, char *argv[])
+{
+	string filter = "";
+	double minTime = 0.5;
+	int minIterations = 3;
+	string outfile = "";
+	string baseline = "";
+	double threshold = 0.1;
+	double checksumTolerance = 1.e-6;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strncmp(argv[i], "--filter=", 9) == 0)
+			filter = argv[i] + 9;
+		else if (strncmp(argv[i], "--min_time=", 11) == 0)
+			minTime = atof(argv[i] + 11);
+		else if (strncmp(argv[i], "--out=", 6) == 0)
+			outfile = argv[i] + 6;
+		else if (strncmp(argv[i], "--compare=", 10) == 0)
+			baseline = argv[i] + 10;
+		else if (strncmp(argv[i], "--threshold=", 12) == 0)
+			threshold = atof(argv[i] + 12);
+		else if (strncmp(argv[i], "--checksum_tolerance=", 21) == 0)
+			checksumTolerance = atof(argv[i] + 21);
+		else {
+			printf("Usage: %s [--filter=<substring>] [--min_time=<seconds>] [--out=<file.json>] [--compare=<baseline.json>] [--threshold=<fraction>] [--checksum_tolerance=<value>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	vector<BenchmarkCase*> benchmarks;
+	benchmarks.push_back(new ModelBenchmark("Ideal/PrimordialDensities/ZeroWidth", ModelBenchmark::Ideal, ModelBenchmark::PrimordialDensities));
+	benchmarks.push_back(new ModelBenchmark("Ideal/PrimordialDensities/eBW", ModelBenchmark::Ideal, ModelBenchmark::PrimordialDensities, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("Ideal/PrimordialDensities/eBW/Quantum", ModelBenchmark::Ideal, ModelBenchmark::PrimordialDensities, ThermalParticle::eBW, true));
+	benchmarks.push_back(new ModelBenchmark("GCE/CalculateDensities", ModelBenchmark::Ideal, ModelBenchmark::Densities, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("CE/CalculateDensities", ModelBenchmark::Canonical, ModelBenchmark::Densities));
+	benchmarks.push_back(new ModelBenchmark("SCE/CalculateDensities", ModelBenchmark::StrangenessCanonical, ModelBenchmark::Densities, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("EV/CalculateDensities", ModelBenchmark::EVDiagonal, ModelBenchmark::Densities, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("QvdW/CalculateDensities", ModelBenchmark::QvdW, ModelBenchmark::Densities, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("GCE/CalculateFluctuations", ModelBenchmark::Ideal, ModelBenchmark::Fluctuations, ThermalParticle::eBW));
+	benchmarks.push_back(new ModelBenchmark("CE/CalculateFluctuations", ModelBenchmark::Canonical, ModelBenchmark::Fluctuations));
+	benchmarks.push_back(new ModelBenchmark("QvdW/CalculateFluctuations", ModelBenchmark::QvdW, ModelBenchmark::Fluctuations, ThermalParticle::eBW));
+	benchmarks.push_back(new PCEBenchmark("PCE/Trajectory"));
+	benchmarks.push_back(new FitBenchmark("Fit/PerformFit/ALICE-PbPb2.76TeV-0-10"));
+	benchmarks.push_back(new EventGeneratorBenchmark("EventGenerator/BlastWave/GetEventWithDecays", 10));
+
+	ThermalParticleSystem TPS(string(ThermalFIST_INPUT_FOLDER) + ListFile);
+
+	printf("%-45s%12s%15s%15s%15s\n", "benchmark", "iterations", "mean[ms]", "min[ms]", "stddev[ms]");
+
+	vector<BenchmarkResult> results;
+	for (size_t i = 0; i < benchmarks.size(); ++i) {
+		if (benchmarks[i]->Name().find(filter) != string::npos) {
+			BenchmarkResult res = RunBenchmark(benchmarks[i], &TPS, minTime, minIterations);
+			printf("%-45s%12d%15.4lf%15.4lf%15.4lf\n", res.Name.c_str(), res.Iterations, res.MeanTime, res.MinTime, res.StdDevTime);
+			fflush(stdout);
+			results.push_back(res);
+		}
+		delete benchmarks[i];
+	}
+
+	if (outfile != "")
+		WriteJSON(outfile, results);
+
+	if (baseline != "") {
+		int regressions = CompareWithBaseline(results, baseline, threshold, checksumTolerance);
+		if (regressions > 0) {
+			printf("\n%d benchmark(s) slower than the baseline by more than %.1lf%% or with a checksum differing by more than %.1E\n", regressions, 100. * threshold, checksumTolerance);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * \example LibraryBenchmarks.cpp
+ *
+ * Timing of the main computational paths of the library, used to track
+ * the performance between the releases.
+ *
+ * Covers the ideal gas primordial densities with and without the resonance widths,
+ * the densities in the grand-canonical, canonical, strangeness-canonical,
+ * excluded-volume and quantum van der Waals HRG models, the fluctuations,
+ * a PCE trajectory, a thermal fit of the ALICE data, and the event generation with decays.
+ * The PDG2020 particle list is used.
+ *
+ * Each benchmark is repeated for at least the given time and at least three times.
+ * The results can be written to a JSON file, and compared to the results of an earlier run.
+ * The comparison lists the time ratios and the relative differences of the computed
+ * quantities (checksums), which should not change with optimizations.
+ * Returns a non-zero exit code if a benchmark is slower than the baseline by more than the threshold,
+ * or if its checksum differs from the baseline by more than the checksum tolerance (10^-6 by default).
+ *
+ * The whole suite is run by the "benchmarks" build target, the results are stored in benchmarks.json
+ * in the build directory.
+ *
+ * Usage:
+ * ~~~.bash
+ * LibraryBenchmarks [--filter=<substring>] [--min_time=<seconds>] [--out=<file.json>] [--compare=<baseline.json>] [--threshold=<fraction>] [--checksum_tolerance=<value>]
+ * ~~~
+ */
@@ -0,0 +1,110 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+#include <cstdio>
+
+#include "HRGBase.h"
+#include "HRGFit.h"
+
+#include "ThermalFISTConfig.h"
+
+using namespace std;
+
+#ifdef ThermalFIST_USENAMESPACE
+using namespace thermalfist;
+#endif
+
+// Creates the HRG model used in all the fits
+ThermalModelBase* CreateModel(ThermalParticleSystem *TPS)
+{
+	ThermalModelBase *model = new ThermalModelIdeal(TPS);
+
+	// Include quantum statistics
+	model->SetStatistics(true);
+
+	// Use finite resonance widths (energy-independent Breit-Wigner)
+	model->SetUseWidth(ThermalParticle::BWTwoGamma);
+
+	return model;
+}
+
+// Fits the ALICE Pb-Pb 2.76 TeV data in several centrality classes
+// Usage: BatchFit <workers> <outputfile>
+int main(int argc, char *argv[])
+{
+	// Number of fits performed concurrently, by default equals the number of OpenMP threads
+	int workers = -1;
+	if (argc > 1)
+		workers = atoi(argv[1]);
+
+	// File with the combined results table
+	string outputfile = "BatchFit.dat";
+	if (argc > 2)
+		outputfile = string(argv[2]);
+
+	// Create the hadron list instance and read the list from file
+	ThermalParticleSystem TPS(string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+
+	ThermalModelFitBatch batch(&TPS, CreateModel);
+
+	if (workers > 0)
+		batch.SetNumberOfWorkers(workers);
+
+	// Fit T, R, and gammaS, muB is set to zero
+	batch.SetParameter("T", 0.155, 0.010, 0.100, 0.200);
+	batch.SetParameter("R", 10.0, 1.0, 0.0, 30.0);
+	batch.SetParameterFitFlag("gammaS", true);
+	batch.SetParameterValue("muB", 0.);
+	batch.SetParameterFitFlag("muB", false);
+
+	// Neighbouring centrality classes are added one after another
+	// so that each fit can start from the result of the preceding one
+	const char* centralities[] = { "0-10", "10-20", "20-40", "40-60", "60-80" };
+	for (int i = 0; i < 5; ++i) {
+		batch.AddDatasetFromFile(string(ThermalFIST_INPUT_FOLDER) + "/data/ALICE/ALICE-PbPb2.76TeV-" + centralities[i] + "-all-symmetrized.dat",
+			string(centralities[i]) + "%");
+	}
+
+	double wt1 = get_wall_time();
+
+	batch.PerformFits();
+
+	double wt2 = get_wall_time();
+
+	printf("\nPerformed %d fits using %d worker(s) in %lf s\n\n", static_cast<int>(batch.Datasets().size()), batch.NumberOfWorkers(), wt2 - wt1);
+
+	batch.PrintResultsTable();
+	batch.PrintResultsTable(outputfile);
+
+	return 0;
+}
+
+
+/**
+ * \example BatchFit.cpp
+ *
+ * An example of performing thermal fits to multiple data sets
+ * with the ThermalModelFitBatch class.
+ *
+ * Fits the ALICE Pb-Pb 2.76 TeV hadron yields in five centrality classes
+ * within the ideal HRG model. The fits are distributed among the
+ * OpenMP threads (if the library is compiled with OpenMP support).
+ * The results are written into a single table.
+ *
+ * Usage:
+ * ~~~.bash
+ * BatchFit <workers> <outputfile>
+ * ~~~
+ *
+ * <workers> is the number of fits performed concurrently (default: number of OpenMP threads)
+ * <outputfile> is the file where the combined results table is written (default: BatchFit.dat)
+ */
@@ -0,0 +1,157 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "HRGBase.h"
+#include "HRGEV.h"
+#include "HRGVDW.h"
+
+#include "ThermalFISTConfig.h"
+
+using namespace std;
+
+#ifdef ThermalFIST_USENAMESPACE
+using namespace thermalfist;
+#endif
+
+// Performs the calculations being timed, returns a few computed quantities
+vector<double> Calculate(ThermalModelBase *model, int iterations)
+{
+	vector<double> ret;
+	for (int it = 0; it < iterations; ++it) {
+		model->SetTemperature(0.150 + 0.001 * it);
+		model->CalculateDensities();
+	}
+	ret.push_back(model->Pressure());
+	ret.push_back(model->EnergyDensity());
+	ret.push_back(model->EntropyDensity());
+	ret.push_back(model->BaryonDensity());
+	ret.push_back(model->GetDensity(211, Feeddown::StabilityFlag));
+	return ret;
+}
+
+// Measures the scaling of the thermal model calculations with the number of OpenMP threads
+// Usage: OpenMPScaling <iterations>
+int main(int argc, char *argv[])
+{
+	int iterations = 10;
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+
+	int maxthreads = 1;
+#ifdef USE_OPENMP
+	maxthreads = omp_get_max_threads();
+#else
+	printf("The library is compiled without OpenMP support, only one thread is used\n\n");
+#endif
+
+	ThermalParticleSystem TPS(string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+
+	// Quantum statistics and energy-dependent Breit-Wigner widths
+	// make the loops over the species expensive
+	vector<ThermalModelBase*> models;
+	vector<string> names;
+
+	models.push_back(new ThermalModelIdeal(&TPS));
+	names.push_back("Ideal HRG");
+
+	ThermalModelEVDiagonal *modelEV = new ThermalModelEVDiagonal(&TPS);
+	modelEV->SetRadius(0.3);
+	models.push_back(modelEV);
+	names.push_back("Diagonal EV-HRG");
+
+	// QvdW interactions between baryons and between antibaryons
+	ThermalModelVDW *modelVDW = new ThermalModelVDW(&TPS);
+	for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+		for (int j = 0; j < TPS.ComponentsNumber(); ++j) {
+			int B1 = TPS.Particle(i).BaryonCharge();
+			int B2 = TPS.Particle(j).BaryonCharge();
+			if ((B1 > 0 && B2 > 0) || (B1 < 0 && B2 < 0)) {
+				modelVDW->SetAttraction(i, j, 0.329);
+				modelVDW->SetVirial(i, j, 3.42);
+			}
+		}
+	}
+	models.push_back(modelVDW);
+	names.push_back("QvdW-HRG");
+
+	for (size_t im = 0; im < models.size(); ++im) {
+		ThermalModelBase *model = models[im];
+		model->SetStatistics(true);
+		model->SetUseWidth(ThermalParticle::eBW);
+		model->SetBaryonChemicalPotential(0.100);
+		model->SetQoverB(0.4);
+
+		printf("%s\n", names[im].c_str());
+		printf("%10s%15s%15s%20s\n", "threads", "time[s]", "speedup", "max. rel. diff.");
+
+		double time1 = 0.;
+		vector<double> res1;
+		for (int threads = 1; threads <= maxthreads; threads *= 2) {
+#ifdef USE_OPENMP
+			omp_set_num_threads(threads);
+#endif
+			model->SetOMP(threads > 1);
+
+			double wt1 = get_wall_time();
+			vector<double> res = Calculate(model, iterations);
+			double wt2 = get_wall_time();
+
+			if (threads == 1) {
+				time1 = wt2 - wt1;
+				res1 = res;
+			}
+
+			// The results should not depend on the number of threads
+			double maxdiff = 0.;
+			for (size_t i = 0; i < res.size(); ++i)
+				if (res1[i] != 0.)
+					maxdiff = max(maxdiff, fabs(res[i] / res1[i] - 1.));
+
+			printf("%10d%15lf%15lf%20E\n", threads, wt2 - wt1, time1 / (wt2 - wt1), maxdiff);
+
+			if (threads < maxthreads && 2 * threads > maxthreads)
+				threads = maxthreads / 2;
+		}
+		printf("\n");
+
+		delete model;
+	}
+
+	return 0;
+}
+
+
+/**
+ * \example OpenMPScaling.cpp
+ *
+ * An example measuring the scaling of the thermal model calculations
+ * with the number of OpenMP threads.
+ *
+ * The loops over the particle species are distributed among the threads
+ * if enabled with ThermalModelBase::SetOMP().
+ * The ideal, diagonal excluded-volume, and quantum van der Waals HRG models
+ * are considered, with quantum statistics and energy-dependent Breit-Wigner widths.
+ * The library has to be compiled with the USE_OpenMP CMake option.
+ *
+ * Usage:
+ * ~~~.bash
+ * OpenMPScaling <iterations>
+ * ~~~
+ *
+ * <iterations> is the number of temperature values calculated for each number of threads (default: 10)
+ */
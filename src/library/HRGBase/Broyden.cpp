@@ -6,9 +6,11 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/Broyden.h"
+#include "HRGBase/Profiling.h"
 
 #include <stdio.h>
 #include <cmath>
+#include <algorithm>
 
 #include <Eigen/Dense>
 
@@ -81,7 +83,8 @@ namespace thermalfist {
       exit(1);
     }
 
-    m_MaxIterations = max_iterations;
+    THERMALFIST_PROFILE_SCOPE(BroydenTimer);
+    THERMALFIST_PROFILE_COUNT(BroydenSolves, 1);
 
     BroydenSolutionCriterium *SolutionCriterium = solcrit;
     bool UseDefaultSolutionCriterium = false;
@@ -96,83 +99,178 @@ namespace thermalfist {
       JacobianInUse = new BroydenJacobian(m_Equations);
       UseDefaultJacobian = true;
     }
+
+    std::vector<double> xcur = Iterate(x0, JacobianInUse, SolutionCriterium, max_iterations);
+
+    if (UseDefaultSolutionCriterium) {
+      delete SolutionCriterium;
+      SolutionCriterium = NULL;
+    }
+    if (UseDefaultJacobian) {
+      delete JacobianInUse;
+      JacobianInUse = NULL;
+    }
+    return xcur;
+  }
+
+  std::vector<double> Broyden::Iterate(const std::vector<double>& x0, BroydenJacobian * jaco, BroydenSolutionCriterium * solcrit, int max_iterations, const std::vector<double>* jac0)
+  {
+    m_MaxIterations = max_iterations;
     m_Iterations = 0;
     double &maxdiff = m_MaxDifference;
     int N = m_Equations->Dimension();
-    std::vector<double> xcur = x0, tmpvec, xdeltavec = x0;
-    VectorXd xold(N), xnew(N), xdelta(N);
-    VectorXd fold(N), fnew(N), fdelta(N);
-
-    xold = VectorXd::Map(&xcur[0], xcur.size());
-
-    MatrixXd Jac = Eigen::Map< Matrix<double, Dynamic, Dynamic, RowMajor> >(&JacobianInUse->Jacobian(xcur)[0], N, N);
 
-    if (Jac.determinant() == 0.0)
-    {
-      printf("**WARNING** Singular Jacobian in Broyden::Solve\n");
-      return xcur;
+    // The stored Jacobian is refreshed once too many updates have been accumulated
+    bool reuse = (jac0 == NULL && m_ReuseJacobian && m_JacobianStored
+      && static_cast<int>(m_Permutation.size()) == N && m_NumberOfUpdates <= 2 * N + 10);
+
+    if (!reuse) {
+      m_JacobianStored = false;
+      bool nonsingular = false;
+      if (jac0 != NULL)
+        nonsingular = FactorizeJacobian(*jac0);
+      else {
+        m_JacobianEvaluations++;
+        THERMALFIST_PROFILE_COUNT(BroydenJacobianEvaluations, 1);
+        nonsingular = FactorizeJacobian(jaco->Jacobian(x0));
+      }
+      if (!nonsingular) {
+        printf("**WARNING** Singular Jacobian in Broyden::Solve\n");
+        return x0;
+      }
     }
 
-    MatrixXd Jinv = Jac.inverse();
-    tmpvec = m_Equations->Equations(xcur);
-    fold   = VectorXd::Map(&tmpvec[0], tmpvec.size());
+    // The attempt with the reused Jacobian is abandoned early if it does not converge
+    int iters_max = max_iterations;
+    if (reuse)
+      iters_max = std::min(max_iterations, 2 * N + 10);
 
-    for (m_Iterations = 1; m_Iterations < max_iterations; ++m_Iterations) {
-      xnew = xold - Jinv * fold;
+    m_xold.resize(N);
+    m_fold.resize(N);
+    m_xdelta.resize(N);
+    m_fdelta.resize(N);
+    m_step.resize(N);
 
-      VectorXd::Map(&xcur[0], xcur.size()) = xnew;
+    std::vector<double> xcur = x0, tmpvec;
+
+    VectorXd::Map(&m_xold[0], N) = VectorXd::Map(&xcur[0], N);
+    tmpvec = m_Equations->Equations(xcur);
+    m_EquationsEvaluations++;
+    THERMALFIST_PROFILE_COUNT(BroydenResidualEvaluations, 1);
+    VectorXd::Map(&m_fold[0], N) = VectorXd::Map(&tmpvec[0], N);
+
+    bool solved = false;
+    for (m_Iterations = 1; m_Iterations < iters_max; ++m_Iterations) {
+      m_TotalIterations++;
+      THERMALFIST_PROFILE_COUNT(BroydenIterations, 1);
+
+      ApplyInverseJacobian(&m_fold[0], &m_step[0]);
+      for (int i = 0; i < N; ++i) {
+        xcur[i] = m_xold[i] - m_step[i];
+        m_xdelta[i] = xcur[i] - m_xold[i];
+      }
 
       tmpvec = m_Equations->Equations(xcur);
-      fnew   = VectorXd::Map(&tmpvec[0], tmpvec.size());
+      m_EquationsEvaluations++;
+      THERMALFIST_PROFILE_COUNT(BroydenResidualEvaluations, 1);
 
-      
       maxdiff = 0.;
-      for (size_t i = 0; i < xcur.size(); ++i) {
-        maxdiff = std::max(maxdiff, fabs(fnew[i]));
+      for (int i = 0; i < N; ++i) {
+        maxdiff = std::max(maxdiff, fabs(tmpvec[i]));
+        m_fdelta[i] = tmpvec[i] - m_fold[i];
       }
 
-      xdelta = xnew - xold;
-      fdelta = fnew - fold;
-
-      VectorXd::Map(&xdeltavec[0], xdeltavec.size()) = xdelta;
-
-      if (SolutionCriterium->IsSolved(xcur, tmpvec, xdeltavec))
+      if (solcrit->IsSolved(xcur, tmpvec, m_xdelta)) {
+        solved = true;
         break;
-      //if (maxdiff < relative_error) break;
+      }
 
       if (!m_UseNewton) // Use Broyden's method
       {
-        
+        // Jinv -> (I + p1 xdelta^T) Jinv, with p1 = (xdelta - Jinv fdelta) / (xdelta^T Jinv fdelta)
+        ApplyInverseJacobian(&m_fdelta[0], &m_step[0]);
         double norm = 0.;
         for (int i = 0; i < N; ++i)
-          for (int j = 0; j < N; ++j)
-            norm += xdelta[i] * Jinv(i, j) * fdelta[j];
-        VectorXd p1(N);
-        p1 = (xdelta - Jinv * fdelta);
-        for (int i = 0; i < N; ++i) p1[i] *= 1. / norm;
-        Jinv = Jinv + (p1 * xdelta.transpose()) * Jinv;
+          norm += m_xdelta[i] * m_step[i];
+        if (norm != 0.) {
+          m_UpdatesP.resize((m_NumberOfUpdates + 1) * N);
+          m_UpdatesX.resize((m_NumberOfUpdates + 1) * N);
+          for (int i = 0; i < N; ++i) {
+            m_UpdatesP[m_NumberOfUpdates * N + i] = (m_xdelta[i] - m_step[i]) / norm;
+            m_UpdatesX[m_NumberOfUpdates * N + i] = m_xdelta[i];
+          }
+          m_NumberOfUpdates++;
+        }
       }
       else // Use Newton's method
       {
-        Jac = Eigen::Map< Matrix<double, Dynamic, Dynamic, RowMajor> >(&JacobianInUse->Jacobian(xcur)[0], N, N);
-        Jinv = Jac.inverse();
+        m_JacobianEvaluations++;
+        THERMALFIST_PROFILE_COUNT(BroydenJacobianEvaluations, 1);
+        if (!FactorizeJacobian(jaco->Jacobian(xcur))) {
+          printf("**WARNING** Singular Jacobian in Broyden::Solve\n");
+          return xcur;
+        }
       }
 
-      xold = xnew;
-      fold = fnew;
+      VectorXd::Map(&m_xold[0], N) = VectorXd::Map(&xcur[0], N);
+      VectorXd::Map(&m_fold[0], N) = VectorXd::Map(&tmpvec[0], N);
     }
 
-    if (UseDefaultSolutionCriterium) {
-      delete SolutionCriterium;
-      SolutionCriterium = NULL;
-    }
-    if (UseDefaultJacobian) {
-      delete JacobianInUse;
-      JacobianInUse = NULL;
+    if (reuse && !solved) {
+      // Start over with a freshly evaluated Jacobian
+      m_JacobianStored = false;
+      return Iterate(x0, jaco, solcrit, max_iterations);
     }
+
+    m_JacobianStored = true;
+
     return xcur;
   }
 
+  bool Broyden::FactorizeJacobian(const std::vector<double>& jac)
+  {
+    int N = m_Equations->Dimension();
+    m_LU.resize(N * N);
+    m_Permutation.resize(N);
+    m_NumberOfUpdates = 0;
+
+    Map<MatrixXd> LU(&m_LU[0], N, N);
+    LU = Eigen::Map< const Matrix<double, Dynamic, Dynamic, RowMajor> >(&jac[0], N, N);
+
+    // In-place LU factorization
+    PartialPivLU< Ref<MatrixXd> > lu(LU);
+    for (int i = 0; i < N; ++i)
+      m_Permutation[i] = lu.permutationP().indices()[i];
+
+    for (int i = 0; i < N; ++i)
+      if (LU(i, i) == 0.0)
+        return false;
+
+    return true;
+  }
+
+  void Broyden::ApplyInverseJacobian(const double * in, double * out)
+  {
+    int N = static_cast<int>(m_Permutation.size());
+    Map<VectorXd> res(out, N);
+    for (int i = 0; i < N; ++i)
+      res[m_Permutation[i]] = in[i];
+
+    Map<const MatrixXd> LU(&m_LU[0], N, N);
+    LU.triangularView<UnitLower>().solveInPlace(res);
+    LU.triangularView<Upper>().solveInPlace(res);
+
+    for (int k = 0; k < m_NumberOfUpdates; ++k) {
+      const double *p = &m_UpdatesP[k * N];
+      const double *x = &m_UpdatesX[k * N];
+      double dot = 0.;
+      for (int i = 0; i < N; ++i)
+        dot += x[i] * out[i];
+      for (int i = 0; i < N; ++i)
+        out[i] += p[i] * dot;
+    }
+  }
+
   bool Broyden::BroydenSolutionCriterium::IsSolved(const std::vector<double>& x, const std::vector<double>& f, const std::vector<double>& xdelta) const
   {
     double maxdiff = 0., maxdiffxdelta = 0.;
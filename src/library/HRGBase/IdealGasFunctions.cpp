@@ -13,9 +13,11 @@
 #include <stdexcept>
 #include <cfloat>
 #include <vector>
+#include <algorithm>
 
 #include "HRGBase/xMath.h"
 #include "HRGBase/NumericalIntegration.h"
+#include "HRGBase/Profiling.h"
 
 using namespace std;
 
@@ -23,7 +25,7 @@ namespace thermalfist {
 
   namespace IdealGasFunctions {
 
-    bool calculationHadBECIssue = false;
+    thread_local bool calculationHadBECIssue = false;
 
     double BoltzmannDensity(double T, double mu, double m, double deg) {
       if (m == 0.)
@@ -51,6 +53,11 @@ namespace thermalfist {
       return deg * m * m * T / 2. / xMath::Pi() / xMath::Pi() * xMath::BesselKexp(1, m / T) * exp((mu - m) / T) * xMath::GeVtoifm3();
     }
 
+    double BoltzmanndndT(double T, double mu, double m, double deg)
+    {
+      return (BoltzmannEnergyDensity(T, mu, m, deg) - mu * BoltzmannDensity(T, mu, m, deg)) / T / T;
+    }
+
     double BoltzmannTdndmu(int /*N*/, double T, double mu, double m, double deg)
     {
       return BoltzmannDensity(T, mu, m, deg);
@@ -186,6 +193,30 @@ namespace thermalfist {
       return ret;
     }
 
+    double QuantumClusterExpansiondndT(int statistics, double T, double mu, double m, double deg, int order)
+    {
+      double sign = 1.;
+      bool signchange = true;
+      if (statistics == 1) //Fermi
+        signchange = true;
+      else if (statistics == -1) //Bose
+        signchange = false;
+      else
+        return BoltzmanndndT(T, mu, m, deg);
+
+      double tfug = exp((mu - m) / T);
+      double cfug = tfug;
+      double moverT = m / T;
+      double ret = 0.;
+      for (int i = 1; i <= order; ++i) {
+        ret += sign * (xMath::BesselKexp(2, i*moverT) * (3. * T / static_cast<double>(i) - mu) + m * xMath::BesselK1exp(i*moverT)) * cfug;
+        cfug *= tfug;
+        if (signchange) sign = -sign;
+      }
+      ret *= deg * m * m / T / 2. / xMath::Pi() / xMath::Pi() * xMath::GeVtoifm3();
+      return ret;
+    }
+
     double QuantumClusterExpansionChiN(int N, int statistics, double T, double mu, double m, double deg, int order)
     {
       return QuantumClusterExpansionTdndmu(N - 1, statistics, T, mu, m, deg, order) / pow(T, 3) / xMath::GeVtoifm3();
@@ -395,6 +426,31 @@ namespace thermalfist {
       return QuantumNumericalIntegrationT3dn3dmu3(statistics, T, mu, m, deg);
     }
 
+    double QuantumNumericalIntegrationdndT(int statistics, double T, double mu, double m, double deg)
+    {
+      if (statistics == 0)           return BoltzmanndndT(T, mu, m, deg);
+      if (statistics == 1 && mu > m) return FermiNumericalIntegrationLargeMudndT(T, mu, m, deg);
+      if (statistics == -1 && mu > m) {
+        printf("**WARNING** QuantumNumericalIntegrationdndT: Bose-Einstein condensation\n");
+        calculationHadBECIssue = true;
+        return 0.;
+      }
+
+      double ret = 0.;
+      double moverT = m / T;
+      double muoverT = mu / T;
+      for (int i = 0; i < 32; i++) {
+        double tx = lagx32[i];
+        double EoverT = sqrt(tx*tx + moverT * moverT);
+        double Eexp = exp(EoverT - muoverT);
+        ret += lagw32[i] * T * tx * T * tx * (EoverT - muoverT) / (1. + statistics / Eexp) / (Eexp + statistics);
+      }
+
+      ret *= deg / 2. / xMath::Pi() / xMath::Pi() * xMath::GeVtoifm3();
+
+      return ret;
+    }
+
     double QuantumNumericalIntegrationChiN(int N, int statistics, double T, double mu, double m, double deg)
     {
       return QuantumNumericalIntegrationTdndmu(N - 1, statistics, T, mu, m, deg) / pow(T, 3) / xMath::GeVtoifm3();
@@ -632,13 +688,184 @@ namespace thermalfist {
       return FermiNumericalIntegrationLargeMuT3dn3dmu3(T, mu, m, deg);
     }
 
+    double FermiNumericalIntegrationLargeMudndT(double T, double mu, double m, double deg)
+    {
+      if (mu <= m)
+        return QuantumNumericalIntegrationdndT(1, T, mu, m, deg);
+
+      double pf = sqrt(mu*mu - m * m);
+      double ret1 = 0.;
+      for (int i = 0; i < 32; i++) {
+        double E = sqrt(legx32[i] * legx32[i] * pf*pf + m * m);
+        double Eexp = exp(-(E - mu) / T);
+        ret1 += legw32[i] * pf * legx32[i] * pf * legx32[i] * pf * (E - mu) / T / T / (1. + 1. / Eexp) / (Eexp + 1.);
+      }
+
+      double moverT = m / T;
+      double muoverT = mu / T;
+      for (int i = 0; i < 32; i++) {
+        double tx = pf / T + lagx32[i];
+        double EoverT = sqrt(tx*tx + moverT * moverT);
+        double Eexp = exp(EoverT - muoverT);
+        ret1 += lagw32[i] * T * tx * T * tx * (EoverT - muoverT) / (1. + 1. / Eexp) / (Eexp + 1.);
+      }
+
+      ret1 *= deg / 2. / xMath::Pi() / xMath::Pi() * xMath::GeVtoifm3();
+
+      return ret1;
+    }
+
     double FermiNumericalIntegrationLargeMuChiN(int N, double T, double mu, double m, double deg)
     {
       return FermiNumericalIntegrationLargeMuTdndmu(N - 1, T, mu, m, deg) / pow(T, 3) / xMath::GeVtoifm3();
     }
 
-    double IdealGasQuantity(Quantity quantity, QStatsCalculationType calctype, int statistics, double T, double mu, double m, double deg, int order)
+    // Gauss-Laguerre 16-point quadrature for [0,\infty] interval, used by the adaptive method
+    const double *lagx16 = NumericalIntegration::coefficients_xlag16;
+    const double *lagw16 = NumericalIntegration::coefficients_wlag16;
+
+    // Same integrals as in the QuantumNumericalIntegration* functions, evaluated with 16-point quadratures.
+    // Only to be used for mu < m.
+    static double QuantumNumericalIntegration16Quantity(Quantity quantity, int statistics, double T, double mu, double m, double deg)
     {
+      if (quantity == EntropyDensity)
+        return (QuantumNumericalIntegration16Quantity(Pressure, statistics, T, mu, m, deg)
+          + QuantumNumericalIntegration16Quantity(EnergyDensity, statistics, T, mu, m, deg)
+          - mu * QuantumNumericalIntegration16Quantity(ParticleDensity, statistics, T, mu, m, deg)) / T;
+
+      double ret = 0.;
+      double moverT = m / T;
+      double muoverT = mu / T;
+      for (int i = 0; i < 16; i++) {
+        double tx = lagx16[i];
+        double EoverT = sqrt(tx*tx + moverT * moverT);
+        double Eexp = exp(EoverT - muoverT);
+        double occ = 1. / (Eexp + statistics);
+        double occfac = 1. / (1. + statistics / Eexp);
+        double val = 0.;
+        if (quantity == ParticleDensity)
+          val = occ;
+        else if (quantity == Pressure)
+          val = tx * tx / EoverT / 3. * occ;
+        else if (quantity == EnergyDensity)
+          val = EoverT * occ;
+        else if (quantity == ScalarDensity)
+          val = moverT / EoverT * occ;
+        else if (quantity == chi2)
+          val = occfac * occ;
+        else if (quantity == chi3)
+          val = (1. - statistics / Eexp) * occfac * occfac * occ;
+        else if (quantity == chi4)
+          val = (1. - 4.*statistics / Eexp + statistics * statistics / Eexp / Eexp) * occfac * occfac * occfac * occ;
+        else if (quantity == dndT)
+          val = (EoverT - muoverT) * occfac * occ;
+        ret += lagw16[i] * tx * tx * val;
+      }
+
+      ret *= deg / 2. / xMath::Pi() / xMath::Pi();
+
+      if (quantity == ParticleDensity || quantity == ScalarDensity)
+        ret *= T * T * T * xMath::GeVtoifm3();
+      else if (quantity == Pressure || quantity == EnergyDensity)
+        ret *= T * T * T * T * xMath::GeVtoifm3();
+      else if (quantity == dndT)
+        ret *= T * T * xMath::GeVtoifm3();
+
+      return ret;
+    }
+
+    QStatsMethod SelectQStatsMethod(Quantity quantity, int statistics, double T, double mu, double m, double tolerance)
+    {
+      QStatsMethod ret;
+      ret.type = MethodQuadratures;
+      ret.order = 32;
+
+      if (statistics == 0) {
+        ret.type = MethodBoltzmann;
+        ret.order = 1;
+        return ret;
+      }
+
+      // Degenerate Fermi gas or Bose-Einstein condensation, handled by the quadratures
+      if (!(mu < m) || !(T > 0.))
+        return ret;
+
+      // The integrands, in particular for the higher-order susceptibilities, become peaked for mu close to m
+      if (tolerance >= 1.e-4 && m - mu >= 2. * T)
+        ret.order = 16;
+
+      // Accuracy of the BesselK approximations used in the cluster expansion,
+      // the entropy density and dn/dT involve cancellations which amplify their error by up to m/T
+      double besselacc = 3.e-7;
+      if (quantity == EntropyDensity || quantity == dndT)
+        besselacc *= std::max(1., m / T);
+      if (tolerance < besselacc)
+        return ret;
+
+      // Power of k in the k-th term of the cluster expansion, cf. the QuantumClusterExpansion* functions
+      int kpow = -1;
+      if (quantity == Pressure)
+        kpow = -2;
+      else if (quantity == chi2 || quantity == dndT)
+        kpow = 0;
+      else if (quantity == chi3)
+        kpow = 1;
+      else if (quantity == chi4)
+        kpow = 2;
+      int kpowpos = (kpow > 0) ? kpow : 0;
+
+      double fug = exp((mu - m) / T);
+
+      // Estimate of the remainder of the series after n terms relative to the first term
+      // k-th term is bounded by fug^(k-1) k^kpow, the ratio of two subsequent terms for k > n by q
+      double Rn = 1., R1 = -1.;
+      // Each term of the cluster expansion costs roughly as much as two quadrature nodes
+      int maxorder = ret.order / 2;
+      for (int n = 1; n <= maxorder; ++n) {
+        Rn *= fug;
+        double q = fug * pow((n + 2.) / (n + 1.), kpowpos);
+        if (q >= 1.)
+          continue;
+        double rem = Rn * pow(n + 1., kpow) / (1. - q);
+        if (n == 1)
+          R1 = rem;
+
+        // The sum of the alternating Fermi-Dirac series can be smaller than its first term
+        double norm = 1.;
+        if (statistics == 1) {
+          if (R1 < 0. || R1 >= 0.5)
+            continue;
+          norm = 1. - R1;
+        }
+
+        if (rem / norm <= tolerance) {
+          ret.type = (n == 1) ? MethodBoltzmann : MethodClusterExpansion;
+          ret.order = n;
+          return ret;
+        }
+      }
+
+      return ret;
+    }
+
+    double IdealGasQuantity(Quantity quantity, QStatsCalculationType calctype, int statistics, double T, double mu, double m, double deg, int order, double tolerance)
+    {
+      if (statistics != 0 && calctype == Adaptive) {
+        QStatsMethod method = SelectQStatsMethod(quantity, statistics, T, mu, m, tolerance);
+        if (method.type == MethodBoltzmann)
+          return IdealGasQuantity(quantity, calctype, 0, T, mu, m, deg);
+        if (method.type == MethodClusterExpansion)
+          return IdealGasQuantity(quantity, ClusterExpansion, statistics, T, mu, m, deg, method.order);
+        if (method.order == 16) {
+          THERMALFIST_PROFILE_COUNT(IdealGasEvaluations, 1);
+          return QuantumNumericalIntegration16Quantity(quantity, statistics, T, mu, m, deg);
+        }
+        return IdealGasQuantity(quantity, Quadratures, statistics, T, mu, m, deg);
+      }
+
+      // Adaptive calculations are counted once, in the branch they dispatch to
+      THERMALFIST_PROFILE_COUNT(IdealGasEvaluations, 1);
+
       if (statistics == 0) {
         if (quantity == ParticleDensity)
           return BoltzmannDensity(T, mu, m, deg);
@@ -656,6 +883,8 @@ namespace thermalfist {
           return BoltzmannChiN(3, T, mu, m, deg);
         if (quantity == chi4)
           return BoltzmannChiN(4, T, mu, m, deg);
+        if (quantity == dndT)
+          return BoltzmanndndT(T, mu, m, deg);
       }
       else {
         if (calctype == ClusterExpansion) {
@@ -675,6 +904,8 @@ namespace thermalfist {
             return QuantumClusterExpansionChiN(3, statistics, T, mu, m, deg, order);
           if (quantity == chi4)
             return QuantumClusterExpansionChiN(4, statistics, T, mu, m, deg, order);
+          if (quantity == dndT)
+            return QuantumClusterExpansiondndT(statistics, T, mu, m, deg, order);
         }
         else {
           if (quantity == ParticleDensity)
@@ -693,6 +924,8 @@ namespace thermalfist {
             return QuantumNumericalIntegrationChiN(3, statistics, T, mu, m, deg);
           if (quantity == chi4)
             return QuantumNumericalIntegrationChiN(4, statistics, T, mu, m, deg);
+          if (quantity == dndT)
+            return QuantumNumericalIntegrationdndT(statistics, T, mu, m, deg);
         }
       }
       printf("**WARNING** IdealGasFunctions::IdealGasQuantity: Unknown quantity\n");
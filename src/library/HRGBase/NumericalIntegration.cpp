@@ -7,6 +7,10 @@
  */
 #include "HRGBase/NumericalIntegration.h"
 
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
 namespace thermalfist {
 
   namespace NumericalIntegration {
@@ -191,6 +195,76 @@ namespace thermalfist {
       }
     }
 
+    namespace {
+      // Iterative radix-2 FFT of a contiguous array of length n (power of 2)
+      void FFT1DRadix2(std::complex<double> *a, int n, bool inverse)
+      {
+        for (int i = 1, j = 0; i < n; ++i) {
+          int bit = n >> 1;
+          for (; j & bit; bit >>= 1)
+            j ^= bit;
+          j ^= bit;
+          if (i < j)
+            std::swap(a[i], a[j]);
+        }
+
+        for (int len = 2; len <= n; len <<= 1) {
+          double ang = 2. * 3.14159265358979323846 / len * (inverse ? 1. : -1.);
+          std::complex<double> wlen(cos(ang), sin(ang));
+          for (int i = 0; i < n; i += len) {
+            std::complex<double> w(1.);
+            for (int j = 0; j < len / 2; ++j) {
+              std::complex<double> u = a[i + j], v = a[i + j + len / 2] * w;
+              a[i + j] = u + v;
+              a[i + j + len / 2] = u - v;
+              w *= wlen;
+            }
+          }
+        }
+      }
+    }
+
+    void FFT(std::vector< std::complex<double> > &data, const std::vector<int> &dims, bool inverse)
+    {
+      int total = 1;
+      for (size_t d = 0; d < dims.size(); ++d)
+        total *= dims[d];
+      if (total != static_cast<int>(data.size())) {
+        printf("**WARNING** NumericalIntegration::FFT: The data size %d does not match the dimensions %d, the data are left unchanged\n", static_cast<int>(data.size()), total);
+        return;
+      }
+      for (size_t d = 0; d < dims.size(); ++d) {
+        if (dims[d] < 1 || (dims[d] & (dims[d] - 1)) != 0) {
+          printf("**WARNING** NumericalIntegration::FFT: The size %d is not a power of 2, the data are left unchanged\n", dims[d]);
+          return;
+        }
+      }
+
+      std::vector< std::complex<double> > line;
+      int stride = total;
+      for (size_t d = 0; d < dims.size(); ++d) {
+        int n = dims[d];
+        if (n <= 1)
+          continue;
+        stride /= n;
+        // stride is the product of the sizes of the dimensions after d
+        int stridepre = 1;
+        for (size_t d2 = 0; d2 < d; ++d2)
+          stridepre *= dims[d2];
+        line.resize(n);
+        for (int ipre = 0; ipre < stridepre; ++ipre) {
+          for (int ipost = 0; ipost < stride; ++ipost) {
+            int offset = ipre * n * stride + ipost;
+            for (int k = 0; k < n; ++k)
+              line[k] = data[offset + k * stride];
+            FFT1DRadix2(&line[0], n, inverse);
+            for (int k = 0; k < n; ++k)
+              data[offset + k * stride] = line[k];
+          }
+        }
+      }
+    }
+
   } // namespace NumericalIntegration
 
 } // namespace thermalfist
\ No newline at end of file
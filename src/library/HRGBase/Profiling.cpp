@@ -0,0 +1,255 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGBase/Profiling.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace thermalfist {
+
+  namespace Profiling {
+
+    namespace {
+      // The counters of a block are written by the owning thread and read concurrently by GetReport(),
+      // they are atomic with relaxed ordering, which compiles to plain loads and stores
+      struct ThreadData {
+        std::atomic<long long> Counts[NumberOfCounters];
+        std::atomic<double> Times[NumberOfTimers];
+        std::atomic<long long> Calls[NumberOfTimers];
+      };
+
+      template<typename T>
+      void AddOwned(std::atomic<T>& value, T n)
+      {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+      template<typename T>
+      void AddShared(std::atomic<T>& value, T n)
+      {
+        T old = value.load(std::memory_order_relaxed);
+        while (!value.compare_exchange_weak(old, old + n, std::memory_order_relaxed)) { }
+      }
+
+      template<typename T>
+      T Get(const std::atomic<T>& value)
+      {
+        return value.load(std::memory_order_relaxed);
+      }
+
+      void Clear(ThreadData& data)
+      {
+        for (int i = 0; i < NumberOfCounters; ++i)
+          data.Counts[i].store(0, std::memory_order_relaxed);
+        for (int i = 0; i < NumberOfTimers; ++i) {
+          data.Times[i].store(0., std::memory_order_relaxed);
+          data.Calls[i].store(0, std::memory_order_relaxed);
+        }
+      }
+
+      // Adds the values of one block to another, the target is not written by other threads
+      void Accumulate(ThreadData& target, const ThreadData& data)
+      {
+        for (int i = 0; i < NumberOfCounters; ++i)
+          AddOwned(target.Counts[i], Get(data.Counts[i]));
+        for (int i = 0; i < NumberOfTimers; ++i) {
+          AddOwned(target.Times[i], Get(data.Times[i]));
+          AddOwned(target.Calls[i], Get(data.Calls[i]));
+        }
+      }
+
+      // Each running thread owns one of the blocks. When the thread terminates,
+      // its values are moved to retiredBlock and the block is returned for reuse.
+      // The threads beyond MaxThreads running at the same time share overflowBlock,
+      // which is updated with atomic read-modify-write operations.
+      // The blocks have static storage and are thus zero-initialized.
+      // The mutex guards the assignment of the blocks, retiredBlock, and the reports,
+      // it is not taken on the hot paths.
+      const int MaxThreads = 256;
+      ThreadData threadBlocks[MaxThreads];
+      bool blockInUse[MaxThreads];
+      ThreadData retiredBlock;
+      ThreadData overflowBlock;
+      std::mutex blocksMutex;
+      std::atomic<int> numberOfThreads(0);
+
+      ThreadData* AcquireBlock()
+      {
+        numberOfThreads.fetch_add(1);
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        for (int ib = 0; ib < MaxThreads; ++ib) {
+          if (!blockInUse[ib]) {
+            blockInUse[ib] = true;
+            return &threadBlocks[ib];
+          }
+        }
+        return &overflowBlock;
+      }
+
+      void ReleaseBlock(ThreadData* block)
+      {
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        Accumulate(retiredBlock, *block);
+        Clear(*block);
+        blockInUse[block - threadBlocks] = false;
+      }
+
+      // Releases the block of a thread when the thread terminates
+      struct LocalBlockOwner {
+        ThreadData* Block;
+        LocalBlockOwner() : Block(NULL) { }
+        ~LocalBlockOwner() {
+          if (Block != NULL && Block != &overflowBlock)
+            ReleaseBlock(Block);
+        }
+      };
+
+      thread_local LocalBlockOwner localOwner;
+
+      ThreadData& LocalData()
+      {
+        if (localOwner.Block == NULL)
+          localOwner.Block = AcquireBlock();
+        return *localOwner.Block;
+      }
+
+      double WallTime()
+      {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+      const char* CounterNames[NumberOfCounters] = {
+        "Ideal gas evaluations",
+        "Broyden solves",
+        "Broyden iterations",
+        "Broyden residual evaluations",
+        "Broyden Jacobian evaluations",
+        "Partition function nodes",
+        "Fit chi2 evaluations",
+        "Events generated",
+        "Events rejected",
+        "Multiplicity trials",
+        "Decays performed"
+      };
+
+      const char* TimerNames[NumberOfTimers] = {
+        "Primordial densities",
+        "Feeddown",
+        "Fluctuations",
+        "Partition functions",
+        "Broyden",
+        "Fit",
+        "Event generation",
+        "Decays"
+      };
+    }
+
+    bool IsEnabled()
+    {
+#ifdef USE_PROFILING
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void AddCount(Counter counter, long long n)
+    {
+      ThreadData& data = LocalData();
+      if (&data == &overflowBlock)
+        AddShared(data.Counts[counter], n);
+      else
+        AddOwned(data.Counts[counter], n);
+    }
+
+    void AddTime(Timer timer, double seconds)
+    {
+      ThreadData& data = LocalData();
+      if (&data == &overflowBlock) {
+        AddShared(data.Times[timer], seconds);
+        AddShared(data.Calls[timer], 1LL);
+      }
+      else {
+        AddOwned(data.Times[timer], seconds);
+        AddOwned(data.Calls[timer], 1LL);
+      }
+    }
+
+    Report GetReport()
+    {
+      ThreadData sum;
+      Clear(sum);
+      {
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        Accumulate(sum, retiredBlock);
+        Accumulate(sum, overflowBlock);
+        for (int ib = 0; ib < MaxThreads; ++ib)
+          Accumulate(sum, threadBlocks[ib]);
+      }
+
+      Report ret;
+      for (int i = 0; i < NumberOfCounters; ++i)
+        ret.Counts[i] = Get(sum.Counts[i]);
+      for (int i = 0; i < NumberOfTimers; ++i) {
+        ret.Times[i] = Get(sum.Times[i]);
+        ret.Calls[i] = Get(sum.Calls[i]);
+      }
+      ret.Threads = numberOfThreads.load();
+      return ret;
+    }
+
+    void PrintReport(FILE* out)
+    {
+      if (!IsEnabled()) {
+        fprintf(out, "Profiling is disabled, compile the library with the USE_PROFILING option\n");
+        return;
+      }
+
+      Report report = GetReport();
+      fprintf(out, "Profiling report (%d thread(s))\n", report.Threads);
+      fprintf(out, "%-35s%20s\n", "Counter", "Count");
+      for (int i = 0; i < NumberOfCounters; ++i)
+        fprintf(out, "%-35s%20lld\n", CounterNames[i], report.Counts[i]);
+      fprintf(out, "%-35s%15s%20s%20s\n", "Timer", "Calls", "Total[s]", "Per call[ms]");
+      for (int i = 0; i < NumberOfTimers; ++i)
+        fprintf(out, "%-35s%15lld%20lf%20lf\n", TimerNames[i], report.Calls[i], report.Times[i],
+          report.Calls[i] > 0 ? 1.e3 * report.Times[i] / report.Calls[i] : 0.);
+    }
+
+    void Reset()
+    {
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      for (int ib = 0; ib < MaxThreads; ++ib)
+        Clear(threadBlocks[ib]);
+      Clear(retiredBlock);
+      Clear(overflowBlock);
+    }
+
+    const char* CounterName(Counter counter)
+    {
+      return CounterNames[counter];
+    }
+
+    const char* TimerName(Timer timer)
+    {
+      return TimerNames[timer];
+    }
+
+    ScopedTimer::ScopedTimer(Timer timer) : m_Timer(timer), m_Start(WallTime())
+    {
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+      AddTime(m_Timer, WallTime() - m_Start);
+    }
+
+  } // namespace Profiling
+
+} // namespace thermalfist
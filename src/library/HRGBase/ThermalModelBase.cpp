@@ -6,6 +6,11 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/ThermalModelBase.h"
+#include "HRGBase/Profiling.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 #include <cstdio>
 #include <algorithm>
@@ -21,6 +26,66 @@ using namespace std;
 
 namespace thermalfist {
 
+  namespace {
+    // Value of the chemical potential corresponding to the thermal parameter
+    double ChargeChemicalPotential(const ThermalModelParameters& params, ThermalParameter::Name name)
+    {
+      if (name == ThermalParameter::BaryonChemicalPotential)
+        return params.muB;
+      if (name == ThermalParameter::ElectricChemicalPotential)
+        return params.muQ;
+      if (name == ThermalParameter::StrangenessChemicalPotential)
+        return params.muS;
+      return params.muC;
+    }
+
+    // Sets the chemical potential corresponding to the thermal parameter
+    void SetChargeChemicalPotential(ThermalModelParameters& params, ThermalParameter::Name name, double value)
+    {
+      if (name == ThermalParameter::BaryonChemicalPotential)
+        params.muB = value;
+      else if (name == ThermalParameter::ElectricChemicalPotential)
+        params.muQ = value;
+      else if (name == ThermalParameter::StrangenessChemicalPotential)
+        params.muS = value;
+      else
+        params.muC = value;
+    }
+
+    // Charge of the particle conjugate to the chemical potential
+    double ChargeOfParticle(const ThermalParticle& part, ThermalParameter::Name name)
+    {
+      if (name == ThermalParameter::BaryonChemicalPotential)
+        return part.BaryonCharge();
+      if (name == ThermalParameter::ElectricChemicalPotential)
+        return part.ElectricCharge();
+      if (name == ThermalParameter::StrangenessChemicalPotential)
+        return part.Strangeness();
+      return part.Charm();
+    }
+
+    // Jacobian of the conservation laws, given as linear combinations of the densities,
+    // with respect to the constrained chemical potentials, neglecting the cross-species
+    // derivatives of the densities (susc[i] = dn_i / dmu_i)
+    MatrixXd ConstraintsJacobian(const ThermalParticleSystem* TPS,
+      const std::vector<ThermalParameter::Name>& constrParams,
+      const std::vector< std::vector<double> >& constrCharges,
+      const std::vector<double>& susc)
+    {
+      int NC = static_cast<int>(constrParams.size());
+      MatrixXd ret(NC, NC);
+      for (int ic = 0; ic < NC; ++ic) {
+        for (int ic2 = 0; ic2 < NC; ++ic2) {
+          ret(ic, ic2) = 0.;
+          for (int i = 0; i < TPS->ComponentsNumber(); ++i)
+            ret(ic, ic2) += constrCharges[ic][i] * ChargeOfParticle(TPS->Particles()[i], constrParams[ic2]) * susc[i];
+        }
+      }
+      return ret;
+    }
+  }
+
+
   ThermalModelBase::ThermalModelBase(ThermalParticleSystem *TPS_, const ThermalModelParameters& params) :
     m_TPS(TPS_), 
     m_Parameters(params),
@@ -29,11 +94,16 @@ namespace thermalfist {
     m_Calculated(false),
     m_FeeddownCalculated(false),
     m_FluctuationsCalculated(false),
+    m_SusceptibilitiesCalculated(false),
     m_GCECalculated(false),
     m_NormBratio(false),
     m_QuantumStats(true),
     m_MaxDiff(0.),
-    m_useOpenMP(0)
+    m_useOpenMP(0),
+    m_SolverJacobianReuse(false),
+    m_ChemContinuation(false),
+    m_ChemContinuationValid(false),
+    m_ChemContinuationdMudTValid(false)
   {
     if (!Disclaimer::DisclaimerPrinted) 
       Disclaimer::DisclaimerPrinted = Disclaimer::PrintDisclaimer();
@@ -58,6 +128,7 @@ namespace thermalfist {
 
     m_Susc.resize(4);
     for (int i = 0; i < 4; ++i) m_Susc[i].resize(4);
+    m_ChargeCumulants.resize(4);
 
     m_NormBratio = false;
   
@@ -87,6 +158,12 @@ namespace thermalfist {
   }
 
 
+  ThermalModelBase* ThermalModelBase::Clone() const
+  {
+    printf("**WARNING** %s::Clone(): Not implemented for this model, returning NULL\n", m_TAG.c_str());
+    return NULL;
+  }
+
   void ThermalModelBase::FillVirial(const std::vector<double>& /*ri*/)
   {
   }
@@ -101,12 +178,18 @@ namespace thermalfist {
       m_TPS->SetResonanceWidthIntegrationType(ThermalParticle::BWTwoGamma);
     }
     m_UseWidth = useWidth;
+    m_ThermalDecays.reset();
+    m_ChemContinuationValid = false;
+    ResetCalculatedFlags();
   }
 
   void ThermalModelBase::SetUseWidth(ThermalParticle::ResonanceWidthIntegration type)
   {
     m_UseWidth = (type != ThermalParticle::ZeroWidth);
     m_TPS->SetResonanceWidthIntegrationType(type);
+    m_ThermalDecays.reset();
+    m_ChemContinuationValid = false;
+    ResetCalculatedFlags();
   }
 
 
@@ -119,6 +202,7 @@ namespace thermalfist {
       else {
         m_TPS->RestoreBranchingRatios();
       }
+      ResetCalculatedFlags();
     }
   }
 
@@ -133,6 +217,7 @@ namespace thermalfist {
   void ThermalModelBase::SetParameters(const ThermalModelParameters& params) {
     m_Parameters = params;
     m_Volume = m_Parameters.V;
+    m_ChemContinuationValid = false;
     ResetCalculatedFlags();
   }
 
@@ -173,12 +258,14 @@ namespace thermalfist {
   void ThermalModelBase::SetGammaS(double gammaS)
   {
     m_Parameters.gammaS = gammaS;
+    m_ChemContinuationValid = false;
     ResetCalculatedFlags();
   }
 
   void ThermalModelBase::SetGammaC(double gammaC)
   {
     m_Parameters.gammaC = gammaC;
+    m_ChemContinuationValid = false;
     ResetCalculatedFlags();
   }
 
@@ -311,12 +398,14 @@ namespace thermalfist {
   void ThermalModelBase::SetGammaq(double gammaq)
   {
     m_Parameters.gammaq = gammaq;
+    m_ChemContinuationValid = false;
     ResetCalculatedFlags();
   }
 
 
   void ThermalModelBase::ChangeTPS(ThermalParticleSystem *TPS_) {
     m_TPS = TPS_;
+    m_ThermalDecays.reset();
     m_Chem.resize(m_TPS->Particles().size());
     m_densities.resize(m_TPS->Particles().size());
     m_densitiestotal.resize(m_TPS->Particles().size());
@@ -331,13 +420,16 @@ namespace thermalfist {
     m_TotalCorrel = std::vector< std::vector<double> >(TPS()->ComponentsNumber(), std::vector<double>(TPS()->ComponentsNumber(), 0.));
     m_PrimChargesCorrel = std::vector< std::vector<double> >(TPS()->ComponentsNumber(), std::vector<double>(4, 0.));
     m_FinalChargesCorrel = std::vector< std::vector<double> >(TPS()->ComponentsNumber(), std::vector<double>(4, 0.));
+    m_ChemContinuationValid = false;
     ResetCalculatedFlags();
   }
 
   void ThermalModelBase::SetStatistics(bool stats) {
     m_QuantumStats = stats;
+    m_ChemContinuationValid = false;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       m_TPS->Particle(i).UseStatistics(stats);
+    ResetCalculatedFlags();
   }
 
   void ThermalModelBase::SetResonanceWidthIntegrationType(ThermalParticle::ResonanceWidthIntegration type)
@@ -348,6 +440,8 @@ namespace thermalfist {
     }
     else
       m_TPS->SetResonanceWidthIntegrationType(type);
+    m_ThermalDecays.reset();
+    ResetCalculatedFlags();
   }
 
   void ThermalModelBase::FillChemicalPotentials() {
@@ -363,6 +457,7 @@ namespace thermalfist {
       return;
     }
     m_Chem = chem;
+    ResetCalculatedFlags();
   }
 
   double ThermalModelBase::ChemicalPotential(int i) const
@@ -394,45 +489,285 @@ namespace thermalfist {
     return ret;
   }
 
+  void ThermalModelBase::IdealGasQuantities(IdealGasFunctions::Quantity type, const std::vector<double>& mu, std::vector<double>& ret) const
+  {
+    int NN = m_TPS->ComponentsNumber();
+    ret.resize(NN);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      ret[i] = m_TPS->Particles()[i].Density(m_Parameters, type, m_UseWidth, mu[i]);
+    }
+  }
+
   void ThermalModelBase::CalculateFeeddown() {
+    THERMALFIST_PROFILE_SCOPE(FeeddownTimer);
+
     if (m_UseWidth && m_TPS->ResonanceWidthIntegrationType() == ThermalParticle::eBW) {
+      // The thermal branching ratios depend on the parameters of this model,
+      // the decay contributions are kept in the model such that the shared list is not modified
+      std::vector< std::vector<double> > thermalBratios(m_TPS->ComponentsNumber());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
       for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-        m_TPS->Particle(i).CalculateThermalBranchingRatios(m_Parameters, m_UseWidth, m_Chem[i] + MuShift(i));
+        thermalBratios[i] = m_TPS->Particles()[i].ThermalBranchingRatios(m_Parameters, m_UseWidth, m_Chem[i] + MuShift(i));
       }
-      m_TPS->ProcessDecays();
+      std::shared_ptr<ThermalParticleSystem::DecayData> decays(new ThermalParticleSystem::DecayData());
+      m_TPS->CalculateDecayData(thermalBratios, *decays);
+      m_ThermalDecays = decays;
+    }
+    else {
+      m_ThermalDecays.reset();
     }
 
-    // Primordial
-    m_densitiesbyfeeddown[static_cast<int>(Feeddown::Primordial)] = m_densities;
+    ApplyFeeddown(m_densities, m_densitiesbyfeeddown);
 
-    // According to stability flags
-    int feed_index = static_cast<int>(Feeddown::StabilityFlag);
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densitiestotal[i] = m_densities[i];
-      //const std::vector< std::pair<double, int> >& decayContributions = m_TPS->Particles()[i].DecayContributionsByFeeddown()[feed_index];
-      const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = m_TPS->DecayContributionsByFeeddown()[feed_index][i];
-      for (size_t j = 0; j < decayContributions.size(); ++j)
-        if (i != decayContributions[j].second) 
-          m_densitiestotal[i] += decayContributions[j].first * m_densities[decayContributions[j].second];
-    }
+    m_densitiestotal = m_densitiesbyfeeddown[static_cast<int>(Feeddown::StabilityFlag)];
+
+    m_FeeddownCalculated = true;
+  }
 
-    m_densitiesbyfeeddown[feed_index] = m_densitiestotal;
+  void ThermalModelBase::ApplyFeeddown(const std::vector<double>& primordial, std::vector< std::vector<double> >& byfeeddown) const
+  {
+    byfeeddown.resize(Feeddown::NumberOfTypes);
 
-    // Weak, EM, strong
-    for (feed_index = static_cast<int>(Feeddown::Weak); feed_index <= static_cast<int>(Feeddown::Strong); ++feed_index) {
+    // Primordial
+    byfeeddown[static_cast<int>(Feeddown::Primordial)] = primordial;
+
+    // According to stability flags, weak, EM, strong
+    for (int feed_index = static_cast<int>(Feeddown::StabilityFlag); feed_index <= static_cast<int>(Feeddown::Strong); ++feed_index) {
+      byfeeddown[feed_index].resize(primordial.size());
+#ifdef USE_OPENMP
+#pragma omp parallel for if(m_useOpenMP)
+#endif
       for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-        m_densitiesbyfeeddown[feed_index][i] = m_densities[i];
-        //const std::vector< std::pair<double, int> >& decayContributions = m_TPS->Particles()[i].DecayContributionsByFeeddown()[feed_index];
-        const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = m_TPS->DecayContributionsByFeeddown()[feed_index][i];
+        byfeeddown[feed_index][i] = primordial[i];
+        const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = DecayContributionsByFeeddown()[feed_index][i];
         for (size_t j = 0; j < decayContributions.size(); ++j)
           if (i != decayContributions[j].second)
-            m_densitiesbyfeeddown[feed_index][i] += decayContributions[j].first * m_densities[decayContributions[j].second];
+            byfeeddown[feed_index][i] += decayContributions[j].first * primordial[decayContributions[j].second];
       }
     }
+  }
 
-    m_FeeddownCalculated = true;
+
+  bool ThermalModelBase::CalculateDensitiesDerivatives(const std::vector<ThermalParameter::Name>& params)
+  {
+    // Implicit derivatives through the entropy per baryon constraint, the canonical treatment of conserved charges,
+    // and the parameter dependence of the thermal branching ratios are not supported
+    if (m_Ensemble != GCE || m_ConstrainMuB)
+      return false;
+
+    if (m_UseWidth && m_TPS->ResonanceWidthIntegrationType() == ThermalParticle::eBW)
+      return false;
+
+    if (!m_Calculated)
+      CalculatePrimordialDensities();
+
+    if (!m_FeeddownCalculated)
+      CalculateFeeddown();
+
+    std::vector<ThermalParameter::Name> parlist = params;
+    if (parlist.size() == 0) {
+      for (int ip = 0; ip < ThermalParameter::NumberOfTypes; ++ip)
+        parlist.push_back(static_cast<ThermalParameter::Name>(ip));
+    }
+
+    int NN = m_TPS->ComponentsNumber();
+
+    // Chemical potentials fixed by the conservation laws
+    std::vector<ThermalParameter::Name> constrParams;
+    std::vector< std::vector<double> > constrCharges;
+    ConstrainedChemicalPotentials(constrParams, constrCharges);
+
+    std::vector<int> needed(ThermalParameter::NumberOfTypes, 0);
+    for (size_t ip = 0; ip < parlist.size(); ++ip)
+      needed[parlist[ip]] = 1;
+    for (size_t ic = 0; ic < constrParams.size(); ++ic)
+      needed[constrParams[ic]] = 1;
+
+    // Partial derivatives of the primordial densities at fixed muQ, muS, muC
+    std::vector< std::vector<double> > dndp(ThermalParameter::NumberOfTypes);
+    for (int ip = 0; ip < ThermalParameter::NumberOfTypes; ++ip) {
+      if (!needed[ip])
+        continue;
+
+      std::vector<double> dmu(NN, 0.);
+      double dT = 0.;
+      for (int i = 0; i < NN; ++i) {
+        const ThermalParticle &part = m_TPS->Particles()[i];
+        if (ip == ThermalParameter::BaryonChemicalPotential)
+          dmu[i] = part.BaryonCharge();
+        else if (ip == ThermalParameter::ElectricChemicalPotential)
+          dmu[i] = part.ElectricCharge();
+        else if (ip == ThermalParameter::StrangenessChemicalPotential)
+          dmu[i] = part.Strangeness();
+        else if (ip == ThermalParameter::CharmChemicalPotential)
+          dmu[i] = part.Charm();
+        else if (ip == ThermalParameter::Gammaq)
+          dmu[i] = m_Parameters.T * part.AbsoluteQuark() / m_Parameters.gammaq;
+        else if (ip == ThermalParameter::GammaS)
+          dmu[i] = m_Parameters.T * part.AbsoluteStrangeness() / m_Parameters.gammaS;
+        else if (ip == ThermalParameter::GammaC)
+          dmu[i] = m_Parameters.T * part.AbsoluteCharm() / m_Parameters.gammaC;
+      }
+      if (ip == ThermalParameter::Temperature)
+        dT = 1.;
+
+      dndp[ip] = PrimordialDensitiesDerivative(dmu, dT);
+    }
+
+    int NC = static_cast<int>(constrParams.size());
+    MatrixXd constrJac(NC, NC);
+    for (int ic = 0; ic < NC; ++ic) {
+      for (int ic2 = 0; ic2 < NC; ++ic2) {
+        constrJac(ic, ic2) = 0.;
+        for (int i = 0; i < NN; ++i)
+          constrJac(ic, ic2) += constrCharges[ic][i] * dndp[constrParams[ic2]][i];
+      }
+    }
+
+    FullPivLU<MatrixXd> decomp;
+    if (NC > 0) {
+      decomp.compute(constrJac);
+      if (!decomp.isInvertible())
+        return false;
+    }
+
+    m_densitiesderivatives.assign(ThermalParameter::NumberOfTypes, std::vector< std::vector<double> >());
+    for (size_t ip = 0; ip < parlist.size(); ++ip) {
+      int tpar = parlist[ip];
+      std::vector<double> dn = dndp[tpar];
+
+      bool constrained = false;
+      for (int ic = 0; ic < NC; ++ic)
+        constrained |= (constrParams[ic] == tpar);
+
+      if (constrained) {
+        // The chemical potential is fixed by the constraints, the densities do not depend on its input value
+        dn = std::vector<double>(NN, 0.);
+      }
+      else if (NC > 0) {
+        VectorXd rhs(NC);
+        for (int ic = 0; ic < NC; ++ic) {
+          rhs(ic) = 0.;
+          for (int i = 0; i < NN; ++i)
+            rhs(ic) -= constrCharges[ic][i] * dndp[tpar][i];
+        }
+        VectorXd dmuc = decomp.solve(rhs);
+        for (int ic = 0; ic < NC; ++ic)
+          for (int i = 0; i < NN; ++i)
+            dn[i] += dmuc(ic) * dndp[constrParams[ic]][i];
+      }
+
+      ApplyFeeddown(dn, m_densitiesderivatives[tpar]);
+    }
+
+    m_DensitiesDerivativesCalculated = true;
+
+    return true;
+  }
+
+  void ThermalModelBase::ConstrainedChemicalPotentials(std::vector<ThermalParameter::Name>& constrParams, std::vector< std::vector<double> >& constrCharges) const
+  {
+    int NN = m_TPS->ComponentsNumber();
+
+    constrParams.clear();
+    constrCharges.clear();
+    if (m_ConstrainMuQ && m_TPS->hasCharged() && m_TPS->hasBaryons()) {
+      constrParams.push_back(ThermalParameter::ElectricChemicalPotential);
+      constrCharges.push_back(std::vector<double>(NN, 0.));
+      for (int i = 0; i < NN; ++i)
+        constrCharges.back()[i] = m_TPS->Particles()[i].ElectricCharge() - m_QBgoal * m_TPS->Particles()[i].BaryonCharge();
+    }
+    if (m_ConstrainMuS && m_TPS->hasStrange()) {
+      constrParams.push_back(ThermalParameter::StrangenessChemicalPotential);
+      constrCharges.push_back(std::vector<double>(NN, 0.));
+      for (int i = 0; i < NN; ++i)
+        constrCharges.back()[i] = m_TPS->Particles()[i].Strangeness();
+    }
+    if (m_ConstrainMuC && m_TPS->hasCharmed()) {
+      constrParams.push_back(ThermalParameter::CharmChemicalPotential);
+      constrCharges.push_back(std::vector<double>(NN, 0.));
+      for (int i = 0; i < NN; ++i)
+        constrCharges.back()[i] = m_TPS->Particles()[i].Charm();
+    }
   }
 
+  std::vector<double> ThermalModelBase::PrimordialDensitiesDerivative(const std::vector<double>& dmu, double dT)
+  {
+    if (!m_Calculated)
+      CalculatePrimordialDensities();
+
+    const double h = 1.e-4;
+    std::vector<double> chem0 = m_Chem;
+    double T0 = m_Parameters.T;
+
+    for (size_t i = 0; i < m_Chem.size(); ++i)
+      m_Chem[i] = chem0[i] + h * dmu[i];
+    m_Parameters.T = T0 + h * dT;
+    CalculatePrimordialDensities();
+    std::vector<double> ret = m_densities;
+
+    for (size_t i = 0; i < m_Chem.size(); ++i)
+      m_Chem[i] = chem0[i] - h * dmu[i];
+    m_Parameters.T = T0 - h * dT;
+    CalculatePrimordialDensities();
+    for (size_t i = 0; i < ret.size(); ++i)
+      ret[i] = (ret[i] - m_densities[i]) / (2. * h);
+
+    m_Chem = chem0;
+    m_Parameters.T = T0;
+    CalculatePrimordialDensities();
+
+    return ret;
+  }
+
+  double ThermalModelBase::GetDensityDerivative(long long PDGID, Feeddown::Type feeddown, ThermalParameter::Name param)
+  {
+    if (!m_DensitiesDerivativesCalculated
+      || m_densitiesderivatives.size() != static_cast<size_t>(ThermalParameter::NumberOfTypes)
+      || m_densitiesderivatives[param].size() == 0) {
+      if (!CalculateDensitiesDerivatives()) {
+        printf("**WARNING** %s: GetDensityDerivative: Derivatives of densities are not supported for the present setup\n", m_TAG.c_str());
+        return 0.;
+      }
+    }
+
+    if (static_cast<size_t>(feeddown) >= m_densitiesderivatives[param].size()) {
+      printf("**WARNING** %s: GetDensityDerivative: Unknown feeddown: %d\n", m_TAG.c_str(), static_cast<int>(feeddown));
+      return 0.;
+    }
+
+    const std::vector<double> *dens = &m_densitiesderivatives[param][static_cast<int>(feeddown)];
+
+    // 1 - Npart
+    if (m_TPS->PdgToId(PDGID) == -1 && PDGID == 1) {
+      const std::vector<double> &dprim = m_densitiesderivatives[param][static_cast<int>(Feeddown::Primordial)];
+      double ret = 0.;
+      for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+        ret += m_TPS->Particles()[i].BaryonCharge() * dprim[i];
+      return ret;
+    }
+
+    double ret = GetDensity(PDGID, dens);
+
+    // Weak decay contributions from K0S if this particle is not in the list
+    if (feeddown == Feeddown::Weak && m_TPS->PdgToId(310) == -1) {
+      // pi0
+      if (PDGID == 111) {
+        ret += 2. * 0.308 * GetDensity(310, dens);
+      }
+      // pi+,-
+      if (PDGID == 211 || PDGID == -211) {
+        ret += 0.692 * GetDensity(310, dens);
+      }
+    }
+
+    return ret;
+  }
 
   void ThermalModelBase::ConstrainChemicalPotentials(bool resetInitialValues)
   {
@@ -488,6 +823,9 @@ namespace thermalfist {
     m_ConstrainMuS &= m_TPS->hasStrange();
     m_ConstrainMuC &= m_TPS->hasCharmed();
 
+    if (m_ChemContinuation && ConstrainChemicalPotentialsContinuation())
+      return;
+
     vector<double> x22(4);
     x22[0] = m_Parameters.muB;
     x22[1] = m_Parameters.muQ;
@@ -502,11 +840,210 @@ namespace thermalfist {
     while (iter < iterMAX) {
       BroydenEquationsChem eqs(this);
       BroydenJacobianChem jaco(this);
-      BroydenChem broydn(this, &eqs, &jaco);
+      m_BroydenChem.SetModel(this);
+      m_BroydenChem.SetEquations(&eqs);
+      m_BroydenChem.SetJacobian(&jaco);
       Broyden::BroydenSolutionCriterium crit(1.0E-8);
-      broydn.Solve(x22, &crit);
+      m_BroydenChem.Solve(x22, &crit);
+      m_BroydenChem.SetEquations(NULL);
+      m_BroydenChem.SetJacobian(NULL);
       break;
     }
+
+    if (m_ChemContinuation && !m_ConstrainMuB)
+      UpdateChemicalPotentialsContinuation();
+  }
+
+  bool ThermalModelBase::ConstrainChemicalPotentialsContinuation()
+  {
+    if (!m_ChemContinuationValid || m_ConstrainMuB)
+      return false;
+
+    std::vector<ThermalParameter::Name> constrParams;
+    std::vector< std::vector<double> > constrCharges;
+    ConstrainedChemicalPotentials(constrParams, constrCharges);
+    if (constrParams.size() == 0 || constrParams != m_ChemContinuationParams)
+      return false;
+
+    int NN = m_TPS->ComponentsNumber();
+    int NC = static_cast<int>(constrParams.size());
+
+    double muQinit = m_Parameters.muQ, muSinit = m_Parameters.muS, muCinit = m_Parameters.muC;
+
+    // Predictor: linear extrapolation from the previous solution along the change of T and muB
+    double dT = m_Parameters.T - m_ChemContinuationT;
+    double dmuB = m_Parameters.muB - m_ChemContinuationMuB;
+    if (dT != 0. && !m_ChemContinuationdMudTValid
+      && !CalculateChemicalPotentialsContinuationdMudT(constrParams, constrCharges)) {
+      m_ChemContinuationValid = false;
+      return false;
+    }
+    std::vector<double> x(NC);
+    for (int ic = 0; ic < NC; ++ic) {
+      x[ic] = m_ChemContinuationMu[ic] + m_ChemContinuationdMudMuB[ic] * dmuB;
+      if (dT != 0.)
+        x[ic] += m_ChemContinuationdMudT[ic] * dT;
+    }
+
+    // Corrector: Newton iterations, the Jacobian is evaluated at the predicted point
+    // and subsequently updated using the Broyden's rank-one formula
+    BroydenEquationsChem eqs(this);
+    eqs.SetDimension(NC);
+    const double tolerance = 1.e-8;
+    const int maxCorrections = 3;
+    MatrixXd jac;
+    VectorXd constrPrev(NC), dx(NC);
+    for (int iter = 0; iter <= maxCorrections; ++iter) {
+      std::vector<double> f = eqs.Equations(x);
+
+      double maxdiff = 0.;
+      bool finite = true;
+      for (int ic = 0; ic < NC; ++ic) {
+        finite &= (f[ic] == f[ic]);
+        maxdiff = std::max(maxdiff, fabs(f[ic]));
+      }
+      if (!finite)
+        break;
+
+      if (maxdiff < tolerance) {
+        UpdateChemicalPotentialsContinuation();
+        return true;
+      }
+
+      if (iter == maxCorrections)
+        break;
+
+      VectorXd constr(NC);
+      for (int ic = 0; ic < NC; ++ic) {
+        constr(ic) = 0.;
+        for (int i = 0; i < NN; ++i)
+          constr(ic) += constrCharges[ic][i] * m_densities[i];
+      }
+
+      if (iter == 0) {
+        std::vector<double> susc;
+        ChemicalPotentialsSusceptibilities(susc);
+        jac = ConstraintsJacobian(m_TPS, constrParams, constrCharges, susc);
+      }
+      else {
+        jac += (constr - constrPrev - jac * dx) * dx.transpose() / dx.squaredNorm();
+      }
+
+      FullPivLU<MatrixXd> decomp(jac);
+      if (!decomp.isInvertible())
+        break;
+
+      dx = -decomp.solve(constr);
+      constrPrev = constr;
+      for (int ic = 0; ic < NC; ++ic)
+        x[ic] += dx(ic);
+    }
+
+    // Fall back to the full solution starting from the initial values
+    m_ChemContinuationValid = false;
+    m_Parameters.muQ = muQinit;
+    m_Parameters.muS = muSinit;
+    m_Parameters.muC = muCinit;
+    FillChemicalPotentials();
+
+    return false;
+  }
+
+  void ThermalModelBase::ChemicalPotentialsSusceptibilities(std::vector<double>& susc)
+  {
+    susc.resize(m_TPS->ComponentsNumber());
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      susc[i] = m_densities[i] * ParticleScaledVariance(i) / m_Parameters.T;
+  }
+
+  void ThermalModelBase::UpdateChemicalPotentialsContinuation()
+  {
+    std::vector<ThermalParameter::Name> constrParams;
+    std::vector< std::vector<double> > constrCharges;
+    ConstrainedChemicalPotentials(constrParams, constrCharges);
+
+    int NN = m_TPS->ComponentsNumber();
+    int NC = static_cast<int>(constrParams.size());
+
+    if (NC == 0) {
+      m_ChemContinuationValid = false;
+      return;
+    }
+
+    m_ChemContinuationParams = constrParams;
+    m_ChemContinuationT = m_Parameters.T;
+    m_ChemContinuationMuB = m_Parameters.muB;
+    m_ChemContinuationMu.resize(NC);
+    for (int ic = 0; ic < NC; ++ic)
+      m_ChemContinuationMu[ic] = ChargeChemicalPotential(m_Parameters, constrParams[ic]);
+
+    m_ChemContinuationValid = false;
+    m_ChemContinuationdMudTValid = false;
+
+    ChemicalPotentialsSusceptibilities(m_ChemContinuationSusc);
+    FullPivLU<MatrixXd> decomp(ConstraintsJacobian(m_TPS, constrParams, constrCharges, m_ChemContinuationSusc));
+    if (!decomp.isInvertible())
+      return;
+
+    // Derivatives of the constraints with respect to muB at fixed muQ, muS, muC
+    VectorXd rhsmuB(NC);
+    for (int ic = 0; ic < NC; ++ic) {
+      rhsmuB(ic) = 0.;
+      for (int i = 0; i < NN; ++i)
+        rhsmuB(ic) -= constrCharges[ic][i] * m_TPS->Particles()[i].BaryonCharge() * m_ChemContinuationSusc[i];
+    }
+
+    // Implicit function theorem
+    VectorXd dmudmuB = decomp.solve(rhsmuB);
+
+    m_ChemContinuationdMudMuB.resize(NC);
+    for (int ic = 0; ic < NC; ++ic)
+      m_ChemContinuationdMudMuB[ic] = dmudmuB(ic);
+
+    m_ChemContinuationValid = true;
+  }
+
+  bool ThermalModelBase::CalculateChemicalPotentialsContinuationdMudT(const std::vector<ThermalParameter::Name>& constrParams, const std::vector< std::vector<double> >& constrCharges)
+  {
+    int NN = m_TPS->ComponentsNumber();
+    int NC = static_cast<int>(constrParams.size());
+
+    FullPivLU<MatrixXd> decomp(ConstraintsJacobian(m_TPS, constrParams, constrCharges, m_ChemContinuationSusc));
+    if (!decomp.isInvertible())
+      return false;
+
+    // The derivatives of the densities are evaluated at the stored solution,
+    // the parameters of the present point are restored afterwards.
+    // The densities are then the ones at the stored solution and have to be recalculated.
+    ThermalModelParameters params = m_Parameters;
+    m_Parameters.T = m_ChemContinuationT;
+    m_Parameters.muB = m_ChemContinuationMuB;
+    for (int ic = 0; ic < NC; ++ic)
+      SetChargeChemicalPotential(m_Parameters, constrParams[ic], m_ChemContinuationMu[ic]);
+    FillChemicalPotentials();
+    CalculatePrimordialDensities();
+    std::vector<double> dndT = PrimordialDensitiesDerivative(std::vector<double>(NN, 0.), 1.);
+    m_Parameters = params;
+    FillChemicalPotentials();
+    ResetCalculatedFlags();
+
+    // Derivatives of the constraints with respect to T at fixed muQ, muS, muC
+    VectorXd rhsT(NC);
+    for (int ic = 0; ic < NC; ++ic) {
+      rhsT(ic) = 0.;
+      for (int i = 0; i < NN; ++i)
+        rhsT(ic) -= constrCharges[ic][i] * dndT[i];
+    }
+
+    // Implicit function theorem
+    VectorXd dmudT = decomp.solve(rhsT);
+
+    m_ChemContinuationdMudT.resize(NC);
+    for (int ic = 0; ic < NC; ++ic)
+      m_ChemContinuationdMudT[ic] = dmudT(ic);
+
+    m_ChemContinuationdMudTValid = true;
+    return true;
   }
 
   bool ThermalModelBase::SolveChemicalPotentials(double totB, double totQ, double totS, double totC,
@@ -569,16 +1106,23 @@ namespace thermalfist {
 
     BroydenEquationsChemTotals eqs(vConstr, vType, vTotals, this);
     BroydenJacobianChemTotals jaco(vConstr, vType, vTotals, this);
-    Broyden broydn(&eqs, &jaco);
+    m_BroydenChemTotals.SetEquations(&eqs);
+    m_BroydenChemTotals.SetJacobian(&jaco);
+    m_BroydenChemTotals.ReuseJacobian(m_SolverJacobianReuse);
     Broyden::BroydenSolutionCriterium crit(1.0E-8);
-    broydn.Solve(xinactual, &crit);
+    m_BroydenChemTotals.Solve(xinactual, &crit);
+    m_BroydenChemTotals.SetEquations(NULL);
+    m_BroydenChemTotals.SetJacobian(NULL);
 
-    return (broydn.Iterations() < broydn.MaxIterations());
+    return (m_BroydenChemTotals.Iterations() < m_BroydenChemTotals.MaxIterations());
   }
 
   void ThermalModelBase::CalculateDensities()
   {
-    CalculatePrimordialDensities();
+    {
+      THERMALFIST_PROFILE_SCOPE(PrimordialDensitiesTimer);
+      CalculatePrimordialDensities();
+    }
 
     CalculateFeeddown();
   }
@@ -610,7 +1154,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateHadronDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_densities[i];
@@ -619,7 +1163,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateBaryonDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].BaryonCharge() * m_densities[i];
@@ -628,7 +1172,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateChargeDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].ElectricCharge() * m_densities[i];
@@ -637,7 +1181,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateStrangenessDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].Strangeness() * m_densities[i];
@@ -646,7 +1190,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateCharmDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].Charm() * m_densities[i];
@@ -654,7 +1198,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateAbsoluteBaryonDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += fabs((double)m_TPS->Particles()[i].BaryonCharge()) * m_densities[i];
@@ -662,7 +1206,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateAbsoluteChargeDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += fabs((double)m_TPS->Particles()[i].ElectricCharge()) * m_densities[i];
@@ -670,7 +1214,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateAbsoluteStrangenessDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].AbsoluteStrangeness() * m_densities[i];
@@ -678,7 +1222,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateAbsoluteCharmDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].AbsoluteCharm() * m_densities[i];
@@ -686,7 +1230,7 @@ namespace thermalfist {
   }
 
   double ThermalModelBase::CalculateArbitraryChargeDensity() {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       ret += m_TPS->Particles()[i].ArbitraryCharge() * m_densities[i];
@@ -772,9 +1316,75 @@ namespace thermalfist {
   void ThermalModelBase::ResetCalculatedFlags()
   {
     m_Calculated = false;
+    m_GCECalculated = false;
+    m_DensitiesDerivativesCalculated = false;
+    ResetDerivedCalculatedFlags();
+  }
+
+  void ThermalModelBase::ResetDerivedCalculatedFlags()
+  {
     m_FeeddownCalculated = false;
     m_FluctuationsCalculated = false;
-    m_GCECalculated = false;
+    m_SusceptibilitiesCalculated = false;
+    for (size_t i = 0; i < m_ChargeCumulants.size(); ++i)
+      m_ChargeCumulants[i].clear();
+  }
+
+  void ThermalModelBase::RequirePrimordialDensities()
+  {
+    if (!m_Calculated)
+      CalculatePrimordialDensities();
+  }
+
+  void ThermalModelBase::RequireFeeddown()
+  {
+    RequirePrimordialDensities();
+    if (!m_FeeddownCalculated)
+      CalculateFeeddown();
+  }
+
+  void ThermalModelBase::RequireFluctuations()
+  {
+    RequireFeeddown();
+    if (!m_FluctuationsCalculated)
+      CalculateFluctuations();
+  }
+
+  void ThermalModelBase::RequireSusceptibilities()
+  {
+    RequirePrimordialDensities();
+    if (!m_SusceptibilitiesCalculated)
+      CalculateConservedChargeSusceptibilities();
+  }
+
+  double ThermalModelBase::Susceptibility(ConservedCharge::Name i, ConservedCharge::Name j)
+  {
+    RequireSusceptibilities();
+    return m_Susc[i][j];
+  }
+
+  double ThermalModelBase::ConservedChargeCumulant(ConservedCharge::Name chg, int order)
+  {
+    if (order < 1 || order > 4) {
+      printf("**WARNING** %s: ConservedChargeCumulant: order %d is not supported\n", m_TAG.c_str(), order);
+      return 0.;
+    }
+
+    RequirePrimordialDensities();
+
+    std::vector<double> &cumulants = m_ChargeCumulants[static_cast<int>(chg)];
+    if (static_cast<int>(cumulants.size()) < order) {
+      std::vector<double> chgs(m_TPS->ComponentsNumber());
+      for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+        chgs[i] = m_TPS->Particles()[i].ConservedCharge(chg);
+      cumulants = CalculateChargeFluctuations(chgs, order);
+      if (static_cast<int>(cumulants.size()) < order) {
+        cumulants.clear();
+        return 0.;
+      }
+    }
+
+    return cumulants[order - 1];
   }
 
   double ThermalModelBase::ConservedChargeDensity(ConservedCharge::Name chg)
@@ -792,7 +1402,7 @@ namespace thermalfist {
 
   double ThermalModelBase::ChargedMultiplicity(int type)
   {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
     double ret = 0.0;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
       int tQ = m_TPS->Particles()[i].ElectricCharge();
@@ -811,10 +1421,7 @@ namespace thermalfist {
 
   double ThermalModelBase::ChargedScaledVariance(int type)
   {
-    if (!m_FluctuationsCalculated) {
-      printf("**WARNING** %s: ChargedScaledVariance(int): Fluctuations were not calculated\n", m_TAG.c_str());
-      return 1.;
-    }
+    RequireFluctuations();
     double ret = 0.0;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
       int tQ = m_TPS->Particles()[i].ElectricCharge();
@@ -847,7 +1454,7 @@ namespace thermalfist {
 
   double ThermalModelBase::ChargedMultiplicityFinal(int type)
   {
-    if (!m_Calculated) CalculateDensities();
+    RequirePrimordialDensities();
 
     int op = type;
     if (type == -1)
@@ -855,25 +1462,22 @@ namespace thermalfist {
 
     double ret = 0.0;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      ret += m_densities[i] * m_TPS->Particles()[i].Nch()[op];
+      ret += m_densities[i] * DecayNch(i)[op];
     }
     return ret * Volume();
   }
 
   double ThermalModelBase::ChargedScaledVarianceFinal(int type)
   {
-    if (!m_FluctuationsCalculated) {
-      printf("**WARNING** %s: ChargedScaledVarianceFinal(int): Fluctuations were not calculated\n", m_TAG.c_str());
-      return 1.;
-    }
+    RequireFluctuations();
     int op = type;
     if (type == -1)
       op = 2;
     double ret = 0.0;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      ret += m_densities[i] * Volume() * m_TPS->Particles()[i].DeltaNch()[op];
+      ret += m_densities[i] * Volume() * DecayDeltaNch(i)[op];
       for (int j = 0; j < m_TPS->ComponentsNumber(); ++j) {
-        ret += m_PrimCorrel[i][j] * m_Parameters.T * Volume() * m_TPS->Particles()[i].Nch()[op] * m_TPS->Particles()[j].Nch()[op];
+        ret += m_PrimCorrel[i][j] * m_Parameters.T * Volume() * DecayNch(i)[op] * DecayNch(j)[op];
       }
     }
     return ret / ChargedMultiplicityFinal(type);
@@ -896,11 +1500,11 @@ namespace thermalfist {
     {
       m_TotalCorrel[i][i] = m_PrimCorrel[i][i];
       //for (int r = 0; r < m_TPS->Particles()[i].DecayContributions().size(); ++r) {
-      const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = m_TPS->DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
+      const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
       for (size_t r = 0; r < decayContributions.size(); ++r) {
         int rr = decayContributions[r].second;
       
-        m_TotalCorrel[i][i] += m_densities[rr] / m_Parameters.T * m_TPS->DecayCumulants()[i][r].first[1];
+        m_TotalCorrel[i][i] += m_densities[rr] / m_Parameters.T * DecayCumulants()[i][r].first[1];
         //m_TotalCorrel[i][i] += m_densities[rr] / m_Parameters.T * m_TPS->Particles()[i].DecayCumulants()[r].first[1];
       
         m_TotalCorrel[i][i] += 2. * m_PrimCorrel[i][rr] * decayContributions[r].first;
@@ -920,8 +1524,8 @@ namespace thermalfist {
           if (j != i && m_TPS->Particles()[j].IsStable()) {
             m_TotalCorrel[i][j] = m_PrimCorrel[i][j];
 
-            const ThermalParticleSystem::DecayContributionsToParticle& decayContributionsI = m_TPS->DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
-            const ThermalParticleSystem::DecayContributionsToParticle& decayContributionsJ = m_TPS->DecayContributionsByFeeddown()[Feeddown::StabilityFlag][j];
+            const ThermalParticleSystem::DecayContributionsToParticle& decayContributionsI = DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
+            const ThermalParticleSystem::DecayContributionsToParticle& decayContributionsJ = DecayContributionsByFeeddown()[Feeddown::StabilityFlag][j];
             
             for (size_t r = 0; r < decayContributionsJ.size(); ++r) {
               int rr = decayContributionsJ[r].second;
@@ -947,7 +1551,7 @@ namespace thermalfist {
               if (r != i && r != j) { // && !m_TPS->Particles()[r].IsStable()) {
                 double nij = 0., ni = 0., nj = 0., dnij = 0.;
                 //const ThermalParticle &tpart = m_TPS->Particle(r);
-                const ThermalParticleSystem::ResonanceFinalStatesDistribution &decayDistributions = m_TPS->ResonanceFinalStatesDistributions()[r];
+                const ThermalParticleSystem::ResonanceFinalStatesDistribution &decayDistributions = ResonanceFinalStatesDistributions()[r];
                 for (size_t br = 0; br < decayDistributions.size(); ++br) {
                   nij += decayDistributions[br].first * decayDistributions[br].second[i] * decayDistributions[br].second[j];
                   ni  += decayDistributions[br].first * decayDistributions[br].second[i];
@@ -1201,6 +1805,15 @@ namespace thermalfist {
         m_Susc[i][j] = m_Susc[i][j] / m_Parameters.T / m_Parameters.T / xMath::GeVtoifm() / xMath::GeVtoifm() / xMath::GeVtoifm();
       }
     }
+
+    m_SusceptibilitiesCalculated = true;
+  }
+
+  void ThermalModelBase::CalculateConservedChargeSusceptibilities()
+  {
+    // Generic case: the susceptibilities follow from the particle number correlations
+    RequireFluctuations();
+    m_SusceptibilitiesCalculated = true;
   }
 
   void ThermalModelBase::CalculateProxySusceptibilityMatrix()
@@ -1274,6 +1887,165 @@ namespace thermalfist {
     }
   }
 
+  ThermalModelState ThermalModelBase::GetState() const
+  {
+    ThermalModelState ret;
+    ret.ModelTag = m_TAG;
+    ret.ComponentsNumber = ComponentsNumber();
+    ret.Parameters = m_Parameters;
+    WriteState(ret);
+    return ret;
+  }
+
+  bool ThermalModelBase::SetState(const ThermalModelState& state)
+  {
+    if (state.ModelTag != m_TAG || state.ComponentsNumber != ComponentsNumber()) {
+      printf("**WARNING** %s::SetState: The state of %s with %d species is incompatible with the model\n",
+        m_TAG.c_str(), state.ModelTag.c_str(), state.ComponentsNumber);
+      return false;
+    }
+    ReadState(state);
+
+    // The thermal branching ratios are not written to file, evaluate them anew.
+    // This is done once the whole ReadState() chain has restored the model-specific
+    // variables, such as the chemical potential shifts in the interacting models.
+    if (m_FeeddownCalculated && !m_ThermalDecays && m_UseWidth && m_TPS->ResonanceWidthIntegrationType() == ThermalParticle::eBW)
+      CalculateFeeddown();
+
+    return true;
+  }
+
+  bool ThermalModelBase::LoadState(const std::string& filename)
+  {
+    ThermalModelState state;
+    if (!state.ReadFromFile(filename))
+      return false;
+    return SetState(state);
+  }
+
+  void ThermalModelBase::WriteState(ThermalModelState& state) const
+  {
+    state.Scalars["QoverB"] = m_QBgoal;
+    state.Scalars["SoverB"] = m_SBgoal;
+    state.Scalars["Volume"] = m_Volume;
+    state.Scalars["ConstrainMuB"] = m_ConstrainMuB;
+    state.Scalars["ConstrainMuQ"] = m_ConstrainMuQ;
+    state.Scalars["ConstrainMuS"] = m_ConstrainMuS;
+    state.Scalars["ConstrainMuC"] = m_ConstrainMuC;
+    state.Scalars["Calculated"] = m_Calculated;
+    state.Scalars["FeeddownCalculated"] = m_FeeddownCalculated;
+    state.Scalars["FluctuationsCalculated"] = m_FluctuationsCalculated;
+    state.Scalars["SusceptibilitiesCalculated"] = m_SusceptibilitiesCalculated;
+    state.Scalars["GCECalculated"] = m_GCECalculated;
+    state.Scalars["LastCalculationSuccessFlag"] = m_LastCalculationSuccessFlag;
+    state.Scalars["MaxDiff"] = m_MaxDiff;
+
+    state.Vectors["Chem"] = m_Chem;
+    state.Vectors["Densities"] = m_densities;
+    if (m_FeeddownCalculated) {
+      state.Vectors["DensitiesTotal"] = m_densitiestotal;
+      state.Matrices["DensitiesByFeeddown"] = m_densitiesbyfeeddown;
+      state.ThermalDecays = m_ThermalDecays;
+    }
+
+    // The (potentially large) correlation matrices are only stored if calculated
+    if (m_FluctuationsCalculated) {
+      state.Vectors["wprim"] = m_wprim;
+      state.Vectors["wtot"] = m_wtot;
+      state.Vectors["skewprim"] = m_skewprim;
+      state.Vectors["skewtot"] = m_skewtot;
+      state.Vectors["kurtprim"] = m_kurtprim;
+      state.Vectors["kurttot"] = m_kurttot;
+      state.Matrices["PrimCorrel"] = m_PrimCorrel;
+      state.Matrices["TotalCorrel"] = m_TotalCorrel;
+      state.Matrices["PrimChargesCorrel"] = m_PrimChargesCorrel;
+      state.Matrices["FinalChargesCorrel"] = m_FinalChargesCorrel;
+      state.Matrices["ProxySusc"] = m_ProxySusc;
+    }
+
+    if (m_SusceptibilitiesCalculated)
+      state.Matrices["Susc"] = m_Susc;
+
+    if (m_ChemContinuationValid) {
+      state.Scalars["ChemContinuationT"] = m_ChemContinuationT;
+      state.Scalars["ChemContinuationMuB"] = m_ChemContinuationMuB;
+      std::vector<double> params(m_ChemContinuationParams.size());
+      for (size_t i = 0; i < params.size(); ++i)
+        params[i] = static_cast<double>(m_ChemContinuationParams[i]);
+      state.Vectors["ChemContinuationParams"] = params;
+      state.Vectors["ChemContinuationMu"] = m_ChemContinuationMu;
+      state.Vectors["ChemContinuationSusc"] = m_ChemContinuationSusc;
+      if (m_ChemContinuationdMudTValid)
+        state.Vectors["ChemContinuationdMudT"] = m_ChemContinuationdMudT;
+      state.Vectors["ChemContinuationdMudMuB"] = m_ChemContinuationdMudMuB;
+    }
+  }
+
+  void ThermalModelBase::ReadState(const ThermalModelState& state)
+  {
+    m_Parameters = state.Parameters;
+
+    state.Get("QoverB", m_QBgoal);
+    state.Get("SoverB", m_SBgoal);
+    state.Get("Volume", m_Volume);
+    state.Get("ConstrainMuB", m_ConstrainMuB);
+    state.Get("ConstrainMuQ", m_ConstrainMuQ);
+    state.Get("ConstrainMuS", m_ConstrainMuS);
+    state.Get("ConstrainMuC", m_ConstrainMuC);
+    state.Get("Calculated", m_Calculated);
+    state.Get("FeeddownCalculated", m_FeeddownCalculated);
+    state.Get("FluctuationsCalculated", m_FluctuationsCalculated);
+    m_SusceptibilitiesCalculated = m_FluctuationsCalculated;
+    state.Get("SusceptibilitiesCalculated", m_SusceptibilitiesCalculated);
+    state.Get("GCECalculated", m_GCECalculated);
+    state.Get("LastCalculationSuccessFlag", m_LastCalculationSuccessFlag);
+    state.Get("MaxDiff", m_MaxDiff);
+    m_DensitiesDerivativesCalculated = false;
+
+    state.Get("Chem", m_Chem);
+    state.Get("Densities", m_densities);
+
+    if (m_FeeddownCalculated) {
+      state.Get("DensitiesTotal", m_densitiestotal);
+      state.Get("DensitiesByFeeddown", m_densitiesbyfeeddown);
+      m_ThermalDecays = state.ThermalDecays;
+    }
+
+    if (m_FluctuationsCalculated) {
+      state.Get("wprim", m_wprim);
+      state.Get("wtot", m_wtot);
+      state.Get("skewprim", m_skewprim);
+      state.Get("skewtot", m_skewtot);
+      state.Get("kurtprim", m_kurtprim);
+      state.Get("kurttot", m_kurttot);
+      state.Get("PrimCorrel", m_PrimCorrel);
+      state.Get("TotalCorrel", m_TotalCorrel);
+      state.Get("PrimChargesCorrel", m_PrimChargesCorrel);
+      state.Get("FinalChargesCorrel", m_FinalChargesCorrel);
+      state.Get("ProxySusc", m_ProxySusc);
+    }
+
+    if (m_SusceptibilitiesCalculated)
+      state.Get("Susc", m_Susc);
+
+    for (size_t i = 0; i < m_ChargeCumulants.size(); ++i)
+      m_ChargeCumulants[i].clear();
+
+    std::vector<double> params;
+    m_ChemContinuationValid = state.Get("ChemContinuationParams", params);
+    if (m_ChemContinuationValid) {
+      m_ChemContinuationParams.resize(params.size());
+      for (size_t i = 0; i < params.size(); ++i)
+        m_ChemContinuationParams[i] = static_cast<ThermalParameter::Name>(static_cast<int>(params[i]));
+      state.Get("ChemContinuationT", m_ChemContinuationT);
+      state.Get("ChemContinuationMuB", m_ChemContinuationMuB);
+      state.Get("ChemContinuationMu", m_ChemContinuationMu);
+      m_ChemContinuationValid = state.Get("ChemContinuationSusc", m_ChemContinuationSusc);
+      m_ChemContinuationdMudTValid = state.Get("ChemContinuationdMudT", m_ChemContinuationdMudT);
+      state.Get("ChemContinuationdMudMuB", m_ChemContinuationdMudMuB);
+    }
+  }
+
   void ThermalModelBase::CalculateFluctuations() {
     printf("**WARNING** %s: Calculation of fluctuations is not implemented\n", m_TAG.c_str());
   }
@@ -1602,19 +2374,11 @@ namespace thermalfist {
       JacobianInUse = new BroydenJacobian(m_Equations);
       UseDefaultJacobian = true;
     }
-    m_Iterations = 0;
-    double &maxdiff = m_MaxDifference;
     int N = m_Equations->Dimension();
 
-    
-
-    std::vector<double> tmpvec, xdeltavec = xcur;
-    VectorXd xold(N), xnew(N), xdelta(N);
-    VectorXd fold(N), fnew(N), fdelta(N);
-
-    xold = VectorXd::Map(&xcur[0], xcur.size());
-
-    MatrixXd Jac = Eigen::Map< Matrix<double, Dynamic, Dynamic, RowMajor> >(&JacobianInUse->Jacobian(xcur)[0], N, N);
+    std::vector<double> JacVec = JacobianInUse->Jacobian(xcur);
+    m_JacobianEvaluations++;
+    Eigen::Map< Matrix<double, Dynamic, Dynamic, RowMajor> > Jac(&JacVec[0], N, N);
 
     bool constrmuB = m_THM->ConstrainMuB();
     bool constrmuQ = m_THM->ConstrainMuQ();
@@ -1654,6 +2418,14 @@ namespace thermalfist {
       NNN++;
     }
     if (repeat) {
+      if (UseDefaultSolutionCriterium) {
+        delete SolutionCriterium;
+        SolutionCriterium = NULL;
+      }
+      if (UseDefaultJacobian) {
+        delete JacobianInUse;
+        JacobianInUse = NULL;
+      }
       std::vector<double> ret = Solve(x0, solcrit, max_iterations);
       m_THM->ConstrainMuQ(constrmuB);
       m_THM->ConstrainMuQ(constrmuQ);
@@ -1662,59 +2434,7 @@ namespace thermalfist {
       return ret;
     }
 
-    if (Jac.determinant() == 0.0)
-    {
-      printf("**WARNING** Singular Jacobian in Broyden::Solve\n");
-      return xcur;
-    }
-
-    MatrixXd Jinv = Jac.inverse();
-    tmpvec = m_Equations->Equations(xcur);
-    fold = VectorXd::Map(&tmpvec[0], tmpvec.size());
-
-    for (m_Iterations = 1; m_Iterations < max_iterations; ++m_Iterations) {
-      xnew = xold - Jinv * fold;
-
-      VectorXd::Map(&xcur[0], xcur.size()) = xnew;
-
-      tmpvec = m_Equations->Equations(xcur);
-      fnew = VectorXd::Map(&tmpvec[0], tmpvec.size());
-
-
-      maxdiff = 0.;
-      for (size_t i = 0; i < xcur.size(); ++i) {
-        maxdiff = std::max(maxdiff, fabs(fnew[i]));
-      }
-
-      xdelta = xnew - xold;
-      fdelta = fnew - fold;
-
-      VectorXd::Map(&xdeltavec[0], xdeltavec.size()) = xdelta;
-
-      if (SolutionCriterium->IsSolved(xcur, tmpvec, xdeltavec))
-        break;
-
-      if (!m_UseNewton) // Use Broyden's method
-      {
-
-        double norm = 0.;
-        for (int i = 0; i < N; ++i)
-          for (int j = 0; j < N; ++j)
-            norm += xdelta[i] * Jinv(i, j) * fdelta[j];
-        VectorXd p1(N);
-        p1 = (xdelta - Jinv * fdelta);
-        for (int i = 0; i < N; ++i) p1[i] *= 1. / norm;
-        Jinv = Jinv + (p1 * xdelta.transpose()) * Jinv;
-      }
-      else // Use Newton's method
-      {
-        Jac = Eigen::Map< Matrix<double, Dynamic, Dynamic, RowMajor> >(&JacobianInUse->Jacobian(xcur)[0], N, N);
-        Jinv = Jac.inverse();
-      }
-
-      xold = xnew;
-      fold = fnew;
-    }
+    xcur = Iterate(xcur, JacobianInUse, SolutionCriterium, max_iterations, &JacVec);
 
     if (m_Iterations == max_iterations) {
       printf("**WARNING** Reached maximum number of iterations in Broyden procedure\n");
@@ -6,6 +6,11 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/ThermalModelCanonical.h"
+#include "HRGBase/Profiling.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 #include <iostream>
 #include <cmath>
@@ -20,7 +25,7 @@ using namespace std;
 namespace thermalfist {
 
   ThermalModelCanonical::ThermalModelCanonical(ThermalParticleSystem *TPS_, const ThermalModelParameters& params) :
-    ThermalModelBase(TPS_, params), m_BCE(1), m_QCE(1), m_SCE(1), m_CCE(1), m_IntegrationIterationsMultiplier(1)
+    ThermalModelBase(TPS_, params), m_BCE(1), m_QCE(1), m_SCE(1), m_CCE(1), m_IntegrationIterationsMultiplier(1), m_UseFFT(false)
   {
 
     m_TAG = "ThermalModelCanonical";
@@ -39,6 +44,14 @@ namespace thermalfist {
     CleanModelGCE();
   }
 
+  ThermalModelCanonical* ThermalModelCanonical::Clone() const
+  {
+    ThermalModelCanonical *ret = new ThermalModelCanonical(*this);
+    // The auxiliary GCE model is not shared with the copy, it is created anew when needed
+    ret->m_modelgce = NULL;
+    return ret;
+  }
+
   void ThermalModelCanonical::ChangeTPS(ThermalParticleSystem *TPS_) {
     ThermalModelBase::ChangeTPS(TPS_);
   }
@@ -51,12 +64,12 @@ namespace thermalfist {
     m_CMAX = 0;
 
 
+    // Quantum statistics of the particles with canonically conserved charges is always
+    // treated with the cluster expansion, the calculation type of the shared particle list is not used
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      ThermalParticle &part = m_TPS->Particle(i);
+      const ThermalParticle &part = m_TPS->Particles()[i];
 
       if (part.Statistics() != 0 && IsParticleCanonical(part)) {
-        part.SetCalculationType(IdealGasFunctions::ClusterExpansion);
-
         m_BMAX = max(m_BMAX, abs(part.BaryonCharge() * part.ClusterExpansionOrder()));
         m_QMAX = max(m_QMAX, abs(part.ElectricCharge() * part.ClusterExpansionOrder()));
         m_SMAX = max(m_SMAX, abs(part.Strangeness() * part.ClusterExpansionOrder()));
@@ -115,6 +128,20 @@ namespace thermalfist {
 
   }
 
+  int ThermalModelCanonical::QuantumNumbersIndex(int B, int Q, int S, int C) const
+  {
+    B *= m_BCE;
+    Q *= m_QCE;
+    S *= m_SCE;
+    C *= m_CCE;
+
+    if (abs(B) > m_BMAX || abs(Q) > m_QMAX || abs(S) > m_SMAX || abs(C) > m_CMAX)
+      return -1;
+
+    // Same ordering as in CalculateQuantumNumbersRange()
+    return (((B + m_BMAX) * (2 * m_QMAX + 1) + (Q + m_QMAX)) * (2 * m_SMAX + 1) + (S + m_SMAX)) * (2 * m_CMAX + 1) + (C + m_CMAX);
+  }
+
   void ThermalModelCanonical::SetStatistics(bool stats) {
     m_QuantumStats = stats;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
@@ -126,6 +153,7 @@ namespace thermalfist {
     }
     m_PartialZ.clear();
     //CalculateQuantumNumbersRange();
+    ResetCalculatedFlags();
   }
 
   void ThermalModelCanonical::FixParameters()
@@ -148,12 +176,12 @@ namespace thermalfist {
 
 
   void ThermalModelCanonical::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     if (m_PartialZ.size() == 0)
       CalculateQuantumNumbersRange();
 
-    if (m_BMAX_list == 1 && m_BCE && m_QCE && m_SCE && m_CCE && !UsePartialChemicalEquilibrium()) {
+    if (m_BMAX_list == 1 && m_BCE && m_QCE && m_SCE && m_CCE && !UsePartialChemicalEquilibrium() && !m_UseFFT) {
       m_Banalyt = true;
       m_Parameters.muB = 0.0;
       m_Parameters.muQ = 0.0;
@@ -183,19 +211,11 @@ namespace thermalfist {
       if (!IsParticleCanonical(tpart)) {
         m_densities[i] = tpart.Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
       }
-      else if (tpart.Statistics() == 0
-        || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion)
-      {
-        int ind = m_QNMap[QuantumNumbers(m_BCE * tpart.BaryonCharge(), m_QCE * tpart.ElectricCharge(), m_SCE * tpart.Strangeness(), m_CCE * tpart.Charm())];
-
-        if (ind < static_cast<int>(m_Corr.size()))
-          m_densities[i] = m_Corr[ind] * tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-      }
       else {
-        for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-          int ind = m_QNMap[QuantumNumbers(m_BCE*n*tpart.BaryonCharge(), m_QCE*n*tpart.ElectricCharge(), m_SCE*n*tpart.Strangeness(), m_CCE*n*tpart.Charm())];
-          if (ind < static_cast<int>(m_Corr.size()))
-            m_densities[i] += m_Corr[ind] * tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
+        for (size_t in = 0; in < m_DensitiesCluster[i].size(); ++in) {
+          int ind = m_ClusterQNIndices[i][in];
+          if (ind != -1)
+            m_densities[i] += m_Corr[ind] * m_DensitiesCluster[i][in];
         }
       }
     }
@@ -288,6 +308,8 @@ Obtained: %lf\n\
 
   void ThermalModelCanonical::CalculatePartitionFunctions(double Vc)
   {
+    THERMALFIST_PROFILE_SCOPE(PartitionFunctionsTimer);
+
     if (Vc < 0.0)
       Vc = m_Parameters.SVc;
 
@@ -319,49 +341,74 @@ Obtained: %lf\n\
     vector<double> Nsx(m_PartialZ.size(), 0.);
     vector<double> Nsy(m_PartialZ.size(), 0.);
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      ThermalParticle &tpart = m_TPS->Particle(i);
+    int NN = m_TPS->ComponentsNumber();
+    m_DensitiesCluster.resize(NN);
+    m_ClusterQNIndices.resize(NN);
+
+    // Cluster densities of all species, the species are independent
+    vector<double> densNonCanonical(NN, 0.);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      const ThermalParticle &tpart = m_TPS->Particles()[i];
+
+      m_DensitiesCluster[i].clear();
+      m_ClusterQNIndices[i].clear();
 
       if (!IsParticleCanonical(tpart)) {
-        int ind = m_QNMap[QuantumNumbers(m_BCE * tpart.BaryonCharge(), m_QCE * tpart.ElectricCharge(), m_SCE * tpart.Strangeness(), m_CCE * tpart.Charm())];
-        if (ind != m_QNMap[QuantumNumbers(0, 0, 0, 0)]) {
+        densNonCanonical[i] = tpart.Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
+        continue;
+      }
+
+      int nmax = tpart.ClusterExpansionOrder();
+      if (tpart.Statistics() == 0)
+        nmax = 1;
+
+      for (int n = 1; n <= nmax; ++n) {
+        int ind = QuantumNumbersIndex(n * tpart.BaryonCharge(), n * tpart.ElectricCharge(), n * tpart.Strangeness(), n * tpart.Charm());
+        double tdens = 0.;
+        if (ind != -1) {
+          if (!UsePartialChemicalEquilibrium())
+            tdens = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, 0.);
+          // Currently only works at mu = 0!!
+          else
+            tdens = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
+        }
+        m_DensitiesCluster[i].push_back(tdens);
+        m_ClusterQNIndices[i].push_back(ind);
+      }
+    }
+
+    // The sums over species are taken in a fixed order
+    for (int i = 0; i < NN; ++i) {
+      const ThermalParticle &tpart = m_TPS->Particles()[i];
+
+      if (!IsParticleCanonical(tpart)) {
+        int ind = QuantumNumbersIndex(tpart.BaryonCharge(), tpart.ElectricCharge(), tpart.Strangeness(), tpart.Charm());
+        if (ind != QuantumNumbersIndex(0, 0, 0, 0)) {
           printf("**ERROR** ThermalModelCanonical: neutral particle cannot have non-zero ce charges\n");
           exit(1);
         }
-        if (ind < static_cast<int>(Nsx.size()))
-          Nsx[ind] += tpart.Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-      }
-      else if (tpart.Statistics() == 0
-        || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion) {
-        int ind = m_QNMap[QuantumNumbers(m_BCE * tpart.BaryonCharge(), m_QCE * tpart.ElectricCharge(), m_SCE * tpart.Strangeness(), m_CCE * tpart.Charm())];
-        if (ind < static_cast<int>(Nsx.size())) {
-          if (!UsePartialChemicalEquilibrium()) {
-            double tdens = tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, 0.);
-            Nsx[ind] += tdens * cosh(m_Chem[i] / m_Parameters.T);
-            Nsy[ind] += tdens * sinh(m_Chem[i] / m_Parameters.T);
-          }
-          // Currently only works at mu = 0!!
-          else {
-            double tdens = tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-            Nsx[ind] += tdens;
-          }
-        }
+        Nsx[ind] += densNonCanonical[i];
+        continue;
       }
-      else {
-        for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-          int ind = m_QNMap[QuantumNumbers(m_BCE*n*tpart.BaryonCharge(), m_QCE*n*tpart.ElectricCharge(), m_SCE*n*tpart.Strangeness(), m_CCE*n*tpart.Charm())];
-          if (ind < static_cast<int>(Nsx.size())) {
-            if (!UsePartialChemicalEquilibrium()) {
-              double tdens = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, 0.) / static_cast<double>(n); // TODO: Check
-              Nsx[ind] += tdens * cosh(n * m_Chem[i] / m_Parameters.T);
-              Nsy[ind] += tdens * sinh(n * m_Chem[i] / m_Parameters.T);
-            }
-            // Currently only works at mu = 0!!
-            else {
-              double tdens = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]) / static_cast<double>(n); // TODO: Check
-              Nsx[ind] += tdens;
-            }
-          }
+
+      for (size_t in = 0; in < m_DensitiesCluster[i].size(); ++in) {
+        int n = in + 1;
+        int ind = m_ClusterQNIndices[i][in];
+        if (ind == -1)
+          continue;
+        if (!UsePartialChemicalEquilibrium()) {
+          double tdens = m_DensitiesCluster[i][in];
+          Nsx[ind] += tdens / static_cast<double>(n) * cosh(n * m_Chem[i] / m_Parameters.T); // TODO: Check
+          Nsy[ind] += tdens / static_cast<double>(n) * sinh(n * m_Chem[i] / m_Parameters.T);
+          // The n-th cluster density is proportional to exp(n mu / T)
+          if (m_Chem[i] != 0.0)
+            m_DensitiesCluster[i][in] *= exp(n * m_Chem[i] / m_Parameters.T);
+        }
+        else {
+          Nsx[ind] += m_DensitiesCluster[i][in] / static_cast<double>(n);
         }
       }
     }
@@ -400,6 +447,14 @@ Obtained: %lf\n\
         m_MultExpBanalyt += Nsx[i];
     }
 
+    if (m_UseFFT && !m_Banalyt && CalculatePartitionFunctionsFFT(Nsx, Nsy)) {
+      m_Corr.resize(m_PartialZ.size());
+      for (size_t iN = 0; iN < m_PartialZ.size(); ++iN) {
+        m_Corr[iN] = m_PartialZ[iN] / m_PartialZ[QuantumNumbersIndex(0, 0, 0, 0)];
+      }
+      return;
+    }
+
     double dphiB = xMath::Pi() / nmaxB;
     int maxB = 2 * nmaxB;
     if (m_BMAX == 0 || m_Banalyt)
@@ -484,6 +539,8 @@ Obtained: %lf\n\
               wlegC[0] = 1.;
             }
 
+            THERMALFIST_PROFILE_COUNT(PartitionFunctionNodes, static_cast<long long>(xlegB.size() * xlegS.size() * xlegQ.size() * xlegC.size()));
+
             for (size_t iBt = 0; iBt < xlegB.size(); ++iBt) {
               for (size_t iSt = 0; iSt < xlegS.size(); ++iSt) {
                 for (size_t iQt = 0; iQt < xlegQ.size(); ++iQt) {
@@ -577,8 +634,82 @@ Obtained: %lf\n\
 
     m_Corr.resize(m_PartialZ.size());
     for (size_t iN = 0; iN < m_PartialZ.size(); ++iN) {
-      m_Corr[iN] = m_PartialZ[iN] / m_PartialZ[m_QNMap[QuantumNumbers(0, 0, 0, 0)]];
+      m_Corr[iN] = m_PartialZ[iN] / m_PartialZ[QuantumNumbersIndex(0, 0, 0, 0)];
+    }
+  }
+
+  bool ThermalModelCanonical::CalculatePartitionFunctionsFFT(const std::vector<double>& Nsx, const std::vector<double>& Nsy)
+  {
+    // Order of the dimensions: B, Q, S, C
+    int XMAX[4] = { m_BMAX, m_QMAX, m_SMAX, m_CMAX };
+    int target[4] = { m_Parameters.B, m_Parameters.Q, m_Parameters.S, m_Parameters.C };
+
+    // Mean and variance of the net charges, used to choose the grid size
+    double mean[4] = { 0., 0., 0., 0. }, var[4] = { 0., 0., 0., 0. };
+    for (size_t i = 0; i < m_QNvec.size(); ++i) {
+      int qn[4] = { m_QNvec[i].B, m_QNvec[i].Q, m_QNvec[i].S, m_QNvec[i].C };
+      for (int d = 0; d < 4; ++d) {
+        mean[d] += qn[d] * Nsy[i];
+        var[d] += qn[d] * qn[d] * fabs(Nsx[i]);
+      }
+    }
+
+    // The partition function with the charges N is aliased with those with N + M,
+    // the grid size M is chosen such that the latter are negligible
+    std::vector<int> dims(4, 1);
+    long long total = 1;
+    for (int d = 0; d < 4; ++d) {
+      if (XMAX[d] == 0)
+        continue;
+      int span = abs(target[d]) + XMAX[d];
+      int Mmin = 2 * (span + static_cast<int>(ceil(fabs(mean[d])))) + static_cast<int>(ceil(8. * sqrt(var[d]))) + 16;
+      Mmin *= m_IntegrationIterationsMultiplier;
+      while (dims[d] < Mmin)
+        dims[d] *= 2;
+      total *= dims[d];
+    }
+
+    const long long maxGridSize = (1LL << 24);
+    if (total > maxGridSize) {
+      printf("**WARNING** ThermalModelCanonical::CalculatePartitionFunctionsFFT: Required grid is too large, using quadratures instead\n");
+      return false;
+    }
+
+    THERMALFIST_PROFILE_COUNT(PartitionFunctionNodes, total);
+
+    // Logarithm of the integrand, sum_q W_q e^{i q phi}, is itself a Fourier series
+    std::vector< std::complex<double> > data(total, std::complex<double>(0., 0.));
+    for (size_t i = 0; i < m_QNvec.size(); ++i) {
+      if (Nsx[i] == 0. && Nsy[i] == 0.)
+        continue;
+      int qn[4] = { m_QNvec[i].B, m_QNvec[i].Q, m_QNvec[i].S, m_QNvec[i].C };
+      int indp = 0, indm = 0;
+      for (int d = 0; d < 4; ++d) {
+        indp = indp * dims[d] + ((qn[d] % dims[d]) + dims[d]) % dims[d];
+        indm = indm * dims[d] + ((-qn[d] % dims[d]) + dims[d]) % dims[d];
+      }
+      // Nsx cos(q phi) + i Nsy sin(q phi)
+      data[indp] += 0.5 * (Nsx[i] + Nsy[i]);
+      data[indm] += 0.5 * (Nsx[i] - Nsy[i]);
+      data[0] -= Nsx[i];
+    }
+
+    NumericalIntegration::FFT(data, dims, true);
+
+    for (long long k = 0; k < total; ++k)
+      data[k] = exp(data[k]);
+
+    NumericalIntegration::FFT(data, dims, false);
+
+    for (size_t iN = 0; iN < m_PartialZ.size(); ++iN) {
+      int tg[4] = { target[0] - m_QNvec[iN].B, target[1] - m_QNvec[iN].Q, target[2] - m_QNvec[iN].S, target[3] - m_QNvec[iN].C };
+      int ind = 0;
+      for (int d = 0; d < 4; ++d)
+        ind = ind * dims[d] + ((tg[d] % dims[d]) + dims[d]) % dims[d];
+      m_PartialZ[iN] = data[ind].real() / static_cast<double>(total);
     }
+
+    return true;
   }
 
   double ThermalModelCanonical::ParticleScaledVariance(int part)
@@ -589,37 +720,35 @@ Obtained: %lf\n\
     if (!IsParticleCanonical(tpart)) {
       return tpart.ScaledVariance(m_Parameters, m_UseWidth, m_Chem[part]);
     }
-    else if (tpart.Statistics() == 0
-      || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion)
+    else if (tpart.Statistics() == 0)
     {
-      int ind = m_QNMap[QuantumNumbers(m_BCE*tpart.BaryonCharge(), m_QCE*tpart.ElectricCharge(), m_SCE*tpart.Strangeness(), m_CCE*tpart.Charm())];
-      int ind2 = m_QNMap[QuantumNumbers(m_BCE * 2 * tpart.BaryonCharge(), m_QCE * 2 * tpart.ElectricCharge(), m_SCE * 2 * tpart.Strangeness(), m_CCE * 2 * tpart.Charm())];
+      int ind = m_ClusterQNIndices[part][0];
+      int ind2 = QuantumNumbersIndex(2 * tpart.BaryonCharge(), 2 * tpart.ElectricCharge(), 2 * tpart.Strangeness(), 2 * tpart.Charm());
 
       ret1 = 1.;
-      if (ind < static_cast<int>(m_Corr.size()) && ind2 < static_cast<int>(m_Corr.size()))
-        ret2 = m_Corr[ind2] / m_Corr[ind] * m_Parameters.SVc * tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[part]);
+      if (ind != -1 && ind2 != -1)
+        ret2 = m_Corr[ind2] / m_Corr[ind] * m_Parameters.SVc * m_DensitiesCluster[part][0];
 
-      if (ind < static_cast<int>(m_Corr.size()))
-        ret3 = -m_Corr[ind] * m_Parameters.SVc * tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[part]);
+      if (ind != -1)
+        ret3 = -m_Corr[ind] * m_Parameters.SVc * m_DensitiesCluster[part][0];
     }
     else {
       double ret1num = 0., ret1zn = 0.;
-      for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-        int ind = m_QNMap[QuantumNumbers(m_BCE*n*tpart.BaryonCharge(), m_QCE*n*tpart.ElectricCharge(), m_SCE*n*tpart.Strangeness(), m_CCE*n*tpart.Charm())];
+      int nmax = m_DensitiesCluster[part].size();
+      for (int n = 1; n <= nmax; ++n) {
+        int ind = m_ClusterQNIndices[part][n - 1];
 
-        double densityClusterN = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[part]);
+        double densityClusterN = m_DensitiesCluster[part][n - 1];
 
-        if (ind < static_cast<int>(m_Corr.size())) {
+        if (ind != -1) {
           ret1num += m_Corr[ind] * n * densityClusterN;
           ret1zn += m_Corr[ind] * densityClusterN;
         }
 
-        for (int n2 = 1; n2 <= tpart.ClusterExpansionOrder(); ++n2) {
-          if (m_QNMap.count(QuantumNumbers(m_BCE*(n + n2)*tpart.BaryonCharge(), m_QCE*(n + n2)*tpart.ElectricCharge(), m_SCE*(n + n2)*tpart.Strangeness(), m_CCE*(n + n2)*tpart.Charm())) != 0) {
-            int ind2 = m_QNMap[QuantumNumbers(m_BCE*(n + n2)*tpart.BaryonCharge(), m_QCE*(n + n2)*tpart.ElectricCharge(), m_SCE*(n + n2)*tpart.Strangeness(), m_CCE*(n + n2)*tpart.Charm())];
-            if (ind < static_cast<int>(m_Corr.size()) && ind2 < static_cast<int>(m_Corr.size()))
-              ret2 += densityClusterN * m_Corr[ind2] * m_Parameters.SVc * tpart.DensityCluster(n2, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[part]);
-          }
+        for (int n2 = 1; n2 <= nmax; ++n2) {
+          int ind2 = QuantumNumbersIndex((n + n2)*tpart.BaryonCharge(), (n + n2)*tpart.ElectricCharge(), (n + n2)*tpart.Strangeness(), (n + n2)*tpart.Charm());
+          if (ind != -1 && ind2 != -1)
+            ret2 += densityClusterN * m_Corr[ind2] * m_Parameters.SVc * m_DensitiesCluster[part][n2 - 1];
         }
       }
 
@@ -648,56 +777,79 @@ Obtained: %lf\n\
       if (!IsParticleCanonical(tpart)) {
         ret1num[i] = tpart.ScaledVariance(m_Parameters, m_UseWidth, m_Chem[i]) * yld[i];
       }
-      else if (tpart.Statistics() == 0
-        || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion)
+      else if (tpart.Statistics() == 0)
       {
         ret1num[i] = yld[i];
       }
       else {
-        for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-          int ind = m_QNMap[QuantumNumbers(m_BCE*n*tpart.BaryonCharge(), m_QCE*n*tpart.ElectricCharge(), m_SCE*n*tpart.Strangeness(), m_CCE*n*tpart.Charm())];
+        for (size_t in = 0; in < m_DensitiesCluster[i].size(); ++in) {
+          int ind = m_ClusterQNIndices[i][in];
+          if (ind != -1)
+            ret1num[i] += m_Corr[ind] * (in + 1) * m_DensitiesCluster[i][in] * m_Parameters.SVc;
+        }
+      }
+    }
 
-          double densityClusterN = tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
+    // The canonical chemical factors depend on the species only through the quantum numbers
+    // of their clusters. The two-particle terms are thus evaluated for classes of clusters
+    // with equal quantum numbers, and then scaled with the cluster densities of each species.
+    map<QuantumNumbers, int> classMap;
+    vector<QuantumNumbers> classQN;
+    vector< vector< pair<int, double> > > classDens(NN);
+    vector<int> canonical(NN, 0);
 
-          if (ind < static_cast<int>(m_Corr.size()))
-            ret1num[i] += m_Corr[ind] * n * densityClusterN * m_Parameters.SVc;
+    for (int i = 0; i < NN; ++i) {
+      ThermalParticle &tpart = m_TPS->Particle(i);
+      if (!IsParticleCanonical(tpart))
+        continue;
+      canonical[i] = 1;
+      for (size_t in = 0; in < m_DensitiesCluster[i].size(); ++in) {
+        int n = in + 1;
+        QuantumNumbers qn(m_BCE * n * tpart.BaryonCharge(), m_QCE * n * tpart.ElectricCharge(), m_SCE * n * tpart.Strangeness(), m_CCE * n * tpart.Charm());
+        map<QuantumNumbers, int>::const_iterator it = classMap.find(qn);
+        int cl = 0;
+        if (it == classMap.end()) {
+          cl = classQN.size();
+          classMap[qn] = cl;
+          classQN.push_back(qn);
         }
+        else
+          cl = it->second;
+        classDens[i].push_back(make_pair(cl, m_DensitiesCluster[i][in] * m_Parameters.SVc));
       }
     }
 
-    for (int i = 0; i < NN; ++i) {
-      for (int j = 0; j < NN; ++j) {
-        ThermalParticle &tpart1 = m_TPS->Particle(i);
-        ThermalParticle &tpart2 = m_TPS->Particle(j);
+    int NC = classQN.size();
+    vector< vector<double> > classCorr(NC, vector<double>(NC, 0.));
+    for (int a = 0; a < NC; ++a) {
+      for (int b = 0; b < NC; ++b) {
+        int ind = QuantumNumbersIndex(classQN[a].B + classQN[b].B, classQN[a].Q + classQN[b].Q, classQN[a].S + classQN[b].S, classQN[a].C + classQN[b].C);
+        if (ind != -1)
+          classCorr[a][b] = m_Corr[ind];
+      }
+    }
 
-        int n1max = tpart1.ClusterExpansionOrder();
-        int n2max = tpart2.ClusterExpansionOrder();
+    vector<double> classSum(NC);
+    for (int i = 0; i < NN; ++i) {
+      if (!canonical[i]) {
+        for (int j = 0; j < NN; ++j)
+          ret2num[i][j] = yld[i] * yld[j];
+        continue;
+      }
 
-        if (tpart1.Statistics() == 0 || tpart1.CalculationType() != IdealGasFunctions::ClusterExpansion)
-          n1max = 1;
-        if (tpart2.Statistics() == 0 || tpart2.CalculationType() != IdealGasFunctions::ClusterExpansion)
-          n2max = 1;
+      for (int b = 0; b < NC; ++b) {
+        classSum[b] = 0.;
+        for (size_t ia = 0; ia < classDens[i].size(); ++ia)
+          classSum[b] += classDens[i][ia].second * classCorr[classDens[i][ia].first][b];
+      }
 
-        if (!IsParticleCanonical(tpart1) || !IsParticleCanonical(tpart2)) {
+      for (int j = 0; j < NN; ++j) {
+        if (!canonical[j]) {
           ret2num[i][j] = yld[i] * yld[j];
+          continue;
         }
-        else {
-          for (int n1 = 1; n1 <= n1max; ++n1) {
-            for (int n2 = 1; n2 <= n2max; ++n2) {
-              int ind = m_QNMap[QuantumNumbers(
-                m_BCE*(n1*tpart1.BaryonCharge() + n2 * tpart2.BaryonCharge()),
-                m_QCE*(n1*tpart1.ElectricCharge() + n2 * tpart2.ElectricCharge()),
-                m_SCE*(n1*tpart1.Strangeness() + n2 * tpart2.Strangeness()),
-                m_CCE*(n1*tpart1.Charm() + n2 * tpart2.Charm()))];
-
-              double densityClusterN1 = tpart1.DensityCluster(n1, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-              double densityClusterN2 = tpart2.DensityCluster(n2, m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[j]);
-
-              if (ind < static_cast<int>(m_Corr.size()))
-                ret2num[i][j] += m_Corr[ind] * densityClusterN1 * densityClusterN2 * m_Parameters.SVc * m_Parameters.SVc;
-            }
-          }
-        }
+        for (size_t ib = 0; ib < classDens[j].size(); ++ib)
+          ret2num[i][j] += classSum[classDens[j][ib].first] * classDens[j][ib].second;
       }
     }
 
@@ -729,6 +881,8 @@ Obtained: %lf\n\
   }
 
   void ThermalModelCanonical::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     CalculateTwoParticleCorrelations();
     CalculateSusceptibilityMatrix();
     CalculateTwoParticleFluctuationsDecays();
@@ -747,31 +901,32 @@ Obtained: %lf\n\
 
   double ThermalModelCanonical::CalculateEnergyDensity() {
     if (!m_Calculated) CalculateDensities();
-    double ret = 0.;
+    int NN = m_TPS->ComponentsNumber();
+    vector<double> edens(NN, 0.);
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      ThermalParticle &tpart = m_TPS->Particle(i);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      const ThermalParticle &tpart = m_TPS->Particles()[i];
       {
         if (!IsParticleCanonical(tpart)) {
-          ret += tpart.Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
-        }
-        else if (tpart.Statistics() == 0
-          || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion) {
-          int ind = m_QNMap[QuantumNumbers(tpart.BaryonCharge(), tpart.ElectricCharge(), tpart.Strangeness(), tpart.Charm())];
-
-          if (ind < static_cast<int>(m_Corr.size()))
-            ret += m_Corr[ind] * tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
+          edens[i] = tpart.Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
         }
         else {
-          for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-            int ind = m_QNMap[QuantumNumbers(n*tpart.BaryonCharge(), n*tpart.ElectricCharge(), n*tpart.Strangeness(), n*tpart.Charm())];
-            if (ind < static_cast<int>(m_Corr.size()))
-              ret += m_Corr[ind] * tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
+          for (size_t in = 0; in < m_ClusterQNIndices[i].size(); ++in) {
+            int ind = m_ClusterQNIndices[i][in];
+            if (ind != -1)
+              edens[i] += m_Corr[ind] * tpart.DensityCluster(in + 1, m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
           }
         }
       }
     }
 
+    double ret = 0.;
+    for (int i = 0; i < NN; ++i)
+      ret += edens[i];
+
     return ret;
   }
 
@@ -785,19 +940,12 @@ Obtained: %lf\n\
         if (!IsParticleCanonical(tpart)) {
           ret += tpart.Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
         }
-        else if (tpart.Statistics() == 0
-          || tpart.CalculationType() != IdealGasFunctions::ClusterExpansion) {
-          int ind = m_QNMap[QuantumNumbers(tpart.BaryonCharge(), tpart.ElectricCharge(), tpart.Strangeness(), tpart.Charm())];
-
-          if (ind < static_cast<int>(m_Corr.size()))
-            ret += m_Corr[ind] * tpart.DensityCluster(1, m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
-        }
         else {
-          for (int n = 1; n <= tpart.ClusterExpansionOrder(); ++n) {
-            int ind = m_QNMap[QuantumNumbers(n*tpart.BaryonCharge(), n*tpart.ElectricCharge(), n*tpart.Strangeness(), n*tpart.Charm())];
-
-            if (ind < static_cast<int>(m_Corr.size()))
-              ret += m_Corr[ind] * tpart.DensityCluster(n, m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
+          // The n-th cluster contributes T/n times its density to the pressure
+          for (size_t in = 0; in < m_DensitiesCluster[i].size(); ++in) {
+            int ind = m_ClusterQNIndices[i][in];
+            if (ind != -1)
+              ret += m_Corr[ind] * m_Parameters.T / static_cast<double>(in + 1) * m_DensitiesCluster[i][in];
           }
         }
       }
@@ -808,7 +956,7 @@ Obtained: %lf\n\
 
   double ThermalModelCanonical::CalculateEntropyDensity()
   {
-    double ret = (CalculateEnergyDensity() / m_Parameters.T) + (m_MultExp + m_MultExpBanalyt + log(m_PartialZ[m_QNMap[QuantumNumbers(0, 0, 0, 0)]])) / m_Parameters.SVc;
+    double ret = (CalculateEnergyDensity() / m_Parameters.T) + (m_MultExp + m_MultExpBanalyt + log(m_PartialZ[QuantumNumbersIndex(0, 0, 0, 0)])) / m_Parameters.SVc;
 
     if (m_BCE)
       ret += -m_Parameters.muB / m_Parameters.T * m_Parameters.B / m_Parameters.SVc;
@@ -913,6 +1061,62 @@ Obtained: %lf\n\
     }
   }
 
+  void ThermalModelCanonical::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Scalars["BMAX"] = m_BMAX;
+    state.Scalars["QMAX"] = m_QMAX;
+    state.Scalars["SMAX"] = m_SMAX;
+    state.Scalars["CMAX"] = m_CMAX;
+    state.Scalars["MultExp"] = m_MultExp;
+    state.Scalars["MultExpBanalyt"] = m_MultExpBanalyt;
+    state.Scalars["Banalyt"] = m_Banalyt;
+    state.Vectors["Corr"] = m_Corr;
+    state.Vectors["PartialZ"] = m_PartialZ;
+    state.Matrices["DensitiesCluster"] = m_DensitiesCluster;
+    std::vector< std::vector<double> > qnindices(m_ClusterQNIndices.size());
+    for (size_t i = 0; i < m_ClusterQNIndices.size(); ++i)
+      qnindices[i] = std::vector<double>(m_ClusterQNIndices[i].begin(), m_ClusterQNIndices[i].end());
+    state.Matrices["ClusterQNIndices"] = qnindices;
+  }
+
+  void ThermalModelCanonical::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+
+    // The partition functions are indexed by the quantum numbers range,
+    // which is doubled if the fluctuations were calculated
+    double BMAX = m_BMAX, QMAX = m_QMAX, SMAX = m_SMAX, CMAX = m_CMAX;
+    state.Get("BMAX", BMAX);
+    state.Get("QMAX", QMAX);
+    state.Get("SMAX", SMAX);
+    state.Get("CMAX", CMAX);
+    if (m_PartialZ.size() == 0 || BMAX != m_BMAX || QMAX != m_QMAX || SMAX != m_SMAX || CMAX != m_CMAX) {
+      CalculateQuantumNumbersRange(false);
+      if (BMAX != m_BMAX || QMAX != m_QMAX || SMAX != m_SMAX || CMAX != m_CMAX)
+        CalculateQuantumNumbersRange(true);
+    }
+
+    state.Get("MultExp", m_MultExp);
+    state.Get("MultExpBanalyt", m_MultExpBanalyt);
+    state.Get("Banalyt", m_Banalyt);
+    state.Get("Corr", m_Corr);
+    state.Get("PartialZ", m_PartialZ);
+    state.Get("DensitiesCluster", m_DensitiesCluster);
+    std::vector< std::vector<double> > qnindices;
+    if (state.Get("ClusterQNIndices", qnindices)) {
+      m_ClusterQNIndices.resize(qnindices.size());
+      for (size_t i = 0; i < qnindices.size(); ++i)
+        m_ClusterQNIndices[i] = std::vector<int>(qnindices[i].begin(), qnindices[i].end());
+    }
+
+    if (m_PartialZ.size() != m_QNvec.size()) {
+      printf("**WARNING** %s::ReadState: The canonical partition functions do not match the quantum numbers range, the state is to be recalculated\n", m_TAG.c_str());
+      CalculateQuantumNumbersRange(false);
+      m_Calculated = m_FeeddownCalculated = m_FluctuationsCalculated = false;
+    }
+  }
+
 } // namespace thermalfist
 
 
@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/ThermalModelCanonicalCharm.h"
+#include "HRGBase/Profiling.h"
 
 #include "HRGBase/xMath.h"
 
@@ -46,6 +47,11 @@ namespace thermalfist {
     m_Parameters.muC = 0.;
   }
 
+  ThermalModelCanonicalCharm* ThermalModelCanonicalCharm::Clone() const
+  {
+    return new ThermalModelCanonicalCharm(*this);
+  }
+
   void ThermalModelCanonicalCharm::SetCharmChemicalPotential(double /*muC*/)
   {
     m_Parameters.muC = 0.0;
@@ -61,20 +67,16 @@ namespace thermalfist {
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       if (m_TPS->Particles()[i].Charm() == 0) m_TPS->Particle(i).UseStatistics(stats);
       else m_TPS->Particle(i).UseStatistics(false);
+    ResetCalculatedFlags();
   }
 
   void ThermalModelCanonicalCharm::CalculateDensitiesGCE() {
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_Chem, m_densitiesGCE);
     m_GCECalculated = true;
   }
 
   void ThermalModelCanonicalCharm::CalculateEnergyDensitiesGCE() {
-    m_energydensitiesGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_energydensitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, m_Chem, m_energydensitiesGCE);
   }
 
   void ThermalModelCanonicalCharm::FixParameters()
@@ -89,7 +91,7 @@ namespace thermalfist {
       exit(1);
     }
 
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
     m_energydensitiesGCE.resize(0);
 
     CalculateDensitiesGCE();
@@ -128,6 +130,8 @@ namespace thermalfist {
   }
 
   void ThermalModelCanonicalCharm::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     m_wprim.resize(m_densities.size());
     m_wtot.resize(m_densities.size());
     for (size_t i = 0; i < m_wprim.size(); ++i) {
@@ -164,4 +168,22 @@ namespace thermalfist {
     return (charge == ConservedCharge::CharmCharge);
   }
 
+  void ThermalModelCanonicalCharm::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Vectors["DensitiesGCE"] = m_densitiesGCE;
+    state.Vectors["EnergyDensitiesGCE"] = m_energydensitiesGCE;
+    state.Vectors["Zsum"] = m_Zsum;
+    state.Vectors["PartialZ"] = m_partialZ;
+  }
+
+  void ThermalModelCanonicalCharm::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+    state.Get("DensitiesGCE", m_densitiesGCE);
+    state.Get("EnergyDensitiesGCE", m_energydensitiesGCE);
+    state.Get("Zsum", m_Zsum);
+    state.Get("PartialZ", m_partialZ);
+  }
+
 } // namespace thermalfist
\ No newline at end of file
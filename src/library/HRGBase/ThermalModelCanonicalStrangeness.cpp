@@ -6,6 +6,10 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/ThermalModelCanonicalStrangeness.h"
+#include "HRGBase/Profiling.h"
+
+#include <cmath>
+#include <algorithm>
 
 #include "HRGBase/xMath.h"
 
@@ -14,7 +18,7 @@ using namespace std;
 namespace thermalfist {
 
   ThermalModelCanonicalStrangeness::ThermalModelCanonicalStrangeness(ThermalParticleSystem *TPS_, const ThermalModelParameters& params) :
-    ThermalModelBase(TPS_, params)
+    ThermalModelBase(TPS_, params), m_ZsumLogFactor(0.)
   {
     m_densitiesGCE.resize(m_TPS->Particles().size());
 
@@ -48,6 +52,11 @@ namespace thermalfist {
     m_Parameters.muS = 0.;
   }
 
+  ThermalModelCanonicalStrangeness* ThermalModelCanonicalStrangeness::Clone() const
+  {
+    return new ThermalModelCanonicalStrangeness(*this);
+  }
+
   void ThermalModelCanonicalStrangeness::SetStrangenessChemicalPotential(double /*muS*/)
   {
     m_Parameters.muS = 0.0;
@@ -70,28 +79,21 @@ namespace thermalfist {
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       if (m_TPS->Particles()[i].Strangeness() == 0) m_TPS->Particle(i).UseStatistics(stats);
       else m_TPS->Particle(i).UseStatistics(false);
+    ResetCalculatedFlags();
   }
 
   void ThermalModelCanonicalStrangeness::CalculateDensitiesGCE() {
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_Chem, m_densitiesGCE);
     m_GCECalculated = true;
   }
 
   void ThermalModelCanonicalStrangeness::CalculateEnergyDensitiesGCE() {
-    m_energydensitiesGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_energydensitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, m_Chem, m_energydensitiesGCE);
   }
 
   void ThermalModelCanonicalStrangeness::CalculatePressuresGCE()
   {
-    m_pressuresGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_pressuresGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::Pressure, m_Chem, m_pressuresGCE);
   }
 
   void ThermalModelCanonicalStrangeness::CalculateSums(double Vc)
@@ -99,11 +101,7 @@ namespace thermalfist {
     if (!m_GCECalculated)
       CalculateDensitiesGCE();
 
-    m_Zsum.resize(m_StrVals.size());
-
     m_partialS.resize(m_StrVals.size());
-    vector<double> xi(3, 0.), yi(3, 0.);
-
     for (size_t i = 0; i < m_StrVals.size(); ++i) {
       m_partialS[i] = 0.;
       for (int j = 0; j < m_TPS->ComponentsNumber(); ++j)
@@ -111,30 +109,120 @@ namespace thermalfist {
           m_partialS[i] += m_densitiesGCE[j] * Vc;
     }
 
-    for (int i = 0; i < 3; ++i) {
-      xi[i] = 2. * sqrt(m_partialS[m_StrMap[i + 1]] * m_partialS[m_StrMap[-(i + 1)]]);
-      yi[i] = sqrt(m_partialS[m_StrMap[i + 1]] / m_partialS[m_StrMap[-(i + 1)]]);
+    CalculateZsum();
+  }
+
+  namespace {
+    /// Mean net strangeness for partial sums a and b of |S| = 1, 2, 3 hadrons and antihadrons weighted with exp(lambda * S)
+    double NetStrangeness(const vector<double>& a, const vector<double>& b, double lambda)
+    {
+      double ret = 0.;
+      for (int i = 0; i < 3; ++i)
+        ret += (i + 1) * (a[i] * exp(lambda * (i + 1)) - b[i] * exp(-lambda * (i + 1)));
+      return ret;
+    }
+
+    /// Coefficients c_k = e^{-(a+b)} (a/b)^{k/2} I_|k|(2 sqrt(ab)) for k = kmin,...,kmax,
+    /// i.e. the Skellam distribution with means a and b
+    void SkellamCoefficients(double a, double b, int kmin, int kmax, vector<double>& c)
+    {
+      c.assign(kmax - kmin + 1, 0.);
+      if (a <= 0. && b <= 0.) {
+        if (kmin <= 0 && kmax >= 0)
+          c[-kmin] = 1.;
+        return;
+      }
+      if (a <= 0. || b <= 0.) {
+        // Poisson limit
+        double mean = (a > 0.) ? a : b;
+        int sgn = (a > 0.) ? 1 : -1;
+        for (int k = kmin; k <= kmax; ++k) {
+          int kk = sgn * k;
+          if (kk >= 0)
+            c[k - kmin] = exp(-mean + kk * log(mean) - lgamma(kk + 1.));
+        }
+        return;
+      }
+      double x = 2. * sqrt(a * b);
+      double logy = 0.5 * log(a / b);
+      vector<double> bessel = xMath::BesselIexpSequence(max(abs(kmin), abs(kmax)), x);
+      for (int k = kmin; k <= kmax; ++k) {
+        double tI = bessel[abs(k)];
+        if (tI > 0.)
+          c[k - kmin] = exp(log(tI) + x - a - b + k * logy);
+      }
     }
+  }
 
-    // TODO: Choose iters dynamically based on total strangeness
-    int iters = 20;
+  void ThermalModelCanonicalStrangeness::CalculateZsum()
+  {
+    m_Zsum.resize(m_StrVals.size());
 
-    for (unsigned int i = 0; i < m_StrVals.size(); ++i) {
-      double res = 0.;
+    // The sums for a vanishing net strangeness are exponentially small in the volume
+    // unless the strange and antistrange partial sums balance.
+    // The terms are therefore weighted by exp(lambda * S), with lambda
+    // chosen such that the mean net strangeness vanishes (saddle point).
+    // Z(S) is recovered by the factor exp(-lambda * S).
+    double lambda = StrangenessSaddlePoint();
+
+    // Truncation ranges for the numbers of |S| = 1, 2, 3 units, covering
+    // both the zero and the mean net value with a margin of several standard deviations
+    vector<int> kmin(3), kmax(3);
+    vector< vector<double> > coefs(3);
+    m_ZsumLogFactor = 0.;
+    for (int i = 0; i < 3; ++i) {
+      double a = m_partialS[m_StrMap[i + 1]] * exp(lambda * (i + 1));
+      double b = m_partialS[m_StrMap[-(i + 1)]] * exp(-lambda * (i + 1));
+      double mean = a - b;
+      double width = 10. * sqrt(a + b) + 20.;
+      kmin[i] = static_cast<int>(floor(min(0., mean) - width));
+      kmax[i] = static_cast<int>(ceil(max(0., mean) + width));
+      SkellamCoefficients(a, b, kmin[i], kmax[i], coefs[i]);
+      m_ZsumLogFactor += a + b;
+    }
 
-      for (int m = -iters; m <= iters; ++m)
-        for (int n = -iters; n <= iters; ++n) {
-          double tmp = xMath::BesselI(abs(3 * m + 2 * n - m_StrVals[i]), xi[0]) *
-            xMath::BesselI(abs(n), xi[1]) *
-            xMath::BesselI(abs(m), xi[2]) *
-            pow(yi[0], m_StrVals[i] - 3 * m - 2 * n) *
-            pow(yi[1], n) *
-            pow(yi[2], m);
-          if (tmp != tmp) continue;
-          res += tmp;
+    for (size_t i = 0; i < m_StrVals.size(); ++i) {
+      double res = 0.;
+      for (int m = kmin[2]; m <= kmax[2]; ++m) {
+        double tm = coefs[2][m - kmin[2]];
+        if (tm == 0.)
+          continue;
+        for (int n = kmin[1]; n <= kmax[1]; ++n) {
+          double tn = coefs[1][n - kmin[1]];
+          int k = m_StrVals[i] - 3 * m - 2 * n;
+          if (tn == 0. || k < kmin[0] || k > kmax[0])
+            continue;
+          res += coefs[0][k - kmin[0]] * tn * tm;
         }
-      m_Zsum[i] = res;
+      }
+      m_Zsum[i] = res * exp(-lambda * m_StrVals[i]);
+    }
+  }
+
+  double ThermalModelCanonicalStrangeness::StrangenessSaddlePoint() const
+  {
+    // Mean net strangeness sum_s s * (a_s e^{lambda s} - b_s e^{-lambda s}), increasing in lambda
+    vector<double> a(3), b(3);
+    for (int i = 0; i < 3; ++i) {
+      a[i] = m_partialS[m_StrMap.find(i + 1)->second];
+      b[i] = m_partialS[m_StrMap.find(-(i + 1))->second];
     }
+    if (a[0] + a[1] + a[2] <= 0. || b[0] + b[1] + b[2] <= 0.)
+      return 0.;
+
+    double lmin = -1., lmax = 1.;
+    while (NetStrangeness(a, b, lmin) > 0.)
+      lmin *= 2.;
+    while (NetStrangeness(a, b, lmax) < 0.)
+      lmax *= 2.;
+    for (int iter = 0; iter < 100 && lmax - lmin > 1.e-12; ++iter) {
+      double lmid = 0.5 * (lmin + lmax);
+      if (NetStrangeness(a, b, lmid) < 0.)
+        lmin = lmid;
+      else
+        lmax = lmid;
+    }
+    return 0.5 * (lmin + lmax);
   }
 
   void ThermalModelCanonicalStrangeness::CalculatePrimordialDensities() {
@@ -143,7 +231,7 @@ namespace thermalfist {
       exit(1);
     }
 
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     m_energydensitiesGCE.resize(0);
     m_pressuresGCE.resize(0);
@@ -163,6 +251,8 @@ namespace thermalfist {
 
 
   void ThermalModelCanonicalStrangeness::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     m_wprim.resize(m_densities.size());
     m_wtot.resize(m_densities.size());
     for (size_t i = 0; i < m_wprim.size(); ++i) {
@@ -188,16 +278,18 @@ namespace thermalfist {
 
 
   double ThermalModelCanonicalStrangeness::CalculateEntropyDensity() {
-    double ret = log(m_Zsum[m_StrMap[0]]) / m_Parameters.SVc;
+    double ret = (log(m_Zsum[m_StrMap[0]]) + m_ZsumLogFactor) / m_Parameters.SVc;
     if (m_energydensitiesGCE.size() == 0)
       CalculateEnergyDensitiesGCE();
+    vector<double> sdens;
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, m_Chem, sdens);
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       if (m_TPS->Particles()[i].Strangeness() != 0) {
         if (m_StrMap.count(-m_TPS->Particles()[i].Strangeness()))
           ret += (m_Zsum[m_StrMap[-m_TPS->Particles()[i].Strangeness()]] / m_Zsum[m_StrMap[0]]) * ((m_energydensitiesGCE[i] - m_Chem[i] * m_densitiesGCE[i]) / m_Parameters.T);
       }
       else {
-        ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i]);
+        ret += sdens[i];
       }
     return ret;
   }
@@ -217,4 +309,26 @@ namespace thermalfist {
     return (charge == ConservedCharge::StrangenessCharge);
   }
 
+  void ThermalModelCanonicalStrangeness::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Scalars["ZsumLogFactor"] = m_ZsumLogFactor;
+    state.Vectors["DensitiesGCE"] = m_densitiesGCE;
+    state.Vectors["EnergyDensitiesGCE"] = m_energydensitiesGCE;
+    state.Vectors["PressuresGCE"] = m_pressuresGCE;
+    state.Vectors["Zsum"] = m_Zsum;
+    state.Vectors["PartialS"] = m_partialS;
+  }
+
+  void ThermalModelCanonicalStrangeness::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+    state.Get("ZsumLogFactor", m_ZsumLogFactor);
+    state.Get("DensitiesGCE", m_densitiesGCE);
+    state.Get("EnergyDensitiesGCE", m_energydensitiesGCE);
+    state.Get("PressuresGCE", m_pressuresGCE);
+    state.Get("Zsum", m_Zsum);
+    state.Get("PartialS", m_partialS);
+  }
+
 } // namespace thermalfist
\ No newline at end of file
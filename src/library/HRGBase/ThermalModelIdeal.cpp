@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGBase/ThermalModelIdeal.h"
+#include "HRGBase/Profiling.h"
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -33,21 +34,54 @@ namespace thermalfist {
   }
 
   void ThermalModelIdeal::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densities[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_Chem, m_densities);
 
     m_Calculated = true;
     ValidateCalculation();
   }
 
+  ThermalModelIdeal* ThermalModelIdeal::Clone() const
+  {
+    return new ThermalModelIdeal(*this);
+  }
+
+  std::vector<double> ThermalModelIdeal::PrimordialDensitiesDerivative(const std::vector<double>& dmu, double dT)
+  {
+    if (!m_Calculated)
+      CalculatePrimordialDensities();
+
+    vector<double> ret(m_densities.size(), 0.);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
+      const ThermalParticle &part = m_TPS->Particles()[i];
+      double dmui = dmu[i];
+      if (dT != 0.) {
+        ret[i] += dT * part.Density(m_Parameters, IdealGasFunctions::dndT, m_UseWidth, m_Chem[i]);
+
+        // Fugacity factors enter as T-dependent shifts of the chemical potentials
+        if (!(m_Parameters.gammaq == 1.))                                      dmui += dT * log(m_Parameters.gammaq) * part.AbsoluteQuark();
+        if (!(m_Parameters.gammaS == 1. || part.AbsoluteStrangeness() == 0.))  dmui += dT * log(m_Parameters.gammaS) * part.AbsoluteStrangeness();
+        if (!(m_Parameters.gammaC == 1. || part.AbsoluteCharm() == 0.))        dmui += dT * log(m_Parameters.gammaC) * part.AbsoluteCharm();
+      }
+      if (dmui != 0.)
+        ret[i] += dmui * part.chi(2, m_Parameters, m_UseWidth, m_Chem[i]) * m_Parameters.T * m_Parameters.T * xMath::GeVtoifm3();
+    }
+
+    return ret;
+  }
+
   void ThermalModelIdeal::CalculateTwoParticleCorrelations() {
     int NN = m_densities.size();
     vector<double> tN(NN), tW(NN);
     for (int i = 0; i < NN; ++i) tN[i] = m_densities[i];
 
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
     for (int i = 0; i < NN; ++i) tW[i] = ParticleScaledVariance(i);
 
     m_PrimCorrel.resize(NN);
@@ -71,26 +105,34 @@ namespace thermalfist {
 
 
   void ThermalModelIdeal::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     CalculateTwoParticleCorrelations();
     CalculateSusceptibilityMatrix();
     CalculateTwoParticleFluctuationsDecays();
     CalculateProxySusceptibilityMatrix();
     CalculateParticleChargeCorrelationMatrix();
 
-    for (size_t i = 0; i < m_wprim.size(); ++i) {
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < static_cast<int>(m_wprim.size()); ++i) {
       m_wprim[i] = ParticleScaledVariance(i);
       m_skewprim[i] = ParticleSkewness(i);
       m_kurtprim[i] = ParticleKurtosis(i);
     }
-    for (size_t i = 0; i < m_wtot.size(); ++i) {
+#ifdef USE_OPENMP
+#pragma omp parallel for if(m_useOpenMP)
+#endif
+    for (int i = 0; i < static_cast<int>(m_wtot.size()); ++i) {
       double tmp1 = 0., tmp2 = 0., tmp3 = 0., tmp4 = 0.;
       tmp2 = m_densities[i] * m_wprim[i];
       tmp3 = m_densities[i] * m_wprim[i] * m_skewprim[i];
       tmp4 = m_densities[i] * m_wprim[i] * m_kurtprim[i];
-      const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = m_TPS->DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
+      const ThermalParticleSystem::DecayContributionsToParticle& decayContributions = DecayContributionsByFeeddown()[Feeddown::StabilityFlag][i];
       for (size_t r = 0; r < decayContributions.size(); ++r) {
         const ThermalParticleSystem::SingleDecayContribution& decayContrib = decayContributions[r];
-        const ThermalParticleSystem::SingleDecayCumulantsContribution& decayCumulantsSingle = m_TPS->DecayCumulants()[i][r];
+        const ThermalParticleSystem::SingleDecayCumulantsContribution& decayCumulantsSingle = DecayCumulants()[i][r];
         tmp2 += m_densities[decayContrib.second] *
           (m_wprim[decayContrib.second] * decayContrib.first * decayContrib.first
             + decayCumulantsSingle.first[1]);
@@ -119,6 +161,35 @@ namespace thermalfist {
     m_FluctuationsCalculated = true;
   }
 
+  void ThermalModelIdeal::CalculateConservedChargeSusceptibilities()
+  {
+    RequirePrimordialDensities();
+
+    // No correlations between different species, chi2 of each species is sufficient
+    vector<double> chi2;
+    IdealGasQuantities(IdealGasFunctions::chi2, m_Chem, chi2);
+
+    for (int i = 0; i < 4; ++i) {
+      ConservedCharge::Name chgi = static_cast<ConservedCharge::Name>(i);
+      for (int j = i; j < 4; ++j) {
+        ConservedCharge::Name chgj = static_cast<ConservedCharge::Name>(j);
+        double ret = 0.;
+        for (int k = 0; k < m_TPS->ComponentsNumber(); ++k) {
+          const ThermalParticle &part = m_TPS->Particles()[k];
+          ret += part.ConservedCharge(chgi) * part.ConservedCharge(chgj) * chi2[k];
+        }
+        m_Susc[i][j] = m_Susc[j][i] = ret;
+      }
+    }
+
+    m_SusceptibilitiesCalculated = true;
+  }
+
+  void ThermalModelIdeal::CalculateSusceptibilityMatrix()
+  {
+    CalculateConservedChargeSusceptibilities();
+  }
+
   std::vector<double> ThermalModelIdeal::CalculateChargeFluctuations(const std::vector<double>& chgs, int order)
   {
     vector<double> ret(order + 1, 0.);
@@ -129,20 +200,19 @@ namespace thermalfist {
 
     ret[0] /= pow(m_Parameters.T * xMath::GeVtoifm(), 3);
 
-    if (order < 2) return ret;
-
-    for (size_t i = 0; i < m_densities.size(); ++i)
-      ret[1] += chgs[i] * chgs[i] * m_TPS->Particles()[i].chi(2, m_Parameters, m_UseWidth, m_Chem[i]);
-
-    if (order < 3) return ret;
-
-    for (size_t i = 0; i < m_densities.size(); ++i)
-      ret[2] += chgs[i] * chgs[i] * chgs[i] * m_TPS->Particles()[i].chi(3, m_Parameters, m_UseWidth, m_Chem[i]);
-
-    if (order < 4) return ret;
+    // Susceptibilities of all species are evaluated first, the sums are then taken in a fixed order
+    int NN = m_densities.size();
+    vector<double> chis(NN);
+    for (int n = 2; n <= order && n <= 4; ++n) {
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+      for (int i = 0; i < NN; ++i)
+        chis[i] = (chgs[i] != 0.) ? m_TPS->Particles()[i].chi(n, m_Parameters, m_UseWidth, m_Chem[i]) : 0.;
 
-    for (size_t i = 0; i < m_densities.size(); ++i)
-      ret[3] += chgs[i] * chgs[i] * chgs[i] * chgs[i] * m_TPS->Particles()[i].chi(4, m_Parameters, m_UseWidth, m_Chem[i]);
+      for (int i = 0; i < NN; ++i)
+        ret[n - 1] += pow(chgs[i], n) * chis[i];
+    }
 
     return ret;
   }
@@ -150,7 +220,9 @@ namespace thermalfist {
   double ThermalModelIdeal::CalculateEnergyDensity() {
     double ret = 0.;
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i]);
+    vector<double> edens;
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, m_Chem, edens);
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += edens[i];
 
     return ret;
   }
@@ -158,7 +230,9 @@ namespace thermalfist {
   double ThermalModelIdeal::CalculateEntropyDensity() {
     double ret = 0.;
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i]);
+    vector<double> sdens;
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, m_Chem, sdens);
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += sdens[i];
 
     return ret;
   }
@@ -182,7 +256,9 @@ namespace thermalfist {
   double ThermalModelIdeal::CalculatePressure() {
     double ret = 0.;
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
+    vector<double> pres;
+    IdealGasQuantities(IdealGasFunctions::Pressure, m_Chem, pres);
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) ret += pres[i];
 
     return ret;
   }
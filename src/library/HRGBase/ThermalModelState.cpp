@@ -0,0 +1,191 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGBase/ThermalModelState.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+using namespace std;
+
+namespace thermalfist {
+
+  namespace {
+    // Reads a double written by operator<<, including inf and nan
+    // (e.g. the total widths of stable particles), which operator>> cannot parse
+    bool ReadDouble(istream& fin, double& value)
+    {
+      string token;
+      if (!(fin >> token))
+        return false;
+      char* end = NULL;
+      value = strtod(token.c_str(), &end);
+      if (end == token.c_str() || *end != '\0') {
+        fin.setstate(ios::failbit);
+        return false;
+      }
+      return true;
+    }
+  }
+
+  bool ThermalModelState::Get(const std::string& name, double& value) const
+  {
+    std::map<std::string, double>::const_iterator it = Scalars.find(name);
+    if (it == Scalars.end())
+      return false;
+    value = it->second;
+    return true;
+  }
+
+  bool ThermalModelState::Get(const std::string& name, bool& value) const
+  {
+    double tval = 0.;
+    if (!Get(name, tval))
+      return false;
+    value = (tval != 0.);
+    return true;
+  }
+
+  bool ThermalModelState::Get(const std::string& name, std::vector<double>& value) const
+  {
+    std::map<std::string, std::vector<double> >::const_iterator it = Vectors.find(name);
+    if (it == Vectors.end())
+      return false;
+    value = it->second;
+    return true;
+  }
+
+  bool ThermalModelState::Get(const std::string& name, std::vector< std::vector<double> >& value) const
+  {
+    std::map<std::string, std::vector< std::vector<double> > >::const_iterator it = Matrices.find(name);
+    if (it == Matrices.end())
+      return false;
+    value = it->second;
+    return true;
+  }
+
+  bool ThermalModelState::WriteToFile(const std::string& filename) const
+  {
+    ofstream fout(filename.c_str());
+    if (!fout.is_open()) {
+      printf("**WARNING** ThermalModelState::WriteToFile: Cannot open file %s\n", filename.c_str());
+      return false;
+    }
+
+    fout << setprecision(numeric_limits<double>::digits10 + 2);
+
+    fout << "# Thermal-FIST model state" << endl;
+    fout << "model " << ModelTag << endl;
+    fout << "components " << ComponentsNumber << endl;
+    fout << "parameters "
+      << Parameters.T << " " << Parameters.muB << " " << Parameters.muS << " " << Parameters.muQ << " " << Parameters.muC << " "
+      << Parameters.gammaq << " " << Parameters.gammaS << " " << Parameters.gammaC << " "
+      << Parameters.V << " " << Parameters.SVc << " "
+      << Parameters.B << " " << Parameters.Q << " " << Parameters.S << " " << Parameters.C << endl;
+
+    for (std::map<std::string, double>::const_iterator it = Scalars.begin(); it != Scalars.end(); ++it)
+      fout << "scalar " << it->first << " " << it->second << endl;
+
+    for (std::map<std::string, std::vector<double> >::const_iterator it = Vectors.begin(); it != Vectors.end(); ++it) {
+      fout << "vector " << it->first << " " << it->second.size();
+      for (size_t i = 0; i < it->second.size(); ++i)
+        fout << " " << it->second[i];
+      fout << endl;
+    }
+
+    for (std::map<std::string, std::vector< std::vector<double> > >::const_iterator it = Matrices.begin(); it != Matrices.end(); ++it) {
+      fout << "matrix " << it->first << " " << it->second.size() << endl;
+      for (size_t i = 0; i < it->second.size(); ++i) {
+        fout << it->second[i].size();
+        for (size_t j = 0; j < it->second[i].size(); ++j)
+          fout << " " << it->second[i][j];
+        fout << endl;
+      }
+    }
+
+    fout.close();
+
+    return true;
+  }
+
+  bool ThermalModelState::ReadFromFile(const std::string& filename)
+  {
+    ifstream fin(filename.c_str());
+    if (!fin.is_open()) {
+      printf("**WARNING** ThermalModelState::ReadFromFile: Cannot open file %s\n", filename.c_str());
+      return false;
+    }
+
+    ThermalModelState state;
+    string key;
+    while (fin >> key) {
+      if (key[0] == '#') {
+        string tmp;
+        getline(fin, tmp);
+      }
+      else if (key == "model") {
+        fin >> state.ModelTag;
+      }
+      else if (key == "components") {
+        fin >> state.ComponentsNumber;
+      }
+      else if (key == "parameters") {
+        ThermalModelParameters &params = state.Parameters;
+        if (ReadDouble(fin, params.T) && ReadDouble(fin, params.muB) && ReadDouble(fin, params.muS)
+          && ReadDouble(fin, params.muQ) && ReadDouble(fin, params.muC)
+          && ReadDouble(fin, params.gammaq) && ReadDouble(fin, params.gammaS) && ReadDouble(fin, params.gammaC)
+          && ReadDouble(fin, params.V) && ReadDouble(fin, params.SVc))
+          fin >> params.B >> params.Q >> params.S >> params.C;
+      }
+      else if (key == "scalar") {
+        string name;
+        double value;
+        fin >> name;
+        ReadDouble(fin, value);
+        state.Scalars[name] = value;
+      }
+      else if (key == "vector") {
+        string name;
+        size_t size = 0;
+        fin >> name >> size;
+        std::vector<double> &vec = state.Vectors[name];
+        vec.resize(size);
+        for (size_t i = 0; i < size && ReadDouble(fin, vec[i]); ++i) { }
+      }
+      else if (key == "matrix") {
+        string name;
+        size_t rows = 0;
+        fin >> name >> rows;
+        std::vector< std::vector<double> > &mat = state.Matrices[name];
+        mat.resize(rows);
+        for (size_t i = 0; i < rows; ++i) {
+          size_t cols = 0;
+          fin >> cols;
+          mat[i].resize(cols);
+          for (size_t j = 0; j < cols && ReadDouble(fin, mat[i][j]); ++j) { }
+        }
+      }
+      else {
+        printf("**WARNING** ThermalModelState::ReadFromFile: Unknown entry %s in file %s\n", key.c_str(), filename.c_str());
+        return false;
+      }
+
+      if (fin.fail()) {
+        printf("**WARNING** ThermalModelState::ReadFromFile: Error reading file %s\n", filename.c_str());
+        return false;
+      }
+    }
+
+    *this = state;
+
+    return true;
+  }
+
+} // namespace thermalfist
@@ -38,6 +38,8 @@ namespace thermalfist {
     if (m_Mass < 1.000) SetClusterExpansionOrder(5);
     if (m_Mass < 0.200) SetClusterExpansionOrder(10);
 
+    SetQuantumStatisticsTolerance(1.e-6);
+
     SetResonanceWidthShape(RelativisticBreitWigner);
     //SetResonanceWidthIntegrationType(BWTwoGamma);
     SetResonanceWidthIntegrationType(ZeroWidth);
@@ -159,9 +161,18 @@ namespace thermalfist {
 
   void ThermalParticle::CalculateThermalBranchingRatios(const ThermalModelParameters & params, bool useWidth, double mu)
   {
+    std::vector<double> bratios = ThermalBranchingRatios(params, useWidth, mu);
+    for (size_t j = 0; j < m_Decays.size(); ++j) {
+      m_Decays[j].mBratioAverage = bratios[j];
+    }
+  }
+
+  std::vector<double> ThermalParticle::ThermalBranchingRatios(const ThermalModelParameters & params, bool useWidth, double mu) const
+  {
+    std::vector<double> ret(m_Decays.size(), 0.);
     if (!useWidth || m_Width == 0.0 || m_Width / m_Mass < 1.e-2 || m_ResonanceWidthIntegrationType != eBW) {
       for (size_t j = 0; j < m_Decays.size(); ++j) {
-        m_Decays[j].mBratioAverage = m_Decays[j].mBratio;
+        ret[j] = m_Decays[j].mBratio;
       }
     }
     else {
@@ -169,29 +180,26 @@ namespace thermalfist {
       if (!(params.gammaS == 1. || m_AbsS == 0.))  mu += log(params.gammaS) * m_AbsS     * params.T;
       if (!(params.gammaC == 1. || m_AbsC == 0.))  mu += log(params.gammaC) * m_AbsC     * params.T;
 
-      for (size_t j = 0; j < m_Decays.size(); ++j) {
-        m_Decays[j].mBratioAverage = 0.;
-      }
-
       double ret1 = 0., ret2 = 0., tmp = 0.;
       for (size_t i = 0; i < m_xalldyn.size(); i++) {
         tmp = m_walldyn[i];
-        double dens = IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_xalldyn[i], m_Degeneracy, m_ClusterExpansionOrder);
+        double dens = IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_xalldyn[i], m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance);
         ret1 += tmp * dens;
         ret2 += tmp;
 
         for (size_t j = 0; j < m_Decays.size(); ++j) {
-          const_cast<double&>(m_Decays[j].mBratioAverage) += tmp * dens * m_Decays[j].mBratioVsM[i];
+          ret[j] += tmp * dens * m_Decays[j].mBratioVsM[i];
         }
       }
 
       for (size_t j = 0; j < m_Decays.size(); ++j) {
         if (ret1 != 0.0)
-          m_Decays[j].mBratioAverage /= ret1;
+          ret[j] /= ret1;
         else
-          m_Decays[j].mBratioAverage = m_Decays[j].mBratio;
+          ret[j] = m_Decays[j].mBratio;
       }
     }
+    return ret;
   }
 
   std::vector<double> ThermalParticle::BranchingRatioWeights(const std::vector<double>& ms) const
@@ -274,6 +282,7 @@ namespace thermalfist {
     ret &= m_Mass == rhs.m_Mass;
     ret &= m_QuantumStatisticsCalculationType == rhs.m_QuantumStatisticsCalculationType;
     ret &= m_ClusterExpansionOrder == rhs.m_ClusterExpansionOrder;
+    ret &= m_QuantumStatisticsTolerance == rhs.m_QuantumStatisticsTolerance;
     ret &= m_Baryon == rhs.m_Baryon;
     ret &= m_ElectricCharge == rhs.m_ElectricCharge;
     ret &= m_Strangeness == rhs.m_Strangeness;
@@ -552,7 +561,7 @@ namespace thermalfist {
 
   double ThermalParticle::ThermalMassDistribution(double M, double T, double Mu, double width)
   {
-    return IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, m_QuantumStatisticsCalculationType, m_Statistics, T, Mu, M, m_Degeneracy, m_ClusterExpansionOrder) * MassDistribution(M, width);
+    return IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, m_QuantumStatisticsCalculationType, m_Statistics, T, Mu, M, m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance) * MassDistribution(M, width);
   }
 
   double ThermalParticle::ThermalMassDistribution(double M, double T, double Mu)
@@ -599,7 +608,7 @@ namespace thermalfist {
 
     //if (!useWidth || m_Mass == 0.0 || m_Width / m_Mass < 1.e-2 || m_ResonanceWidthIntegrationType == ZeroWidth) {
     if (!useWidth || m_Mass == 0.0 || ZeroWidthEnforced() || m_ResonanceWidthIntegrationType == ZeroWidth) {
-      return IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_Mass, m_Degeneracy, m_ClusterExpansionOrder);
+      return IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_Mass, m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance);
     }
 
     int ind = m_xleg.size();
@@ -615,7 +624,7 @@ namespace thermalfist {
         if (m_ResonanceWidthIntegrationType == FullIntervalWeighted)
           tmp *= m_brweight[i];
 
-        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, x[i], m_Degeneracy, m_ClusterExpansionOrder);
+        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, x[i], m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance);
 
         ret1 += tmp * dens;
         ret2 += tmp;
@@ -628,7 +637,7 @@ namespace thermalfist {
       for (int i = 0; i < ind2; ++i) {
         double tmass = m_Mass + 2.*m_Width + m_xlag32[i] * m_Width;
         tmp = m_wlag32[i] * m_Width * MassDistribution(tmass);
-        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, tmass, m_Degeneracy, m_ClusterExpansionOrder);
+        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, tmass, m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance);
 
         ret1 += tmp * dens;
         ret2 += tmp;
@@ -638,7 +647,7 @@ namespace thermalfist {
     if (m_ResonanceWidthIntegrationType == eBW || m_ResonanceWidthIntegrationType == eBWconstBR) {
       for (size_t i = 0; i < m_xalldyn.size(); i++) {
         tmp = m_walldyn[i];
-        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_xalldyn[i], m_Degeneracy, m_ClusterExpansionOrder);
+        double dens = IdealGasFunctions::IdealGasQuantity(type, m_QuantumStatisticsCalculationType, m_Statistics, params.T, mu, m_xalldyn[i], m_Degeneracy, m_ClusterExpansionOrder, m_QuantumStatisticsTolerance);
         ret1 += tmp * dens;
         ret2 += tmp;
       }
@@ -647,6 +656,31 @@ namespace thermalfist {
     return ret1 / ret2;
   }
 
+  IdealGasFunctions::QStatsMethod ThermalParticle::QuantumStatisticsMethod(const ThermalModelParameters & params, double mu) const
+  {
+    if (!(params.gammaq == 1.))                  mu += log(params.gammaq) * m_AbsQuark * params.T;
+    if (!(params.gammaS == 1. || m_AbsS == 0.))  mu += log(params.gammaS) * m_AbsS     * params.T;
+    if (!(params.gammaC == 1. || m_AbsC == 0.))  mu += log(params.gammaC) * m_AbsC     * params.T;
+
+    IdealGasFunctions::QStatsMethod ret;
+    if (m_Statistics == 0) {
+      ret.type = IdealGasFunctions::MethodBoltzmann;
+      ret.order = 1;
+    }
+    else if (m_QuantumStatisticsCalculationType == IdealGasFunctions::ClusterExpansion) {
+      ret.type = IdealGasFunctions::MethodClusterExpansion;
+      ret.order = m_ClusterExpansionOrder;
+    }
+    else if (m_QuantumStatisticsCalculationType == IdealGasFunctions::Quadratures) {
+      ret.type = IdealGasFunctions::MethodQuadratures;
+      ret.order = 32;
+    }
+    else {
+      ret = IdealGasFunctions::SelectQStatsMethod(IdealGasFunctions::ParticleDensity, m_Statistics, params.T, mu, m_Mass, m_QuantumStatisticsTolerance);
+    }
+    return ret;
+  }
+
   double ThermalParticle::DensityCluster(int n, const ThermalModelParameters & params, IdealGasFunctions::Quantity type, bool useWidth, double mu) const
   {
     double mn = 1.;
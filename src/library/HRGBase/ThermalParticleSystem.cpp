@@ -144,32 +144,66 @@ namespace thermalfist {
   }
 
   void ThermalParticleSystem::FillResonanceDecays() {
-    m_DecayContributionsByFeeddown[Feeddown::StabilityFlag].resize(m_Particles.size());
-    m_DecayCumulants.resize(m_Particles.size());
-    m_DecayProbabilities.resize(m_Particles.size());
+    std::vector< std::vector<double> > firstBratios = FirstDecayBranchingRatios();
+    DecayData data;
+    CalculateDecayContributions(firstBratios, data);
+    CalculateDecayDistributions(firstBratios, data);
+
+    m_DecayContributionsByFeeddown[Feeddown::StabilityFlag].swap(data.DecayContributionsByFeeddown[Feeddown::StabilityFlag]);
+    m_DecayCumulants.swap(data.DecayCumulants);
+    m_ResonanceFinalStatesDistributions.swap(data.ResonanceFinalStatesDistributions);
     for (size_t i = 0; i < m_Particles.size(); ++i) {
-      m_DecayContributionsByFeeddown[Feeddown::StabilityFlag][i].resize(0);
-      m_DecayProbabilities[i].resize(0);
-      m_DecayCumulants[i].resize(0);
+      m_Particles[i].Nch() = data.Nch[i];
+      m_Particles[i].DeltaNch() = data.DeltaNch[i];
     }
+  }
+
+  std::vector< std::vector<double> > ThermalParticleSystem::FirstDecayBranchingRatios() const
+  {
+    std::vector< std::vector<double> > ret(m_Particles.size());
+    for (size_t i = 0; i < m_Particles.size(); ++i) {
+      const ThermalParticle::ParticleDecaysVector& decays = m_Particles[i].Decays();
+      ret[i].resize(decays.size());
+      for (size_t j = 0; j < decays.size(); ++j)
+        ret[i][j] = (m_ResonanceWidthIntegrationType == ThermalParticle::eBW) ? decays[j].mBratioAverage : decays[j].mBratio;
+    }
+    return ret;
+  }
+
+  void ThermalParticleSystem::CalculateDecayData(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const
+  {
+    CalculateDecayContributions(firstBratios, data);
+    CalculateDecayContributionsByFeeddown(firstBratios, data);
+    CalculateDecayDistributions(firstBratios, data);
+  }
+
+  void ThermalParticleSystem::CalculateDecayContributions(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const
+  {
+    data.DecayContributionsByFeeddown.resize(Feeddown::NumberOfTypes);
+    DecayContributionsToAllParticles& contributions = data.DecayContributionsByFeeddown[Feeddown::StabilityFlag];
+    contributions.assign(m_Particles.size(), DecayContributionsToParticle());
     for (int i = static_cast<int>(m_Particles.size()) - 1; i >= 0; i--)
       if (!m_Particles[i].IsStable()) {
-        GoResonance(i, i, 1.);
+        GoResonance(i, i, 1., &firstBratios[i], contributions);
       }
+  }
 
+  void ThermalParticleSystem::CalculateDecayDistributions(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const
+  {
+    const DecayContributionsToAllParticles& contributions = data.DecayContributionsByFeeddown[Feeddown::StabilityFlag];
+    data.DecayCumulants.assign(m_Particles.size(), DecayCumulantsContributionsToParticle());
     for (size_t i = 0; i < m_Particles.size(); ++i) {
-      for (size_t j = 0; j < m_DecayContributionsByFeeddown[Feeddown::StabilityFlag][i].size(); ++j) {
-        SingleDecayContribution &DecayContrib = m_DecayContributionsByFeeddown[Feeddown::StabilityFlag][i][j];
-        vector<double> tmp = GoResonanceDecayProbs(DecayContrib.second, i, true);
-        if (tmp.size() > 1) m_DecayProbabilities[i].push_back(make_pair(tmp, DecayContrib.second));
-      }
-      for (size_t j = 0; j < m_DecayProbabilities[i].size(); ++j) {
+      for (size_t j = 0; j < contributions[i].size(); ++j) {
+        int r = contributions[i][j].second;
+        vector<double> probs = GoResonanceDecayProbs(r, i, &firstBratios[r]);
+        if (probs.size() <= 1)
+          continue;
         double tmp = 0., tmp2 = 0., tmp3 = 0., tmp4 = 0.;
-        for (int jj = 0; jj < static_cast<int>(m_DecayProbabilities[i][j].first.size()); ++jj) {
-          tmp += m_DecayProbabilities[i][j].first[jj] * jj;
-          tmp2 += m_DecayProbabilities[i][j].first[jj] * jj * jj;
-          tmp3 += m_DecayProbabilities[i][j].first[jj] * jj * jj * jj;
-          tmp4 += m_DecayProbabilities[i][j].first[jj] * jj * jj * jj * jj;
+        for (int jj = 0; jj < static_cast<int>(probs.size()); ++jj) {
+          tmp += probs[jj] * jj;
+          tmp2 += probs[jj] * jj * jj;
+          tmp3 += probs[jj] * jj * jj * jj;
+          tmp4 += probs[jj] * jj * jj * jj * jj;
         }
         double n2 = 0., n3 = 0., n4 = 0.;
         n2 = tmp2 - tmp * tmp;
@@ -180,33 +214,27 @@ namespace thermalfist {
         moments.push_back(n2);
         moments.push_back(n3);
         moments.push_back(n4);
-        m_DecayCumulants[i].push_back(make_pair(moments, m_DecayProbabilities[i][j].second));
+        data.DecayCumulants[i].push_back(make_pair(moments, r));
       }
     }
 
-    m_DecayDistributionsMap.resize(m_Particles.size());
-    m_ResonanceFinalStatesDistributions.resize(m_Particles.size());
-    for (size_t i = 0; i < m_Particles.size(); ++i) {
-      m_ResonanceFinalStatesDistributions[i].resize(0);
-      m_DecayDistributionsMap[i].resize(0);
-    }
+    // Final state distributions of the subsequent decays are evaluated once and reused
+    std::vector<ResonanceFinalStatesDistribution> cache(m_Particles.size());
+    data.ResonanceFinalStatesDistributions.resize(m_Particles.size());
     for (size_t i = 0; i < m_Particles.size(); ++i) {
-      m_ResonanceFinalStatesDistributions[i] = GoResonanceDecayDistributions(i, true);
+      data.ResonanceFinalStatesDistributions[i] = GoResonanceDecayDistributions(i, &firstBratios[i], cache);
     }
-    // Clear m_DecayDistributionsMap and memory it occupies
-    std::vector< std::vector< std::pair<double, std::vector<int> > > >().swap(m_DecayDistributionsMap);
 
+    data.Nch.assign(m_Particles.size(), vector<double>());
+    data.DeltaNch.assign(m_Particles.size(), vector<double>());
     for (size_t i = 0; i < m_Particles.size(); ++i) {
       vector<int> nchtyp(0);
       nchtyp.push_back(0);
       nchtyp.push_back(1);
       nchtyp.push_back(-1);
 
-      m_Particles[i].Nch().resize(0);
-      m_Particles[i].DeltaNch().resize(0);
-
       for (int nti = 0; nti < 3; nti++) {
-        vector<double> prob = GoResonanceDecayProbsCharge(i, nchtyp[nti], true);
+        vector<double> prob = GoResonanceDecayProbsCharge(i, nchtyp[nti], &firstBratios[i]);
         double tmp = 0., tmp2 = 0., tmp3 = 0., tmp4 = 0.;
         for (int jj = 0; jj < static_cast<int>(prob.size()); ++jj) {
           tmp += prob[jj] * jj;
@@ -214,20 +242,17 @@ namespace thermalfist {
           tmp3 += prob[jj] * jj * jj * jj;
           tmp4 += prob[jj] * jj * jj * jj * jj;
         }
-        double n2 = 0., n3 = 0., n4 = 0.;
+        double n2 = 0.;
         n2 = tmp2 - tmp * tmp;
-        n3 = tmp3 - 3. * tmp2 * tmp + 2. * tmp * tmp * tmp;
-        n4 = tmp4 - 4. * tmp3 * tmp + 6. * tmp2 * tmp * tmp - 3. * tmp * tmp * tmp * tmp - 3. * n2 * n2;
-        m_Particles[i].Nch().push_back(tmp);
-        m_Particles[i].DeltaNch().push_back(n2);
+        data.Nch[i].push_back(tmp);
+        data.DeltaNch[i].push_back(n2);
       }
-
     }
   }
 
 
-  void ThermalParticleSystem::GoResonance(int ind, int startind, double BR) {
-    DecayContributionsToParticle& DecayContrib = m_DecayContributionsByFeeddown[Feeddown::StabilityFlag][ind];
+  void ThermalParticleSystem::GoResonance(int ind, int startind, double BR, const std::vector<double>* firstBratios, DecayContributionsToAllParticles& contributions) const {
+    DecayContributionsToParticle& DecayContrib = contributions[ind];
     if (ind != startind && DecayContrib.size() > 0 && DecayContrib[DecayContrib.size() - 1].second == startind)
     {
       DecayContrib[DecayContrib.size() - 1].first += BR;
@@ -238,20 +263,18 @@ namespace thermalfist {
     if (!m_Particles[ind].IsStable()) {
       for (size_t i = 0; i < m_Particles[ind].Decays().size(); ++i) {
         const ParticleDecayChannel& decaychannel = m_Particles[ind].Decays()[i];
-        double tbr = decaychannel.mBratio;
-
-        if (m_ResonanceWidthIntegrationType == ThermalParticle::eBW && ind == startind)
-          tbr = decaychannel.mBratioAverage;
+        double tbr = (firstBratios != NULL) ? (*firstBratios)[i] : decaychannel.mBratio;
 
         for (size_t j = 0; j < decaychannel.mDaughters.size(); ++j) {
-          if (m_PDGtoID.count(decaychannel.mDaughters[j]) != 0)
-            GoResonance(m_PDGtoID[decaychannel.mDaughters[j]], startind, BR*tbr);
+          int tid = PdgToId(decaychannel.mDaughters[j]);
+          if (tid != -1)
+            GoResonance(tid, startind, BR*tbr, NULL, contributions);
         }
       }
     }
   }
 
-  std::vector<double> ThermalParticleSystem::GoResonanceDecayProbs(int ind, int goalind, bool firstdecay) {
+  std::vector<double> ThermalParticleSystem::GoResonanceDecayProbs(int ind, int goalind, const std::vector<double>* firstBratios) const {
     std::vector<double> ret(1, 0.);
     if (m_Particles[ind].IsStable()) {
       if (ind == goalind) ret.push_back(1.);
@@ -266,15 +289,14 @@ namespace thermalfist {
       ret[0] = 0.;
       vector<double> tret;
       for (size_t i = 0; i < m_Particles[ind].Decays().size(); ++i) {
-        double tbr = m_Particles[ind].Decays()[i].mBratio;
-        if (m_ResonanceWidthIntegrationType == ThermalParticle::eBW && firstdecay)
-          tbr = m_Particles[ind].Decays()[i].mBratioAverage;
+        double tbr = (firstBratios != NULL) ? (*firstBratios)[i] : m_Particles[ind].Decays()[i].mBratio;
 
         tret.resize(1);
         tret[0] = 1.;
         for (size_t j = 0; j < m_Particles[ind].Decays()[i].mDaughters.size(); ++j) {
-          if (m_PDGtoID.count(m_Particles[ind].Decays()[i].mDaughters[j]) != 0) {
-            vector<double> tmp = GoResonanceDecayProbs(m_PDGtoID[m_Particles[ind].Decays()[i].mDaughters[j]], goalind);
+          int tid = PdgToId(m_Particles[ind].Decays()[i].mDaughters[j]);
+          if (tid != -1) {
+            vector<double> tmp = GoResonanceDecayProbs(tid, goalind);
             vector<double> tmp2(tret.size() + tmp.size() - 1, 0.);
             for (size_t i1 = 0; i1 < tret.size(); ++i1)
               for (size_t i2 = 0; i2 < tmp.size(); ++i2)
@@ -301,7 +323,7 @@ namespace thermalfist {
     //return ret;
   }
 
-  std::vector<double> ThermalParticleSystem::GoResonanceDecayProbsCharge(int ind, int nch, bool firstdecay)
+  std::vector<double> ThermalParticleSystem::GoResonanceDecayProbsCharge(int ind, int nch, const std::vector<double>* firstBratios) const
   {
     bool fl = false;
     int tQ = m_Particles[ind].ElectricCharge();
@@ -322,15 +344,14 @@ namespace thermalfist {
       ret[0] = 0.;
       vector<double> tret;
       for (size_t i = 0; i < m_Particles[ind].Decays().size(); ++i) {
-        double tbr = m_Particles[ind].Decays()[i].mBratio;
-        if (m_ResonanceWidthIntegrationType == ThermalParticle::eBW && firstdecay)
-          tbr = m_Particles[ind].Decays()[i].mBratioAverage;
+        double tbr = (firstBratios != NULL) ? (*firstBratios)[i] : m_Particles[ind].Decays()[i].mBratio;
 
         tret.resize(1);
         tret[0] = 1.;
         for (size_t j = 0; j < m_Particles[ind].Decays()[i].mDaughters.size(); ++j) {
-          if (m_PDGtoID.count(m_Particles[ind].Decays()[i].mDaughters[j]) != 0) {
-            vector<double> tmp = GoResonanceDecayProbsCharge(m_PDGtoID[m_Particles[ind].Decays()[i].mDaughters[j]], nch);
+          int tid = PdgToId(m_Particles[ind].Decays()[i].mDaughters[j]);
+          if (tid != -1) {
+            vector<double> tmp = GoResonanceDecayProbsCharge(tid, nch);
             vector<double> tmp2(tret.size() + tmp.size() - 1, 0.);
             for (size_t i1 = 0; i1 < tret.size(); ++i1)
               for (size_t i2 = 0; i2 < tmp.size(); ++i2)
@@ -358,10 +379,10 @@ namespace thermalfist {
     //return ret;
   }
 
-  ThermalParticleSystem::ResonanceFinalStatesDistribution ThermalParticleSystem::GoResonanceDecayDistributions(int ind, bool firstdecay)
+  ThermalParticleSystem::ResonanceFinalStatesDistribution ThermalParticleSystem::GoResonanceDecayDistributions(int ind, const std::vector<double>* firstBratios, std::vector<ResonanceFinalStatesDistribution>& cache) const
   {
-    if (!firstdecay && m_DecayDistributionsMap[ind].size() != 0)
-      return m_DecayDistributionsMap[ind];
+    if (firstBratios == NULL && cache[ind].size() != 0)
+      return cache[ind];
 
 
     std::vector< std::pair<double, std::vector<int> > > retorig(1);
@@ -371,24 +392,21 @@ namespace thermalfist {
 
     std::vector< std::pair<double, std::vector<int> > > ret(0);
 
-    ThermalParticle &tpart = m_Particles[ind];
+    const ThermalParticle &tpart = m_Particles[ind];
 
-    if (tpart.IsStable()) {
-      m_ResonanceFinalStatesDistributions[ind] = retorig;
+    if (tpart.IsStable())
       return retorig;
-    }
 
     for (size_t i = 0; i < tpart.Decays().size(); ++i) {
-      double tbr = tpart.Decays()[i].mBratio;
-      if (m_ResonanceWidthIntegrationType == ThermalParticle::eBW && firstdecay)
-        tbr = m_Particles[ind].Decays()[i].mBratioAverage;
+      double tbr = (firstBratios != NULL) ? (*firstBratios)[i] : tpart.Decays()[i].mBratio;
 
       std::vector< std::pair<double, std::vector<int> > > tret = retorig;
 
       for (size_t j = 0; j < tpart.Decays()[i].mDaughters.size(); ++j) {
-        if (m_PDGtoID.count(tpart.Decays()[i].mDaughters[j]) != 0) {
+        int tid = PdgToId(tpart.Decays()[i].mDaughters[j]);
+        if (tid != -1) {
 
-          std::vector< std::pair<double, std::vector<int> > > tmp = GoResonanceDecayDistributions(m_PDGtoID[tpart.Decays()[i].mDaughters[j]]);
+          std::vector< std::pair<double, std::vector<int> > > tmp = GoResonanceDecayDistributions(tid, NULL, cache);
           std::vector< std::pair<double, std::vector<int> > > tmp2(tret.size() * tmp.size());
           for (int i1 = 0; i1 < static_cast<int>(tret.size()); ++i1) {
             for (int i2 = 0; i2 < static_cast<int>(tmp.size()); ++i2) {
@@ -436,8 +454,8 @@ namespace thermalfist {
       ret.push_back(std::make_pair(emptyprob, retorig[0].second));
     }
 
-    if (!firstdecay)
-      m_DecayDistributionsMap[ind] = ret;
+    if (firstBratios == NULL)
+      cache[ind] = ret;
 
     // Debugging
 
@@ -1263,8 +1281,10 @@ namespace thermalfist {
   void ThermalParticleSystem::SetCalculationType(IdealGasFunctions::QStatsCalculationType type)
   {
     m_QStatsCalculationType = type;
-    for (size_t i = 0; i < m_Particles.size(); ++i)
-      m_Particles[i].SetCalculationType(type);
+    for (size_t i = 0; i < m_Particles.size(); ++i) {
+      if (m_Particles[i].CalculationType() != type)
+        m_Particles[i].SetCalculationType(type);
+    }
   }
 
   void ThermalParticleSystem::SetClusterExpansionOrder(int order)
@@ -1273,6 +1293,13 @@ namespace thermalfist {
       m_Particles[i].SetClusterExpansionOrder(order);
   }
 
+  void ThermalParticleSystem::SetQuantumStatisticsTolerance(double tolerance)
+  {
+    for (size_t i = 0; i < m_Particles.size(); ++i)
+      if (m_Particles[i].QuantumStatisticsTolerance() != tolerance)
+        m_Particles[i].SetQuantumStatisticsTolerance(tolerance);
+  }
+
   void ThermalParticleSystem::SetResonanceWidthShape(ThermalParticle::ResonanceWidthShape shape)
   {
     m_ResonanceWidthShape = shape;
@@ -1284,10 +1311,13 @@ namespace thermalfist {
   {
     bool dodecays = (type != m_ResonanceWidthIntegrationType);
 
-    m_ResonanceWidthIntegrationType = type;
+    if (dodecays)
+      m_ResonanceWidthIntegrationType = type;
 
+    // Particles which already use the requested scheme are not touched,
+    // such that the list is not modified if nothing changes
     for (size_t i = 0; i < m_Particles.size(); ++i) {
-      if (!m_Particles[i].ZeroWidthEnforced())
+      if (!m_Particles[i].ZeroWidthEnforced() && m_Particles[i].GetResonanceWidthIntegrationType() != type)
         m_Particles[i].SetResonanceWidthIntegrationType(type);
     }
 
@@ -1315,11 +1345,12 @@ namespace thermalfist {
 
   ThermalParticle & ThermalParticleSystem::ParticleByPDG(long long pdgid)
   {
-    if (m_PDGtoID.count(pdgid) == 0) {
+    std::map<long long, int>::const_iterator it = m_PDGtoID.find(pdgid);
+    if (it == m_PDGtoID.end()) {
       printf("**ERROR** ThermalParticleSystem::ParticleByPDG(long long pdgid): pdgid %lld is unknown\n", pdgid);
       exit(1);
     }
-    return m_Particles[m_PDGtoID[pdgid]];
+    return m_Particles[it->second];
   }
 
   void ThermalParticleSystem::FillPdgMap()
@@ -1453,7 +1484,6 @@ namespace thermalfist {
     ret &= m_NumCharmed == rhs.m_NumCharmed;
     ret &= m_NumberOfParticles == rhs.m_NumberOfParticles;
     ret &= m_ResonanceWidthIntegrationType == rhs.m_ResonanceWidthIntegrationType;
-    ret &= m_DecayDistributionsMap == rhs.m_DecayDistributionsMap;
 
     ret &= m_Particles == rhs.m_Particles;
 
@@ -1529,25 +1559,27 @@ namespace thermalfist {
   }
 
   void ThermalParticleSystem::FillResonanceDecaysByFeeddown() {
-    m_DecayContributionsByFeeddown[Feeddown::Weak].resize(m_Particles.size());
-    m_DecayContributionsByFeeddown[Feeddown::Electromagnetic].resize(m_Particles.size());
-    m_DecayContributionsByFeeddown[Feeddown::Strong].resize(m_Particles.size());
-    for (size_t i = 0; i < m_Particles.size(); ++i) {
-      m_DecayContributionsByFeeddown[Feeddown::Weak][i].resize(0);
-      m_DecayContributionsByFeeddown[Feeddown::Electromagnetic][i].resize(0);
-      m_DecayContributionsByFeeddown[Feeddown::Strong][i].resize(0);
-    }
+    DecayData data;
+    CalculateDecayContributionsByFeeddown(FirstDecayBranchingRatios(), data);
+    for (int feed_index = static_cast<int>(Feeddown::Weak); feed_index <= static_cast<int>(Feeddown::Strong); ++feed_index)
+      m_DecayContributionsByFeeddown[feed_index].swap(data.DecayContributionsByFeeddown[feed_index]);
+  }
+
+  void ThermalParticleSystem::CalculateDecayContributionsByFeeddown(const std::vector< std::vector<double> >& firstBratios, DecayData& data) const
+  {
+    data.DecayContributionsByFeeddown.resize(Feeddown::NumberOfTypes);
+    for (int feed_index = static_cast<int>(Feeddown::Weak); feed_index <= static_cast<int>(Feeddown::Strong); ++feed_index)
+      data.DecayContributionsByFeeddown[feed_index].assign(m_Particles.size(), DecayContributionsToParticle());
     for (int i = static_cast<int>(m_Particles.size()) - 1; i >= 0; i--)
       if (m_Particles[i].DecayType() != ParticleDecayType::Stable && m_Particles[i].DecayType() != ParticleDecayType::Default) {
-        GoResonanceByFeeddown(i, i, 1., Feeddown::Type(static_cast<int>(m_Particles[i].DecayType())));
+        GoResonanceByFeeddown(i, i, 1., Feeddown::Type(static_cast<int>(m_Particles[i].DecayType())), &firstBratios[i], data.DecayContributionsByFeeddown);
       }
   }
 
-  void ThermalParticleSystem::GoResonanceByFeeddown(int ind, int startind, double BR, Feeddown::Type feeddown) {
+  void ThermalParticleSystem::GoResonanceByFeeddown(int ind, int startind, double BR, Feeddown::Type feeddown, const std::vector<double>* firstBratios, std::vector<DecayContributionsToAllParticles>& contributions) const {
     for (int feed_index = static_cast<int>(Feeddown::Weak); feed_index <= static_cast<int>(Feeddown::Strong); ++feed_index) {
       if (static_cast<int>(feeddown) < feed_index) continue;
-      //std::vector< std::pair<double, int> >& decayContributions = m_Particles[ind].DecayContributionsByFeeddown()[feed_index];
-      DecayContributionsToParticle& decayContributions = m_DecayContributionsByFeeddown[feed_index][ind];
+      DecayContributionsToParticle& decayContributions = contributions[feed_index][ind];
       if (ind != startind && decayContributions.size() > 0 && decayContributions[decayContributions.size() - 1].second == startind)
       {
         decayContributions[decayContributions.size() - 1].first += BR;
@@ -1561,14 +1593,12 @@ namespace thermalfist {
     if (m_Particles[ind].DecayType() != ParticleDecayType::Stable && m_Particles[ind].DecayType() != ParticleDecayType::Default) {
       for (size_t i = 0; i < m_Particles[ind].Decays().size(); ++i) {
         const ParticleDecayChannel& decaychannel = m_Particles[ind].Decays()[i];
-        double tbr = decaychannel.mBratio;
-
-        if (m_ResonanceWidthIntegrationType == ThermalParticle::eBW && ind == startind)
-          tbr = decaychannel.mBratioAverage;
+        double tbr = (firstBratios != NULL) ? (*firstBratios)[i] : decaychannel.mBratio;
 
         for (size_t j = 0; j < decaychannel.mDaughters.size(); ++j) {
-          if (m_PDGtoID.count(decaychannel.mDaughters[j]) != 0)
-            GoResonanceByFeeddown(m_PDGtoID[decaychannel.mDaughters[j]], startind, BR*tbr, Feeddown::Type(static_cast<int>(m_Particles[ind].DecayType())));
+          int tid = PdgToId(decaychannel.mDaughters[j]);
+          if (tid != -1)
+            GoResonanceByFeeddown(tid, startind, BR*tbr, Feeddown::Type(static_cast<int>(m_Particles[ind].DecayType())), NULL, contributions);
         }
       }
     }
@@ -11,6 +11,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <cfloat>
+#include <algorithm>
 
 using namespace std;
 
@@ -215,7 +216,9 @@ namespace thermalfist {
     double bip = 0, bim = 0;
     double bi = 1;
     double result = 0;
-    int m = 2 * ((n + int(sqrt(float(iacc*n)))));
+    // The starting order of the downward recurrence must exceed both n and x
+    int nstart = max(n, static_cast<int>(fabs(x)));
+    int m = 2 * ((nstart + int(sqrt(float(iacc*nstart)))));
     for (int j = m; j >= 1; j--) {
       bim = bip + double(j)*tox*bi;
       bip = bi;
@@ -819,7 +822,9 @@ namespace thermalfist {
     double bip = 0, bim = 0;
     double bi = 1;
     double result = 0;
-    int m = 2 * ((n + int(sqrt(float(iacc*n)))));
+    // The starting order of the downward recurrence must exceed both n and x
+    int nstart = max(n, static_cast<int>(fabs(x)));
+    int m = 2 * ((nstart + int(sqrt(float(iacc*nstart)))));
     for (int j = m; j >= 1; j--) {
       bim = bip + double(j)*tox*bi;
       bip = bi;
@@ -840,6 +845,55 @@ namespace thermalfist {
   }
 
 
+  std::vector<double> xMath::BesselIexpSequence(int nmax, double x)
+  {
+    if (nmax < 0) nmax = 0;
+    std::vector<double> ret(nmax + 1, 0.);
+
+    double ax = fabs(x);
+    if (ax == 0.) {
+      ret[0] = 1.;
+      return ret;
+    }
+
+    int iacc = 40; // Increase to enhance accuracy
+    const double kBigPositive = 1.e10;
+    const double kBigNegative = 1.e-10;
+
+    // The starting order of the downward recurrence must exceed both nmax and x
+    int nstart = max(nmax, static_cast<int>(ax));
+    int m = 2 * ((nstart + int(sqrt(double(iacc*(nstart + 1)))))) + 10;
+
+    double tox = 2. / ax;
+    double bip = 0., bim = 0.;
+    double bi = 1.;
+    // e^x = I_0 + 2 * sum_{k>=1} I_k
+    double sum = 2. * bi;
+    for (int j = m; j >= 1; j--) {
+      bim = bip + double(j)*tox*bi;
+      bip = bi;
+      bi = bim;
+      // Renormalise to prevent overflows
+      if (fabs(bi) > kBigPositive) {
+        bi *= kBigNegative;
+        bip *= kBigNegative;
+        sum *= kBigNegative;
+        for (int k = j; k <= nmax; ++k)
+          ret[k] *= kBigNegative;
+      }
+      sum += (j == 1 ? 1. : 2.) * bi;
+      if (j - 1 <= nmax)
+        ret[j - 1] = bi;
+    }
+
+    for (int k = 0; k <= nmax; ++k) {
+      ret[k] /= sum;
+      if ((x < 0) && (k % 2 == 1)) ret[k] = -ret[k];
+    }
+
+    return ret;
+  }
+
   double xMath::Gamma
   (
     double x    // We require x > 0
@@ -35,13 +35,21 @@ namespace thermalfist {
     ClearModelEV();
   }
 
+  ThermalModelEVCanonicalStrangeness* ThermalModelEVCanonicalStrangeness::Clone() const
+  {
+    ThermalModelEVCanonicalStrangeness *ret = new ThermalModelEVCanonicalStrangeness(*this);
+    // The model for non-strange hadrons owns its particle list and is thus not shared with the copy
+    ret->m_modelEV = NULL;
+    if (m_modelEV != NULL)
+      ret->PrepareModelEV();
+    return ret;
+  }
+
   void ThermalModelEVCanonicalStrangeness::CalculateDensitiesGCE() {
     if (m_modelEV == NULL)
       PrepareModelEV();
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densitiesGCE[i] = /*m_Suppression **/ m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i] - m_v[i] * m_PNS);
-    }
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, ShiftedChemicalPotentials(), m_densitiesGCE);
 
     m_GCECalculated = true;
   }
@@ -50,10 +58,7 @@ namespace thermalfist {
     if (m_modelEV == NULL)
       PrepareModelEV();
 
-    m_energydensitiesGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_energydensitiesGCE[i] = /*m_Suppression **/ m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i] - m_v[i] * m_PNS);
-    }
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, ShiftedChemicalPotentials(), m_energydensitiesGCE);
   }
 
   void ThermalModelEVCanonicalStrangeness::CalculatePressuresGCE()
@@ -61,15 +66,12 @@ namespace thermalfist {
     if (m_modelEV == NULL)
       PrepareModelEV();
 
-    m_pressuresGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_pressuresGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i] - m_v[i] * m_PNS);
-    }
+    IdealGasQuantities(IdealGasFunctions::Pressure, ShiftedChemicalPotentials(), m_pressuresGCE);
   }
 
 
   void ThermalModelEVCanonicalStrangeness::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     m_energydensitiesGCE.resize(0);
     m_pressuresGCE.resize(0);
@@ -118,18 +120,21 @@ namespace thermalfist {
 
 
   double ThermalModelEVCanonicalStrangeness::CalculateEntropyDensity() {
-    double ret = log(m_Zsum[m_StrMap[0]]) / m_Parameters.SVc;
+    double ret = (log(m_Zsum[m_StrMap[0]]) + m_ZsumLogFactor) / m_Parameters.SVc;
 
     if (m_energydensitiesGCE.size() == 0)
       CalculateEnergyDensitiesGCE();
 
+    vector<double> sdens;
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, ShiftedChemicalPotentials(), sdens);
+
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       if (m_TPS->Particles()[i].Strangeness() != 0) {
         if (m_StrMap.count(-m_TPS->Particles()[i].Strangeness()))
           ret += m_Suppression * (m_Zsum[m_StrMap[-m_TPS->Particles()[i].Strangeness()]] / m_Zsum[m_StrMap[0]]) * ((m_energydensitiesGCE[i] - (m_Chem[i] - m_v[i] * m_PNS) * m_densitiesGCE[i]) / m_Parameters.T);
       }
       else {
-        ret += m_Suppression * m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i] - m_v[i] * m_PNS);
+        ret += m_Suppression * sdens[i];
       }
     return ret;
   }
@@ -144,6 +149,14 @@ namespace thermalfist {
     return ret;
   }
 
+  std::vector<double> ThermalModelEVCanonicalStrangeness::ShiftedChemicalPotentials() const
+  {
+    std::vector<double> ret(m_TPS->ComponentsNumber());
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      ret[i] = m_Chem[i] - m_v[i] * m_PNS;
+    return ret;
+  }
+
   double ThermalModelEVCanonicalStrangeness::MuShift(int id) const
   {
     if (id >= 0. && id < static_cast<int>(m_v.size()))
@@ -284,4 +297,22 @@ namespace thermalfist {
     return (charge == ConservedCharge::StrangenessCharge);
   }
 
+  void ThermalModelEVCanonicalStrangeness::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelCanonicalStrangeness::WriteState(state);
+    state.Scalars["PressureNonStrange"] = m_PNS;
+    state.Scalars["Suppression"] = m_Suppression;
+    state.Scalars["EigenvolumeNonStrange"] = m_EVNS;
+    state.Scalars["EigenvolumeStrange"] = m_EVS;
+  }
+
+  void ThermalModelEVCanonicalStrangeness::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelCanonicalStrangeness::ReadState(state);
+    state.Get("PressureNonStrange", m_PNS);
+    state.Get("Suppression", m_Suppression);
+    state.Get("EigenvolumeNonStrange", m_EVNS);
+    state.Get("EigenvolumeStrange", m_EVS);
+  }
+
 } // namespace thermalfist
\ No newline at end of file
@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGEV/ThermalModelEVCrossterms.h"
+#include "HRGBase/Profiling.h"
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -31,7 +32,7 @@ using namespace std;
 namespace thermalfist {
 
   ThermalModelEVCrossterms::ThermalModelEVCrossterms(ThermalParticleSystem *TPS, const ThermalModelParameters& params) :
-    ThermalModelBase(TPS, params)
+    ThermalModelBase(TPS, params), m_EVComponentMapsValid(false)
   {
     m_densitiesid.resize(m_TPS->Particles().size());
     m_Volume = params.V;
@@ -52,6 +53,8 @@ namespace thermalfist {
       printf("**WARNING** %s::FillVirial(const std::vector<double> & ri): size %d of ri does not match number of hadrons %d in the list", m_TAG.c_str(), static_cast<int>(ri.size()), static_cast<int>(m_TPS->Particles().size()));
       return;
     }
+    m_EVComponentMapsValid = false;
+    ResetCalculatedFlags();
     m_Virial.resize(m_TPS->Particles().size());
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
       m_Virial[i].resize(m_TPS->Particles().size());
@@ -68,8 +71,15 @@ namespace thermalfist {
       }
   }
 
+  ThermalModelEVCrossterms* ThermalModelEVCrossterms::Clone() const
+  {
+    return new ThermalModelEVCrossterms(*this);
+  }
+
   void ThermalModelEVCrossterms::ReadInteractionParameters(const std::string & filename)
   {
+    m_EVComponentMapsValid = false;
+    ResetCalculatedFlags();
     m_Virial = std::vector< std::vector<double> >(m_TPS->Particles().size(), std::vector<double>(m_TPS->Particles().size(), 0.));
 
     ifstream fin(filename.c_str());
@@ -135,14 +145,18 @@ namespace thermalfist {
   }
 
   void ThermalModelEVCrossterms::SetVirial(int i, int j, double b) {
-    if (i >= 0 && i < static_cast<int>(m_Virial.size()) && j >= 0 && j < static_cast<int>(m_Virial.size())) 
+    if (i >= 0 && i < static_cast<int>(m_Virial.size()) && j >= 0 && j < static_cast<int>(m_Virial.size())) {
       m_Virial[i][j] = b;
+      m_EVComponentMapsValid = false;
+      ResetCalculatedFlags();
+    }
     else printf("**WARNING** Index overflow in ThermalModelEVCrossterms::SetVirial\n");
   }
 
   void ThermalModelEVCrossterms::ChangeTPS(ThermalParticleSystem *TPS) {
     ThermalModelBase::ChangeTPS(TPS);
     m_densitiesid.resize(m_TPS->Particles().size());
+    m_EVComponentMapsValid = false;
     FillVirial();
   }
 
@@ -188,9 +202,17 @@ namespace thermalfist {
 
 
   double ThermalModelEVCrossterms::PressureDiagonalTotal(double P) {
+    int NN = m_TPS->ComponentsNumber();
+    vector<double> Ps(NN);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i)
+      Ps[i] = PartialPressureDiagonal(i, P);
+
     double ret = 0.;
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
-      ret += PartialPressureDiagonal(i, P);
+    for (int i = 0; i < NN; ++i)
+      ret += Ps[i];
     return ret;
   }
 
@@ -222,175 +244,140 @@ namespace thermalfist {
 
     BroydenEquationsCRS eqs(this);
     BroydenJacobianCRS  jac(this);
-    Broyden broydn(&eqs, &jac);
+    m_Broyden.SetEquations(&eqs);
+    m_Broyden.SetJacobian(&jac);
+    m_Broyden.ReuseJacobian(m_SolverJacobianReuse);
     BroydenSolutionCriteriumCRS crit(this);
 
-    m_Ps = broydn.Solve(m_Ps, &crit);
+    m_Ps = m_Broyden.Solve(m_Ps, &crit);
     m_Pressure = 0.;
     for (size_t i = 0; i < m_Ps.size(); ++i) 
       m_Pressure += m_Ps[i];
 
-    if (broydn.Iterations() == broydn.MaxIterations())
+    if (m_Broyden.Iterations() == m_Broyden.MaxIterations())
       m_LastCalculationSuccessFlag = false;
     else m_LastCalculationSuccessFlag = true;
 
-    m_MaxDiff = broydn.MaxDifference();
+    m_MaxDiff = m_Broyden.MaxDifference();
+
+    m_Broyden.SetEquations(NULL);
+    m_Broyden.SetJacobian(NULL);
   }
 
-  void ThermalModelEVCrossterms::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+  void ThermalModelEVCrossterms::FillEVComponentMaps() {
+    if (m_EVComponentMapsValid)
+      return;
 
     map< vector<double>, int> m_MapEVcomponent;
 
-    {
-      int NN = m_densities.size();
-      m_MapToEVComponent.resize(NN);
-      m_MapFromEVComponent.clear();
-      m_MapEVcomponent.clear();
-      m_EVComponentIndices.clear();
-
-      int tind = 0;
-      for (int i = 0; i < NN; ++i) {
-        vector<double> EVParam(0);
-        for (int j = 0; j < NN; ++j) {
-          EVParam.push_back(m_Virial[i][j]);
-          EVParam.push_back(m_Virial[j][i]);
-        }
+    int NN = m_densities.size();
+    m_MapToEVComponent.resize(NN);
+    m_MapFromEVComponent.clear();
+    m_MapEVcomponent.clear();
+    m_EVComponentIndices.clear();
 
-        if (m_MapEVcomponent.count(EVParam) == 0) {
-          m_MapEVcomponent[EVParam] = tind;
-          m_MapToEVComponent[i] = tind;
-          m_MapFromEVComponent.push_back(i);
-          m_EVComponentIndices.push_back(vector<int>(1, i));
-          tind++;
-        }
-        else {
-          m_MapToEVComponent[i] = m_MapEVcomponent[EVParam];
-          m_EVComponentIndices[m_MapEVcomponent[EVParam]].push_back(i);
-        }
+    int tind = 0;
+    for (int i = 0; i < NN; ++i) {
+      vector<double> EVParam(0);
+      for (int j = 0; j < NN; ++j) {
+        EVParam.push_back(m_Virial[i][j]);
+        EVParam.push_back(m_Virial[j][i]);
       }
-    }
 
-    // Pressure
-    SolvePressure();
-    vector<double> tN(m_densities.size());
-    for (size_t i = 0; i < m_Ps.size(); ++i) 
-      tN[i] = DensityId(i);
+      if (m_MapEVcomponent.count(EVParam) == 0) {
+        m_MapEVcomponent[EVParam] = tind;
+        m_MapToEVComponent[i] = tind;
+        m_MapFromEVComponent.push_back(i);
+        m_EVComponentIndices.push_back(vector<int>(1, i));
+        tind++;
+      }
+      else {
+        m_MapToEVComponent[i] = m_MapEVcomponent[EVParam];
+        m_EVComponentIndices[m_MapEVcomponent[EVParam]].push_back(i);
+      }
+    }
 
-    // Densities
+    m_EVComponentMapsValid = true;
+  }
 
+  void ThermalModelEVCrossterms::CalculateDensitiesFromPartialPressures() {
     int NN = m_densities.size();
+    int NNEV = m_EVComponentIndices.size();
 
-    MatrixXd densMatrix(NN, NN);
-    VectorXd solVector(NN), xVector(NN);
+    // The chemical potential shifts are the same for all species within an EV component
+    vector<double> Pcomp(NNEV, 0.);
+    for (int i = 0; i < NN; ++i)
+      Pcomp[m_MapToEVComponent[i]] += m_Ps[i];
 
+    vector<double> dMucomp(NNEV, 0.);
+    for (int ic = 0; ic < NNEV; ++ic) {
+      int i = m_MapFromEVComponent[ic];
+      for (int jc = 0; jc < NNEV; ++jc)
+        dMucomp[ic] += -m_Virial[i][m_MapFromEVComponent[jc]] * Pcomp[jc];
+    }
+
+    vector<double> mus(NN);
     for (int i = 0; i < NN; ++i)
-      for (int j = 0; j < NN; ++j) {
-        densMatrix(i, j) = m_Virial[i][j] * tN[i];
-        if (i == j) densMatrix(i, j) += 1.;
-      }
+      mus[i] = m_Chem[i] + dMucomp[m_MapToEVComponent[i]];
 
-    PartialPivLU<MatrixXd> decomp(densMatrix);
+    vector<double> sid;
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, mus, m_densitiesid);
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, mus, sid);
 
-    for (int i = 0; i < NN; ++i) xVector[i] = 0.;
+    vector<double> ncomp(NNEV, 0.), scomp(NNEV, 0.);
     for (int i = 0; i < NN; ++i) {
-      xVector[i] = tN[i];
-      solVector = decomp.solve(xVector);
-      if (1) {
-        m_densities[i] = 0.;
-        for (int j = 0; j < NN; ++j)
-          m_densities[i] += solVector[j];
-      }
-      else {
-        cout << "Could not recover m_densities from partial pressures!\n";
-      }
-      xVector[i] = 0.;
+      int ic = m_MapToEVComponent[i];
+      ncomp[ic] += m_densitiesid[i];
+      scomp[ic] += sid[i];
     }
 
-    std::vector<double> fEntropyP(m_densities.size());
-    for (int i = 0; i < NN; ++i) {
-      double dMu = 0.;
-      for (int j = 0; j < m_TPS->ComponentsNumber(); ++j) dMu += -m_Virial[i][j] * m_Ps[j];
-      xVector[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i] + dMu);
+    // The densities are n_i = n_i^id * y_i, where y solves (1 + b^T n^id) y = 1,
+    // y_i is the same for all species within an EV component
+    MatrixXd densMatrix(NNEV, NNEV);
+    VectorXd solVector(NNEV), xVector(NNEV);
+
+    for (int ic = 0; ic < NNEV; ++ic) {
+      for (int jc = 0; jc < NNEV; ++jc) {
+        densMatrix(ic, jc) = m_Virial[m_MapFromEVComponent[jc]][m_MapFromEVComponent[ic]] * ncomp[jc];
+        if (ic == jc) densMatrix(ic, jc) += 1.;
+      }
+      xVector[ic] = 1.;
     }
 
+    PartialPivLU<MatrixXd> decomp(densMatrix);
     solVector = decomp.solve(xVector);
 
-    if (1) {
-      m_TotalEntropyDensity = 0.;
-      for (int i = 0; i < NN; ++i)
-        m_TotalEntropyDensity += solVector[i];
-    }
-    else {
-      cout << "**ERROR** Could not recover m_densities from partial pressures!\n";
-      return;
-    }
+    for (int i = 0; i < NN; ++i)
+      m_densities[i] = m_densitiesid[i] * solVector[m_MapToEVComponent[i]];
 
-    m_Calculated = true;
-    ValidateCalculation();
+    m_TotalEntropyDensity = 0.;
+    for (int ic = 0; ic < NNEV; ++ic)
+      m_TotalEntropyDensity += scomp[ic] * solVector[ic];
   }
 
-  void ThermalModelEVCrossterms::CalculatePrimordialDensitiesNoReset() {
-    // Pressure
-    SolvePressure(false);
-    vector<double> tN(m_densities.size());
-    for (size_t i = 0; i < m_Ps.size(); ++i) 
-      tN[i] = DensityId(i);
-
-    // Densities
-
-    int NN = m_densities.size();
+  void ThermalModelEVCrossterms::CalculatePrimordialDensities() {
+    ResetDerivedCalculatedFlags();
 
-    MatrixXd densMatrix(NN, NN);
-    VectorXd solVector(NN), xVector(NN);
+    FillEVComponentMaps();
 
-    for (int i = 0; i < NN; ++i)
-      for (int j = 0; j < NN; ++j) {
-        densMatrix(i, j) = m_Virial[i][j] * tN[i];
-        if (i == j) densMatrix(i, j) += 1.;
-      }
+    // Pressure
+    SolvePressure();
 
-    PartialPivLU<MatrixXd> decomp(densMatrix);
+    // Densities and entropy
+    CalculateDensitiesFromPartialPressures();
 
-    for (int i = 0; i < NN; ++i) xVector[i] = 0.;
-    for (int i = 0; i < NN; ++i) {
-      xVector[i] = tN[i];//m_Ps[i] / m_Parameters.T;
-      //solVector = lu.Solve(xVector, ok);
-      solVector = decomp.solve(xVector);
-      //if (ok) {
-      if (1) {
-        //if (decomp.info()==Eigen::Success) {
-        m_densities[i] = 0.;
-        for (int j = 0; j < NN; ++j)
-          m_densities[i] += solVector[j];
-      }
-      else {
-        cout << "**ERROR** Could not recover m_densities from partial pressures!\n";
-        return;
-      }
-      xVector[i] = 0.;
-    }
+    m_Calculated = true;
+    ValidateCalculation();
+  }
 
-    std::vector<double> fEntropyP(m_densities.size());
-    for (int i = 0; i < NN; ++i) {
-      double dMu = 0.;
-      for (int j = 0; j < m_TPS->ComponentsNumber(); ++j) dMu += -m_Virial[i][j] * m_Ps[j];
-      xVector[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i] + dMu);
-    }
+  void ThermalModelEVCrossterms::CalculatePrimordialDensitiesNoReset() {
+    FillEVComponentMaps();
 
-    solVector = decomp.solve(xVector);
+    // Pressure
+    SolvePressure(false);
 
-    //if (ok) {
-    if (1) {
-      //if (decomp.info()==Eigen::Success) {
-      m_TotalEntropyDensity = 0.;
-      for (int i = 0; i < NN; ++i)
-        m_TotalEntropyDensity += solVector[i];
-    }
-    else {
-      cout << "**ERROR** Could not recover m_densities from partial pressures!\n";
-      return;
-    }
+    // Densities and entropy
+    CalculateDensitiesFromPartialPressures();
 
     // Decays
 
@@ -425,64 +412,13 @@ namespace thermalfist {
   }
 
   void ThermalModelEVCrossterms::CalculatePrimordialDensitiesIter() {
+    FillEVComponentMaps();
+
     // Pressure
     SolvePressureIter();
 
-    int NN = m_densities.size();
-    vector<double> tN(NN);
-    for (int i = 0; i < NN; ++i) tN[i] = DensityId(i);
-
-    MatrixXd densMatrix(NN, NN);
-    for (int i = 0; i < NN; ++i)
-      for (int j = 0; j < NN; ++j) {
-        densMatrix(i, j) = m_Virial[j][i] * tN[i];
-        if (i == j) densMatrix(i, j) += 1.;
-      }
-    //densMatrix.SetMatrixArray(matr.GetArray());
-
-    VectorXd solVector(NN), xVector(NN);
-    for (int i = 0; i < NN; ++i) xVector[i] = tN[i];
-
-    PartialPivLU<MatrixXd> decomp(densMatrix);
-
-    solVector = decomp.solve(xVector);
-
-    if (1) {
-      //if (decomp.info()==Eigen::Success) {
-      for (int i = 0; i < NN; ++i)
-        m_densities[i] = solVector[i];
-    }
-    else {
-      cout << "**ERROR** Could not recover m_densities from partial pressures!\n";
-      return;
-    }
-
-    // Entropy
-    for (int i = 0; i < NN; ++i)
-      for (int j = 0; j < NN; ++j) {
-        densMatrix(i, j) = m_Virial[i][j] * tN[i];
-        if (i == j) densMatrix(i, j) += 1.;
-      }
-
-    std::vector<double> fEntropyP(m_densities.size());
-    for (int i = 0; i < NN; ++i) {
-      double dMu = 0.;
-      for (int j = 0; j < m_TPS->ComponentsNumber(); ++j) dMu += -m_Virial[i][j] * m_Ps[j];
-      xVector[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i] + dMu);
-    }
-
-    decomp = PartialPivLU<MatrixXd>(densMatrix);
-    solVector = decomp.solve(xVector);
-
-    if (1) {
-      //if (decomp.info()==Eigen::Success) {
-      m_TotalEntropyDensity = 0.;
-      for (int i = 0; i < NN; ++i)
-        m_TotalEntropyDensity += solVector[i];
-    }
-    else {
-      cout << "Could not recover entropy m_densities from partial pressures!\n";
-    }
+    // Densities and entropy
+    CalculateDensitiesFromPartialPressures();
 
     m_Calculated = true;
   }
@@ -490,8 +426,13 @@ namespace thermalfist {
   void ThermalModelEVCrossterms::CalculateTwoParticleCorrelations() {
     int NN = m_densities.size();
     vector<double> tN(NN), tW(NN);
-    for (int i = 0; i < NN; ++i) tN[i] = DensityId(i);
-    for (int i = 0; i < NN; ++i) tW[i] = ScaledVarianceId(i);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      tN[i] = DensityId(i);
+      tW[i] = ScaledVarianceId(i);
+    }
     MatrixXd densMatrix(NN, NN);
     VectorXd solVector(NN), xVector(NN), xVector2(NN);
 
@@ -573,6 +514,8 @@ namespace thermalfist {
 
   // TODO include correlations
   void ThermalModelEVCrossterms::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     CalculateTwoParticleCorrelations();
     CalculateSusceptibilityMatrix();
     CalculateTwoParticleFluctuationsDecays();
@@ -635,6 +578,10 @@ namespace thermalfist {
       densMatrix(i, NN + i) = (densMatrix(i, NN + i) - 1.) * chi2id[i] * pow(xMath::GeVtoifm(), 3) * m_Parameters.T * m_Parameters.T;
     }
 
+    for (int i = 0; i < NN; ++i)
+      for (int j = 0; j < NN; ++j)
+        densMatrix(NN + i, j) = 0.;
+
     for (int i = 0; i < NN; ++i)
       for (int j = 0; j < NN; ++j) {
         densMatrix(NN + i, NN + j) = m_Virial[i][j] * DensitiesId[j];
@@ -808,10 +755,32 @@ namespace thermalfist {
       return 0.0;
   }
 
+  void ThermalModelEVCrossterms::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Scalars["Pressure"] = m_Pressure;
+    state.Scalars["TotalEntropyDensity"] = m_TotalEntropyDensity;
+    state.Vectors["DensitiesId"] = m_densitiesid;
+    state.Vectors["PartialPressures"] = m_Ps;
+  }
+
+  void ThermalModelEVCrossterms::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+    state.Get("Pressure", m_Pressure);
+    state.Get("TotalEntropyDensity", m_TotalEntropyDensity);
+    state.Get("DensitiesId", m_densitiesid);
+    state.Get("PartialPressures", m_Ps);
+  }
+
   std::vector<double> ThermalModelEVCrossterms::BroydenEquationsCRS::Equations(const std::vector<double>& x)
   {
     std::vector<double> ret(m_N);
-    for (size_t i = 0; i < x.size(); ++i)
+    int N = x.size();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_THM->m_useOpenMP)
+#endif
+    for (int i = 0; i < N; ++i)
       ret[i] = x[i] - m_THM->Pressure(i, x);
     return ret;
   }
@@ -821,6 +790,9 @@ namespace thermalfist {
     int N = x.size();
 
     vector<double> tN(N);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_THM->m_useOpenMP)
+#endif
     for (int i = 0; i < N; ++i) {
       tN[i] = m_THM->DensityId(i, x);
     }
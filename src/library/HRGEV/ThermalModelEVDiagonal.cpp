@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGEV/ThermalModelEVDiagonal.h"
+#include "HRGBase/Profiling.h"
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -30,7 +31,7 @@ using namespace std;
 namespace thermalfist {
 
   ThermalModelEVDiagonal::ThermalModelEVDiagonal(ThermalParticleSystem *TPS, const ThermalModelParameters& params) :
-    ThermalModelBase(TPS, params)
+    ThermalModelBase(TPS, params), m_Pressure(0.), m_PressureWarmStart(false)
   {
     m_densitiesid.resize(m_TPS->Particles().size());
     m_v.resize(m_TPS->Particles().size());
@@ -53,6 +54,12 @@ namespace thermalfist {
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
       m_v[i] = CuteHRGHelper::vr(rad);
     }
+    ResetCalculatedFlags();
+  }
+
+  ThermalModelEVDiagonal* ThermalModelEVDiagonal::Clone() const
+  {
+    return new ThermalModelEVDiagonal(*this);
   }
 
   void ThermalModelEVDiagonal::FillVirial(const std::vector<double>& ri)
@@ -64,6 +71,7 @@ namespace thermalfist {
     m_v.resize(m_TPS->Particles().size());
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       m_v[i] = CuteHRGHelper::vr(ri[i]);
+    ResetCalculatedFlags();
   }
 
   void ThermalModelEVDiagonal::FillVirialEV(const std::vector<double>& vi)
@@ -73,6 +81,7 @@ namespace thermalfist {
       return;
     }
     m_v = vi;
+    ResetCalculatedFlags();
   }
 
   void ThermalModelEVDiagonal::ReadInteractionParameters(const std::string & filename)
@@ -97,6 +106,7 @@ namespace thermalfist {
       }
     }
     fin.close();
+    ResetCalculatedFlags();
   }
 
   void ThermalModelEVDiagonal::WriteInteractionParameters(const std::string & filename)
@@ -162,45 +172,135 @@ namespace thermalfist {
     return ret;
   }
 
+  void ThermalModelEVDiagonal::EVPressureAndDerivatives(double P, double & pressure, double & dpressure, double & d2pressure)
+  {
+    pressure = dpressure = d2pressure = 0.;
+    const double T = m_Parameters.T;
+    int NEV = m_EVSpecies.size();
+
+    m_pressuresid.resize(m_TPS->Particles().size());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int k = 0; k < NEV; ++k) {
+      int i = m_EVSpecies[k];
+      const ThermalParticle &part = m_TPS->Particles()[i];
+      double mu = m_Chem[i] - m_v[i] * P;
+      m_densitiesid[i] = part.Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, mu);
+      // Boltzmann statistics: p = T n
+      if (part.Statistics() == 0)
+        m_pressuresid[i] = T * m_densitiesid[i];
+      else
+        m_pressuresid[i] = part.Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, mu);
+    }
+
+    for (int k = 0; k < NEV; ++k) {
+      int i = m_EVSpecies[k];
+      double n = m_densitiesid[i];
+      pressure += m_pressuresid[i];
+      dpressure -= m_v[i] * n;
+      // dn/dmu = n / T, exact for Boltzmann statistics
+      d2pressure += m_v[i] * m_v[i] * n / T;
+    }
+  }
+
   void ThermalModelEVDiagonal::SolvePressure() {
-    BroydenEquationsDEV eqs(this);
-    BroydenJacobianDEV jac(this);
-    Broyden broydn(&eqs, &jac);
-    BroydenSolutionCriteriumDEV crit(this, 1.0E-8);
+    m_densitiesid.resize(m_TPS->Particles().size());
+    m_densitiesidnoshift.resize(m_TPS->Particles().size());
 
-    m_Pressure = Pressure(0.);
-    double mnc = pow(m_Parameters.T, 4.) * pow(xMath::GeVtoifm(), 3.);
-    eqs.SetMnc(mnc);
-    jac.SetMnc(mnc);
-    double x0 = log(m_Pressure / mnc);
-    std::vector<double> x(1, x0);
+    // Species with zero eigenvolume do not depend on the pressure
+    std::vector<int> pointlike;
+    m_EVSpecies.clear();
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
+      if (m_v[i] != 0.)
+        m_EVSpecies.push_back(i);
+      else
+        pointlike.push_back(i);
+    }
 
-    x = broydn.Solve(x, &crit);
+    m_pressuresid.resize(m_TPS->Particles().size());
+    int Npointlike = pointlike.size();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int k = 0; k < Npointlike; ++k) {
+      int i = pointlike[k];
+      const ThermalParticle &part = m_TPS->Particles()[i];
+      m_densitiesid[i] = part.Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
+      m_densitiesidnoshift[i] = m_densitiesid[i];
+      if (part.Statistics() == 0)
+        m_pressuresid[i] = m_Parameters.T * m_densitiesid[i];
+      else
+        m_pressuresid[i] = part.Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_Chem[i]);
+    }
 
-    
+    double Ppointlike = 0.;
+    for (int k = 0; k < Npointlike; ++k)
+      Ppointlike += m_pressuresid[pointlike[k]];
 
-    double PressureNew = mnc * exp(x[0]);
+    double f, df, d2f;
+    EVPressureAndDerivatives(0., f, df, d2f);
+    for (size_t k = 0; k < m_EVSpecies.size(); ++k)
+      m_densitiesidnoshift[m_EVSpecies[k]] = m_densitiesid[m_EVSpecies[k]];
 
-    // UPDATE: Currently not used
-    //double current_precision = Broyden::TOL;
-    //// If pressures are too small we may need additional iterations with higher accuracy
-    //while (abs(PressureNew) < current_precision && current_precision > 1.e-50 && abs(PressureNew /m_Pressure) < 1.e-5) {
-    //  current_precision *= 1.e-10;
-    //  x = broydn.Solve(x, &Broyden::BroydenSolutionCriterium(current_precision));
-    //  PressureNew = mnc * exp(x[0]);
-    //}
+    // The r.h.s. decreases with P, thus the solution lies between these two values
+    double Plo = Ppointlike, Phi = Ppointlike + f;
 
-    m_Pressure = PressureNew;
+    m_LastCalculationSuccessFlag = true;
+    m_MaxDiff = 0.;
 
-    if (broydn.Iterations() == broydn.MaxIterations())
+    if (m_EVSpecies.size() == 0 || !(Phi > 0.) || Phi == Plo) {
+      m_Pressure = Phi;
+      return;
+    }
+
+    double P = Phi;
+    if (m_PressureWarmStart && m_Pressure > Plo && m_Pressure < Phi)
+      P = m_Pressure;
+
+    const double tol = 1.e-10;
+    int iter = 0;
+    for (iter = 0; iter < Broyden::MAX_ITERS; ++iter) {
+      EVPressureAndDerivatives(P, f, df, d2f);
+
+      // h(P) = P - p(P) is increasing and concave
+      double h = P - Ppointlike - f;
+      double dh = 1. - df;
+      m_MaxDiff = fabs(h) / P;
+      if (m_MaxDiff < tol)
+        break;
+
+      if (h > 0.)
+        Phi = P;
+      else
+        Plo = P;
+
+      // Halley's correction to the Newton step
+      double dP = -h / dh;
+      double denom = 1. - 0.5 * dP * d2f / dh;
+      if (denom > 0.5)
+        dP /= denom;
+
+      double Pnew = P + dP;
+      // Bisection if the step leaves the bracket
+      if (!(Pnew > Plo && Pnew < Phi))
+        Pnew = 0.5 * (Plo + Phi);
+      if (Pnew == P)
+        break;
+      P = Pnew;
+    }
+
+    if (iter == Broyden::MAX_ITERS) {
       m_LastCalculationSuccessFlag = false;
-    else m_LastCalculationSuccessFlag = true;
+      // Make the ideal gas densities consistent with the returned pressure
+      EVPressureAndDerivatives(P, f, df, d2f);
+    }
 
-    m_MaxDiff = broydn.MaxDifference();
+    m_Pressure = P;
   }
 
   void ThermalModelEVDiagonal::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     SolvePressure();
 
@@ -210,16 +310,10 @@ namespace thermalfist {
     m_Suppression = 0.;
     double densityid = 0., suppression = 0.;
 
-    m_densitiesidnoshift = m_densitiesid;
-
-#pragma omp parallel for reduction(+:densityid) reduction(+:suppression) if(useOpenMP)
+    // Ideal gas densities at the solved pressure are filled by SolvePressure()
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      double dMu = -m_v[i] * m_Pressure;
-      m_densitiesid[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i] + dMu);
       densityid += m_densitiesid[i];
       suppression += m_v[i] * m_densitiesid[i];
-
-      m_densitiesidnoshift[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i]);
     }
 
     m_Densityid = densityid;
@@ -227,10 +321,18 @@ namespace thermalfist {
 
     m_Suppression = 1. / (1. + m_Suppression);
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
+    int NN = m_TPS->ComponentsNumber();
+    vector<double> wid(NN);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i)
+      wid[i] = m_TPS->Particles()[i].ScaledVariance(m_Parameters, m_UseWidth, m_Chem[i] - m_v[i] * m_Pressure);
+
+    for (int i = 0; i < NN; ++i) {
       m_densities[i] = m_densitiesid[i] * m_Suppression;
       m_TotalDensity += m_densities[i];
-      m_wnSum += m_densities[i] * m_TPS->Particles()[i].ScaledVariance(m_Parameters, m_UseWidth, m_Chem[i] - m_v[i] * m_Pressure);
+      m_wnSum += m_densities[i] * wid[i];
     }
 
     CalculateFeeddown();
@@ -242,8 +344,13 @@ namespace thermalfist {
   void ThermalModelEVDiagonal::CalculateTwoParticleCorrelations() {
     int NN = m_densities.size();
     vector<double> tN(NN), tW(NN);
-    for (int i = 0; i < NN; ++i) tN[i] = DensityId(i, m_Pressure);
-    for (int i = 0; i < NN; ++i) tW[i] = ScaledVarianceId(i, m_Pressure);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      tN[i] = DensityId(i, m_Pressure);
+      tW[i] = ScaledVarianceId(i, m_Pressure);
+    }
 
     m_PrimCorrel.resize(NN);
     for (int i = 0; i < NN; ++i) m_PrimCorrel[i].resize(NN);
@@ -272,6 +379,8 @@ namespace thermalfist {
 
   // TODO include correlations
   void ThermalModelEVDiagonal::CalculateFluctuations() {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     CalculateTwoParticleCorrelations();
     CalculateSusceptibilityMatrix();
     CalculateTwoParticleFluctuationsDecays();
@@ -342,6 +451,10 @@ namespace thermalfist {
       densMatrix(i, NN + i) = (densMatrix(i, NN + i) - 1.) * chi2id[i] * pow(xMath::GeVtoifm(), 3) * m_Parameters.T * m_Parameters.T;
     }
 
+    for (int i = 0; i < NN; ++i)
+      for (int j = 0; j < NN; ++j)
+        densMatrix(NN + i, j) = 0.;
+
     for (int i = 0; i < NN; ++i)
       for (int j = 0; j < NN; ++j) {
         densMatrix(NN + i, NN + j) = m_v[i] * DensitiesId[j];
@@ -486,23 +599,27 @@ namespace thermalfist {
 
   double ThermalModelEVDiagonal::CalculateEnergyDensity() {
     if (!m_Calculated) CalculateDensities();
+    vector<double> mus(m_TPS->ComponentsNumber()), edens;
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      mus[i] = m_Chem[i] - m_v[i] * m_Pressure;
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, mus, edens);
+
     double ret = 0.;
-    double dMu = 0.;
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      dMu = -m_v[i] * m_Pressure;
-      ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_Chem[i] + dMu);
-    }
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      ret += edens[i];
     return ret * m_Suppression;
   }
 
   double ThermalModelEVDiagonal::CalculateEntropyDensity() {
     if (!m_Calculated) CalculateDensities();
+    vector<double> mus(m_TPS->ComponentsNumber()), sdens;
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      mus[i] = m_Chem[i] - m_v[i] * m_Pressure;
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, mus, sdens);
+
     double ret = 0.;
-    double dMu = 0.;
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      dMu = -m_v[i] * m_Pressure;
-      ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_Chem[i] + dMu);
-    }
+    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
+      ret += sdens[i];
     return ret * m_Suppression;
   }
 
@@ -534,6 +651,30 @@ namespace thermalfist {
       return 0.0;
   }
 
+  void ThermalModelEVDiagonal::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Scalars["Pressure"] = m_Pressure;
+    state.Scalars["Suppression"] = m_Suppression;
+    state.Scalars["DensityId"] = m_Densityid;
+    state.Scalars["TotalDensity"] = m_TotalDensity;
+    state.Vectors["DensitiesId"] = m_densitiesid;
+    state.Vectors["DensitiesIdNoShift"] = m_densitiesidnoshift;
+    state.Vectors["PressuresId"] = m_pressuresid;
+  }
+
+  void ThermalModelEVDiagonal::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+    state.Get("Pressure", m_Pressure);
+    state.Get("Suppression", m_Suppression);
+    state.Get("DensityId", m_Densityid);
+    state.Get("TotalDensity", m_TotalDensity);
+    state.Get("DensitiesId", m_densitiesid);
+    state.Get("DensitiesIdNoShift", m_densitiesidnoshift);
+    state.Get("PressuresId", m_pressuresid);
+  }
+
   double ThermalModelEVDiagonal::CalculateEigenvolumeFraction() {
     double tEV = 0.;
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
@@ -546,6 +687,7 @@ namespace thermalfist {
   {
     if (i >= 0 && i < static_cast<int>(m_v.size()))
       m_v[i] = CuteHRGHelper::vr(rad);
+    ResetCalculatedFlags();
   }
 
   double ThermalModelEVDiagonal::VirialCoefficient(int i, int /*j*/) const
@@ -557,29 +699,7 @@ namespace thermalfist {
   {
     if (i == j)
       m_v[i] = b;
-  }
-
-  std::vector<double> ThermalModelEVDiagonal::BroydenEquationsDEV::Equations(const std::vector<double>& x)
-  {
-    std::vector<double> ret(1);
-    double pressure = m_mnc * exp(x[0]);
-
-    ret[0] = pressure - m_THM->Pressure(pressure);
-
-    return ret;
-  }
-
-  std::vector<double> ThermalModelEVDiagonal::BroydenJacobianDEV::Jacobian(const std::vector<double>& x)
-  {
-    double pressure = m_mnc * exp(x[0]);
-
-    double ret = 0.;
-    for (size_t i = 0; i < m_THM->Densities().size(); ++i)
-      ret += m_THM->VirialCoefficient(i, i) * m_THM->DensityId(i, pressure);
-    ret += 1.;
-    ret *= pressure;
-
-    return std::vector<double>(1, ret);
+    ResetCalculatedFlags();
   }
 
   std::vector<double> ThermalModelEVDiagonal::BroydenEquationsDEVOrig::Equations(const std::vector<double>& x)
@@ -600,13 +720,4 @@ namespace thermalfist {
 
     return std::vector<double>(1, ret);
   }
-
-  bool ThermalModelEVDiagonal::BroydenSolutionCriteriumDEV::IsSolved(const std::vector<double>& x, const std::vector<double>& f, const std::vector<double>& /*xdelta*/) const
-  {
-    double maxdiff = 0.;
-    for (size_t i = 0; i < x.size(); ++i) {
-      maxdiff = std::max(maxdiff, fabs(f[i]) / m_THM->m_Pressure);
-    }
-    return (maxdiff < m_MaximumError);
-  }
 } // namespace thermalfist
\ No newline at end of file
@@ -0,0 +1,177 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGEventGenerator/EventChunk.h"
+
+namespace thermalfist {
+
+  namespace {
+    template<typename T>
+    void ReleaseVector(std::vector<T>& vec)
+    {
+      std::vector<T>().swap(vec);
+    }
+
+    template<typename T>
+    size_t VectorMemory(const std::vector<T>& vec)
+    {
+      return vec.capacity() * sizeof(T);
+    }
+
+    size_t ParticlesMemory(const EventChunk::Particles& parts)
+    {
+      return VectorMemory(parts.px) + VectorMemory(parts.py) + VectorMemory(parts.pz) + VectorMemory(parts.m)
+        + VectorMemory(parts.PDGID)
+        + VectorMemory(parts.r0) + VectorMemory(parts.rx) + VectorMemory(parts.ry) + VectorMemory(parts.rz)
+        + VectorMemory(parts.MotherPDGID) + VectorMemory(parts.PrimordialPDGID) + VectorMemory(parts.Epoch);
+    }
+  }
+
+  void EventChunk::Particles::Clear()
+  {
+    px.clear(); py.clear(); pz.clear(); m.clear();
+    PDGID.clear();
+    r0.clear(); rx.clear(); ry.clear(); rz.clear();
+    MotherPDGID.clear(); PrimordialPDGID.clear(); Epoch.clear();
+  }
+
+  void EventChunk::Particles::Release()
+  {
+    ReleaseVector(px); ReleaseVector(py); ReleaseVector(pz); ReleaseVector(m);
+    ReleaseVector(PDGID);
+    ReleaseVector(r0); ReleaseVector(rx); ReleaseVector(ry); ReleaseVector(rz);
+    ReleaseVector(MotherPDGID); ReleaseVector(PrimordialPDGID); ReleaseVector(Epoch);
+  }
+
+  SimpleParticle EventChunk::Particles::GetParticle(size_t i) const
+  {
+    SimpleParticle ret(px[i], py[i], pz[i], m[i], PDGID[i]);
+    if (i < r0.size()) {
+      ret.r0 = r0[i];
+      ret.rx = rx[i];
+      ret.ry = ry[i];
+      ret.rz = rz[i];
+    }
+    if (i < MotherPDGID.size()) {
+      ret.MotherPDGID = MotherPDGID[i];
+      ret.epoch = Epoch[i];
+    }
+    return ret;
+  }
+
+  void EventChunk::Clear()
+  {
+    m_Weights.clear();
+    m_LogWeights.clear();
+    m_EventOffsets.clear();
+    m_EventOffsets.push_back(0);
+    m_PhotonsLeptonsOffsets.clear();
+    m_PhotonsLeptonsOffsets.push_back(0);
+    m_Particles.Clear();
+    m_PhotonsLeptons.Clear();
+  }
+
+  void EventChunk::Release()
+  {
+    ReleaseVector(m_Weights);
+    ReleaseVector(m_LogWeights);
+    ReleaseVector(m_EventOffsets);
+    ReleaseVector(m_PhotonsLeptonsOffsets);
+    m_Particles.Release();
+    m_PhotonsLeptons.Release();
+    Clear();
+  }
+
+  void EventChunk::Reserve(size_t events, size_t particles)
+  {
+    m_Weights.reserve(events);
+    m_LogWeights.reserve(events);
+    m_EventOffsets.reserve(events + 1);
+    m_PhotonsLeptonsOffsets.reserve(events + 1);
+
+    Particles& parts = m_Particles;
+    parts.px.reserve(particles); parts.py.reserve(particles); parts.pz.reserve(particles); parts.m.reserve(particles);
+    parts.PDGID.reserve(particles);
+    if (m_Config.StoreCoordinates) {
+      parts.r0.reserve(particles); parts.rx.reserve(particles); parts.ry.reserve(particles); parts.rz.reserve(particles);
+    }
+    if (m_Config.StoreDecayHistory) {
+      parts.MotherPDGID.reserve(particles); parts.PrimordialPDGID.reserve(particles); parts.Epoch.reserve(particles);
+    }
+  }
+
+  void EventChunk::AddParticles(Particles& out, const std::vector<SimpleParticle>& in, const SimpleEvent& evt, bool isFinal)
+  {
+    for (size_t i = 0; i < in.size(); ++i) {
+      const SimpleParticle& part = in[i];
+      out.px.push_back(part.px);
+      out.py.push_back(part.py);
+      out.pz.push_back(part.pz);
+      out.m.push_back(part.m);
+      out.PDGID.push_back(part.PDGID);
+
+      if (m_Config.StoreCoordinates) {
+        out.r0.push_back(part.r0);
+        out.rx.push_back(part.rx);
+        out.ry.push_back(part.ry);
+        out.rz.push_back(part.rz);
+      }
+
+      if (m_Config.StoreDecayHistory) {
+        out.MotherPDGID.push_back(part.MotherPDGID);
+        out.Epoch.push_back(part.epoch);
+        long long primordial = 0;
+        if (isFinal && i < evt.DecayMapFinal.size()) {
+          int ind = evt.DecayMapFinal[i];
+          if (ind >= 0 && ind < static_cast<int>(evt.AllParticles.size()))
+            primordial = evt.AllParticles[ind].PDGID;
+        }
+        // No decay map if the decays were not performed, each particle is primordial
+        else if (isFinal && evt.DecayMapFinal.empty())
+          primordial = part.PDGID;
+        out.PrimordialPDGID.push_back(primordial);
+      }
+    }
+  }
+
+  void EventChunk::AddEvent(const SimpleEvent& evt)
+  {
+    m_Weights.push_back(evt.weight);
+    m_LogWeights.push_back(evt.logweight);
+
+    AddParticles(m_Particles, evt.Particles, evt, true);
+    m_EventOffsets.push_back(m_Particles.Size());
+
+    if (m_Config.StorePhotonsLeptons)
+      AddParticles(m_PhotonsLeptons, evt.PhotonsLeptons, evt, false);
+    m_PhotonsLeptonsOffsets.push_back(m_PhotonsLeptons.Size());
+  }
+
+  SimpleEvent EventChunk::GetEvent(int k) const
+  {
+    SimpleEvent ret;
+    ret.weight = m_Weights[k];
+    ret.logweight = m_LogWeights[k];
+
+    ret.Particles.reserve(EventSize(k));
+    for (size_t i = m_EventOffsets[k]; i < m_EventOffsets[k + 1]; ++i)
+      ret.Particles.push_back(m_Particles.GetParticle(i));
+
+    for (size_t i = m_PhotonsLeptonsOffsets[k]; i < m_PhotonsLeptonsOffsets[k + 1]; ++i)
+      ret.PhotonsLeptons.push_back(m_PhotonsLeptons.GetParticle(i));
+
+    return ret;
+  }
+
+  size_t EventChunk::MemoryUsage() const
+  {
+    return VectorMemory(m_Weights) + VectorMemory(m_LogWeights)
+      + VectorMemory(m_EventOffsets) + VectorMemory(m_PhotonsLeptonsOffsets)
+      + ParticlesMemory(m_Particles) + ParticlesMemory(m_PhotonsLeptons);
+  }
+
+} // namespace thermalfist
@@ -12,6 +12,7 @@
 
 
 #include "HRGBase/xMath.h"
+#include "HRGBase/Profiling.h"
 #include "HRGBase/ThermalModelBase.h"
 #include "HRGBase/ThermalModelIdeal.h"
 #include "HRGBase/ThermalModelCanonicalStrangeness.h"
@@ -399,8 +400,10 @@ namespace thermalfist {
 
       double weight = ComputeWeightNew(totals);
       //std::cout << weight << " " << ComputeWeightNew(totals) << "\n";
-      if (weight < 0.)
+      if (weight < 0.) {
+        THERMALFIST_PROFILE_COUNT(EventsRejected, 1);
         continue;
+      }
 
       break;
 
@@ -545,6 +548,7 @@ namespace thermalfist {
     }
 
     fCEAccepted++;
+    THERMALFIST_PROFILE_COUNT(EventsGenerated, 1);
 
     return totals;
   }
@@ -552,6 +556,7 @@ namespace thermalfist {
   std::vector<int> EventGeneratorBase::GenerateTotalsGCE() const
   {
     fCETotal++;
+    THERMALFIST_PROFILE_COUNT(MultiplicityTrials, 1);
 
     if (!m_THM->IsGCECalculated()) m_THM->CalculateDensitiesGCE();
     std::vector<int> totals(m_THM->TPS()->Particles().size(), 0);
@@ -709,6 +714,7 @@ namespace thermalfist {
 
     while (1) {
       fCETotal++;
+      THERMALFIST_PROFILE_COUNT(MultiplicityTrials, 1);
       const std::vector<double>& densities = m_THM->Densities();
 
       for (size_t i = 0; i < m_THM->TPS()->Particles().size(); ++i) totals[i] = 0;
@@ -906,12 +912,14 @@ namespace thermalfist {
     double fMeanAntiCharmc = m_MeanACHRM * VolumeSC / m_THM->Volume();
 
     fCETotal++;
+    THERMALFIST_PROFILE_COUNT(MultiplicityTrials, 1);
 
     int netC = 0;
     int tC = RandomGenerators::RandomPoisson(fMeanCharmc);
     int tAC = RandomGenerators::RandomPoisson(fMeanAntiCharmc);
     while (tC - tAC != m_THM->Parameters().C - netC) {
       fCETotal++;
+      THERMALFIST_PROFILE_COUNT(MultiplicityTrials, 1);
       tC = RandomGenerators::RandomPoisson(fMeanCharmc);
       tAC = RandomGenerators::RandomPoisson(fMeanAntiCharmc);
     }
@@ -984,6 +992,7 @@ namespace thermalfist {
     // Multi-step procedure as described in F. Becattini, L. Ferroni, hep-ph/0307061
     while (1) {
       fCETotal++;
+      THERMALFIST_PROFILE_COUNT(MultiplicityTrials, 1);
 
       const std::vector<double>& densities = m_THM->Densities();
 
@@ -1186,33 +1195,71 @@ namespace thermalfist {
     //return make_pair(totals, 1.);
   }
 
+  SimpleParticle EventGeneratorBase::SamplePrimordialParticle(int i, MTRand* rangen) const
+  {
+    const ThermalParticle& species = m_THM->TPS()->Particles()[i];
+    double tmass = species.Mass();
+    if (m_THM->UseWidth() && !species.ZeroWidthEnforced() && !(species.GetResonanceWidthIntegrationType() == ThermalParticle::ZeroWidth))
+      tmass = m_BWGens[i]->GetRandom(rangen != NULL ? *rangen : RandomGenerators::randgenMT);
+
+    // Check for Bose-Einstein condensation
+    // Force m = mu if the sampled mass is too small
+    double tmu = m_THM->FullIdealChemicalPotential(i);
+    if (species.Statistics() == -1 && tmu > tmass) {
+      tmass = tmu;
+    }
+
+    std::vector<double> momentum = (rangen != NULL) ? m_MomentumGens[i]->GetMomentum(tmass, *rangen) : m_MomentumGens[i]->GetMomentum(tmass);
+
+    return SimpleParticle(momentum[0], momentum[1], momentum[2], tmass, species.PdgId(), 0,
+      momentum[3], momentum[4], momentum[5], momentum[6]);
+  }
+
   SimpleEvent EventGeneratorBase::SampleMomenta(const std::vector<int>& yields) const
   {
     SimpleEvent ret;
 
     std::vector< std::vector<SimpleParticle> > primParticles(m_THM->TPS()->Particles().size());
 
-    for (size_t i = 0; i < m_THM->TPS()->Particles().size(); ++i) {
-      const ThermalParticle& species = m_THM->TPS()->Particles()[i];
-      primParticles[i].resize(0);
-      int total = yields[i];
-      for (int part = 0; part < total; ++part) {
-        double tmass = species.Mass();
-        if (m_THM->UseWidth() && !species.ZeroWidthEnforced() && !(species.GetResonanceWidthIntegrationType() == ThermalParticle::ZeroWidth))
-          tmass = m_BWGens[i]->GetRandom();
-
-        // Check for Bose-Einstein condensation
-        // Force m = mu if the sampled mass is too small
-        double tmu = m_THM->FullIdealChemicalPotential(i);
-        if (species.Statistics() == -1 && tmu > tmass) {
-          tmass = tmu;
-        }
+    bool parallel = m_useOpenMP;
+    for (size_t i = 0; i < m_THM->TPS()->Particles().size() && parallel; ++i) {
+      if (yields[i] > 0 && !m_MomentumGens[i]->SupportsRandomGenerator())
+        parallel = false;
+    }
 
-        std::vector<double> momentum = m_MomentumGens[i]->GetMomentum(tmass);
-        //std::vector<double> momentum = m_MomentumGens[i]->GetMomentum(0.99999 * m_THM->TPS()->Particles()[i].Mass());
+    if (!parallel) {
+      for (size_t i = 0; i < m_THM->TPS()->Particles().size(); ++i) {
+        primParticles[i].resize(0);
+        int total = yields[i];
+        for (int part = 0; part < total; ++part)
+          primParticles[i].push_back(SamplePrimordialParticle(i));
+      }
+    }
+    else {
+      // Blocks of at most blockSize particles of the same species.
+      // The blocks and their seeds do not depend on the number of threads.
+      const int blockSize = 1000;
+      std::vector<int> blockSpecies, blockStart;
+      std::vector<MTRand::uint32> blockSeeds;
+      for (size_t i = 0; i < m_THM->TPS()->Particles().size(); ++i) {
+        primParticles[i].resize(yields[i]);
+        for (int start = 0; start < yields[i]; start += blockSize) {
+          blockSpecies.push_back(i);
+          blockStart.push_back(start);
+          blockSeeds.push_back(RandomGenerators::randgenMT.randInt());
+        }
+      }
 
-        primParticles[i].push_back(SimpleParticle(momentum[0], momentum[1], momentum[2], tmass, species.PdgId(), 0,
-          momentum[3], momentum[4], momentum[5], momentum[6]));
+      int blocks = blockSpecies.size();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int ib = 0; ib < blocks; ++ib) {
+        MTRand rangen(blockSeeds[ib]);
+        int i = blockSpecies[ib];
+        int end = std::min(blockStart[ib] + blockSize, yields[i]);
+        for (int part = blockStart[ib]; part < end; ++part)
+          primParticles[i][part] = SamplePrimordialParticle(i, &rangen);
       }
     }
 
@@ -1234,6 +1281,8 @@ namespace thermalfist {
 
   SimpleEvent EventGeneratorBase::GetEvent(bool DoDecays) const
   {
+    THERMALFIST_PROFILE_SCOPE(EventGenerationTimer);
+
     if (!m_THM->IsGCECalculated()) m_THM->CalculateDensitiesGCE();
 
     std::vector<int> totals = GenerateTotals();
@@ -1381,8 +1430,17 @@ namespace thermalfist {
   //   return ret;
   // }
 
+  void EventGeneratorBase::GenerateChunk(EventChunk& chunk, int nevents, bool PerformDecays) const
+  {
+    chunk.Clear();
+    for (int i = 0; i < nevents; ++i)
+      chunk.AddEvent(GetEvent(PerformDecays));
+  }
+
   SimpleEvent EventGeneratorBase::PerformDecays(const SimpleEvent& evtin, ThermalParticleSystem* TPS)
   {
+    THERMALFIST_PROFILE_SCOPE(DecaysTimer);
+
     SimpleEvent ret;
     ret.weight = evtin.weight;
     ret.logweight = evtin.logweight;
@@ -1401,6 +1459,10 @@ namespace thermalfist {
       }
     }
 
+    // Buffers for the batched decays, reused across species and decay channels
+    std::vector<int> pending, channels, batch;
+    std::vector<SimpleParticle> mothers, decres;
+
     bool flag_repeat = true;
     while (flag_repeat) {
       flag_repeat = false;
@@ -1419,9 +1481,13 @@ namespace thermalfist {
           }
         }
         else {
+          // Sample the decay channels of all the unprocessed particles of this species first,
+          // then decay the particles of each channel in one batch
+          pending.clear();
+          channels.clear();
           for (size_t j = 0; j < primParticles[i].size(); ++j) {
             if (!primParticles[i][j].processed) {
-              flag_repeat = true;
+              THERMALFIST_PROFILE_COUNT(DecaysPerformed, 1);
               double DecParam = RandomGenerators::randgenMT.rand(), tsum = 0.;
 
               std::vector<double> Bratios;
@@ -1438,49 +1504,73 @@ namespace thermalfist {
                 tsum += Bratios[DecayIndex];
                 if (tsum > DecParam) break;
               }
-              if (DecayIndex < static_cast<int>(TPS->Particles()[i].Decays().size())) {
-                std::vector<double> masses(0);
-                std::vector<long long> pdgids(0);
-                for (size_t di = 0; di < TPS->Particles()[i].Decays()[DecayIndex].mDaughters.size(); di++) {
-                  long long dpdg = TPS->Particles()[i].Decays()[DecayIndex].mDaughters[di];
-                  if (TPS->PdgToId(dpdg) == -1) {
-                    // Try to see if the daughter particle is a photon/lepton
-                    if (ExtraParticles::PdgToId(dpdg) == -1)
-                      continue;
-                    else
-                      masses.push_back(ExtraParticles::ParticleByPdg(dpdg).Mass());
-                  }
-                  else {
-                    masses.push_back(TPS->ParticleByPDG(dpdg).Mass());
-                  }
-                  pdgids.push_back(dpdg);
-                }
-                std::vector<SimpleParticle> decres = ParticleDecaysMC::ManyBodyDecay(primParticles[i][j], masses, pdgids);
-                for (size_t ind = 0; ind < decres.size(); ind++) {
-                  decres[ind].processed = false;
-                  if (TPS->PdgToId(decres[ind].PDGID) != -1) {
-                    int tid = TPS->PdgToId(decres[ind].PDGID);
-                    SimpleParticle& dprt = decres[ind];
-                    primParticles[tid].push_back(dprt);
-                    ret.AllParticles.push_back(dprt);
-                    AllParticlesMap[tid].push_back(static_cast<int>(ret.AllParticles.size()) - 1);
-                    ret.DecayMap.push_back(AllParticlesMap[i][j]);
-                  }
-                  else if (ExtraParticles::PdgToId(decres[ind].PDGID) != -1) {
-                    SimpleParticle& dprt = decres[ind];
-                    ret.AllParticles.push_back(dprt);
-                    ret.DecayMap.push_back(AllParticlesMap[i][j]);
-                    ret.PhotonsLeptons.push_back(dprt);
-                  }
-                }
-                primParticles[i][j].processed = true;
+              pending.push_back(static_cast<int>(j));
+              channels.push_back(DecayIndex);
+            }
+          }
+
+          if (pending.empty())
+            continue;
+          flag_repeat = true;
+
+          // Decays through unknown branching ratios, presumably radiative, no hadrons, are not performed, the decay products are ignored
+          const ThermalParticle::ParticleDecaysVector& decays = TPS->Particles()[i].Decays();
+          for (int DecayIndex = 0; DecayIndex < static_cast<int>(decays.size()); ++DecayIndex) {
+            batch.clear();
+            mothers.clear();
+            for (size_t k = 0; k < pending.size(); ++k) {
+              if (channels[k] == DecayIndex) {
+                batch.push_back(pending[k]);
+                mothers.push_back(primParticles[i][pending[k]]);
+              }
+            }
+            if (batch.empty())
+              continue;
+
+            std::vector<double> masses(0);
+            std::vector<long long> pdgids(0);
+            for (size_t di = 0; di < decays[DecayIndex].mDaughters.size(); di++) {
+              long long dpdg = decays[DecayIndex].mDaughters[di];
+              if (TPS->PdgToId(dpdg) == -1) {
+                // Try to see if the daughter particle is a photon/lepton
+                if (ExtraParticles::PdgToId(dpdg) == -1)
+                  continue;
+                else
+                  masses.push_back(ExtraParticles::ParticleByPdg(dpdg).Mass());
               }
               else {
-                // Decay through unknown branching ratio, presumably radiative, no hadrons, just ignore decay products
-                primParticles[i][j].processed = true;
+                masses.push_back(TPS->ParticleByPDG(dpdg).Mass());
+              }
+              pdgids.push_back(dpdg);
+            }
+
+            ParticleDecaysMC::ManyBodyDecayBatch(mothers, masses, pdgids, decres);
+            size_t nproducts = decres.size() / mothers.size();
+
+            for (size_t k = 0; k < batch.size(); ++k) {
+              int j = batch[k];
+              for (size_t ind = k * nproducts; ind < (k + 1) * nproducts; ind++) {
+                decres[ind].processed = false;
+                if (TPS->PdgToId(decres[ind].PDGID) != -1) {
+                  int tid = TPS->PdgToId(decres[ind].PDGID);
+                  SimpleParticle& dprt = decres[ind];
+                  primParticles[tid].push_back(dprt);
+                  ret.AllParticles.push_back(dprt);
+                  AllParticlesMap[tid].push_back(static_cast<int>(ret.AllParticles.size()) - 1);
+                  ret.DecayMap.push_back(AllParticlesMap[i][j]);
+                }
+                else if (ExtraParticles::PdgToId(decres[ind].PDGID) != -1) {
+                  SimpleParticle& dprt = decres[ind];
+                  ret.AllParticles.push_back(dprt);
+                  ret.DecayMap.push_back(AllParticlesMap[i][j]);
+                  ret.PhotonsLeptons.push_back(dprt);
+                }
               }
             }
           }
+
+          for (size_t k = 0; k < pending.size(); ++k)
+            primParticles[i][pending[k]].processed = true;
         }
       }
     }
@@ -7,6 +7,7 @@
  */
 #include "HRGEventGenerator/FreezeoutModels.h"
 
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 
@@ -19,6 +20,82 @@ namespace thermalfist {
     return Rfunc(zeta) * taufunc(zeta) * (coshetaperp(zeta) * dRdZeta(zeta) - sinhetaperp(zeta) * dtaudZeta(zeta));
   }
 
+  BoostInvariantFreezeoutParametrization::ProfileValues BoostInvariantFreezeoutParametrization::Profile(double zeta) const
+  {
+    ProfileValues ret;
+    ret.CoshEtaPerp = coshetaperp(zeta);
+    ret.SinhEtaPerp = sinhetaperp(zeta);
+    ret.TanhEtaPerp = tanhetaperp(zeta);
+    ret.dRdZeta = dRdZeta(zeta);
+    ret.dTaudZeta = dtaudZeta(zeta);
+    return ret;
+  }
+
+  void BoostInvariantFreezeoutParametrization::TabulateZetaDistribution(int nodes)
+  {
+    if (nodes < 1)
+      nodes = 1;
+
+    double h = 1. / nodes;
+    m_ZetaPDF.resize(nodes + 1);
+    m_ZetaCDF.resize(nodes + 1);
+    for (int i = 0; i <= nodes; ++i) {
+      double prob = ZetaProbability(i * h);
+      m_ZetaPDF[i] = (prob > 0. && prob == prob) ? prob : 0.;
+    }
+
+    m_ZetaCDF[0] = 0.;
+    for (int i = 0; i < nodes; ++i)
+      m_ZetaCDF[i + 1] = m_ZetaCDF[i] + 0.5 * h * (m_ZetaPDF[i] + m_ZetaPDF[i + 1]);
+
+    if (m_ZetaCDF[nodes] <= 0.) {
+      printf("**WARNING** BoostInvariantFreezeoutParametrization::TabulateZetaDistribution: Vanishing zeta distribution, using the rejection sampling!\n");
+      m_ZetaPDF.clear();
+      m_ZetaCDF.clear();
+      m_ZetaGuide.clear();
+      return;
+    }
+
+    m_ZetaGuide.resize(nodes);
+    int ind = 0;
+    for (int k = 0; k < nodes; ++k) {
+      double target = m_ZetaCDF[nodes] * k / nodes;
+      while (ind < nodes - 1 && m_ZetaCDF[ind + 1] <= target)
+        ind++;
+      m_ZetaGuide[k] = ind;
+    }
+  }
+
+  double BoostInvariantFreezeoutParametrization::InverseZetaDistributionTabulated(double xi) const
+  {
+    int nodes = static_cast<int>(m_ZetaGuide.size());
+    double target = xi * m_ZetaCDF[nodes];
+
+    int k = static_cast<int>(xi * nodes);
+    if (k >= nodes)
+      k = nodes - 1;
+    if (k < 0)
+      k = 0;
+    int ind = m_ZetaGuide[k];
+    while (ind < nodes - 1 && m_ZetaCDF[ind + 1] <= target)
+      ind++;
+
+    // Solve f_i t + (f_{i+1} - f_i) t^2 / (2h) = u for t in the interval
+    double h = 1. / nodes;
+    double u = target - m_ZetaCDF[ind];
+    double f0 = m_ZetaPDF[ind];
+    double s = (m_ZetaPDF[ind + 1] - f0) / h;
+    double disc = f0 * f0 + 2. * s * u;
+    if (disc < 0.)
+      disc = 0.;
+    double denom = f0 + sqrt(disc);
+    double t = (denom > 0.) ? 2. * u / denom : 0.;
+    if (t > h)
+      t = h;
+
+    return ind * h + t;
+  }
+
   double BoostInvariantFreezeoutParametrization::ProbabilityMaximum()
   {
     if (!m_ProbabilityMaximumComputed) {
@@ -36,7 +113,7 @@ namespace thermalfist {
     // Look for a possibility that the ternary search has produced a local minimum instead of the global one
     double tmax = 0., tzetamax = 0.;
     double dzeta = 0.01;
-    for (double tzeta = 0.; tzeta <= 1. + 1.e9; tzeta += dzeta) {
+    for (double tzeta = 0.; tzeta <= 1. + 1.e-9; tzeta += dzeta) {
       double tprob = ZetaProbability(tzeta);
       if (tprob > tmax) {
         tmax = tprob;
@@ -92,6 +169,17 @@ namespace thermalfist {
     }
   }
 
+  BoostInvariantFreezeoutParametrization::ProfileValues CylindricalBlastWaveParametrization::Profile(double zeta) const
+  {
+    ProfileValues ret;
+    ret.TanhEtaPerp = m_BetaS * pow(zeta, m_n);
+    ret.CoshEtaPerp = 1. / sqrt(1. - ret.TanhEtaPerp * ret.TanhEtaPerp);
+    ret.SinhEtaPerp = ret.TanhEtaPerp * ret.CoshEtaPerp;
+    ret.dRdZeta = m_R;
+    ret.dTaudZeta = 0.;
+    return ret;
+  }
+
   double CylindricalBlastWaveParametrization::ZetaProbability(double zeta) const
   {
     return m_R * zeta * m_tau * coshetaperp(zeta) * m_R;
@@ -108,6 +196,17 @@ namespace thermalfist {
     }
   }
 
+  BoostInvariantFreezeoutParametrization::ProfileValues CracowFreezeoutParametrization::Profile(double zeta) const
+  {
+    ProfileValues ret;
+    ret.SinhEtaPerp = zeta * m_RoverTauH;
+    ret.CoshEtaPerp = sqrt(1. + ret.SinhEtaPerp * ret.SinhEtaPerp);
+    ret.TanhEtaPerp = ret.SinhEtaPerp / ret.CoshEtaPerp;
+    ret.dRdZeta = Rmax();
+    ret.dTaudZeta = Rmax() * ret.TanhEtaPerp;
+    return ret;
+  }
+
   double CracowFreezeoutParametrization::ZetaProbability(double zeta) const
   {
     return Rmax() * zeta * m_tauH * Rmax();
@@ -228,7 +228,7 @@ namespace thermalfist {
 
     for (size_t i = 0; i < m_xlegeta.size(); i++) {
       for (size_t j = 0; j < m_xlegT.size(); j++) {
-        double tmp = m_wlegeta[i] * m_wlegT[j] * ZetaIntegrandpTYSingleFireball(m_xlegeta[i], pt, y - m_xlegeta[i]);
+        double tmp = m_wlegeta[i] * m_wlegT[j] * ZetaIntegrandpTYSingleFireball(m_xlegT[j], pt, y - m_xlegeta[i]);
         ret += tmp;
       }
     }
@@ -265,6 +265,162 @@ namespace thermalfist {
       m_wlegeta.resize(1);
       m_wlegeta[0] = 1.;
     }
+
+    m_Profile.resize(m_xlegT.size());
+    for (size_t i = 0; i < m_xlegT.size(); i++) {
+      double zeta = m_xlegT[i];
+      double Rtau = m_FreezeoutModel->Rfunc(zeta) * m_FreezeoutModel->taufunc(zeta);
+      m_Profile[i].WeightK = m_wlegT[i] * Rtau * m_FreezeoutModel->dRdZeta(zeta);
+      m_Profile[i].WeightI = m_wlegT[i] * Rtau * m_FreezeoutModel->dtaudZeta(zeta);
+      m_Profile[i].CoshOverT = m_FreezeoutModel->coshetaperp(zeta) / m_T;
+      m_Profile[i].SinhOverT = m_FreezeoutModel->sinhetaperp(zeta) / m_T;
+    }
+  }
+
+  bool BoostInvariantMomentumDistribution::SameProfile(const BoostInvariantMomentumDistribution& other) const
+  {
+    if (other.m_Profile.size() != m_Profile.size())
+      return false;
+    for (size_t i = 0; i < m_Profile.size(); i++) {
+      if (other.m_Profile[i].WeightK != m_Profile[i].WeightK
+        || other.m_Profile[i].WeightI != m_Profile[i].WeightI
+        || other.m_Profile[i].CoshOverT != m_Profile[i].CoshOverT
+        || other.m_Profile[i].SinhOverT != m_Profile[i].SinhOverT)
+        return false;
+    }
+    return true;
+  }
+
+  void BoostInvariantMomentumDistribution::TabulateBesselI(const std::vector<double>& pts, std::vector<double>& I0, std::vector<double>& I1) const
+  {
+    size_t nodes = m_Profile.size();
+    I0.resize(pts.size() * nodes);
+    I1.resize(pts.size() * nodes);
+    for (size_t ipt = 0; ipt < pts.size(); ipt++) {
+      for (size_t i = 0; i < nodes; i++) {
+        double arg = pts[ipt] * m_Profile[i].SinhOverT;
+        I0[ipt * nodes + i] = xMath::BesselI0(arg);
+        I1[ipt * nodes + i] = xMath::BesselI1(arg);
+      }
+    }
+  }
+
+  double BoostInvariantMomentumDistribution::dnmtdmtProfile(double mt, double pt, const double* I0, const double* I1) const
+  {
+    double ret = 0.;
+    for (size_t i = 0; i < m_Profile.size(); i++) {
+      const ProfileNode& node = m_Profile[i];
+      double arg = mt * node.CoshOverT;
+      double tmp = mt * node.WeightK * xMath::BesselK1(arg) * I0[i]
+        - pt * node.WeightI * xMath::BesselK0(arg) * I1[i];
+      if (tmp != tmp) break;
+      ret += tmp;
+    }
+    return ret;
+  }
+
+  std::vector<double> BoostInvariantMomentumDistribution::dnmtdmt(const std::vector<double>& mts) const
+  {
+    std::vector<double> pts(mts.size());
+    for (size_t ipt = 0; ipt < mts.size(); ipt++)
+      pts[ipt] = sqrt(mts[ipt] * mts[ipt] - m_Mass * m_Mass);
+
+    std::vector<double> I0, I1;
+    TabulateBesselI(pts, I0, I1);
+
+    size_t nodes = m_Profile.size();
+    std::vector<double> ret(mts.size());
+    for (size_t ipt = 0; ipt < mts.size(); ipt++)
+      ret[ipt] = dnmtdmtProfile(mts[ipt], pts[ipt], &I0[ipt * nodes], &I1[ipt * nodes]) * m_NormPt;
+    return ret;
+  }
+
+  std::vector<double> BoostInvariantMomentumDistribution::d2ndptdy(const std::vector<double>& pts, double y) const
+  {
+    size_t nodes = m_Profile.size();
+    std::vector<double> I0, I1;
+    TabulateBesselI(pts, I0, I1);
+
+    std::vector<double> coshy(m_xlegeta.size());
+    for (size_t i = 0; i < m_xlegeta.size(); i++)
+      coshy[i] = cosh(y - m_xlegeta[i]);
+
+    std::vector<double> ret(pts.size());
+    for (size_t ipt = 0; ipt < pts.size(); ipt++) {
+      double pt = pts[ipt];
+      double mt = sqrt(pt * pt + m_Mass * m_Mass);
+      const double* tI0 = &I0[ipt * nodes];
+      const double* tI1 = &I1[ipt * nodes];
+      double tret = 0.;
+      for (size_t i = 0; i < m_xlegeta.size(); i++) {
+        for (size_t j = 0; j < nodes; j++) {
+          const ProfileNode& node = m_Profile[j];
+          tret += m_wlegeta[i] * (mt * node.WeightK * coshy[i] * tI0[j] - pt * node.WeightI * tI1[j])
+            * exp(-mt * node.CoshOverT * coshy[i]);
+        }
+      }
+      ret[ipt] = tret * m_Norm * pt;
+      if (m_useacc)
+        ret[ipt] *= m_acc->getAcceptance(y + m_ycm, pt);
+    }
+    return ret;
+  }
+
+  std::vector< std::vector<double> > BoostInvariantMomentumDistribution::CalculatePtSpectra(
+    const std::vector<const BoostInvariantMomentumDistribution*>& distrs,
+    const std::vector<double>& pts,
+    bool useOpenMP)
+  {
+    std::vector< std::vector<double> > ret(distrs.size());
+
+    // Distributions with identical freeze-out profiles share the tables of the Bessel functions
+    std::vector<int> group(distrs.size(), -1);
+    std::vector<const BoostInvariantMomentumDistribution*> groupDistrs;
+    for (size_t ind = 0; ind < distrs.size(); ind++) {
+      if (distrs[ind] == NULL)
+        continue;
+      for (size_t ig = 0; ig < groupDistrs.size(); ig++) {
+        if (distrs[ind]->SameProfile(*groupDistrs[ig])) {
+          group[ind] = static_cast<int>(ig);
+          break;
+        }
+      }
+      if (group[ind] == -1) {
+        group[ind] = static_cast<int>(groupDistrs.size());
+        groupDistrs.push_back(distrs[ind]);
+      }
+    }
+
+    int ngroups = static_cast<int>(groupDistrs.size());
+    std::vector< std::vector<double> > I0(ngroups), I1(ngroups);
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(useOpenMP)
+#else
+    (void)useOpenMP;
+#endif
+    for (int ig = 0; ig < ngroups; ig++)
+      groupDistrs[ig]->TabulateBesselI(pts, I0[ig], I1[ig]);
+
+    int ndistrs = static_cast<int>(distrs.size());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(useOpenMP)
+#endif
+    for (int ind = 0; ind < ndistrs; ind++) {
+      const BoostInvariantMomentumDistribution* distr = distrs[ind];
+      if (distr == NULL)
+        continue;
+      size_t nodes = distr->m_Profile.size();
+      const std::vector<double>& tI0 = I0[group[ind]];
+      const std::vector<double>& tI1 = I1[group[ind]];
+      ret[ind].resize(pts.size());
+      for (size_t ipt = 0; ipt < pts.size(); ipt++) {
+        double pt = pts[ipt];
+        double mt = sqrt(pt * pt + distr->m_Mass * distr->m_Mass);
+        ret[ind][ipt] = pt * distr->dnmtdmtProfile(mt, pt, &tI0[ipt * nodes], &tI1[ipt * nodes]) * distr->m_NormPt;
+      }
+    }
+
+    return ret;
   }
 
   double BoostInvariantMomentumDistribution::dndysingle(double y) const
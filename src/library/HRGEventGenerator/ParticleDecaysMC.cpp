@@ -14,6 +14,103 @@ namespace thermalfist {
 
   namespace ParticleDecaysMC {
 
+    namespace {
+      /// Four-momenta and masses of a batch of particles, stored as separate arrays
+      struct MomentumArrays {
+        std::vector<double> px, py, pz, p0, m;
+
+        void resize(size_t n) {
+          px.resize(n); py.resize(n); pz.resize(n); p0.resize(n); m.resize(n);
+        }
+      };
+
+      /// Sines and cosines of the decay angles of a batch of two-body decays
+      struct DecayAngles {
+        std::vector<double> cphi, sphi, cthe, sthe;
+      };
+
+      /**
+       * Samples the decay angles of n two-body decays, in the same order as TwoBodyDecay().
+       * The trigonometric functions are evaluated here so that the decay kernel is free of library calls.
+       */
+      void SampleDecayAngles(size_t n, DecayAngles& angles, MTRand& rangen)
+      {
+        angles.cphi.resize(n);
+        angles.sphi.resize(n);
+        angles.cthe.resize(n);
+        angles.sthe.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+          double phi = 2. * xMath::Pi() * rangen.rand();
+          double cthe = 2. * rangen.rand() - 1.;
+          angles.cphi[i] = cos(phi);
+          angles.sphi[i] = sin(phi);
+          angles.cthe[i] = cthe;
+          angles.sthe[i] = sqrt(1. - cthe * cthe);
+        }
+      }
+
+      /**
+       * Two-body decays mo[i] -> d1[i] + d2[i] for given decay angles.
+       * The daughter masses are read from d1.m (one per mother) and m2 (common).
+       * The loop contains no branches and no random number calls, so that it can be vectorized.
+       */
+      void TwoBodyDecayKernel(const MomentumArrays& mo, double m2, MomentumArrays& d1, MomentumArrays& d2,
+        const DecayAngles& angles)
+      {
+        size_t n = mo.m.size();
+        d2.resize(n);
+        const double *Mpx = &mo.px[0], *Mpy = &mo.py[0], *Mpz = &mo.pz[0], *Mp0 = &mo.p0[0], *M = &mo.m[0];
+        const double *cphi = &angles.cphi[0], *sphi = &angles.sphi[0], *cthe = &angles.cthe[0], *sthe = &angles.sthe[0];
+        double *px1 = &d1.px[0], *py1 = &d1.py[0], *pz1 = &d1.pz[0], *p01 = &d1.p0[0], *m1 = &d1.m[0];
+        double *px2 = &d2.px[0], *py2 = &d2.py[0], *pz2 = &d2.pz[0], *p02 = &d2.p0[0], *dm2 = &d2.m[0];
+        // The arrays never overlap, which the compiler cannot prove by itself
+#ifndef _MSC_VER
+#pragma omp simd
+#endif
+        for (size_t i = 0; i < n; ++i) {
+          // Momenta in the rest frame of the mother
+          double ten1 = (M[i] * M[i] - m2 * m2 + m1[i] * m1[i]) / 2. / M[i];
+          double tp = sqrt(ten1 * ten1 - m1[i] * m1[i]);
+          double kx = tp * cphi[i] * sthe[i];
+          double ky = tp * sphi[i] * sthe[i];
+          double kz = tp * cthe[i];
+          double ten2 = sqrt(m2 * m2 + tp * tp);
+
+          // Boost to the frame where the mother moves with the velocity v
+          double vx = Mpx[i] / Mp0[i], vy = Mpy[i] / Mp0[i], vz = Mpz[i] / Mp0[i];
+          double v2 = vx * vx + vy * vy + vz * vz;
+          double gamma = 1. / sqrt(1. - v2);
+          // (gamma - 1) / v^2, without the division by zero for a mother at rest
+          double f = gamma * gamma / (gamma + 1.);
+          double vk = vx * kx + vy * ky + vz * kz;
+
+          p01[i] = gamma * (ten1 + vk);
+          px1[i] = kx + gamma * vx * ten1 + f * vx * vk;
+          py1[i] = ky + gamma * vy * ten1 + f * vy * vk;
+          pz1[i] = kz + gamma * vz * ten1 + f * vz * vk;
+
+          p02[i] = gamma * (ten2 - vk);
+          px2[i] = -kx + gamma * vx * ten2 - f * vx * vk;
+          py2[i] = -ky + gamma * vy * ten2 - f * vy * vk;
+          pz2[i] = -kz + gamma * vz * ten2 - f * vz * vk;
+          dm2[i] = m2;
+        }
+      }
+
+      /// Copies decay product i of the batch into a SimpleParticle produced by the decay of Mother
+      void StoreDecayProduct(const SimpleParticle& Mother, const MomentumArrays& d, size_t i, long long pdg, SimpleParticle& out)
+      {
+        out = Mother;
+        out.px = d.px[i];
+        out.py = d.py[i];
+        out.pz = d.pz[i];
+        out.p0 = d.p0[i];
+        out.m = d.m[i];
+        out.PDGID = pdg;
+        out.MotherPDGID = Mother.PDGID;
+        out.epoch = Mother.epoch + 1;
+      }
+    }
     
     double ThreeBodym12F2(double m12, double M, double m1, double m2, double m3) {
       double m12k = m12 * m12;
@@ -44,11 +141,11 @@ namespace thermalfist {
     int threebodysucc = 0, threebodytot = 0;
 
     // Random sample for m12 in a 3-body decay
-    double GetRandomThreeBodym12(double M, double m1_, double m2_, double m3_, double fm12max) {
+    double GetRandomThreeBodym12(double M, double m1_, double m2_, double m3_, double fm12max, MTRand& rangen) {
       while (true) {
         threebodytot++;
-        double x0 = m1_ + m2_ + (M - m1_ - m2_ - m3_) * RandomGenerators::randgenMT.randDblExc();
-        double y0 = fm12max * RandomGenerators::randgenMT.randDblExc();
+        double x0 = m1_ + m2_ + (M - m1_ - m2_ - m3_) * rangen.randDblExc();
+        double y0 = fm12max * rangen.randDblExc();
         if (y0*y0 < ThreeBodym12F2(x0, M, m1_, m2_, m3_)) {
           threebodysucc++;
           return x0;
@@ -76,7 +173,7 @@ namespace thermalfist {
       return ret;
     }
 
-    std::vector<SimpleParticle> TwoBodyDecay(const SimpleParticle & Mother, double m1, long long pdg1, double m2, long long pdg2) {
+    std::vector<SimpleParticle> TwoBodyDecay(const SimpleParticle & Mother, double m1, long long pdg1, double m2, long long pdg2, MTRand& rangen) {
 
       std::vector<SimpleParticle> ret(0);
       ret.push_back(Mother);
@@ -89,11 +186,11 @@ namespace thermalfist {
       double vx = Mother.px / Mother.p0;
       double vy = Mother.py / Mother.p0;
       double vz = Mother.pz / Mother.p0;
-      SimpleParticle Mo = LorentzBoost(Mother, vx, vy, vz);
-      double ten1 = (Mo.m*Mo.m - m2 * m2 + m1 * m1) / 2. / Mo.m;
+      // Only the mass of the mother is needed in its rest frame
+      double ten1 = (Mother.m*Mother.m - m2 * m2 + m1 * m1) / 2. / Mother.m;
       double tp = sqrt(ten1*ten1 - m1 * m1);
-      double tphi = 2. * xMath::Pi() * RandomGenerators::randgenMT.rand();
-      double cthe = 2. * RandomGenerators::randgenMT.rand() - 1.;
+      double tphi = 2. * xMath::Pi() * rangen.rand();
+      double cthe = 2. * rangen.rand() - 1.;
       double sthe = sqrt(1. - cthe * cthe);
       ret[0].px = tp * cos(tphi) * sthe;
       ret[0].py = tp * sin(tphi) * sthe;
@@ -131,20 +228,30 @@ namespace thermalfist {
       return ret;
     }
 
-    std::vector<SimpleParticle> ManyBodyDecay(const SimpleParticle & Mother, std::vector<double> masses, std::vector<long long> pdgs) {
+    std::vector<SimpleParticle> ManyBodyDecay(const SimpleParticle & Mother, const std::vector<double>& massesIn, const std::vector<long long>& pdgsIn, MTRand& rangen) {
       std::vector<SimpleParticle> ret(0);
-      if (masses.size() < 1) return ret;
+      if (massesIn.size() < 1) return ret;
 
       // If only one daughter listed, assume a radiative decay A -> B + gamma
-      if (masses.size() == 1)
+      if (massesIn.size() == 1)
       {
+        std::vector<double> masses(1, massesIn[0]);
+        std::vector<long long> pdgs(1, pdgsIn[0]);
         masses.push_back(0.);
         pdgs.push_back(22);
+        return ManyBodyDecay(Mother, masses, pdgs, rangen);
       }
 
-      if (masses.size() > 3) {
-        ShuffleDecayProducts(masses, pdgs);
+      // The daughter lists are only copied for (4+)-body decays, which shuffle them
+      std::vector<double> massesShuffled;
+      std::vector<long long> pdgsShuffled;
+      if (massesIn.size() > 3) {
+        massesShuffled = massesIn;
+        pdgsShuffled = pdgsIn;
+        ShuffleDecayProducts(massesShuffled, pdgsShuffled, rangen);
       }
+      const std::vector<double>& masses = (massesIn.size() > 3) ? massesShuffled : massesIn;
+      const std::vector<long long>& pdgs = (massesIn.size() > 3) ? pdgsShuffled : pdgsIn;
 
       SimpleParticle Mother2 = Mother;
       // Mass validation
@@ -159,23 +266,21 @@ namespace thermalfist {
         Mother2.p0 = sqrt(Mother2.px * Mother2.px + Mother2.py * Mother2.py + Mother2.pz * Mother2.pz + Mother2.m * Mother2.m);
       }
 
-      if (masses.size() == 2) return TwoBodyDecay(Mother2, masses[0], pdgs[0], masses[1], pdgs[1]);
+      if (masses.size() == 2) return TwoBodyDecay(Mother2, masses[0], pdgs[0], masses[1], pdgs[1], rangen);
       double tmin = 0.;
       for (size_t i = 0; i < masses.size() - 1; ++i) tmin += masses[i];
       double tmax = Mother2.m - masses[masses.size() - 1];
       double mijk = 0.;
       if (masses.size() == 3) {
-        mijk = GetRandomThreeBodym12(Mother2.m, masses[0], masses[1], masses[2], 1.01*TernaryThreeBodym12Maximum(Mother2.m, masses[0], masses[1], masses[2]));
+        mijk = GetRandomThreeBodym12(Mother2.m, masses[0], masses[1], masses[2], 1.01*TernaryThreeBodym12Maximum(Mother2.m, masses[0], masses[1], masses[2]), rangen);
       }
       else // More than 3 body decay kinematics are only approximate!
       {
-        mijk = tmin + (tmax - tmin) * RandomGenerators::randgenMT.rand();
+        mijk = tmin + (tmax - tmin) * rangen.rand();
       }
-      std::vector<SimpleParticle> ret1 = TwoBodyDecay(Mother2, mijk, 11111, masses[masses.size() - 1], pdgs[pdgs.size() - 1]);
+      std::vector<SimpleParticle> ret1 = TwoBodyDecay(Mother2, mijk, 11111, masses[masses.size() - 1], pdgs[pdgs.size() - 1], rangen);
       ret.push_back(ret1[1]);
-      masses.resize(masses.size() - 1);
-      pdgs.resize(pdgs.size() - 1);
-      ret1 = ManyBodyDecay(ret1[0], masses, pdgs);
+      ret1 = ManyBodyDecay(ret1[0], std::vector<double>(masses.begin(), masses.end() - 1), std::vector<long long>(pdgs.begin(), pdgs.end() - 1), rangen);
       for (size_t i = 0; i < ret1.size(); ++i)
         ret.push_back(ret1[i]);
 
@@ -192,7 +297,110 @@ namespace thermalfist {
       return ret;
     }
 
-    void ShuffleDecayProducts(std::vector<double>& masses, std::vector<long long>& pdgs)
+    void ManyBodyDecayBatch(const std::vector<SimpleParticle>& mothers, const std::vector<double>& masses, const std::vector<long long>& pdgs, std::vector<SimpleParticle>& out, MTRand& rangen)
+    {
+      out.clear();
+      if (mothers.size() == 0 || masses.size() < 1)
+        return;
+
+      // If only one daughter listed, assume a radiative decay A -> B + gamma
+      if (masses.size() == 1) {
+        std::vector<double> masses2(1, masses[0]);
+        std::vector<long long> pdgs2(1, pdgs[0]);
+        masses2.push_back(0.);
+        pdgs2.push_back(22);
+        ManyBodyDecayBatch(mothers, masses2, pdgs2, out, rangen);
+        return;
+      }
+
+      size_t n = mothers.size();
+      size_t N = masses.size();
+
+      // (4+)-body decays are approximate and are sampled one by one
+      if (N > 3) {
+        out.reserve(n * N);
+        for (size_t i = 0; i < n; ++i) {
+          std::vector<SimpleParticle> decres = ManyBodyDecay(mothers[i], masses, pdgs, rangen);
+          out.insert(out.end(), decres.begin(), decres.end());
+        }
+        return;
+      }
+
+      double tmasssum = 0.;
+      for (size_t i = 0; i < N; ++i)
+        tmasssum += masses[i];
+
+      // Mothers, with the same mass validation as in ManyBodyDecay()
+      MomentumArrays mo;
+      mo.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        const SimpleParticle& Mother = mothers[i];
+        mo.px[i] = Mother.px;
+        mo.py[i] = Mother.py;
+        mo.pz[i] = Mother.pz;
+        mo.p0[i] = Mother.p0;
+        mo.m[i] = Mother.m;
+        if (mo.m[i] < tmasssum) {
+          mo.m[i] = tmasssum + 1.e-7;
+          mo.p0[i] = sqrt(Mother.px * Mother.px + Mother.py * Mother.py + Mother.pz * Mother.pz + mo.m[i] * mo.m[i]);
+        }
+      }
+
+      DecayAngles angles;
+      MomentumArrays d1, d2;
+      d1.resize(n);
+      out.resize(n * N);
+
+      if (N == 2) {
+        for (size_t i = 0; i < n; ++i)
+          d1.m[i] = masses[0];
+        SampleDecayAngles(n, angles, rangen);
+        TwoBodyDecayKernel(mo, masses[1], d1, d2, angles);
+        for (size_t i = 0; i < n; ++i) {
+          StoreDecayProduct(mothers[i], d1, i, pdgs[0], out[2 * i]);
+          StoreDecayProduct(mothers[i], d2, i, pdgs[1], out[2 * i + 1]);
+        }
+      }
+      else {
+        // Invariant mass of the first two daughters, the maximum of its density is reused for equal mother masses
+        double Mprev = -1., fm12max = 0.;
+        for (size_t i = 0; i < n; ++i) {
+          if (mo.m[i] != Mprev) {
+            Mprev = mo.m[i];
+            fm12max = 1.01 * TernaryThreeBodym12Maximum(Mprev, masses[0], masses[1], masses[2]);
+          }
+          d1.m[i] = GetRandomThreeBodym12(mo.m[i], masses[0], masses[1], masses[2], fm12max, rangen);
+        }
+
+        // M -> (12) + 3
+        MomentumArrays d3;
+        SampleDecayAngles(n, angles, rangen);
+        TwoBodyDecayKernel(mo, masses[2], d1, d3, angles);
+
+        // (12) -> 1 + 2
+        MomentumArrays d12;
+        d12.resize(n);
+        for (size_t i = 0; i < n; ++i)
+          d12.m[i] = masses[0];
+        SampleDecayAngles(n, angles, rangen);
+        TwoBodyDecayKernel(d1, masses[1], d12, d2, angles);
+
+        for (size_t i = 0; i < n; ++i) {
+          StoreDecayProduct(mothers[i], d12, i, pdgs[0], out[3 * i]);
+          StoreDecayProduct(mothers[i], d2, i, pdgs[1], out[3 * i + 1]);
+          StoreDecayProduct(mothers[i], d3, i, pdgs[2], out[3 * i + 2]);
+        }
+      }
+
+      for (size_t i = 0; i < out.size(); ++i) {
+        if (out[i].px != out[i].px) {
+          printf("**WARNING** Issue in a batch of %d-body decays!\n", static_cast<int>(N));
+          break;
+        }
+      }
+    }
+
+    void ShuffleDecayProducts(std::vector<double>& masses, std::vector<long long>& pdgs, MTRand& rangen)
     {
       if (masses.size() != pdgs.size()) {
         std::cout << "**WARNING** ShuffleDecayProducts(): size of masses does not match size of pdgs!\n";
@@ -200,7 +408,7 @@ namespace thermalfist {
       }
       int N = masses.size();
       for (int i = N - 1; i >= 1; --i) {
-        int j = RandomGenerators::randgenMT.randInt() % (i + 1);
+        int j = rangen.randInt() % (i + 1);
         std::swap(masses[j], masses[i]);
         std::swap(pdgs[j], pdgs[i]);
       }
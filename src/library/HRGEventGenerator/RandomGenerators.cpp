@@ -167,12 +167,12 @@ namespace thermalfist {
       m_Max = g((m1 + m2) / 2.);
     }
 
-    double SiemensRasmussenMomentumGenerator::GetRandom(double mass) const {
+    double SiemensRasmussenMomentumGenerator::GetRandom(double mass, MTRand& rangen) const {
       if (mass < 0.)
         mass = m_Mass;
       while (1) {
-        double x0 = randgenMT.randDblExc();
-        double y0 = m_Max * randgenMT.randDblExc();
+        double x0 = rangen.randDblExc();
+        double y0 = m_Max * rangen.randDblExc();
         double mn = 1.;
         if (mass != m_Mass)
           mn = 10.;
@@ -181,11 +181,11 @@ namespace thermalfist {
       return 0.;
     }
 
-    std::vector<double> SiemensRasmussenMomentumGenerator::GetMomentum(double mass) const {
+    std::vector<double> SiemensRasmussenMomentumGenerator::GetMomentum(double mass, MTRand& rangen) const {
       std::vector<double> ret(0);
-      double tp = GetRandom(mass);
-      double tphi = 2. * xMath::Pi() * randgenMT.rand();
-      double cthe = 2. * randgenMT.rand() - 1.;
+      double tp = GetRandom(mass, rangen);
+      double tphi = 2. * xMath::Pi() * rangen.rand();
+      double cthe = 2. * rangen.rand() - 1.;
       double sthe = sqrt(1. - cthe * cthe);
       ret.push_back(tp*cos(tphi)*sthe); //px
       ret.push_back(tp*sin(tphi)*sthe); //py
@@ -253,12 +253,12 @@ namespace thermalfist {
       return g((m1 + m2) / 2., mass);
     }
 
-    double ThermalMomentumGenerator::GetP(double mass) const
+    double ThermalMomentumGenerator::GetP(double mass, MTRand& rangen) const
     {
       if (mass < 0.)
         mass = m_Mass;
       while (1) {
-        double x0 = randgenMT.randDblExc();
+        double x0 = rangen.randDblExc();
 
         if (mass < m_Mu && m_Statistics == -1)
           printf("**WARNING** ThermalMomentumGenerator::GetP: Bose-condensation mu %lf > mass %lf\n", m_Mu, mass);
@@ -272,7 +272,7 @@ namespace thermalfist {
         if (prob > 1.)
           printf("**WARNING** ThermalMomentumGenerator::GetP: Probability exceeds unity by %E\n", prob - 1.);
 
-        if (randgenMT.randDblExc() < prob) return -log(x0);
+        if (rangen.randDblExc() < prob) return -log(x0);
       }
       return 0.;
     }
@@ -287,6 +287,13 @@ namespace thermalfist {
       if (m_FreezeoutModel == NULL) {
         //m_FreezeoutModel = new BoostInvariantFreezeoutParametrization();
       }
+      else if (!m_FreezeoutModel->InverseZetaDistributionIsExplicit() && !m_FreezeoutModel->IsZetaDistributionTabulated()) {
+        m_FreezeoutModel->TabulateZetaDistribution();
+        // The rejection sampling fallback needs the maximum, it is computed here
+        // and not on the first call of GetRandomZeta(), which may come from several threads
+        if (!m_FreezeoutModel->IsZetaDistributionTabulated())
+          m_FreezeoutModel->ProbabilityMaximum();
+      }
     }
 
     BoostInvariantMomentumGenerator::~BoostInvariantMomentumGenerator()
@@ -295,17 +302,19 @@ namespace thermalfist {
         delete m_FreezeoutModel;
     }
 
-    std::vector<double> BoostInvariantMomentumGenerator::GetMomentum(double mass) const
+    std::vector<double> BoostInvariantMomentumGenerator::GetMomentum(double mass, MTRand& rangen) const
     {
       if (mass < 0.)
         mass = Mass();
 
 
-      double zetacand = GetRandomZeta(RandomGenerators::randgenMT);
-      double eta = -EtaMax() + 2. * EtaMax() * RandomGenerators::randgenMT.rand();
-      double ph = 2. * xMath::Pi() * RandomGenerators::randgenMT.rand();
+      double zetacand = GetRandomZeta(rangen);
+      double eta = -EtaMax() + 2. * EtaMax() * rangen.rand();
+      double ph = 2. * xMath::Pi() * rangen.rand();
 
-      double betar = m_FreezeoutModel->tanhetaperp(zetacand);
+      BoostInvariantFreezeoutParametrization::ProfileValues profile = m_FreezeoutModel->Profile(zetacand);
+
+      double betar = profile.TanhEtaPerp;
       double cosheta = cosh(eta);
       double sinheta = sinh(eta);
 
@@ -316,11 +325,8 @@ namespace thermalfist {
       double vy = betar * sinphi / cosheta;
       double vz = tanh(eta);
 
-      double dRdZeta = m_FreezeoutModel->dRdZeta(zetacand);
-      double dtaudZeta = m_FreezeoutModel->dtaudZeta(zetacand);
-
-      double coshetaperp = m_FreezeoutModel->coshetaperp(zetacand);
-      double sinhetaperp = m_FreezeoutModel->sinhetaperp(zetacand);
+      double dRdZeta = profile.dRdZeta;
+      double dtaudZeta = profile.dTaudZeta;
 
       std::vector<double> dsigma_lab;
       dsigma_lab.push_back(dRdZeta * cosheta);
@@ -339,9 +345,9 @@ namespace thermalfist {
 
       while (true) {
 
-        double tp = m_Generator.GetP(mass);
-        double tphi = 2. * xMath::Pi() * RandomGenerators::randgenMT.rand();
-        double cthe = 2. * RandomGenerators::randgenMT.rand() - 1.;
+        double tp = m_Generator.GetP(mass, rangen);
+        double tphi = 2. * xMath::Pi() * rangen.rand();
+        double cthe = 2. * rangen.rand() - 1.;
         double sthe = sqrt(1. - cthe * cthe);
         part.px = tp * cos(tphi) * sthe;
         part.py = tp * sin(tphi) * sthe;
@@ -365,7 +371,7 @@ namespace thermalfist {
             Weight - 1.);
         }
 
-        if (RandomGenerators::randgenMT.rand() < Weight)
+        if (rangen.rand() < Weight)
           break;
 
       }
@@ -399,6 +405,9 @@ namespace thermalfist {
     {
       if (m_FreezeoutModel->InverseZetaDistributionIsExplicit())
         return m_FreezeoutModel->InverseZetaDistribution(rangen.rand());
+
+      if (m_FreezeoutModel->IsZetaDistributionTabulated())
+        return m_FreezeoutModel->InverseZetaDistributionTabulated(rangen.rand());
       
       while (1) {
         double zetacand = rangen.rand();
@@ -437,12 +446,12 @@ namespace thermalfist {
       m_Max = f((m1 + m2) / 2.);
     }
 
-    double BreitWignerGenerator::GetRandom() const {
+    double BreitWignerGenerator::GetRandom(MTRand& rangen) const {
       //bool fl = true;
       if (m_Gamma < 1e-7) return m_M;
       while (1) {
-        double x0 = m_Mthr + (m_M + 2.*m_Gamma - m_Mthr) * randgenMT.rand();
-        double y0 = m_Max * randgenMT.rand();
+        double x0 = m_Mthr + (m_M + 2.*m_Gamma - m_Mthr) * rangen.rand();
+        double y0 = m_Max * rangen.rand();
         if (y0 < f(x0)) return x0;
       }
       return 0.;
@@ -491,13 +500,13 @@ namespace thermalfist {
       return m_part->ThermalMassDistribution(M, m_T, m_Mu, m_part->ResonanceWidth());
     }
 
-    double ThermalBreitWignerGenerator::GetRandom() const
+    double ThermalBreitWignerGenerator::GetRandom(MTRand& rangen) const
     {
       if (m_part->ResonanceWidth() / m_part->Mass() < 1.e-2)
         return m_part->Mass();
       while (true) {
-        double x0 = m_Xmin + (m_Xmax - m_Xmin) * randgenMT.rand();
-        double y0 = m_Max * randgenMT.rand();
+        double x0 = m_Xmin + (m_Xmax - m_Xmin) * rangen.rand();
+        double y0 = m_Max * rangen.rand();
         if (y0 < f(x0)) return x0;
       }
       return 0.;
@@ -817,13 +826,13 @@ namespace thermalfist {
         return RandomBesselNormal(a, nu, rangen);
     }
 
-    std::vector<double> SiemensRasmussenMomentumGeneratorGeneralized::GetMomentum(double mass) const
+    std::vector<double> SiemensRasmussenMomentumGeneratorGeneralized::GetMomentum(double mass, MTRand& rangen) const
     {
       if (mass < 0.)
         mass = GetMass();
 
-      double ph = 2. * xMath::Pi() * RandomGenerators::randgenMT.rand();
-      double costh = 2. * RandomGenerators::randgenMT.rand() - 1.;
+      double ph = 2. * xMath::Pi() * rangen.rand();
+      double costh = 2. * rangen.rand() - 1.;
       double sinth = sqrt(1. - costh * costh);
 
       double vx = GetBeta() * sinth * cos(ph);
@@ -832,9 +841,9 @@ namespace thermalfist {
 
       SimpleParticle part(0., 0., 0., mass, 0);
 
-      double tp = m_Generator.GetP(mass);
-      double tphi = 2. * xMath::Pi() * RandomGenerators::randgenMT.rand();
-      double cthe = 2. * RandomGenerators::randgenMT.rand() - 1.;
+      double tp = m_Generator.GetP(mass, rangen);
+      double tphi = 2. * xMath::Pi() * rangen.rand();
+      double cthe = 2. * rangen.rand() - 1.;
       double sthe = sqrt(1. - cthe * cthe);
       part.px = tp * cos(tphi) * sthe;
       part.py = tp * sin(tphi) * sthe;
@@ -0,0 +1,607 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGEventGenerator/ResonanceDecaySpectra.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "HRGBase/xMath.h"
+
+using namespace std;
+
+namespace thermalfist {
+
+  namespace {
+    /// Momentum of the decay products in the rest frame of a two-body decay
+    double TwoBodyMomentum(double M, double m1, double m2)
+    {
+      if (M <= m1 + m2)
+        return 0.;
+      return sqrt((M * M - (m1 + m2) * (m1 + m2)) * (M * M - (m1 - m2) * (m1 - m2))) / (2. * M);
+    }
+
+    /// Phase space volume of a decay into particles with the given masses, up to a constant factor
+    double PhaseSpaceVolume(double M, const std::vector<double>& masses, int npoints)
+    {
+      if (masses.size() < 2)
+        return 1.;
+      if (masses.size() == 2)
+        return TwoBodyMomentum(M, masses[0], masses[1]) / M;
+
+      std::vector<double> rest(masses.begin() + 1, masses.end());
+      double Mmin = 0.;
+      for (size_t i = 0; i < rest.size(); ++i)
+        Mmin += rest[i];
+      double Mmax = M - masses[0];
+      if (Mmax <= Mmin)
+        return 0.;
+
+      double dM = (Mmax - Mmin) / npoints;
+      double ret = 0.;
+      for (int i = 0; i < npoints; ++i) {
+        double Mr = Mmin + (i + 0.5) * dM;
+        ret += 2. * Mr * TwoBodyMomentum(M, masses[0], Mr) / M * PhaseSpaceVolume(Mr, rest, npoints) * dM;
+      }
+      return ret;
+    }
+
+    /// Distribution of the daughter momentum in the rest frame of the mother
+    void DaughterMomenta(double M, double md, const std::vector<double>& others, int npoints,
+      std::vector<double>& pstar, std::vector<double>& weights)
+    {
+      pstar.clear();
+      weights.clear();
+
+      if (others.size() == 1) {
+        pstar.push_back(TwoBodyMomentum(M, md, others[0]));
+        weights.push_back(1.);
+        return;
+      }
+
+      // The other decay products are treated as a single system
+      // with the invariant mass distributed according to the phase space
+      double Mmin = 0.;
+      for (size_t i = 0; i < others.size(); ++i)
+        Mmin += others[i];
+      double Mmax = M - md;
+      double dM = (Mmax - Mmin) / npoints;
+      double wsum = 0.;
+      for (int i = 0; i < npoints; ++i) {
+        double Mr = Mmin + (i + 0.5) * dM;
+        double p = TwoBodyMomentum(M, md, Mr);
+        double w = p * 2. * Mr * PhaseSpaceVolume(Mr, others, npoints);
+        pstar.push_back(p);
+        weights.push_back(w);
+        wsum += w;
+      }
+
+      if (wsum > 0.) {
+        for (size_t i = 0; i < weights.size(); ++i)
+          weights[i] /= wsum;
+      }
+    }
+  }
+
+  ResonanceDecaySpectra::ResonanceDecaySpectra(ThermalParticleSystem* TPS, const Grid& grid, const Quadrature& quad) :
+    m_TPS(TPS),
+    m_Grid(grid),
+    m_Quadrature(quad),
+    m_DecaysPrepared(false),
+    m_FeeddownCalculated(false),
+    m_useOpenMP(false)
+  {
+    m_dPt = m_Grid.PtMax / m_Grid.PtBins;
+    m_dY = 2. * m_Grid.YMax / m_Grid.YBins;
+    m_Primordial.resize(m_TPS->ComponentsNumber());
+    m_Total.resize(m_TPS->ComponentsNumber());
+  }
+
+  void ResonanceDecaySpectra::SetPrimordialSpectrum(int id, const MomentumDistributionBase& distr, double yield)
+  {
+    if (id < 0 || id >= m_TPS->ComponentsNumber()) {
+      printf("**WARNING** ResonanceDecaySpectra::SetPrimordialSpectrum: Invalid species index %d\n", id);
+      return;
+    }
+
+    TabulateSpectrum(id, distr, yield);
+    m_FeeddownCalculated = false;
+  }
+
+  void ResonanceDecaySpectra::TabulateSpectrum(int id, const MomentumDistributionBase& distr, double yield)
+  {
+    std::vector<double>& counts = m_Primordial[id];
+    counts.assign(m_Grid.PtBins * m_Grid.YBins, 0.);
+    double total = 0.;
+    for (int ipt = 0; ipt < m_Grid.PtBins; ++ipt) {
+      double pt = (ipt + 0.5) * m_dPt;
+      for (int iy = 0; iy < m_Grid.YBins; ++iy) {
+        double y = -m_Grid.YMax + (iy + 0.5) * m_dY;
+        double val = distr.d2ndptdy(pt, y);
+        // Far tails of some distributions evaluate to NaN due to underflow
+        if (val != val)
+          val = 0.;
+        counts[ipt * m_Grid.YBins + iy] = val;
+        total += val;
+      }
+    }
+
+    // The normalization of d2ndptdy() differs between the distributions,
+    // the tabulated spectrum is normalized to the yield directly
+    if (total <= 0.) {
+      if (yield != 0.)
+        printf("**WARNING** ResonanceDecaySpectra: Momentum distribution of %lld vanishes on the pT/y grid\n", m_TPS->Particles()[id].PdgId());
+      counts.assign(counts.size(), 0.);
+      return;
+    }
+    for (size_t i = 0; i < counts.size(); ++i)
+      counts[i] *= yield / total;
+  }
+
+  void ResonanceDecaySpectra::SetPrimordialSpectra(const std::vector<MomentumDistributionBase*>& distrs, const std::vector<double>& yields)
+  {
+    int NN = min(static_cast<int>(distrs.size()), m_TPS->ComponentsNumber());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int i = 0; i < NN; ++i) {
+      if (distrs[i] != NULL && i < static_cast<int>(yields.size()))
+        TabulateSpectrum(i, *distrs[i], yields[i]);
+    }
+    m_FeeddownCalculated = false;
+  }
+
+  int ResonanceDecaySpectra::KernelIndex(double mass, double dmass, std::vector<double> others)
+  {
+    sort(others.begin(), others.end());
+    std::vector<double> key;
+    key.push_back(mass);
+    key.push_back(dmass);
+    key.insert(key.end(), others.begin(), others.end());
+
+    std::map< std::vector<double>, int >::const_iterator it = m_KernelMap.find(key);
+    if (it != m_KernelMap.end())
+      return it->second;
+
+    DecayKernel kernel;
+    kernel.MotherMass = mass;
+    kernel.DaughterMass = dmass;
+    kernel.OtherMasses = others;
+    m_Kernels.push_back(kernel);
+    m_KernelMap[key] = static_cast<int>(m_Kernels.size()) - 1;
+    return static_cast<int>(m_Kernels.size()) - 1;
+  }
+
+  void ResonanceDecaySpectra::CalculateKernel(DecayKernel& kernel) const
+  {
+    const int nPt = m_Grid.PtBins;
+    const int nY = m_Grid.YBins;
+    // Rapidity shifts beyond the grid size never end up in the grid
+    const int nShift = 2 * nY + 1;
+    const int shiftOffset = nY;
+
+    std::vector<double> pstar, pweights;
+    DaughterMomenta(kernel.MotherMass, kernel.DaughterMass, kernel.OtherMasses, m_Quadrature.MassPoints, pstar, pweights);
+
+    const int nCos = m_Quadrature.CosThetaPoints;
+    const int nPhi = m_Quadrature.PhiPoints;
+    const double angleWeight = 1. / nCos / nPhi;
+    const double M = kernel.MotherMass;
+    const double md = kernel.DaughterMass;
+
+    kernel.PtMin.resize(nPt);
+    kernel.PtMax.resize(nPt);
+    kernel.ShiftMin.resize(nPt);
+    kernel.ShiftMax.resize(nPt);
+    kernel.Weights.resize(nPt);
+
+    // Tables of the decay angles, phi in [0, pi] is sufficient by symmetry
+    std::vector<double> cths(nCos), sths(nCos), cphis(nPhi), sphis(nPhi);
+    for (int ic = 0; ic < nCos; ++ic) {
+      cths[ic] = -1. + (ic + 0.5) * 2. / nCos;
+      sths[ic] = sqrt(1. - cths[ic] * cths[ic]);
+    }
+    for (int iphi = 0; iphi < nPhi; ++iphi) {
+      double phi = (iphi + 0.5) * xMath::Pi() / nPhi;
+      cphis[iphi] = cos(phi);
+      sphis[iphi] = sin(phi);
+    }
+
+    std::vector<double> tmp(nPt * nShift, 0.);
+    for (int i = 0; i < nPt; ++i) {
+      int jmin = nPt, jmax = -1, smin = nShift, smax = -1;
+
+      // Mother at the bin center moving along the x axis at zero rapidity
+      double pTR = (i + 0.5) * m_dPt;
+      double gamma = sqrt(M * M + pTR * pTR) / M;
+      double betagamma = pTR / M;
+
+      for (size_t ip = 0; ip < pstar.size(); ++ip) {
+        if (pweights[ip] == 0.)
+          continue;
+        double p = pstar[ip];
+        double Ed = sqrt(p * p + md * md);
+        // Backward emission gives the opposite rapidity shift, only cos(theta) >= 0 is evaluated
+        for (int ic = nCos / 2; ic < nCos; ++ic) {
+          double pz = p * cths[ic];
+          double pts = p * sths[ic];
+          int nmirror = (cths[ic] > 0.) ? 2 : 1;
+          for (int iphi = 0; iphi < nPhi; ++iphi) {
+            double pxs = pts * cphis[iphi];
+            double py = pts * sphis[iphi];
+            double px = gamma * pxs + betagamma * Ed;
+            double E = gamma * Ed + betagamma * pxs;
+            double pt = sqrt(px * px + py * py);
+            double y = 0.5 * log((E + pz) / (E - pz));
+            double w = pweights[ip] * angleWeight;
+
+            // Linear sharing between the two nearest bin centers in pT and in rapidity shift
+            double u = pt / m_dPt - 0.5;
+            int j0 = static_cast<int>(floor(u));
+            double fu = u - j0;
+            if (j0 < 0) {
+              j0 = 0;
+              fu = 0.;
+            }
+
+            for (int im = 0; im < nmirror; ++im) {
+              double v = (im == 0 ? y : -y) / m_dY;
+              int s0 = static_cast<int>(floor(v));
+              double fv = v - s0;
+              s0 += shiftOffset;
+
+              for (int dj = 0; dj < 2; ++dj) {
+                int j = j0 + dj;
+                double wj = (dj == 0) ? 1. - fu : fu;
+                if (j >= nPt || wj == 0.)
+                  continue;
+                for (int ds = 0; ds < 2; ++ds) {
+                  int s = s0 + ds;
+                  double ws = (ds == 0) ? 1. - fv : fv;
+                  if (s < 0 || s >= nShift || ws == 0.)
+                    continue;
+                  tmp[j * nShift + s] += w * wj * ws;
+                  jmin = min(jmin, j);
+                  jmax = max(jmax, j);
+                  smin = min(smin, s);
+                  smax = max(smax, s);
+                }
+              }
+            }
+          }
+        }
+      }
+
+      // Keep only the bounding box of the non-zero entries
+      std::vector<double>& weights = kernel.Weights[i];
+      if (jmax < 0) {
+        kernel.PtMin[i] = 0;
+        kernel.PtMax[i] = -1;
+        kernel.ShiftMin[i] = 0;
+        kernel.ShiftMax[i] = -1;
+        weights.clear();
+        continue;
+      }
+      kernel.PtMin[i] = jmin;
+      kernel.PtMax[i] = jmax;
+      kernel.ShiftMin[i] = smin - shiftOffset;
+      kernel.ShiftMax[i] = smax - shiftOffset;
+      int ns = smax - smin + 1;
+      weights.resize((jmax - jmin + 1) * ns);
+      for (int j = jmin; j <= jmax; ++j) {
+        for (int s = smin; s <= smax; ++s) {
+          weights[(j - jmin) * ns + (s - smin)] = tmp[j * nShift + s];
+          tmp[j * nShift + s] = 0.;
+        }
+      }
+    }
+
+    kernel.Calculated = true;
+  }
+
+  std::vector<int> ResonanceDecaySpectra::DecayOrder() const
+  {
+    int NN = m_TPS->ComponentsNumber();
+
+    // Unstable species, from the heaviest one
+    std::vector< std::pair<double, int> > unstable;
+    std::vector<int> isMother(NN, 0);
+    for (int i = 0; i < NN; ++i) {
+      if (!m_TPS->Particles()[i].IsStable() && m_TPS->Particles()[i].Decays().size() > 0) {
+        unstable.push_back(std::make_pair(-m_TPS->Particles()[i].Mass(), i));
+        isMother[i] = 1;
+      }
+    }
+    stable_sort(unstable.begin(), unstable.end());
+
+    // Number of distinct unstable mothers of each species
+    std::vector< std::vector<int> > daughters(NN);
+    std::vector<int> nmothers(NN, 0);
+    for (size_t iu = 0; iu < unstable.size(); ++iu) {
+      int im = unstable[iu].second;
+      const ThermalParticle& mother = m_TPS->Particles()[im];
+      for (size_t idec = 0; idec < mother.Decays().size(); ++idec) {
+        const ParticleDecayChannel& decay = mother.Decays()[idec];
+        if (decay.mBratio <= 0.)
+          continue;
+        for (size_t di = 0; di < decay.mDaughters.size(); ++di) {
+          int tid = m_TPS->PdgToId(decay.mDaughters[di]);
+          if (tid != -1 && isMother[tid] && find(daughters[im].begin(), daughters[im].end(), tid) == daughters[im].end()) {
+            daughters[im].push_back(tid);
+            nmothers[tid]++;
+          }
+        }
+      }
+    }
+
+    // Topological order of the decay chains: a species decays only after all its mothers did,
+    // the species available at each step are taken from the heaviest one
+    std::vector<int> ret;
+    std::vector<int> done(NN, 0);
+    while (ret.size() < unstable.size()) {
+      size_t before = ret.size();
+      for (size_t iu = 0; iu < unstable.size(); ++iu) {
+        int im = unstable[iu].second;
+        if (done[im] || nmothers[im] > 0)
+          continue;
+        done[im] = 1;
+        ret.push_back(im);
+        for (size_t id = 0; id < daughters[im].size(); ++id)
+          nmothers[daughters[im][id]]--;
+        break;
+      }
+
+      // A cycle in the decay chains, the remaining species are taken from the heaviest one
+      if (ret.size() == before) {
+        printf("**WARNING** ResonanceDecaySpectra: Cyclic decay chains in the particle list, the feeddown is incomplete\n");
+        for (size_t iu = 0; iu < unstable.size(); ++iu) {
+          int im = unstable[iu].second;
+          if (!done[im]) {
+            done[im] = 1;
+            ret.push_back(im);
+          }
+        }
+      }
+    }
+
+    return ret;
+  }
+
+  void ResonanceDecaySpectra::PrepareDecays()
+  {
+    std::vector<int> order = DecayOrder();
+
+    m_Decays.clear();
+    for (size_t io = 0; io < order.size(); ++io) {
+      int im = order[io];
+      const ThermalParticle& mother = m_TPS->Particles()[im];
+      std::vector<DecayContribution> contribs;
+      for (size_t idec = 0; idec < mother.Decays().size(); ++idec) {
+        const ParticleDecayChannel& decay = mother.Decays()[idec];
+        if (decay.mBratio <= 0.)
+          continue;
+
+        // Masses of all decay products, photons and leptons included
+        std::vector<double> masses;
+        std::vector<int> ids;
+        for (size_t di = 0; di < decay.mDaughters.size(); ++di) {
+          long long dpdg = decay.mDaughters[di];
+          int tid = m_TPS->PdgToId(dpdg);
+          if (tid != -1) {
+            masses.push_back(m_TPS->Particles()[tid].Mass());
+          }
+          else if (ExtraParticles::PdgToId(dpdg) != -1) {
+            masses.push_back(ExtraParticles::ParticleByPdg(dpdg).Mass());
+          }
+          else
+            continue;
+          ids.push_back(tid);
+        }
+
+        if (masses.size() == 0)
+          continue;
+
+        // Same conventions as in ParticleDecaysMC::ManyBodyDecay():
+        // a single listed daughter means a radiative decay,
+        // and a mother below the threshold decays at the threshold
+        if (masses.size() == 1) {
+          masses.push_back(0.);
+          ids.push_back(-1);
+        }
+
+        double msum = 0.;
+        for (size_t di = 0; di < masses.size(); ++di)
+          msum += masses[di];
+        double mass = max(mother.Mass(), msum + 1.e-7);
+
+        for (size_t di = 0; di < ids.size(); ++di) {
+          if (ids[di] == -1)
+            continue;
+          std::vector<double> others;
+          for (size_t dj = 0; dj < masses.size(); ++dj)
+            if (dj != di)
+              others.push_back(masses[dj]);
+
+          DecayContribution contrib;
+          contrib.Mother = im;
+          contrib.Daughter = ids[di];
+          contrib.Kernel = KernelIndex(mass, masses[di], others);
+          contrib.Weight = decay.mBratio;
+          contribs.push_back(contrib);
+        }
+      }
+
+      // Grouped by the daughter, each daughter is then updated by a single thread
+      for (size_t i = 1; i < contribs.size(); ++i)
+        for (size_t j = i; j > 0 && contribs[j - 1].Daughter > contribs[j].Daughter; --j)
+          std::swap(contribs[j - 1], contribs[j]);
+
+      if (contribs.size() > 0)
+        m_Decays.push_back(contribs);
+    }
+
+    int nKernels = static_cast<int>(m_Kernels.size());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP)
+#endif
+    for (int ik = 0; ik < nKernels; ++ik) {
+      if (!m_Kernels[ik].Calculated)
+        CalculateKernel(m_Kernels[ik]);
+    }
+
+    m_DecaysPrepared = true;
+  }
+
+  void ResonanceDecaySpectra::CalculateFeeddown()
+  {
+    if (!m_DecaysPrepared)
+      PrepareDecays();
+
+    const int nPt = m_Grid.PtBins;
+    const int nY = m_Grid.YBins;
+
+    m_Total = m_Primordial;
+
+    // Decay products which fall outside the grid
+    double produced = 0., lost = 0.;
+
+    for (size_t im = 0; im < m_Decays.size(); ++im) {
+      const std::vector<DecayContribution>& contribs = m_Decays[im];
+      const std::vector<double>& mcounts = m_Total[contribs[0].Mother];
+      if (mcounts.size() == 0)
+        continue;
+
+      std::vector<int> groups;
+      for (size_t ic = 0; ic < contribs.size(); ++ic)
+        if (ic == 0 || contribs[ic].Daughter != contribs[ic - 1].Daughter)
+          groups.push_back(static_cast<int>(ic));
+      groups.push_back(static_cast<int>(contribs.size()));
+
+      int ngroups = static_cast<int>(groups.size()) - 1;
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(m_useOpenMP) reduction(+:produced,lost)
+#endif
+      for (int ig = 0; ig < ngroups; ++ig) {
+        std::vector<double>& dcounts = m_Total[contribs[groups[ig]].Daughter];
+        if (dcounts.size() == 0)
+          dcounts.assign(nPt * nY, 0.);
+        double before = 0., expected = 0.;
+        for (size_t i = 0; i < dcounts.size(); ++i)
+          before += dcounts[i];
+
+        for (int ic = groups[ig]; ic < groups[ig + 1]; ++ic) {
+          const DecayKernel& kernel = m_Kernels[contribs[ic].Kernel];
+          double W = contribs[ic].Weight;
+          for (int i = 0; i < nPt; ++i) {
+            if (kernel.PtMax[i] < kernel.PtMin[i])
+              continue;
+            const std::vector<double>& weights = kernel.Weights[i];
+            int jmin = kernel.PtMin[i], jmax = kernel.PtMax[i];
+            int smin = kernel.ShiftMin[i], smax = kernel.ShiftMax[i];
+            int ns = smax - smin + 1;
+            for (int iy = 0; iy < nY; ++iy) {
+              double a = W * mcounts[i * nY + iy];
+              if (a == 0.)
+                continue;
+              expected += a;
+              int s1 = max(smin, -iy);
+              int s2 = min(smax, nY - 1 - iy);
+              for (int j = jmin; j <= jmax; ++j) {
+                const double* krow = &weights[(j - jmin) * ns];
+                double* drow = &dcounts[j * nY + iy];
+                for (int s = s1; s <= s2; ++s)
+                  drow[s] += a * krow[s - smin];
+              }
+            }
+          }
+        }
+
+        double after = 0.;
+        for (size_t i = 0; i < dcounts.size(); ++i)
+          after += dcounts[i];
+        produced += expected;
+        lost += max(0., expected - (after - before));
+      }
+    }
+
+    if (produced > 0. && lost > 1.e-3 * produced)
+      printf("**WARNING** ResonanceDecaySpectra::CalculateFeeddown: %.2lf%% of the decay products fall outside the pT/y grid\n", 100. * lost / produced);
+
+    m_FeeddownCalculated = true;
+  }
+
+  double ResonanceDecaySpectra::d2ndptdy(int id, int ipt, int iy, bool feeddown) const
+  {
+    const std::vector<double>& counts = feeddown ? m_Total[id] : m_Primordial[id];
+    if (counts.size() == 0 || ipt < 0 || ipt >= m_Grid.PtBins || iy < 0 || iy >= m_Grid.YBins)
+      return 0.;
+    return counts[ipt * m_Grid.YBins + iy] / m_dPt / m_dY;
+  }
+
+  std::vector<double> ResonanceDecaySpectra::dndpt(int id, bool feeddown) const
+  {
+    return dndpt(id, -m_Grid.YMax, m_Grid.YMax, feeddown);
+  }
+
+  std::vector<double> ResonanceDecaySpectra::dndpt(int id, double ymin, double ymax, bool feeddown) const
+  {
+    std::vector<double> ret(m_Grid.PtBins, 0.);
+    const std::vector<double>& counts = feeddown ? m_Total[id] : m_Primordial[id];
+    if (counts.size() == 0)
+      return ret;
+    for (int ipt = 0; ipt < m_Grid.PtBins; ++ipt) {
+      for (int iy = 0; iy < m_Grid.YBins; ++iy) {
+        double y = -m_Grid.YMax + (iy + 0.5) * m_dY;
+        if (y >= ymin && y <= ymax)
+          ret[ipt] += counts[ipt * m_Grid.YBins + iy];
+      }
+      ret[ipt] /= m_dPt;
+    }
+    return ret;
+  }
+
+  std::vector<double> ResonanceDecaySpectra::dndy(int id, bool feeddown) const
+  {
+    std::vector<double> ret(m_Grid.YBins, 0.);
+    const std::vector<double>& counts = feeddown ? m_Total[id] : m_Primordial[id];
+    if (counts.size() == 0)
+      return ret;
+    for (int ipt = 0; ipt < m_Grid.PtBins; ++ipt)
+      for (int iy = 0; iy < m_Grid.YBins; ++iy)
+        ret[iy] += counts[ipt * m_Grid.YBins + iy];
+    for (int iy = 0; iy < m_Grid.YBins; ++iy)
+      ret[iy] /= m_dY;
+    return ret;
+  }
+
+  double ResonanceDecaySpectra::Yield(int id, bool feeddown) const
+  {
+    const std::vector<double>& counts = feeddown ? m_Total[id] : m_Primordial[id];
+    double ret = 0.;
+    for (size_t i = 0; i < counts.size(); ++i)
+      ret += counts[i];
+    return ret;
+  }
+
+  std::vector<double> ResonanceDecaySpectra::PtValues() const
+  {
+    std::vector<double> ret(m_Grid.PtBins);
+    for (int ipt = 0; ipt < m_Grid.PtBins; ++ipt)
+      ret[ipt] = (ipt + 0.5) * m_dPt;
+    return ret;
+  }
+
+  std::vector<double> ResonanceDecaySpectra::YValues() const
+  {
+    std::vector<double> ret(m_Grid.YBins);
+    for (int iy = 0; iy < m_Grid.YBins; ++iy)
+      ret[iy] = -m_Grid.YMax + (iy + 0.5) * m_dY;
+    return ret;
+  }
+
+} // namespace thermalfist
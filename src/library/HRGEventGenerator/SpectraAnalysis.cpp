@@ -0,0 +1,395 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGEventGenerator/SpectraAnalysis.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+namespace thermalfist {
+
+  SpectraHistogram1D::SpectraHistogram1D(double xmin, double xmax, int bins) :
+    m_XMin(xmin), m_Bins(bins)
+  {
+    if (m_Bins < 1)
+      m_Bins = 1;
+    if (xmax < xmin)
+      printf("**WARNING** SpectraHistogram1D: Right limit is less than left!\n");
+    m_Step = (xmax - xmin) / m_Bins;
+    m_Sum.resize(m_Bins);
+    m_Sum2.resize(m_Bins);
+    m_EventCounts.resize(m_Bins);
+    Reset();
+  }
+
+  int SpectraHistogram1D::Bin(double x) const
+  {
+    double ind = floor((x - m_XMin) / m_Step);
+    if (ind >= 0. && ind < m_Bins)
+      return static_cast<int>(ind);
+    return -1;
+  }
+
+  void SpectraHistogram1D::FillBin(int ind)
+  {
+    if (ind < 0)
+      return;
+    if (m_EventCounts[ind] == 0)
+      m_EventBins.push_back(ind);
+    m_EventCounts[ind]++;
+  }
+
+  void SpectraHistogram1D::FinishEvent(double weight)
+  {
+    // Bins not filled in this event only contribute to the weight sums
+    for (size_t i = 0; i < m_EventBins.size(); ++i) {
+      int ind = m_EventBins[i];
+      double cnt = static_cast<double>(m_EventCounts[ind]);
+      m_Sum[ind] += weight * cnt;
+      m_Sum2[ind] += weight * cnt * cnt;
+      m_EventCounts[ind] = 0;
+    }
+    m_EventBins.clear();
+
+    m_WeightSum += weight;
+    m_Weight2Sum += weight * weight;
+    m_Events++;
+  }
+
+  void SpectraHistogram1D::Merge(const SpectraHistogram1D& other)
+  {
+    if (!SameBinning(other)) {
+      printf("**WARNING** SpectraHistogram1D::Merge: Incompatible binning, skipping!\n");
+      return;
+    }
+
+    for (int i = 0; i < m_Bins; ++i) {
+      m_Sum[i] += other.m_Sum[i];
+      m_Sum2[i] += other.m_Sum2[i];
+    }
+    m_WeightSum += other.m_WeightSum;
+    m_Weight2Sum += other.m_Weight2Sum;
+    m_Events += other.m_Events;
+  }
+
+  bool SpectraHistogram1D::SameBinning(const SpectraHistogram1D& other) const
+  {
+    return other.m_Bins == m_Bins && other.m_XMin == m_XMin && other.m_Step == m_Step;
+  }
+
+  void SpectraHistogram1D::Reset()
+  {
+    for (int i = 0; i < m_Bins; ++i) {
+      m_Sum[i] = m_Sum2[i] = 0.;
+      m_EventCounts[i] = 0;
+    }
+    m_EventBins.clear();
+    m_WeightSum = m_Weight2Sum = 0.;
+    m_Events = 0;
+  }
+
+  double SpectraHistogram1D::Entry(int ind) const
+  {
+    if (ind < 0 || ind >= m_Bins || m_WeightSum <= 0.)
+      return 0.;
+    return m_Sum[ind] / m_WeightSum / m_Step;
+  }
+
+  double SpectraHistogram1D::EntryError(int ind) const
+  {
+    if (ind < 0 || ind >= m_Bins || m_WeightSum <= 0.)
+      return 0.;
+    double av = m_Sum[ind] / m_WeightSum;
+    double neff = m_WeightSum * m_WeightSum / m_Weight2Sum;
+    if (neff <= 1.)
+      return 0.;
+    double var = m_Sum2[ind] / m_WeightSum - av * av;
+    if (var < 0.)
+      var = 0.;
+    return sqrt(var / (neff - 1.)) / m_Step;
+  }
+
+  std::vector<double> SpectraHistogram1D::GetXVector() const
+  {
+    std::vector<double> ret(m_Bins);
+    for (int i = 0; i < m_Bins; ++i)
+      ret[i] = BinCenter(i);
+    return ret;
+  }
+
+  std::vector<double> SpectraHistogram1D::GetYVector() const
+  {
+    std::vector<double> ret(m_Bins);
+    for (int i = 0; i < m_Bins; ++i)
+      ret[i] = Entry(i);
+    return ret;
+  }
+
+  std::vector<double> SpectraHistogram1D::GetYErrorVector() const
+  {
+    std::vector<double> ret(m_Bins);
+    for (int i = 0; i < m_Bins; ++i)
+      ret[i] = EntryError(i);
+    return ret;
+  }
+
+  SpectraHistogram2D::SpectraHistogram2D(double xmin, double xmax, int binsx, double ymin, double ymax, int binsy) :
+    m_Flat(0., static_cast<double>((binsx < 1 ? 1 : binsx) * (binsy < 1 ? 1 : binsy)), (binsx < 1 ? 1 : binsx) * (binsy < 1 ? 1 : binsy)),
+    m_XMin(xmin), m_YMin(ymin),
+    m_BinsX(binsx < 1 ? 1 : binsx), m_BinsY(binsy < 1 ? 1 : binsy)
+  {
+    if (xmax < xmin || ymax < ymin)
+      printf("**WARNING** SpectraHistogram2D: Right limit is less than left!\n");
+    m_StepX = (xmax - xmin) / m_BinsX;
+    m_StepY = (ymax - ymin) / m_BinsY;
+  }
+
+  void SpectraHistogram2D::Fill(double x, double y)
+  {
+    double indx = floor((x - m_XMin) / m_StepX);
+    double indy = floor((y - m_YMin) / m_StepY);
+    if (indx >= 0. && indx < m_BinsX && indy >= 0. && indy < m_BinsY)
+      m_Flat.FillBin(static_cast<int>(indx) * m_BinsY + static_cast<int>(indy));
+  }
+
+  void SpectraHistogram2D::Merge(const SpectraHistogram2D& other)
+  {
+    if (!SameBinning(other)) {
+      printf("**WARNING** SpectraHistogram2D::Merge: Incompatible binning, skipping!\n");
+      return;
+    }
+    m_Flat.Merge(other.m_Flat);
+  }
+
+  bool SpectraHistogram2D::SameBinning(const SpectraHistogram2D& other) const
+  {
+    return other.m_BinsX == m_BinsX && other.m_XMin == m_XMin && other.m_StepX == m_StepX
+      && other.m_BinsY == m_BinsY && other.m_YMin == m_YMin && other.m_StepY == m_StepY;
+  }
+
+  std::vector<double> SpectraHistogram2D::GetXCenterVector() const
+  {
+    std::vector<double> ret(Bins());
+    for (int i = 0; i < Bins(); ++i)
+      ret[i] = m_XMin + (i / m_BinsY + 0.5) * m_StepX;
+    return ret;
+  }
+
+  std::vector<double> SpectraHistogram2D::GetYCenterVector() const
+  {
+    std::vector<double> ret(Bins());
+    for (int i = 0; i < Bins(); ++i)
+      ret[i] = m_YMin + (i % m_BinsY + 0.5) * m_StepY;
+    return ret;
+  }
+
+  std::vector<double> SpectraHistogram2D::GetZVector() const
+  {
+    std::vector<double> ret(Bins());
+    for (int i = 0; i < Bins(); ++i)
+      ret[i] = Entry(i);
+    return ret;
+  }
+
+  std::vector<double> SpectraHistogram2D::GetZErrorVector() const
+  {
+    std::vector<double> ret(Bins());
+    for (int i = 0; i < Bins(); ++i)
+      ret[i] = EntryError(i);
+    return ret;
+  }
+
+  SpectraAnalysis::Species::Species(long long pdgid, double mass, const Binning& binning) :
+    PdgId(pdgid), Mass(mass),
+    dndp(0., binning.PMax + mass, binning.Bins),
+    dndy(-binning.YMax, binning.YMax, binning.Bins),
+    dndmt(mass, mass + binning.MtMax, binning.Bins),
+    dndpt(0., binning.PtMax + mass, binning.Bins),
+    d2ndptdy(-binning.YMax, binning.YMax, binning.Bins2D, 0., binning.Pt2DMax, binning.Bins2D),
+    PtSum(0.), Pt2Sum(0.),
+    EventCount(0), EventPtSum(0.), EventPt2Sum(0.)
+  {
+    for (int k = 0; k < 4; ++k)
+      Moments[k] = 0.;
+  }
+
+  SpectraAnalysis::SpectraAnalysis(const ThermalParticleSystem* TPS, const Binning& binning, bool onlyStable) :
+    m_WeightSum(0.), m_Events(0)
+  {
+    std::map<long long, int> pdgToSlot;
+    for (int i = 0; i < TPS->ComponentsNumber(); ++i) {
+      const ThermalParticle& part = TPS->Particles()[i];
+      if (onlyStable && !part.IsStable())
+        continue;
+      pdgToSlot[part.PdgId()] = static_cast<int>(m_Species.size());
+      m_Species.push_back(Species(part.PdgId(), part.Mass(), binning));
+    }
+
+    // The map iterates in ascending order of the PDG codes
+    for (std::map<long long, int>::const_iterator it = pdgToSlot.begin(); it != pdgToSlot.end(); ++it) {
+      m_SortedPdgs.push_back(it->first);
+      m_SortedSlots.push_back(it->second);
+    }
+  }
+
+  int SpectraAnalysis::SpeciesIndex(long long pdgid) const
+  {
+    std::vector<long long>::const_iterator it = std::lower_bound(m_SortedPdgs.begin(), m_SortedPdgs.end(), pdgid);
+    if (it == m_SortedPdgs.end() || *it != pdgid)
+      return -1;
+    return m_SortedSlots[it - m_SortedPdgs.begin()];
+  }
+
+  void SpectraAnalysis::FillParticle(long long pdgid, double px, double py, double pz, double m)
+  {
+    int ind = SpeciesIndex(pdgid);
+    if (ind == -1)
+      return;
+
+    SimpleParticle part(px, py, pz, m, pdgid);
+    Species& spec = m_Species[ind];
+    double pt = part.GetPt();
+    double y = part.GetY();
+    spec.dndp.Fill(part.GetP());
+    spec.dndy.Fill(y);
+    spec.dndmt.Fill(part.GetMt());
+    spec.dndpt.Fill(pt);
+    spec.d2ndptdy.Fill(y, pt);
+    spec.EventCount++;
+    spec.EventPtSum += pt;
+    spec.EventPt2Sum += pt * pt;
+  }
+
+  void SpectraAnalysis::FinishEvent(double weight)
+  {
+    for (size_t ind = 0; ind < m_Species.size(); ++ind) {
+      Species& spec = m_Species[ind];
+      spec.dndp.FinishEvent(weight);
+      spec.dndy.FinishEvent(weight);
+      spec.dndmt.FinishEvent(weight);
+      spec.dndpt.FinishEvent(weight);
+      spec.d2ndptdy.FinishEvent(weight);
+
+      double n = static_cast<double>(spec.EventCount);
+      double nk = weight;
+      for (int k = 0; k < 4; ++k) {
+        nk *= n;
+        spec.Moments[k] += nk;
+      }
+      spec.PtSum += weight * spec.EventPtSum;
+      spec.Pt2Sum += weight * spec.EventPt2Sum;
+      spec.EventCount = 0;
+      spec.EventPtSum = spec.EventPt2Sum = 0.;
+    }
+
+    m_WeightSum += weight;
+    m_Events++;
+  }
+
+  void SpectraAnalysis::ProcessEvent(const SimpleEvent& evt)
+  {
+    for (size_t i = 0; i < evt.Particles.size(); ++i) {
+      const SimpleParticle& part = evt.Particles[i];
+      FillParticle(part.PDGID, part.px, part.py, part.pz, part.m);
+    }
+    FinishEvent(evt.weight);
+  }
+
+  void SpectraAnalysis::ProcessChunk(const EventChunk& chunk)
+  {
+    const EventChunk::Particles& parts = chunk.FinalParticles();
+    for (int k = 0; k < chunk.NumberOfEvents(); ++k) {
+      for (size_t i = chunk.EventOffset(k); i < chunk.EventOffset(k + 1); ++i)
+        FillParticle(parts.PDGID[i], parts.px[i], parts.py[i], parts.pz[i], parts.m[i]);
+      FinishEvent(chunk.Weight(k));
+    }
+  }
+
+  void SpectraAnalysis::Merge(const SpectraAnalysis& other)
+  {
+    // Check everything first, a partial merge would leave the results inconsistent
+    bool compatible = (other.m_Species.size() == m_Species.size());
+    for (size_t ind = 0; compatible && ind < m_Species.size(); ++ind) {
+      const Species& spec = m_Species[ind];
+      const Species& ospec = other.m_Species[ind];
+      compatible = ospec.PdgId == spec.PdgId
+        && ospec.dndp.SameBinning(spec.dndp)
+        && ospec.dndy.SameBinning(spec.dndy)
+        && ospec.dndmt.SameBinning(spec.dndmt)
+        && ospec.dndpt.SameBinning(spec.dndpt)
+        && ospec.d2ndptdy.SameBinning(spec.d2ndptdy);
+    }
+    if (!compatible) {
+      printf("**WARNING** SpectraAnalysis::Merge: Incompatible particle lists or binning, skipping!\n");
+      return;
+    }
+
+    for (size_t ind = 0; ind < m_Species.size(); ++ind) {
+      Species& spec = m_Species[ind];
+      const Species& ospec = other.m_Species[ind];
+      spec.dndp.Merge(ospec.dndp);
+      spec.dndy.Merge(ospec.dndy);
+      spec.dndmt.Merge(ospec.dndmt);
+      spec.dndpt.Merge(ospec.dndpt);
+      spec.d2ndptdy.Merge(ospec.d2ndptdy);
+      for (int k = 0; k < 4; ++k)
+        spec.Moments[k] += ospec.Moments[k];
+      spec.PtSum += ospec.PtSum;
+      spec.Pt2Sum += ospec.Pt2Sum;
+    }
+
+    m_WeightSum += other.m_WeightSum;
+    m_Events += other.m_Events;
+  }
+
+  void SpectraAnalysis::Reset()
+  {
+    for (size_t ind = 0; ind < m_Species.size(); ++ind) {
+      Species& spec = m_Species[ind];
+      spec.dndp.Reset();
+      spec.dndy.Reset();
+      spec.dndmt.Reset();
+      spec.dndpt.Reset();
+      spec.d2ndptdy.Reset();
+      for (int k = 0; k < 4; ++k)
+        spec.Moments[k] = 0.;
+      spec.PtSum = spec.Pt2Sum = 0.;
+      spec.EventCount = 0;
+      spec.EventPtSum = spec.EventPt2Sum = 0.;
+    }
+    m_WeightSum = 0.;
+    m_Events = 0;
+  }
+
+  double SpectraAnalysis::MeanMultiplicity(int ind) const
+  {
+    if (m_WeightSum <= 0.)
+      return 0.;
+    return m_Species[ind].Moments[0] / m_WeightSum;
+  }
+
+  double SpectraAnalysis::ScaledVariance(int ind) const
+  {
+    double mean = MeanMultiplicity(ind);
+    if (mean <= 0.)
+      return 1.;
+    double mean2 = m_Species[ind].Moments[1] / m_WeightSum;
+    return (mean2 - mean * mean) / mean;
+  }
+
+  double SpectraAnalysis::MeanPt(int ind) const
+  {
+    if (m_Species[ind].Moments[0] <= 0.)
+      return 0.;
+    return m_Species[ind].PtSum / m_Species[ind].Moments[0];
+  }
+
+} // namespace thermalfist
@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGFit/ThermalModelFit.h"
+#include "HRGBase/Profiling.h"
 
 #include <fstream>
 #include <cstdio>
@@ -17,6 +18,7 @@
 
 #ifdef USE_MINUIT
 #include "Minuit2/FCNBase.h"
+#include "Minuit2/FCNGradientBase.h"
 #include "Minuit2/FunctionMinimum.h"
 #include "Minuit2/MnMigrad.h"
 #include "Minuit2/MnMinos.h"
@@ -26,6 +28,8 @@
 //#include "Minuit2/SimplexMinimizer.h"
 #endif
 
+#include <Eigen/Dense>
+
 #include "HRGBase/ThermalModelBase.h"
 #include "HRGBase/Utility.h"
 #include "HRGPCE/ThermalModelPCE.h"
@@ -49,6 +53,7 @@ namespace thermalfist {
 
       double operator()(const std::vector<double>& par) const {
         m_THMFit->Increment();
+        THERMALFIST_PROFILE_COUNT(FitChi2Evaluations, 1);
         double chi2 = 0.;
         if (par[2]<0.) return 1e12;
         if (par[3]<0.) return 1e12;
@@ -207,13 +212,178 @@ namespace thermalfist {
       int    m_iter;
       bool   m_verbose;
     };
+
+    // Names of the fit parameters, in the order used by FitFCN
+    const std::string FitParameterNames[ThermalModelFitParameters::ParameterCount] = 
+    { "T", "muB", "gammaS", "R", "Rc", "gammaq", "muQ", "muS", "muC", "gammaC", "Tkin" };
+
+    // Thermal parameters corresponding to the fit parameters, -1 if not a thermal parameter
+    const int FitThermalParameters[ThermalModelFitParameters::ParameterCount] =
+    { ThermalParameter::Temperature, ThermalParameter::BaryonChemicalPotential, ThermalParameter::GammaS, -1, -1,
+      ThermalParameter::Gammaq, ThermalParameter::ElectricChemicalPotential, ThermalParameter::StrangenessChemicalPotential,
+      ThermalParameter::CharmChemicalPotential, ThermalParameter::GammaC, -1 };
+
+    /// Same as FitFCN but also provides MINUIT with the analytic gradient of the chi2 function,
+    /// based on the derivatives of the densities computed by ThermalModelBase::CalculateDensitiesDerivatives()
+    class FitFCNGradient : public FCNGradientBase {
+
+    public:
+
+      FitFCNGradient(ThermalModelFit *thmfit_, bool verbose_ = true) : m_THMFit(thmfit_), m_FCN(thmfit_, verbose_), m_LastChi2(0.) {
+      }
+
+      ~FitFCNGradient() {}
+
+      double operator()(const std::vector<double>& par) const {
+        m_LastParameters = par;
+        return m_LastChi2 = m_FCN(par);
+      }
+
+      std::vector<double> Gradient(const std::vector<double>& par) const {
+        if (par != m_LastParameters)
+          (*this)(par);
+
+        ThermalModelBase *model = m_THMFit->model();
+
+        std::vector<ThermalParameter::Name> tpars;
+        for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+          if (IsFitted(k) && FitThermalParameters[k] != -1)
+            tpars.push_back(static_cast<ThermalParameter::Name>(FitThermalParameters[k]));
+        }
+
+        if (m_LastChi2 >= 1.e12 || m_THMFit->UseTkin() || !model->CalculateDensitiesDerivatives(tpars))
+          return NumericalGradient(par);
+
+        std::vector<double> ret(par.size(), 0.);
+
+        for (size_t i = 0; i < m_THMFit->FittedQuantities().size(); ++i) {
+          const FittedQuantity &quantity = m_THMFit->FittedQuantities()[i];
+          if (!quantity.toFit)
+            continue;
+
+          if (quantity.type == FittedQuantity::Ratio) {
+            const ExperimentRatio &ratio = quantity.ratio;
+            double dens1 = model->GetDensity(ratio.fPDGID1, ratio.fFeedDown1);
+            double dens2 = model->GetDensity(ratio.fPDGID2, ratio.fFeedDown2);
+            double ModelRatio = dens1 / dens2;
+            double dchi2 = 2. * (ModelRatio - ratio.fValue) / ratio.fError / ratio.fError;
+            for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+              if (!IsFitted(k) || FitThermalParameters[k] == -1)
+                continue;
+              ThermalParameter::Name tpar = static_cast<ThermalParameter::Name>(FitThermalParameters[k]);
+              double ddens1 = model->GetDensityDerivative(ratio.fPDGID1, ratio.fFeedDown1, tpar);
+              double ddens2 = model->GetDensityDerivative(ratio.fPDGID2, ratio.fFeedDown2, tpar);
+              ret[k] += dchi2 * (ddens1 * dens2 - dens1 * ddens2) / dens2 / dens2;
+            }
+          }
+          else {
+            const ExperimentMultiplicity &multiplicity = quantity.mult;
+            double dens = model->GetDensity(multiplicity.fPDGID, multiplicity.fFeedDown);
+            double V = model->Parameters().V;
+            double ModelMult = dens * V;
+            double dchi2 = 2. * (ModelMult - multiplicity.fValue) / multiplicity.fError / multiplicity.fError;
+            for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+              if (!IsFitted(k) || FitThermalParameters[k] == -1)
+                continue;
+              ThermalParameter::Name tpar = static_cast<ThermalParameter::Name>(FitThermalParameters[k]);
+              ret[k] += dchi2 * V * model->GetDensityDerivative(multiplicity.fPDGID, multiplicity.fFeedDown, tpar);
+            }
+            // V = 4/3 pi R^3
+            if (IsFitted(3))
+              ret[3] += dchi2 * dens * 4. * xMath::Pi() * par[3] * par[3];
+          }
+        }
+
+        return ret;
+      }
+
+      /**
+       * Computes the parabolic errors of the fit parameters 
+       * from the finite differences of the analytic gradient.
+       * This requires 2 x (number of fit parameters) evaluations of the gradient,
+       * instead of the quadratic number of chi2 evaluations needed by MnHesse.
+       * The errors of the fixed parameters are taken from steps.
+       * Returns false if the resulting Hessian is not positive definite.
+       */
+      bool ErrorsFromGradient(const std::vector<double>& par, const std::vector<double>& steps, std::vector<double>& errors) const {
+        std::vector<int> fitted;
+        for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k)
+          if (IsFitted(k))
+            fitted.push_back(k);
+
+        int NF = static_cast<int>(fitted.size());
+        Eigen::MatrixXd hess(NF, NF);
+        for (int j = 0; j < NF; ++j) {
+          int k = fitted[j];
+          double h = 1.e-2 * steps[k];
+          if (!(h > 0.))
+            h = 1.e-6;
+          std::vector<double> parp = par, parm = par;
+          parp[k] += h;
+          parm[k] -= h;
+          std::vector<double> gradp = Gradient(parp);
+          std::vector<double> gradm = Gradient(parm);
+          for (int l = 0; l < NF; ++l)
+            hess(l, j) = (gradp[fitted[l]] - gradm[fitted[l]]) / (2. * h);
+        }
+
+        // Restore the model state at the minimum
+        (*this)(par);
+
+        Eigen::MatrixXd hesssym = 0.5 * (hess + hess.transpose());
+        Eigen::LLT<Eigen::MatrixXd> llt(hesssym);
+        if (llt.info() != Eigen::Success)
+          return false;
+
+        Eigen::MatrixXd cov = 2. * Up() * llt.solve(Eigen::MatrixXd::Identity(NF, NF));
+
+        errors = steps;
+        for (int j = 0; j < NF; ++j)
+          errors[fitted[j]] = sqrt(cov(j, j));
+
+        return true;
+      }
+
+      // The gradient is based on the same model calculations as the chi2 function itself,
+      // no need to check it against the numerical one
+      bool CheckGradient() const { return false; }
+
+      double Up() const { return 1.; }
+
+    private:
+      bool IsFitted(int k) const { return m_THMFit->Parameters().GetParameter(FitParameterNames[k]).toFit; }
+
+      // Central finite differences, used if the analytic derivatives are not available
+      std::vector<double> NumericalGradient(const std::vector<double>& par) const {
+        std::vector<double> ret(par.size(), 0.);
+        for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+          if (!IsFitted(k))
+            continue;
+          double h = 1.e-3 * m_THMFit->Parameters().GetParameter(FitParameterNames[k]).error;
+          if (!(h > 0.))
+            h = 1.e-6;
+          std::vector<double> parp = par, parm = par;
+          parp[k] += h;
+          parm[k] -= h;
+          ret[k] = (m_FCN(parp) - m_FCN(parm)) / (2. * h);
+        }
+        (*this)(par);
+        return ret;
+      }
+
+      ThermalModelFit *m_THMFit;
+      FitFCN m_FCN;
+      mutable std::vector<double> m_LastParameters;
+      mutable double m_LastChi2;
+    };
   }
 
   #endif
 
   ThermalModelFit::ThermalModelFit(ThermalModelBase *model_):
     m_model(model_), m_modelpce(NULL), m_Parameters(model_->Parameters()), m_FixVcToV(true), m_VcOverV(1.), 
-    m_YieldsAtTkin(false), m_SahaForNuclei(true), m_PCEFreezeLongLived(false), m_PCEWidthCut(0.015)
+    m_YieldsAtTkin(false), m_SahaForNuclei(true), m_PCEFreezeLongLived(false), m_PCEWidthCut(0.015),
+    m_UseAnalyticGradient(false)
   {
   }
 
@@ -224,6 +394,8 @@ namespace thermalfist {
 
   ThermalModelFitParameters ThermalModelFit::PerformFit(bool verbose, bool AsymmErrors) {
   #ifdef USE_MINUIT
+    THERMALFIST_PROFILE_SCOPE(FitTimer);
+
     m_ModelData.resize(m_Quantities.size(), 0.);
 
     m_Parameters.B = m_model->Parameters().B;
@@ -363,15 +535,28 @@ namespace thermalfist {
         printf("\n");
       }
 
-      MnMigrad migrad(mfunc, upar);
+      FitFCNGradient mfuncgrad(this, verbose);
+      bool analyticGradient = false;
+      if (UseAnalyticGradient()) {
+        mfuncgrad(params);
+        analyticGradient = !UseTkin() && m_model->CalculateDensitiesDerivatives();
+        if (!analyticGradient)
+          printf("**WARNING** ThermalModelFit::PerformFit: Analytic derivatives are not available for the present setup, using numerical ones\n");
+      }
 
-      FunctionMinimum min = migrad();
+      FunctionMinimum min = analyticGradient ? MnMigrad(mfuncgrad, upar)() : MnMigrad(mfunc, upar)();
 
       if (verbose)
         printf("\nMinimum found! Now calculating the error matrix...\n\n");
 
-      MnHesse hess;
-      hess(mfunc, min);
+      // Parabolic errors, from the finite differences of the analytic gradient if available,
+      // otherwise from MnHesse, which also provides the covariance matrix for MnMinos
+      std::vector<double> errors;
+      if (AsymmErrors || !analyticGradient || !mfuncgrad.ErrorsFromGradient(min.UserParameters().Params(), min.UserParameters().Errors(), errors)) {
+        MnHesse hess;
+        hess(mfunc, min);
+        errors = min.UserParameters().Errors();
+      }
 
       ret = m_Parameters;
 
@@ -387,27 +572,27 @@ namespace thermalfist {
       }
 
       ret.T.value = (min.UserParameters()).Params()[0];
-      ret.T.error = (min.UserParameters()).Errors()[0];
+      ret.T.error = errors[0];
       ret.muB.value = (min.UserParameters()).Params()[1];
-      ret.muB.error = (min.UserParameters()).Errors()[1];
+      ret.muB.error = errors[1];
       ret.gammaS.value = (min.UserParameters()).Params()[2];
-      ret.gammaS.error = (min.UserParameters()).Errors()[2];
+      ret.gammaS.error = errors[2];
       ret.R.value = (min.UserParameters()).Params()[3];
-      ret.R.error = (min.UserParameters()).Errors()[3];
+      ret.R.error = errors[3];
       ret.Rc.value = (min.UserParameters()).Params()[4];
-      ret.Rc.error = (min.UserParameters()).Errors()[4];
+      ret.Rc.error = errors[4];
       ret.gammaq.value = (min.UserParameters()).Params()[5];
-      ret.gammaq.error = (min.UserParameters()).Errors()[5];
+      ret.gammaq.error = errors[5];
       ret.muQ.value = (min.UserParameters()).Params()[6];
-      ret.muQ.error = (min.UserParameters()).Errors()[6];
+      ret.muQ.error = errors[6];
       ret.muS.value = (min.UserParameters()).Params()[7];
-      ret.muS.error = (min.UserParameters()).Errors()[7];
+      ret.muS.error = errors[7];
       ret.muC.value = (min.UserParameters()).Params()[8];
-      ret.muC.error = (min.UserParameters()).Errors()[8];
+      ret.muC.error = errors[8];
       ret.gammaC.value = (min.UserParameters()).Params()[9];
-      ret.gammaC.error = (min.UserParameters()).Errors()[9];
+      ret.gammaC.error = errors[9];
       ret.Tkin.value = (min.UserParameters()).Params()[10];
-      ret.Tkin.error = (min.UserParameters()).Errors()[10];
+      ret.Tkin.error = errors[10];
 
       if (!m_Parameters.Rc.toFit && FixVcOverV()) {
         ret.Rc.value = ret.R.value * pow(VcOverV(), 1./3.);
@@ -0,0 +1,174 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include "HRGFit/ThermalModelFitBatch.h"
+
+#include <cstdio>
+#include <algorithm>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "HRGBase/ThermalModelIdeal.h"
+
+namespace thermalfist {
+
+  ThermalModelFitBatch::ThermalModelFitBatch(ThermalParticleSystem *TPS, const ModelFactory& factory) :
+    m_TPS(TPS), m_Factory(factory), m_Workers(1), m_WarmStart(true),
+    m_FixVcToV(true), m_VcOverV(1.), m_YieldsAtTkin(false), m_UseAnalyticGradient(false)
+  {
+#ifdef USE_OPENMP
+    m_Workers = omp_get_max_threads();
+#endif
+  }
+
+  void ThermalModelFitBatch::AddDatasetFromFile(const std::string & filename, const std::string & name)
+  {
+    std::string label = name;
+    if (label == "") {
+      label = filename;
+      size_t pos = label.find_last_of("/\\");
+      if (pos != std::string::npos)
+        label = label.substr(pos + 1);
+    }
+    AddDataset(label, ThermalModelFit::loadExpDataFromFile(filename));
+  }
+
+  const std::vector<ThermalModelFitParameters>& ThermalModelFitBatch::PerformFits(bool verbose)
+  {
+    int NDS = static_cast<int>(m_Datasets.size());
+    m_Results = std::vector<ThermalModelFitParameters>(NDS, m_Parameters);
+    if (NDS == 0)
+      return m_Results;
+
+    int NW = std::max(1, std::min(m_Workers, NDS));
+
+    // Each worker gets its own model sharing the particle list, the models are created serially
+    // as the factory need not be thread-safe and applies the list-wide settings
+    std::vector<ThermalModelBase*> models(NW, NULL);
+    for (int iw = 0; iw < NW; ++iw) {
+      if (m_Factory)
+        models[iw] = m_Factory(m_TPS);
+      else
+        models[iw] = new ThermalModelIdeal(m_TPS);
+    }
+
+    // Contiguous blocks of data sets handled by each worker
+    std::vector<int> blocks(NW + 1);
+    for (int iw = 0; iw <= NW; ++iw)
+      blocks[iw] = static_cast<int>((static_cast<long long>(iw) * NDS) / NW);
+
+    // With several workers the first data set is fitted beforehand,
+    // its result is the starting point for the first data sets of all the other blocks
+    bool anchored = m_WarmStart && NW > 1;
+    if (anchored) {
+      ThermalModelFit fitter(models[0]);
+      ConfigureFitter(fitter);
+      PerformSingleFit(fitter, 0, -1, verbose);
+    }
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(NW)
+#endif
+    for (int iw = 0; iw < NW; ++iw) {
+      ThermalModelFit fitter(models[iw]);
+      ConfigureFitter(fitter);
+
+      // Within a block each fit is warm-started from the preceding data set
+      for (int ids = blocks[iw]; ids < blocks[iw + 1]; ++ids) {
+        if (anchored && ids == 0)
+          continue;
+        int iprev = (ids > blocks[iw]) ? ids - 1 : (anchored ? 0 : -1);
+        PerformSingleFit(fitter, ids, iprev, verbose);
+      }
+    }
+
+    for (int iw = 0; iw < NW; ++iw)
+      delete models[iw];
+
+    return m_Results;
+  }
+
+  void ThermalModelFitBatch::ConfigureFitter(ThermalModelFit& fitter) const
+  {
+    fitter.FixVcOverV(m_FixVcToV);
+    fitter.SetVcOverV(m_VcOverV);
+    fitter.UseTkin(m_YieldsAtTkin);
+    fitter.UseAnalyticGradient(m_UseAnalyticGradient);
+  }
+
+  void ThermalModelFitBatch::PerformSingleFit(ThermalModelFit& fitter, int ids, int iprev, bool verbose)
+  {
+    ThermalModelFitParameters params = m_Parameters;
+
+    // Warm start from the result for data set iprev, unless its fit failed
+    if (m_WarmStart && iprev >= 0 && m_Results[iprev].chi2 < 1.e12) {
+      const ThermalModelFitParameters& prev = m_Results[iprev];
+      for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+        FitParameter& par = params.GetParameter(k);
+        const FitParameter& prevpar = prev.GetParameter(k);
+        if (par.toFit && prevpar.toFit && prevpar.value >= par.xmin && prevpar.value <= par.xmax)
+          par.value = prevpar.value;
+      }
+    }
+
+    fitter.SetParameters(params);
+    fitter.SetQuantities(m_Datasets[ids].data);
+    m_Results[ids] = fitter.PerformFit(false);
+
+    if (verbose) {
+      printf("%-50s chi2/dof = %lf/%d, T = %lf +- %lf MeV\n",
+        m_Datasets[ids].name.c_str(),
+        m_Results[ids].chi2, m_Results[ids].ndf,
+        m_Results[ids].T.value * 1.e3, m_Results[ids].T.error * 1.e3);
+    }
+  }
+
+  void ThermalModelFitBatch::PrintResultsTable(const std::string & filename) const
+  {
+    FILE *f = stdout;
+    if (filename != "") {
+      f = fopen(filename.c_str(), "w");
+      if (f == NULL) {
+        printf("**ERROR** ThermalModelFitBatch::PrintResultsTable: Cannot open file %s for writing!\n", filename.c_str());
+        return;
+      }
+    }
+
+    // Parameters fitted in at least one data set
+    std::vector<int> fitted;
+    for (int k = 0; k < ThermalModelFitParameters::ParameterCount; ++k) {
+      for (size_t ids = 0; ids < m_Results.size(); ++ids) {
+        if (m_Results[ids].GetParameter(k).toFit) {
+          fitted.push_back(k);
+          break;
+        }
+      }
+    }
+
+    fprintf(f, "%-50s %15s %6s", "# Dataset", "chi2", "ndf");
+    for (size_t j = 0; j < fitted.size(); ++j) {
+      const std::string& name = m_Parameters.GetParameter(fitted[j]).name;
+      fprintf(f, " %15s %15s", name.c_str(), ("err" + name).c_str());
+    }
+    fprintf(f, "\n");
+
+    for (size_t ids = 0; ids < m_Results.size() && ids < m_Datasets.size(); ++ids) {
+      fprintf(f, "%-50s %15lf %6d", m_Datasets[ids].name.c_str(), m_Results[ids].chi2, m_Results[ids].ndf);
+      for (size_t j = 0; j < fitted.size(); ++j) {
+        const FitParameter& par = m_Results[ids].GetParameter(fitted[j]);
+        fprintf(f, " %15lf %15lf", par.value, par.toFit ? par.error : 0.);
+      }
+      fprintf(f, "\n");
+    }
+
+    if (f != stdout)
+      fclose(f);
+  }
+
+} // namespace thermalfist
@@ -141,7 +141,8 @@ namespace thermalfist {
     
 
     BroydenEquationsPCE eqs(this, mode);
-    Broyden broydn(&eqs);
+    m_Broyden.SetEquations(&eqs);
+    m_Broyden.ReuseJacobian(m_model->SolverJacobianReuse());
 
     std::vector<double> PCEParams(m_StableComponentsNumber, 0.);
     int stab_index = 0;
@@ -166,7 +167,8 @@ namespace thermalfist {
     else
       PCEParams.push_back(m_ParametersCurrent.T);
 
-    PCEParams = broydn.Solve(PCEParams);
+    PCEParams = m_Broyden.Solve(PCEParams);
+    m_Broyden.SetEquations(NULL);
 
     m_ChemCurrent = m_model->ChemicalPotentials();
     if (mode == 0)
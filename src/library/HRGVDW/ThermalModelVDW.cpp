@@ -6,6 +6,7 @@
  * GNU General Public License (GPLv3 or later)
  */
 #include "HRGVDW/ThermalModelVDW.h"
+#include "HRGBase/Profiling.h"
 
 #include <vector>
 #include <cmath>
@@ -61,6 +62,11 @@ namespace thermalfist {
       m_MuStar[i] = m_Chem[i];
   }
 
+  ThermalModelVDW* ThermalModelVDW::Clone() const
+  {
+    return new ThermalModelVDW(*this);
+  }
+
   void ThermalModelVDW::SetChemicalPotentials(const vector<double>& chem)
   {
     ThermalModelBase::SetChemicalPotentials(chem);
@@ -90,6 +96,7 @@ namespace thermalfist {
 
     m_VirialdT = vector< vector<double> >(m_TPS->Particles().size(), vector<double>(m_TPS->Particles().size(),0.));
     m_AttrdT   = vector< vector<double> >(m_TPS->Particles().size(), vector<double>(m_TPS->Particles().size(), 0.));
+    ResetCalculatedFlags();
   }
 
   void ThermalModelVDW::FillVirialEV(const vector< vector<double> >& bij)
@@ -99,6 +106,7 @@ namespace thermalfist {
       return;
     }
     m_Virial = bij;
+    ResetCalculatedFlags();
   }
 
   void ThermalModelVDW::FillAttraction(const vector<vector<double> >& aij)
@@ -108,6 +116,7 @@ namespace thermalfist {
       return;
     }
     m_Attr = aij;
+    ResetCalculatedFlags();
   }
 
   void ThermalModelVDW::ReadInteractionParameters(const string & filename)
@@ -138,6 +147,7 @@ namespace thermalfist {
       }
     }
     fin.close();
+    ResetCalculatedFlags();
   }
 
   void ThermalModelVDW::WriteInteractionParameters(const string & filename)
@@ -186,9 +196,12 @@ namespace thermalfist {
 
   std::vector<double> ThermalModelVDW::ComputeNp(const std::vector<double>& dmustar)
   {
-    vector<double> ns(m_densities.size(), 0.);
+    vector<double> mus(m_densities.size(), 0.);
     for (size_t i = 0; i < m_densities.size(); ++i)
-      ns[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_Chem[i] + dmustar[m_MapTodMuStar[i]]);
+      mus[i] = m_Chem[i] + dmustar[m_MapTodMuStar[i]];
+
+    vector<double> ns;
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, mus, ns);
 
     return ComputeNp(dmustar, ns);
   }
@@ -252,18 +265,21 @@ namespace thermalfist {
 
     BroydenEquationsVDW eqs(this);
     BroydenJacobianVDW  jac(this);
-    Broyden broydn(&eqs, &jac);
+    m_Broyden.SetEquations(&eqs);
+    m_Broyden.SetJacobian(&jac);
+    m_Broyden.ReuseJacobian(m_SolverJacobianReuse && !m_SearchMultipleSolutions);
     BroydenSolutionCriteriumVDW crit(this);
 
-    dmuscur = broydn.Solve(dmuscur, &crit);
+    dmuscur = m_Broyden.Solve(dmuscur, &crit);
 
-    if (broydn.Iterations() == broydn.MaxIterations())
+    if (m_Broyden.Iterations() == m_Broyden.MaxIterations())
       m_LastBroydenSuccessFlag = false;
     else m_LastBroydenSuccessFlag = true;
 
+    m_MaxDiff = m_Broyden.MaxDifference();
 
-
-    m_MaxDiff = broydn.MaxDifference();
+    m_Broyden.SetEquations(NULL);
+    m_Broyden.SetJacobian(NULL);
 
     vector<double> ret(NN);
     for (int i = 0; i < NN; ++i)
@@ -297,8 +313,7 @@ namespace thermalfist {
       fl &= m_LastBroydenSuccessFlag;
       if (!fl) continue;
 
-      for(int i = 0; i < m_TPS->ComponentsNumber(); ++i) 
-        m_DensitiesId[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, sol[i]);
+      IdealGasQuantities(IdealGasFunctions::ParticleDensity, sol, m_DensitiesId);
 
       int NN = m_densities.size();
 
@@ -319,9 +334,11 @@ namespace thermalfist {
       for(int i=0;i<NN;++i) 
         m_densities[i] = solVector[i];
 
+      vector<double> Ps;
+      IdealGasQuantities(IdealGasFunctions::Pressure, sol, Ps);
       double tP = 0.;
       for(size_t i=0;i<m_densities.size();++i) 
-        tP += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, sol[i]);
+        tP += Ps[i];
       for(size_t i=0;i<m_densities.size();++i)
         for(size_t j=0;j<m_densities.size();++j)
           tP += -m_Attr[i][j] * m_densities[i] * m_densities[j];
@@ -362,7 +379,7 @@ namespace thermalfist {
   }
 
   void ThermalModelVDW::CalculatePrimordialDensitiesOld() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     map< vector<double> , int> m_MapVDW;
 
@@ -420,8 +437,7 @@ namespace thermalfist {
 
     tbeg = clock();
 
-    for(int i=0;i<m_TPS->ComponentsNumber();++i) 
-      m_DensitiesId[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_MuStar[i]);
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_MuStar, m_DensitiesId);
 
     MatrixXd densMatrix(NN, NN);
     VectorXd solVector(NN), xVector(NN);
@@ -439,7 +455,9 @@ namespace thermalfist {
     for(int i=0;i<NN;++i) m_densities[i] = solVector[i];
 
     // TODO: Scalar density properly
-    for(int i=0;i<NN;++i) xVector[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ScalarDensity, m_UseWidth, m_MuStar[i]);
+    vector<double> scaldensid;
+    IdealGasQuantities(IdealGasFunctions::ScalarDensity, m_MuStar, scaldensid);
+    for(int i=0;i<NN;++i) xVector[i] = scaldensid[i];
     solVector = decomp.solve(xVector);
     m_scaldens.resize(m_densities.size());
     for(int i=0;i<NN;++i) m_scaldens[i] = solVector[i];
@@ -451,7 +469,7 @@ namespace thermalfist {
   }
 
   void ThermalModelVDW::CalculatePrimordialDensitiesNew() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     map< vector<double>, int> m_MapVDW;
 
@@ -493,8 +511,7 @@ namespace thermalfist {
 
     tbeg = clock();
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
-      m_DensitiesId[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_MuStar[i]);
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_MuStar, m_DensitiesId);
 
   
     int NNdmu = m_MapFromdMuStar.size();
@@ -559,9 +576,8 @@ namespace thermalfist {
     MatrixXd densMatrix(2*NN, 2*NN);
     VectorXd solVector(2*NN), xVector(2*NN);
 
-    vector<double> chi2id(m_densities.size());
-    for(int i=0;i<NN;++i) 
-      chi2id[i] = m_TPS->Particles()[i].chi(2, m_Parameters, m_UseWidth, m_MuStar[i]);
+    vector<double> chi2id;
+    IdealGasQuantities(IdealGasFunctions::chi2, m_MuStar, chi2id);
 
     for(int i=0;i<NN;++i)
       for(int j=0;j<NN;++j) {
@@ -620,9 +636,8 @@ namespace thermalfist {
     // chi3
     vector<double> d2ni(NN, 0.), d2mus(NN, 0.);
 
-    vector<double> chi3id(m_densities.size());
-    for(int i=0;i<NN;++i) 
-      chi3id[i] = m_TPS->Particles()[i].chi(3, m_Parameters, m_UseWidth, m_MuStar[i]);
+    vector<double> chi3id;
+    IdealGasQuantities(IdealGasFunctions::chi3, m_MuStar, chi3id);
 
     for(int i=0;i<NN;++i) {
       xVector[i]    = 0.;
@@ -664,9 +679,8 @@ namespace thermalfist {
     // chi4
     vector<double> d3ni(NN, 0.), d3mus(NN, 0.);
 
-    vector<double> chi4id(m_densities.size());
-    for (int i = 0; i < NN; ++i)
-      chi4id[i] = m_TPS->Particles()[i].chi(4, m_Parameters, m_UseWidth, m_MuStar[i]);
+    vector<double> chi4id;
+    IdealGasQuantities(IdealGasFunctions::chi4, m_MuStar, chi4id);
 
     vector<double> dnis(NN, 0.);
     for(int i=0;i<NN;++i) {
@@ -774,9 +788,8 @@ namespace thermalfist {
     MatrixXd densMatrix(2 * NN, 2 * NN);
     VectorXd solVector(2 * NN), xVector(2 * NN);
 
-    vector<double> chi2id(m_densities.size());
-    for (int i = 0; i<NN; ++i)
-      chi2id[i] = m_TPS->Particles()[i].chi(2, m_Parameters, m_UseWidth, m_MuStar[i]);
+    vector<double> chi2id;
+    IdealGasQuantities(IdealGasFunctions::chi2, m_MuStar, chi2id);
 
     for (int i = 0; i<NN; ++i)
       for (int j = 0; j<NN; ++j) {
@@ -839,6 +852,8 @@ namespace thermalfist {
 
   void ThermalModelVDW::CalculateFluctuations()
   {
+    THERMALFIST_PROFILE_SCOPE(FluctuationsTimer);
+
     CalculateTwoParticleCorrelations();
     CalculateSusceptibilityMatrix();
     CalculateTwoParticleFluctuationsDecays();
@@ -859,16 +874,20 @@ namespace thermalfist {
   double ThermalModelVDW::CalculateEnergyDensity() {
     if (!m_Calculated) CalculateDensities();
     double ret = 0.;
+    vector<double> edens;
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, m_MuStar, edens);
     for(size_t i=0;i<m_densities.size();++i) 
       if (m_densities[i]>0.) 
-        ret += m_densities[i] / m_DensitiesId[i] * m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_MuStar[i]);
+        ret += m_densities[i] / m_DensitiesId[i] * edens[i];
     for(size_t i=0;i<m_densities.size();++i)
       for(size_t j=0;j<m_densities.size();++j)
         ret += -m_Attr[i][j] * m_densities[i] * m_densities[j];
 
     if (m_TemperatureDependentAB) {
+      vector<double> Ps;
+      IdealGasQuantities(IdealGasFunctions::Pressure, m_MuStar, Ps);
       for (size_t i = 0; i < m_densities.size(); ++i) {
-        double tPid = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_MuStar[i]);
+        double tPid = Ps[i];
         for (size_t j = 0; j < m_densities.size(); ++j) {
           ret += -tPid * m_densities[j] * m_Parameters.T * m_VirialdT[j][i];
           ret += m_Parameters.T * m_AttrdT[i][j] * m_densities[i] * m_densities[j];
@@ -882,13 +901,17 @@ namespace thermalfist {
   double ThermalModelVDW::CalculateEntropyDensity() {
     if (!m_Calculated) CalculateDensities();
     double ret = 0.;
+    vector<double> sdens;
+    IdealGasQuantities(IdealGasFunctions::EntropyDensity, m_MuStar, sdens);
     for(size_t i=0;i<m_densities.size();++i) 
       if (m_densities[i]>0.) 
-        ret += m_densities[i] / m_DensitiesId[i] * m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EntropyDensity, m_UseWidth, m_MuStar[i]);
+        ret += m_densities[i] / m_DensitiesId[i] * sdens[i];
   
     if (m_TemperatureDependentAB) {
+      vector<double> Ps;
+      IdealGasQuantities(IdealGasFunctions::Pressure, m_MuStar, Ps);
       for (size_t i = 0; i < m_densities.size(); ++i) {
-        double tPid = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_MuStar[i]);
+        double tPid = Ps[i];
         for (size_t j = 0; j < m_densities.size(); ++j) {
           ret += -tPid * m_densities[j] * m_VirialdT[j][i];
           ret += m_AttrdT[i][j] * m_densities[i] * m_densities[j];
@@ -902,8 +925,10 @@ namespace thermalfist {
   double ThermalModelVDW::CalculatePressure() {
     if (!m_Calculated) CalculateDensities();
     double ret = 0.;
+    vector<double> Ps;
+    IdealGasQuantities(IdealGasFunctions::Pressure, m_MuStar, Ps);
     for(size_t i=0;i<m_densities.size();++i) 
-      ret += m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_MuStar[i]);
+      ret += Ps[i];
     for(size_t i=0;i<m_densities.size();++i)
       for(size_t j=0;j<m_densities.size();++j)
         ret += -m_Attr[i][j] * m_densities[i] * m_densities[j];
@@ -925,6 +950,28 @@ namespace thermalfist {
       return 0.0;
   }
 
+  void ThermalModelVDW::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelBase::WriteState(state);
+    state.Scalars["LastBroydenSuccessFlag"] = m_LastBroydenSuccessFlag;
+    state.Vectors["MuStar"] = m_MuStar;
+    state.Vectors["DensitiesId"] = m_DensitiesId;
+    state.Vectors["ScalarDensities"] = m_scaldens;
+    state.Vectors["chiarb"] = m_chiarb;
+    state.Matrices["chi"] = m_chi;
+  }
+
+  void ThermalModelVDW::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelBase::ReadState(state);
+    state.Get("LastBroydenSuccessFlag", m_LastBroydenSuccessFlag);
+    state.Get("MuStar", m_MuStar);
+    state.Get("DensitiesId", m_DensitiesId);
+    state.Get("ScalarDensities", m_scaldens);
+    state.Get("chiarb", m_chiarb);
+    state.Get("chi", m_chi);
+  }
+
   double ThermalModelVDW::VirialCoefficient(int i, int j) const
   {
     if (i<0 || i >= static_cast<int>(m_Virial.size()) || j < 0 || j >= static_cast<int>(m_Virial.size()))
@@ -956,23 +1003,13 @@ namespace thermalfist {
   std::vector<double> ThermalModelVDW::BroydenEquationsVDW::Equations(const std::vector<double>& x)
   {
     int NN = m_THM->Densities().size();
-    vector<double> Ps(NN, 0.);
-    for (int i = 0; i < NN; ++i) {
-      Ps[i] = m_THM->TPS()->Particles()[i].Density(m_THM->Parameters(),
-        IdealGasFunctions::Pressure,
-        m_THM->UseWidth(),
-        m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]]
-      );
-    }
+    vector<double> mus(NN, 0.);
+    for (int i = 0; i < NN; ++i)
+      mus[i] = m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]];
 
-    vector<double> ns(NN, 0.);
-    for (int i = 0; i < NN; ++i) {
-      ns[i] = m_THM->TPS()->Particles()[i].Density(m_THM->Parameters(),
-        IdealGasFunctions::ParticleDensity,
-        m_THM->UseWidth(),
-        m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]]
-      );
-    }
+    vector<double> Ps, ns;
+    m_THM->IdealGasQuantities(IdealGasFunctions::Pressure, mus, Ps);
+    m_THM->IdealGasQuantities(IdealGasFunctions::ParticleDensity, mus, ns);
 
     vector<double> np = m_THM->ComputeNp(x, ns);
 
@@ -1009,28 +1046,14 @@ namespace thermalfist {
 
     std::vector<double> ret(NNdmu*NNdmu, 0.);
     {
-      vector<double> Ps(NN, 0.);
-      for (int i = 0; i<NN; ++i)
-        Ps[i] = m_THM->TPS()->Particles()[i].Density(m_THM->Parameters(),
-          IdealGasFunctions::Pressure,
-          m_THM->UseWidth(),
-          m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]]
-        );
-
-      vector<double> ns(NN, 0.);
-      for (int i = 0; i<NN; ++i)
-        ns[i] = m_THM->TPS()->Particles()[i].Density(m_THM->Parameters(),
-          IdealGasFunctions::ParticleDensity,
-          m_THM->UseWidth(),
-          m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]]
-        );
-
-      vector<double> chi2s(NN, 0.);
-      for (int i = 0; i<NN; ++i)
-        chi2s[i] = m_THM->TPS()->Particles()[i].chi(2, m_THM->Parameters(),
-          m_THM->UseWidth(),
-          m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]]
-        );
+      vector<double> mus(NN, 0.);
+      for (int i = 0; i < NN; ++i)
+        mus[i] = m_THM->ChemicalPotential(i) + x[m_THM->m_MapTodMuStar[i]];
+
+      vector<double> Ps, ns, chi2s;
+      m_THM->IdealGasQuantities(IdealGasFunctions::Pressure, mus, Ps);
+      m_THM->IdealGasQuantities(IdealGasFunctions::ParticleDensity, mus, ns);
+      m_THM->IdealGasQuantities(IdealGasFunctions::chi2, mus, chi2s);
 
       for (int i = 0; i < NNdmu; ++i) {
         for (int j = 0; j < NNdmu; ++j) {
@@ -37,13 +37,21 @@ namespace thermalfist {
     ClearModelVDW();
   }
 
+  ThermalModelVDWCanonicalStrangeness* ThermalModelVDWCanonicalStrangeness::Clone() const
+  {
+    ThermalModelVDWCanonicalStrangeness *ret = new ThermalModelVDWCanonicalStrangeness(*this);
+    // The model for non-strange hadrons owns its particle list and is thus not shared with the copy
+    ret->m_modelVDW = NULL;
+    if (m_modelVDW != NULL)
+      ret->PrepareModelVDW();
+    return ret;
+  }
+
   void ThermalModelVDWCanonicalStrangeness::CalculateDensitiesGCE() {
     if (m_modelVDW == NULL)
       PrepareModelVDW();
 
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_densitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::ParticleDensity, m_UseWidth, m_MuStar[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::ParticleDensity, m_MuStar, m_densitiesGCE);
 
     m_GCECalculated = true;
   }
@@ -52,10 +60,7 @@ namespace thermalfist {
     if (m_modelVDW == NULL)
       PrepareModelVDW();
 
-    m_energydensitiesGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_energydensitiesGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::EnergyDensity, m_UseWidth, m_MuStar[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::EnergyDensity, m_MuStar, m_energydensitiesGCE);
   }
 
   void ThermalModelVDWCanonicalStrangeness::CalculatePressuresGCE()
@@ -63,10 +68,7 @@ namespace thermalfist {
     if (m_modelVDW == NULL)
       PrepareModelVDW();
 
-    m_pressuresGCE.resize(m_densitiesGCE.size());
-    for (int i = 0; i < m_TPS->ComponentsNumber(); ++i) {
-      m_pressuresGCE[i] = m_TPS->Particles()[i].Density(m_Parameters, IdealGasFunctions::Pressure, m_UseWidth, m_MuStar[i]);
-    }
+    IdealGasQuantities(IdealGasFunctions::Pressure, m_MuStar, m_pressuresGCE);
   }
 
   void ThermalModelVDWCanonicalStrangeness::CalculateSums(const std::vector<double>& Vcs)
@@ -74,11 +76,7 @@ namespace thermalfist {
     if (!m_GCECalculated)
       CalculateDensitiesGCE();
 
-    m_Zsum.resize(m_StrVals.size());
-
     m_partialS.resize(m_StrVals.size());
-    vector<double> xi(3, 0.), yi(3, 0.);
-
     for (size_t i = 0; i < m_StrVals.size(); ++i) {
       m_partialS[i] = 0.;
       for (int j = 0; j < m_TPS->ComponentsNumber(); ++j)
@@ -86,35 +84,12 @@ namespace thermalfist {
           m_partialS[i] += m_densitiesGCE[j] * Vcs[j];
     }
 
-    for (int i = 0; i < 3; ++i) {
-      xi[i] = 2. * sqrt(m_partialS[m_StrMap[i + 1]] * m_partialS[m_StrMap[-(i + 1)]]);
-      yi[i] = sqrt(m_partialS[m_StrMap[i + 1]] / m_partialS[m_StrMap[-(i + 1)]]);
-    }
-
-    // TODO: Choose iters dynamically based on total strangeness
-    int iters = 20;
-
-    for (unsigned int i = 0; i < m_StrVals.size(); ++i) {
-      double res = 0.;
-
-      for (int m = -iters; m <= iters; ++m)
-        for (int n = -iters; n <= iters; ++n) {
-          double tmp = xMath::BesselI(abs(3 * m + 2 * n - m_StrVals[i]), xi[0]) *
-            xMath::BesselI(abs(n), xi[1]) *
-            xMath::BesselI(abs(m), xi[2]) *
-            pow(yi[0], m_StrVals[i] - 3 * m - 2 * n) *
-            pow(yi[1], n) *
-            pow(yi[2], m);
-          if (tmp != tmp) continue;
-          res += tmp;
-        }
-      m_Zsum[i] = res;
-    }
+    CalculateZsum();
   }
 
 
   void ThermalModelVDWCanonicalStrangeness::CalculatePrimordialDensities() {
-    m_FluctuationsCalculated = false;
+    ResetDerivedCalculatedFlags();
 
     m_energydensitiesGCE.resize(0);
     m_pressuresGCE.resize(0);
@@ -173,7 +148,7 @@ namespace thermalfist {
 
     ret += m_modelVDW->CalculateEntropyDensity();
 
-    ret += log(m_Zsum[m_StrMap[0]]) / m_Parameters.SVc;
+    ret += (log(m_Zsum[m_StrMap[0]]) + m_ZsumLogFactor) / m_Parameters.SVc;
 
     for (int i = 0; i < m_TPS->ComponentsNumber(); ++i)
       if (m_TPS->Particles()[i].Strangeness() != 0)
@@ -367,4 +342,20 @@ namespace thermalfist {
     return (charge == ConservedCharge::StrangenessCharge);
   }
 
+  void ThermalModelVDWCanonicalStrangeness::WriteState(ThermalModelState& state) const
+  {
+    ThermalModelCanonicalStrangeness::WriteState(state);
+    state.Scalars["PressureNonStrange"] = m_PNS;
+    state.Vectors["MuStar"] = m_MuStar;
+    state.Vectors["Suppression"] = m_Suppression;
+  }
+
+  void ThermalModelVDWCanonicalStrangeness::ReadState(const ThermalModelState& state)
+  {
+    ThermalModelCanonicalStrangeness::ReadState(state);
+    state.Get("PressureNonStrange", m_PNS);
+    state.Get("MuStar", m_MuStar);
+    state.Get("Suppression", m_Suppression);
+  }
+
 } // namespace thermalfist
\ No newline at end of file
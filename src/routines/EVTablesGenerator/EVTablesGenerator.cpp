@@ -11,6 +11,14 @@
 #include <iomanip>
 #include <ctime>
 #include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 #include "HRGBase.h"
 #include "HRGEV.h"
@@ -27,6 +35,8 @@ using namespace thermalfist;
 #endif
 
 // A macro for generating input files with excluded-volume/van der Waals parameters
+// The tables are generated in parallel (with OpenMP), each thread reuses its own copies
+// of the models sharing a single particle list
 // Modes:
 // 0 - Constant
 // 1 - Meson/Baryon(CI)
@@ -37,8 +47,8 @@ using namespace thermalfist;
 // 6 - 4b
 // 7 - s-inv
 
-void Diagonal(std::string filename, ThermalParticleSystem *TPS, int mode = 0, double r1 = 0., double r2 = 0., double r3 = 0., double r4 = 0.) {
-	ThermalModelEVDiagonal model(TPS);
+void Diagonal(ThermalModelEVDiagonal &model, int mode = 0, double r1 = 0., double r2 = 0., double r3 = 0., double r4 = 0.) {
+	ThermalParticleSystem *TPS = model.TPS();
 	vector<double> radii(TPS->Particles().size(), 0.);
 	for (int i = 0; i < TPS->Particles().size(); ++i) {
 		ThermalParticle &tpart = TPS->Particle(i);
@@ -83,12 +93,11 @@ void Diagonal(std::string filename, ThermalParticleSystem *TPS, int mode = 0, do
 	}
 
 	model.FillVirial(radii);
-	model.WriteInteractionParameters(filename);
 }
 
 
-void Crossterms(std::string filename, ThermalParticleSystem *TPS, int mode = 0, double r1 = 0., double r2 = 0., double r3 = 0., double r4 = 0.) {
-	ThermalModelEVCrossterms model(TPS);
+void Crossterms(ThermalModelEVCrossterms &model, int mode = 0, double r1 = 0., double r2 = 0., double r3 = 0., double r4 = 0.) {
+	ThermalParticleSystem *TPS = model.TPS();
 	vector<double> radii(TPS->Particles().size(), 0.);
 	for (int i = 0; i < TPS->Particles().size(); ++i) {
 		ThermalParticle &tpart = TPS->Particle(i);
@@ -159,12 +168,10 @@ void Crossterms(std::string filename, ThermalParticleSystem *TPS, int mode = 0,
 
 	if (!(mode >= 1 && mode <= 3))
 		model.FillVirial(radii);
-	model.WriteInteractionParameters(filename);
 }
 
 
-void QvdWHRG(std::string filename, ThermalParticleSystem *TPS, double a = 0.329, double b = 3.42, double StoNS = 1.) {
-	ThermalModelVDW model(TPS);
+void QvdWHRG(ThermalModelVDW &model, double a = 0.329, double b = 3.42, double StoNS = 1.) {
 
 	for (int i1 = 0; i1 < model.TPS()->Particles().size(); ++i1) {
 		for (int i2 = 0; i2 < model.TPS()->Particles().size(); ++i2) {
@@ -217,39 +224,237 @@ void QvdWHRG(std::string filename, ThermalParticleSystem *TPS, double a = 0.329,
 
 		}
 	}
+}
+
+
+// A table to be generated
+struct EVTableJob {
+	enum JobType { DiagonalEV, CrosstermsEV, QvdW };
+	JobType type;
+	std::string filename;
+	int mode;            // Mode of Diagonal() and Crossterms()
+	double par[4];       // r1...r4 for Diagonal() and Crossterms(), a, b, StoNS for QvdWHRG()
+
+	EVTableJob(JobType type_, const std::string &filename_, int mode_, double p1 = 0., double p2 = 0., double p3 = 0., double p4 = 0.) :
+		type(type_), filename(filename_), mode(mode_) {
+		par[0] = p1; par[1] = p2; par[2] = p3; par[3] = p4;
+	}
+};
+
+// Model instances used by one thread, reused for all the jobs of this thread
+struct EVTableModels {
+	ThermalModelEVDiagonal *diagonal;
+	ThermalModelEVCrossterms *crossterms;
+	ThermalModelVDW *vdw;
+};
+
+// Binary output, the file name has the .dat extension replaced by .bin
+// Layout (native endianness):
+// char[8]    "TFEVTAB1"
+// int32      table type (0 - Diagonal, 1 - Crossterms, 2 - QvdW)
+// int32      number of particles N
+// int64[N]   PDG codes
+// double[N]  v_i [fm^3] (Diagonal)
+// or
+// double[N*N] b_ij [fm^3] (Crossterms), followed by double[N*N] a_ij [GeV fm^3] (QvdW)
+std::string BinaryFileName(const std::string &filename) {
+	std::string ret = filename;
+	if (ret.size() > 4 && ret.substr(ret.size() - 4) == ".dat")
+		ret = ret.substr(0, ret.size() - 4);
+	return ret + ".bin";
+}
+
+bool WriteBinaryTable(const std::string &filename, const EVTableJob &job, const ThermalModelBase &model) {
+	FILE *f = fopen(filename.c_str(), "wb");
+	if (f == NULL)
+		return false;
+
+	const ThermalParticleSystem *TPS = model.TPS();
+	int32_t type = static_cast<int32_t>(job.type);
+	int32_t N = TPS->ComponentsNumber();
+	fwrite("TFEVTAB1", 1, 8, f);
+	fwrite(&type, sizeof(type), 1, f);
+	fwrite(&N, sizeof(N), 1, f);
+
+	vector<int64_t> pdgs(N);
+	for (int i = 0; i < N; ++i)
+		pdgs[i] = TPS->Particles()[i].PdgId();
+	fwrite(&pdgs[0], sizeof(int64_t), N, f);
+
+	vector<double> data;
+	if (job.type == EVTableJob::DiagonalEV) {
+		data.resize(N);
+		for (int i = 0; i < N; ++i)
+			data[i] = model.VirialCoefficient(i, i);
+	}
+	else {
+		data.resize(N * N);
+		for (int i = 0; i < N; ++i)
+			for (int j = 0; j < N; ++j)
+				data[i * N + j] = model.VirialCoefficient(i, j);
+		if (job.type == EVTableJob::QvdW) {
+			data.resize(2 * N * N);
+			for (int i = 0; i < N; ++i)
+				for (int j = 0; j < N; ++j)
+					data[N * N + i * N + j] = model.AttractionCoefficient(i, j);
+		}
+	}
+	bool ret = (fwrite(&data[0], sizeof(double), data.size(), f) == data.size());
+	return (fclose(f) == 0) && ret;
+}
 
-	model.WriteInteractionParameters(filename);
+// The output is first written to a temporary file which is renamed once complete,
+// thus an existing output file always corresponds to a finished job
+bool CommitFile(const std::string &tmpname, const std::string &filename) {
+	remove(filename.c_str());
+	return (rename(tmpname.c_str(), filename.c_str()) == 0);
 }
 
+bool FileExists(const std::string &filename) {
+	ifstream fin(filename.c_str());
+	return fin.good();
+}
 
+bool RunJob(const EVTableJob &job, EVTableModels &models, bool binary) {
+	ThermalModelBase *model = NULL;
+	if (job.type == EVTableJob::DiagonalEV) {
+		Diagonal(*models.diagonal, job.mode, job.par[0], job.par[1], job.par[2], job.par[3]);
+		model = models.diagonal;
+	}
+	else if (job.type == EVTableJob::CrosstermsEV) {
+		Crossterms(*models.crossterms, job.mode, job.par[0], job.par[1], job.par[2], job.par[3]);
+		model = models.crossterms;
+	}
+	else {
+		QvdWHRG(*models.vdw, job.par[0], job.par[1], job.par[2]);
+		model = models.vdw;
+	}
+
+	// The text table is committed last and marks the job as done
+	if (binary) {
+		std::string binname = BinaryFileName(job.filename);
+		if (!WriteBinaryTable(binname + ".tmp", job, *model) || !CommitFile(binname + ".tmp", binname))
+			return false;
+	}
+	model->WriteInteractionParameters(job.filename + ".tmp");
+	return CommitFile(job.filename + ".tmp", job.filename);
+}
+
+// Usage: EVTablesGenerator [particle list] [output directory] [-resume] [-binary] [-threads N]
+// -resume     Skip the tables which already exist in the output directory
+// -binary     Also write the tables in the binary format, see WriteBinaryTable()
+// -threads N  Number of threads, all available by default (requires OpenMP)
 int main(int argc, char *argv[])
 {
 	//string inputlist = string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei-withcharm.dat";
 	string inputlist = string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list-all.dat";
-  if (argc > 1)
-    inputlist = string(argv[1]);
+	string directory = "./";
+	bool resume = false, binary = false;
+	int threads = 1;
+#ifdef USE_OPENMP
+	threads = omp_get_max_threads();
+#endif
 
-	ThermalParticleSystem TPS(inputlist);
+	int positional = 0;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "-resume")
+			resume = true;
+		else if (arg == "-binary")
+			binary = true;
+		else if (arg == "-threads" && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (positional == 0) {
+			inputlist = arg;
+			positional++;
+		}
+		else if (positional == 1) {
+			directory = arg;
+			if (directory.size() > 0 && directory[directory.size() - 1] != '/')
+				directory += "/";
+			positional++;
+		}
+		else {
+			printf("**WARNING** Unknown argument %s\n", arg.c_str());
+		}
+	}
+	if (threads < 1)
+		threads = 1;
+
+	vector<EVTableJob> jobs;
 
-  string directory = "./";
-	
 	// arXiv:1512.08046
-	Diagonal(directory + "1512.08046.DiagonalEV.Rm00Rb03.dat", &TPS, 1, 0.3);
-	Diagonal(directory + "1512.08046.DiagonalEV.Bag05.dat", &TPS, 4, 0.5);
+	jobs.push_back(EVTableJob(EVTableJob::DiagonalEV, directory + "1512.08046.DiagonalEV.Rm00Rb03.dat", 1, 0.3));
+	jobs.push_back(EVTableJob(EVTableJob::DiagonalEV, directory + "1512.08046.DiagonalEV.Bag05.dat", 4, 0.5));
 
 	// arXiv:1606.06542
-	Diagonal(directory + "1606.06542.DiagonalEV.sinv.dat", &TPS, 7, 0.49, 0.42);
+	jobs.push_back(EVTableJob(EVTableJob::DiagonalEV, directory + "1606.06542.DiagonalEV.sinv.dat", 7, 0.49, 0.42));
 
 	// arXiv:1609.03975
-	QvdWHRG(directory + "1609.03975.QvdWHRG.dat", &TPS, 0.329, 3.42);
+	jobs.push_back(EVTableJob(EVTableJob::QvdW, directory + "1609.03975.QvdWHRG.dat", 0, 0.329, 3.42, 1.));
 
 	// arXiv:1707.09215
-	QvdWHRG(directory + "1707.09215.QvdWHRG.SandNS.dat", &TPS, 0.329, 3.42, 1./8.);
+	jobs.push_back(EVTableJob(EVTableJob::QvdW, directory + "1707.09215.QvdWHRG.SandNS.dat", 0, 0.329, 3.42, 1. / 8.));
 
 	// arXiv:1708.02852
-	Crossterms(directory + "1708.02852.ImMu.dat", &TPS, 3, CuteHRGHelper::rv(1.), 0.);
+	jobs.push_back(EVTableJob(EVTableJob::CrosstermsEV, directory + "1708.02852.ImMu.dat", 3, CuteHRGHelper::rv(1.), 0.));
 
+	vector<int> pending;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		if (resume && FileExists(jobs[i].filename) && (!binary || FileExists(BinaryFileName(jobs[i].filename)))) {
+			printf("Skipping %s, already done\n", jobs[i].filename.c_str());
+			continue;
+		}
+		pending.push_back(i);
+	}
+	if (threads > static_cast<int>(pending.size()))
+		threads = std::max(static_cast<int>(pending.size()), 1);
 
+	ThermalParticleSystem TPS(inputlist);
+
+	// The models are constructed serially, the constructors apply the list-wide
+	// settings to the shared particle list, the per-thread copies are made with Clone()
+	ThermalModelEVDiagonal diagonal(&TPS);
+	ThermalModelEVCrossterms crossterms(&TPS);
+	ThermalModelVDW vdw(&TPS);
+	vector<EVTableModels> models(threads);
+	for (int i = 0; i < threads; ++i) {
+		models[i].diagonal = diagonal.Clone();
+		models[i].crossterms = crossterms.Clone();
+		models[i].vdw = vdw.Clone();
+	}
+
+	int failed = 0;
+	int npending = pending.size();
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+:failed)
+#endif
+	for (int i = 0; i < npending; ++i) {
+		int tid = 0;
+#ifdef USE_OPENMP
+		tid = omp_get_thread_num();
+#endif
+		const EVTableJob &job = jobs[pending[i]];
+		if (RunJob(job, models[tid], binary)) {
+#ifdef USE_OPENMP
+#pragma omp critical
+#endif
+			printf("Written %s\n", job.filename.c_str());
+		}
+		else {
+#ifdef USE_OPENMP
+#pragma omp critical
+#endif
+			printf("**ERROR** Could not write %s\n", job.filename.c_str());
+			failed++;
+		}
+	}
+
+	for (int i = 0; i < threads; ++i) {
+		delete models[i].diagonal;
+		delete models[i].crossterms;
+		delete models[i].vdw;
+	}
 
-	return 0;
+	return (failed > 0) ? 1 : 0;
 }
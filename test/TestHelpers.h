@@ -0,0 +1,120 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#ifndef THERMALFIST_TESTHELPERS_H
+#define THERMALFIST_TESTHELPERS_H
+
+/**
+ * \file TestHelpers.h
+ * \brief Helpers shared by the unit tests
+ *
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGEV.h"
+#include "HRGVDW.h"
+#include "HRGVDW/ThermalModelVDWCanonicalStrangeness.h"
+#include "gtest/gtest.h"
+
+namespace thermalfist {
+namespace tests {
+
+	/// Expects value to agree with reference within a relative tolerance
+	inline void ExpectClose(double value, double reference, double reltol = 1.e-9, double abstol = 1.e-15) {
+		EXPECT_NEAR(value, reference, reltol * std::abs(reference) + abstol);
+	}
+
+	/// The PDG2014 hadron list shipped with the package, optionally restricted to masses below mcut (GeV)
+	inline ThermalParticleSystem PDG2014List(double mcut = -1.) {
+		return ThermalParticleSystem(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat", true, mcut);
+	}
+
+	/// The PDG2014 hadrons lighter than 1.2 GeV, a list small enough for the expensive models
+	inline ThermalParticleSystem LightHadrons() {
+		return PDG2014List(1.2);
+	}
+
+	/// HRG model types covered by the tests which run over several models
+	enum ModelType { Ideal, EVDiagonal, EVCrossterms, VDW, Canonical, CanonicalStrangeness, CanonicalCharm, EVCanonicalStrangeness, VDWCanonicalStrangeness };
+
+	/**
+	 * Creates the HRG model of a given type with the interactions used across the tests:
+	 * r = 0.3 fm for the EV models, and the nuclear matter QvdW parameters
+	 * between baryons and between antibaryons for the QvdW models.
+	 * The models use quantum statistics except the full canonical model,
+	 * which uses Boltzmann statistics to keep the tests fast.
+	 * The thermal parameters are left at their defaults.
+	 */
+	inline ThermalModelBase* CreateModel(ModelType type, ThermalParticleSystem *TPS)
+	{
+		ThermalModelBase *model = NULL;
+		if (type == Ideal)
+			model = new ThermalModelIdeal(TPS);
+		else if (type == EVDiagonal)
+			model = new ThermalModelEVDiagonal(TPS);
+		else if (type == EVCrossterms)
+			model = new ThermalModelEVCrossterms(TPS);
+		else if (type == VDW)
+			model = new ThermalModelVDW(TPS);
+		else if (type == Canonical)
+			model = new ThermalModelCanonical(TPS);
+		else if (type == CanonicalStrangeness)
+			model = new ThermalModelCanonicalStrangeness(TPS);
+		else if (type == CanonicalCharm)
+			model = new ThermalModelCanonicalCharm(TPS);
+		else if (type == EVCanonicalStrangeness)
+			model = new ThermalModelEVCanonicalStrangeness(TPS);
+		else
+			model = new ThermalModelVDWCanonicalStrangeness(TPS);
+
+		if (type == EVDiagonal || type == EVCrossterms || type == EVCanonicalStrangeness)
+			model->SetRadius(0.3);
+
+		// QvdW interactions between baryons and between antibaryons
+		if (type == VDW || type == VDWCanonicalStrangeness) {
+			for (int i = 0; i < TPS->ComponentsNumber(); ++i) {
+				for (int j = 0; j < TPS->ComponentsNumber(); ++j) {
+					int B1 = TPS->Particle(i).BaryonCharge();
+					int B2 = TPS->Particle(j).BaryonCharge();
+					if ((B1 > 0 && B2 > 0) || (B1 < 0 && B2 < 0)) {
+						model->SetAttraction(i, j, 0.329);
+						model->SetVirial(i, j, 3.42);
+					}
+				}
+			}
+		}
+
+		model->SetStatistics(type != Canonical);
+		return model;
+	}
+
+	/// CreateModel() for a fixed model type, usable as a ThermalModelFitBatch::ModelFactory
+	template <ModelType type>
+	ThermalModelBase* CreateModel(ThermalParticleSystem *TPS) {
+		return CreateModel(type, TPS);
+	}
+
+	/**
+	 * Allocates and frees a block of a given number of doubles filled with NaNs.
+	 * The next allocation of the same size is likely to reuse this memory,
+	 * any of its elements left uninitialized then propagates as a NaN.
+	 */
+	inline void PoisonFreedMemory(size_t size) {
+		std::vector<double> *block = new std::vector<double>(size, std::numeric_limits<double>::quiet_NaN());
+		delete block;
+	}
+
+} // namespace tests
+} // namespace thermalfist
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGEV.h"
+#include "HRGVDW.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// x^2 + y^2 = r^2, x * y = 1
+	class CircleHyperbola : public BroydenEquations {
+	public:
+		CircleHyperbola(double r) : m_R(r) { m_N = 2; }
+		void SetRadius(double r) { m_R = r; }
+		std::vector<double> Equations(const std::vector<double>& x) {
+			std::vector<double> ret(2);
+			ret[0] = x[0] * x[0] + x[1] * x[1] - m_R * m_R;
+			ret[1] = x[0] * x[1] - 1.;
+			return ret;
+		}
+	private:
+		double m_R;
+	};
+
+	TEST(BroydenTest, SolvesNonlinearSystem) {
+		CircleHyperbola eqs(2.);
+		Broyden broyden(&eqs);
+		Broyden::BroydenSolutionCriterium crit(1.e-12);
+		std::vector<double> x = broyden.Solve(std::vector<double>{ 2., 0.3 }, &crit);
+
+		// x = sqrt(2 + sqrt(3)), y = 1/x
+		double xexact = std::sqrt(2. + std::sqrt(3.));
+		EXPECT_LT(broyden.Iterations(), broyden.MaxIterations());
+		EXPECT_NEAR(x[0], xexact, 1.e-10);
+		EXPECT_NEAR(x[1], 1. / xexact, 1.e-10);
+		EXPECT_EQ(broyden.JacobianEvaluations(), 1);
+		EXPECT_EQ(broyden.TotalIterations(), broyden.Iterations());
+	}
+
+	// With Jacobian reuse a sequence of nearby systems is solved to the same accuracy,
+	// the Jacobian is re-evaluated only once many Broyden's updates are accumulated
+	TEST(BroydenTest, JacobianReuse) {
+		CircleHyperbola eqs(2.), eqsfresh(2.);
+		Broyden reuse(&eqs);
+		reuse.ReuseJacobian(true);
+		Broyden::BroydenSolutionCriterium crit(1.e-12);
+
+		const int nsolves = 11;
+		std::vector<double> x{ 2., 0.3 };
+		for (int ir = 0; ir < nsolves; ++ir) {
+			double r = 2. + 0.01 * ir;
+			eqs.SetRadius(r);
+			eqsfresh.SetRadius(r);
+			x = reuse.Solve(x, &crit);
+
+			Broyden fresh(&eqsfresh);
+			std::vector<double> xfresh = fresh.Solve(x, &crit);
+			EXPECT_NEAR(x[0], xfresh[0], 1.e-10);
+			EXPECT_NEAR(x[1], xfresh[1], 1.e-10);
+			EXPECT_NEAR(x[0] * x[1], 1., 1.e-10);
+		}
+		EXPECT_LT(reuse.JacobianEvaluations(), nsolves / 2);
+	}
+
+	// QvdW model with strangeness neutrality and Q/B = 0.4 along a temperature scan at muB = 0.4 GeV.
+	// Reference values for muS, muQ, P, nB, and the pi+, p, and Lambda densities
+	// are computed with the solver which inverted the Jacobian explicitly.
+	// The constraints are also checked directly at the solution.
+	TEST(BroydenTest, ReferenceQvdWConstrainedChemicalPotentials) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		const long long pdgs[3] = { 211, 2212, 3122 };
+		const double Ts[4] = { 0.13, 0.14, 0.15, 0.16 };
+		const double ref[4][7] = {
+			{ 0.069182348825808537, -0.007441212846992026, 0.02362551375694601, 0.056519875777485178, 0.023392662321499419, 0.011328779839791595, 0.0022595415958482769 },
+			{ 0.073284573080781554, -0.0081618342962467717, 0.038513811861266053, 0.083366296423175654, 0.030209412106953337, 0.014461028535650164, 0.0032060221652053379 },
+			{ 0.072411327889031207, -0.0083484861297038662, 0.06006602130650459, 0.10935308272508597, 0.038362485182094577, 0.016369581443950856, 0.0040947954719488594 },
+			{ 0.067413221909945462, -0.008067356306106126, 0.089917623755563156, 0.130807683134469, 0.04799933034174541, 0.016926873641449385, 0.0048115079426300656 }
+		};
+
+		for (int reuse = 0; reuse < 2; ++reuse) {
+			ThermalModelVDW model(&TPS);
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+				for (int j = 0; j < TPS.ComponentsNumber(); ++j) {
+					int B1 = TPS.Particle(i).BaryonCharge();
+					int B2 = TPS.Particle(j).BaryonCharge();
+					if ((B1 > 0 && B2 > 0) || (B1 < 0 && B2 < 0)) {
+						model.SetAttraction(i, j, 0.329);
+						model.SetVirial(i, j, 3.42);
+					}
+				}
+			}
+			model.SetStatistics(true);
+			model.SetSolverJacobianReuse(reuse == 1);
+			model.ConstrainMuS(true);
+			model.ConstrainMuQ(true);
+			model.SetQoverB(0.4);
+			model.SetBaryonChemicalPotential(0.4);
+
+			for (int it = 0; it < 4; ++it) {
+				model.SetTemperature(Ts[it]);
+				model.ConstrainChemicalPotentials();
+				model.CalculateDensities();
+
+				tests::ExpectClose(model.Parameters().muS, ref[it][0]);
+				tests::ExpectClose(model.Parameters().muQ, ref[it][1]);
+				tests::ExpectClose(model.Pressure(), ref[it][2]);
+				tests::ExpectClose(model.BaryonDensity(), ref[it][3]);
+				for (int a = 0; a < 3; ++a)
+					tests::ExpectClose(model.Densities()[TPS.PdgToId(pdgs[a])], ref[it][4 + a]);
+
+				EXPECT_NEAR(model.StrangenessDensity(), 0., 1.e-9 * model.AbsoluteStrangenessDensity());
+				tests::ExpectClose(model.ElectricChargeDensity() / model.BaryonDensity(), 0.4, 1.e-8);
+			}
+		}
+	}
+
+	// Exposes the solved partial pressures and the ideal gas pressures they are solved for
+	class PartialPressuresProbe : public ThermalModelEVCrossterms {
+	public:
+		PartialPressuresProbe(ThermalParticleSystem* TPS) : ThermalModelEVCrossterms(TPS) {}
+		double PartialPressure(int i) const { return m_Ps[i]; }
+		double IdealGasPartialPressure(int i) { return Pressure(i); }
+	};
+
+	// Crossterms EV model with r = 0.5 fm for baryons and r = 0.3 fm for mesons at muB = 0.3 GeV.
+	// Reference values for P, nB, and the pi+, p, and Lambda densities
+	// are computed with the solver which inverted the Jacobian explicitly.
+	// The partial pressures are also checked to solve the system of equations,
+	// p_i = p_i^id(T, mu_i - sum_j b_ij p_j), and to sum up to the total pressure.
+	TEST(BroydenTest, ReferenceEVCrossterms) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		const long long pdgs[3] = { 211, 2212, 3122 };
+		const double Ts[4] = { 0.13, 0.14, 0.15, 0.16 };
+		const double ref[4][5] = {
+			{ 0.017956505623022177, 0.0260045607858061, 0.021152508387706329, 0.0046454024437869992, 0.0014856206012154925 },
+			{ 0.028348728671847789, 0.041158894879815541, 0.025262364518520156, 0.0063108460050409791, 0.0022200555485284465 },
+			{ 0.042993669567039032, 0.058515785238737683, 0.02893593224290059, 0.007728690994414332, 0.0029519350007307563 },
+			{ 0.06257851278655982, 0.075661705205373464, 0.031993685082269789, 0.0086518614875248576, 0.0035498942966436346 }
+		};
+
+		for (int reuse = 0; reuse < 2; ++reuse) {
+			PartialPressuresProbe model(&TPS);
+			std::vector<double> radii(TPS.ComponentsNumber());
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i)
+				radii[i] = (TPS.Particle(i).BaryonCharge() != 0) ? 0.5 : 0.3;
+			model.FillVirial(radii);
+			model.SetStatistics(true);
+			model.SetSolverJacobianReuse(reuse == 1);
+			model.SetBaryonChemicalPotential(0.3);
+
+			ThermalModelBase& base = model;
+			for (int it = 0; it < 4; ++it) {
+				model.SetTemperature(Ts[it]);
+				model.CalculateDensities();
+
+				tests::ExpectClose(base.Pressure(), ref[it][0]);
+				tests::ExpectClose(base.BaryonDensity(), ref[it][1]);
+				for (int a = 0; a < 3; ++a)
+					tests::ExpectClose(model.Densities()[TPS.PdgToId(pdgs[a])], ref[it][2 + a]);
+
+				double Psum = 0.;
+				for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+					EXPECT_NEAR(model.PartialPressure(i), model.IdealGasPartialPressure(i), 1.e-9 * base.Pressure());
+					Psum += model.PartialPressure(i);
+				}
+				tests::ExpectClose(Psum, base.Pressure(), 1.e-9);
+			}
+		}
+	}
+
+}
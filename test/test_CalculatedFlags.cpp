@@ -0,0 +1,123 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "HRGEV/ThermalModelEVDiagonal.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// The values obtained on demand are compared with a freshly set up model
+	// after the setting has been changed
+
+	TEST(CalculatedFlagsTest, StatisticsChange) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelIdeal model(&TPS);
+		model.SetStatistics(true);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.);
+		model.FillChemicalPotentials();
+		double chi2quantum = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+
+		model.SetStatistics(false);
+		double chi2boltzmann = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+		EXPECT_NE(chi2quantum, chi2boltzmann);
+
+		ThermalModelIdeal reference(&TPS);
+		reference.SetStatistics(false);
+		reference.SetTemperature(0.155);
+		reference.SetBaryonChemicalPotential(0.);
+		reference.FillChemicalPotentials();
+		EXPECT_DOUBLE_EQ(chi2boltzmann, reference.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge));
+		EXPECT_DOUBLE_EQ(model.ConservedChargeCumulant(ConservedCharge::BaryonCharge, 2),
+			reference.ConservedChargeCumulant(ConservedCharge::BaryonCharge, 2));
+	}
+
+	TEST(CalculatedFlagsTest, ExcludedVolumeChange) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelEVDiagonal model(&TPS);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.);
+		model.FillChemicalPotentials();
+		double chi2point = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+
+		model.FillVirial(std::vector<double>(TPS.ComponentsNumber(), 0.5));
+		double chi2ev = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+		EXPECT_LT(chi2ev, chi2point);
+
+		ThermalModelEVDiagonal reference(&TPS);
+		reference.FillVirial(std::vector<double>(TPS.ComponentsNumber(), 0.5));
+		reference.SetTemperature(0.155);
+		reference.SetBaryonChemicalPotential(0.);
+		reference.FillChemicalPotentials();
+		EXPECT_DOUBLE_EQ(chi2ev, reference.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge));
+	}
+
+	TEST(CalculatedFlagsTest, ChemicalPotentialsChange) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelIdeal model(&TPS);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.);
+		model.FillChemicalPotentials();
+		double chi2zero = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+
+		ThermalModelIdeal reference(&TPS);
+		reference.SetTemperature(0.155);
+		reference.SetBaryonChemicalPotential(0.300);
+		reference.FillChemicalPotentials();
+
+		model.SetChemicalPotentials(reference.ChemicalPotentials());
+		double chi2 = model.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge);
+		EXPECT_GT(chi2, chi2zero);
+		EXPECT_DOUBLE_EQ(chi2, reference.Susceptibility(ConservedCharge::BaryonCharge, ConservedCharge::BaryonCharge));
+	}
+
+	// The susceptibilities of the ideal gas obtained on demand, without the particle number correlations,
+	// agree with the ones from the full calculation of the fluctuations
+	TEST(CalculatedFlagsTest, LazySusceptibilitiesMatchFluctuations) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		const ConservedCharge::Name charges[3] = { ConservedCharge::BaryonCharge, ConservedCharge::ElectricCharge, ConservedCharge::StrangenessCharge };
+		for (int quantum = 0; quantum < 2; ++quantum) {
+			ThermalModelIdeal model(&TPS), reference(&TPS);
+			ThermalModelIdeal *models[2] = { &model, &reference };
+			for (int im = 0; im < 2; ++im) {
+				models[im]->SetStatistics(quantum == 1);
+				models[im]->SetTemperature(0.155);
+				models[im]->SetBaryonChemicalPotential(0.100);
+				models[im]->SetElectricChemicalPotential(-0.005);
+				models[im]->SetStrangenessChemicalPotential(0.020);
+				models[im]->FillChemicalPotentials();
+			}
+			reference.CalculateDensities();
+			reference.CalculateFluctuations();
+
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 3; ++j) {
+					double ref = reference.Susc(charges[i], charges[j]);
+					EXPECT_NEAR(model.Susceptibility(charges[i], charges[j]), ref, 1.e-12 * std::abs(ref) + 1.e-15)
+						<< "quantum " << quantum << ", " << i << " " << j;
+				}
+			}
+
+			model.CalculateSusceptibilityMatrix();
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 3; ++j) {
+					double ref = reference.Susc(charges[i], charges[j]);
+					EXPECT_NEAR(model.Susc(charges[i], charges[j]), ref, 1.e-12 * std::abs(ref) + 1.e-15)
+						<< "quantum " << quantum << ", " << i << " " << j;
+				}
+			}
+		}
+	}
+
+}
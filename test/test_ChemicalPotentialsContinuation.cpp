@@ -0,0 +1,96 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	void SetUpModel(ThermalModelBase& model) {
+		model.SetUseWidth(ThermalParticle::ZeroWidth);
+		model.SetStatistics(true);
+		model.SetQoverB(0.4);
+		model.ConstrainMuQ(true);
+		model.ConstrainMuS(true);
+	}
+
+	void ExpectSameSolution(const ThermalModelBase& model, const ThermalModelBase& reference) {
+		EXPECT_NEAR(model.Parameters().muQ, reference.Parameters().muQ, 1.e-6);
+		EXPECT_NEAR(model.Parameters().muS, reference.Parameters().muS, 1.e-6);
+	}
+
+	// Continuation along a short T-muB path, compared with the full solution at each point
+	TEST(ChemicalPotentialsContinuationTest, TmuBPath) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelIdeal model(&TPS), reference(&TPS);
+		SetUpModel(model);
+		SetUpModel(reference);
+		model.SetChemicalPotentialsContinuation(true);
+
+		const int steps = 10;
+		for (int i = 0; i <= steps; ++i) {
+			double T = 0.150 + 0.010 * i / steps;
+			// The second half of the path is at fixed T
+			if (i > steps / 2)
+				T = 0.155;
+			double muB = 0.100 + 0.200 * i / steps;
+
+			// The Q/B ratio changes midway, which discards the stored solution
+			if (i == steps / 2) {
+				model.SetQoverB(0.45);
+				reference.SetQoverB(0.45);
+			}
+
+			model.SetTemperature(T);
+			model.SetBaryonChemicalPotential(muB);
+			model.ConstrainChemicalPotentials(false);
+
+			reference.SetTemperature(T);
+			reference.SetBaryonChemicalPotential(muB);
+			reference.ConstrainChemicalPotentials(true);
+
+			ExpectSameSolution(model, reference);
+		}
+	}
+
+	// Continuation in T for a model where the derivatives of the densities are evaluated by finite differences,
+	// the densities after the continuation are the ones at the new point
+	TEST(ChemicalPotentialsContinuationTest, TPathFiniteDifferenceDerivatives) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		ThermalModelBase *model = tests::CreateModel(tests::EVDiagonal, &TPS);
+		ThermalModelBase *reference = tests::CreateModel(tests::EVDiagonal, &TPS);
+		SetUpModel(*model);
+		SetUpModel(*reference);
+		model->SetChemicalPotentialsContinuation(true);
+
+		for (int i = 0; i <= 4; ++i) {
+			double T = 0.140 + 0.005 * i;
+			model->SetTemperature(T);
+			model->SetBaryonChemicalPotential(0.200);
+			model->ConstrainChemicalPotentials(false);
+			model->CalculateDensities();
+
+			reference->SetTemperature(T);
+			reference->SetBaryonChemicalPotential(0.200);
+			reference->ConstrainChemicalPotentials(true);
+			reference->CalculateDensities();
+
+			ExpectSameSolution(*model, *reference);
+			for (int j = 0; j < TPS.ComponentsNumber(); ++j)
+				EXPECT_NEAR(model->Densities()[j], reference->Densities()[j], 1.e-5 * reference->Densities()[j]) << "T = " << T << ", particle " << j;
+		}
+
+		delete model;
+		delete reference;
+	}
+
+}
@@ -0,0 +1,134 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <vector>
+#include "HRGBase.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	double GetParameter(const ThermalModelBase& model, ThermalParameter::Name param) {
+		const ThermalModelParameters& pars = model.Parameters();
+		switch (param) {
+			case ThermalParameter::Temperature: return pars.T;
+			case ThermalParameter::BaryonChemicalPotential: return pars.muB;
+			case ThermalParameter::ElectricChemicalPotential: return pars.muQ;
+			case ThermalParameter::StrangenessChemicalPotential: return pars.muS;
+			case ThermalParameter::CharmChemicalPotential: return pars.muC;
+			case ThermalParameter::Gammaq: return pars.gammaq;
+			case ThermalParameter::GammaS: return pars.gammaS;
+			default: return pars.gammaC;
+		}
+	}
+
+	void SetParameter(ThermalModelBase& model, ThermalParameter::Name param, double value) {
+		switch (param) {
+			case ThermalParameter::Temperature: model.SetTemperature(value); break;
+			case ThermalParameter::BaryonChemicalPotential: model.SetBaryonChemicalPotential(value); break;
+			case ThermalParameter::ElectricChemicalPotential: model.SetElectricChemicalPotential(value); break;
+			case ThermalParameter::StrangenessChemicalPotential: model.SetStrangenessChemicalPotential(value); break;
+			case ThermalParameter::CharmChemicalPotential: model.SetCharmChemicalPotential(value); break;
+			case ThermalParameter::Gammaq: model.SetGammaq(value); break;
+			case ThermalParameter::GammaS: model.SetGammaS(value); break;
+			default: model.SetGammaC(value);
+		}
+	}
+
+	void SetupModel(ThermalModelBase& model) {
+		model.SetUseWidth(ThermalParticle::ZeroWidth);
+		model.SetStatistics(true);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.100);
+		model.SetElectricChemicalPotential(-0.005);
+		model.SetStrangenessChemicalPotential(0.020);
+		model.SetGammaq(1.1);
+		model.SetGammaS(0.9);
+		model.SetQoverB(0.4);
+	}
+
+	// The analytic derivatives of the primordial and final densities agree with central finite differences.
+	// With the strangeness neutrality and Q/B constraints the derivatives include the implicit dependence
+	// through muS and muQ, and vanish with respect to the input values of muS and muQ themselves.
+	void CheckDerivatives(bool constrained) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		ThermalModelIdeal model(&TPS);
+		SetupModel(model);
+		model.ConstrainMuS(constrained);
+		model.ConstrainMuQ(constrained);
+		model.ConstrainChemicalPotentials();
+		model.CalculateDensities();
+
+		const long long pdgs[] = { 211, -211, 321, -321, 2212, -2212, 3122, 3312 };
+		const int npdgs = sizeof(pdgs) / sizeof(pdgs[0]);
+		const Feeddown::Type feeddowns[2] = { Feeddown::Primordial, Feeddown::StabilityFlag };
+		const ThermalParameter::Name params[] = {
+			ThermalParameter::Temperature, ThermalParameter::BaryonChemicalPotential,
+			ThermalParameter::ElectricChemicalPotential, ThermalParameter::StrangenessChemicalPotential,
+			ThermalParameter::Gammaq, ThermalParameter::GammaS };
+		const int nparams = sizeof(params) / sizeof(params[0]);
+
+		ASSERT_TRUE(model.CalculateDensitiesDerivatives());
+		std::vector<double> analytic;
+		for (int ip = 0; ip < nparams; ++ip)
+			for (int ifd = 0; ifd < 2; ++ifd)
+				for (int a = 0; a < npdgs; ++a)
+					analytic.push_back(model.GetDensityDerivative(pdgs[a], feeddowns[ifd], params[ip]));
+
+		const double h = 1.e-4;
+		int ind = 0;
+		for (int ip = 0; ip < nparams; ++ip) {
+			double value = GetParameter(model, params[ip]);
+			std::vector<double> densities[2];
+			for (int k = 0; k < 2; ++k) {
+				ThermalModelIdeal varied(&TPS);
+				SetupModel(varied);
+				varied.ConstrainMuS(constrained);
+				varied.ConstrainMuQ(constrained);
+				SetParameter(varied, params[ip], value + (2 * k - 1) * h);
+				varied.ConstrainChemicalPotentials();
+				varied.CalculateDensities();
+				for (int ifd = 0; ifd < 2; ++ifd)
+					for (int a = 0; a < npdgs; ++a)
+						densities[k].push_back(varied.GetDensity(pdgs[a], feeddowns[ifd]));
+			}
+
+			// Tolerance for the accuracy of the densities and the constrained chemical potentials,
+			// and for the O(h^2) truncation error of the finite differences
+			for (size_t i = 0; i < densities[0].size(); ++i, ++ind) {
+				double numeric = (densities[1][i] - densities[0][i]) / (2. * h);
+				double scale = densities[1][i] + densities[0][i];
+				EXPECT_NEAR(analytic[ind], numeric, 1.e-10 * scale / h + 1.e-5 * std::abs(numeric))
+					<< "parameter " << params[ip] << ", entry " << i;
+			}
+		}
+	}
+
+	TEST(DensitiesDerivativesTest, MatchFiniteDifferences) {
+		CheckDerivatives(false);
+	}
+
+	TEST(DensitiesDerivativesTest, MatchFiniteDifferencesWithConstraints) {
+		CheckDerivatives(true);
+	}
+
+	// The implicit dependence through the entropy per baryon constraint is not supported
+	TEST(DensitiesDerivativesTest, NotAvailableWithEntropyPerBaryonConstraint) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		ThermalModelIdeal model(&TPS);
+		SetupModel(model);
+		model.ConstrainMuB(true);
+		model.SetSoverB(50.);
+		model.ConstrainChemicalPotentials();
+		model.CalculateDensities();
+		EXPECT_FALSE(model.CalculateDensitiesDerivatives());
+	}
+
+}
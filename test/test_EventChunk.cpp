@@ -0,0 +1,166 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "HRGEventGenerator/SphericalBlastWaveEventGenerator.h"
+#include "HRGEventGenerator/EventChunk.h"
+#include "HRGEventGenerator/SpectraAnalysis.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	class EventChunkTest : public ::testing::Test {
+	protected:
+		EventChunkTest() :
+			TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat"),
+			model(&TPS)
+		{
+			model.SetTemperature(0.155);
+			model.SetBaryonChemicalPotential(0.);
+			model.SetVolume(50.);
+			config.fEnsemble = EventGeneratorConfiguration::GCE;
+			config.fModelType = EventGeneratorConfiguration::PointParticle;
+			config.CFOParameters = model.Parameters();
+		}
+
+		ThermalParticleSystem TPS;
+		ThermalModelIdeal model;
+		EventGeneratorConfiguration config;
+	};
+
+	void ExpectSameParticles(const SimpleEvent& a, const SimpleEvent& b) {
+		ASSERT_EQ(a.Particles.size(), b.Particles.size());
+		EXPECT_EQ(a.weight, b.weight);
+		for (size_t i = 0; i < a.Particles.size(); ++i) {
+			EXPECT_EQ(a.Particles[i].PDGID, b.Particles[i].PDGID);
+			EXPECT_EQ(a.Particles[i].px, b.Particles[i].px);
+			EXPECT_EQ(a.Particles[i].py, b.Particles[i].py);
+			EXPECT_EQ(a.Particles[i].pz, b.Particles[i].pz);
+			EXPECT_EQ(a.Particles[i].m, b.Particles[i].m);
+		}
+	}
+
+	// Same seed, the events generated one by one and in a chunk are identical
+	TEST_F(EventChunkTest, ProcessChunkMatchesProcessEvent) {
+		SphericalBlastWaveEventGenerator generator(&TPS, config, 0.100, 0.5);
+		const int nevents = 200;
+
+		RandomGenerators::SetSeed(1);
+		std::vector<SimpleEvent> events;
+		SpectraAnalysis byevent(&TPS);
+		for (int i = 0; i < nevents; ++i) {
+			events.push_back(generator.GetEvent());
+			byevent.ProcessEvent(events.back());
+		}
+
+		RandomGenerators::SetSeed(1);
+		EventChunk chunk;
+		generator.GenerateChunk(chunk, nevents);
+		ASSERT_EQ(chunk.NumberOfEvents(), nevents);
+		for (int k = 0; k < nevents; ++k)
+			ExpectSameParticles(chunk.GetEvent(k), events[k]);
+
+		SpectraAnalysis bychunk(&TPS);
+		bychunk.ProcessChunk(chunk);
+		ASSERT_EQ(bychunk.Events(), byevent.Events());
+		for (int ind = 0; ind < byevent.NumberOfSpecies(); ++ind) {
+			EXPECT_EQ(bychunk.MeanMultiplicity(ind), byevent.MeanMultiplicity(ind));
+			EXPECT_EQ(bychunk.ScaledVariance(ind), byevent.ScaledVariance(ind));
+			EXPECT_EQ(bychunk.MeanPt(ind), byevent.MeanPt(ind));
+			EXPECT_EQ(bychunk.GetSpecies(ind).dndpt.GetYVector(), byevent.GetSpecies(ind).dndpt.GetYVector());
+			EXPECT_EQ(bychunk.GetSpecies(ind).d2ndptdy.GetZVector(), byevent.GetSpecies(ind).d2ndptdy.GetZVector());
+		}
+	}
+
+	// Refilling a chunk reuses its memory
+	TEST_F(EventChunkTest, MemoryUsageOnRefill) {
+		SphericalBlastWaveEventGenerator generator(&TPS, config, 0.100, 0.5);
+		EventChunk::Config chunkconfig;
+		chunkconfig.StoreDecayHistory = true;
+		EventChunk chunk(chunkconfig);
+		const int nevents = 50;
+
+		RandomGenerators::SetSeed(1);
+		generator.GenerateChunk(chunk, nevents);
+		size_t particles = chunk.EventOffset(chunk.NumberOfEvents());
+		ASSERT_GT(particles, 0u);
+
+		// Same events, no reallocation
+		size_t memory = chunk.MemoryUsage();
+		for (int iter = 0; iter < 3; ++iter) {
+			RandomGenerators::SetSeed(1);
+			generator.GenerateChunk(chunk, nevents);
+			EXPECT_EQ(chunk.MemoryUsage(), memory);
+		}
+
+		// Different events within the reserved capacity
+		chunk.Reserve(nevents, 2 * particles);
+		memory = chunk.MemoryUsage();
+		for (int iter = 0; iter < 5; ++iter) {
+			generator.GenerateChunk(chunk, nevents);
+			ASSERT_LE(chunk.EventOffset(chunk.NumberOfEvents()), 2 * particles);
+			EXPECT_EQ(chunk.MemoryUsage(), memory);
+		}
+
+		chunk.Release();
+		EXPECT_LT(chunk.MemoryUsage(), memory);
+		EXPECT_EQ(chunk.NumberOfEvents(), 0);
+	}
+
+	TEST_F(EventChunkTest, PrimordialPDGID) {
+		SphericalBlastWaveEventGenerator generator(&TPS, config, 0.100, 0.5);
+		EventChunk::Config chunkconfig;
+		chunkconfig.StoreDecayHistory = true;
+		EventChunk chunk(chunkconfig);
+
+		// Decays performed, the primordial ancestor is taken from the decay map
+		RandomGenerators::SetSeed(1);
+		SimpleEvent evt = generator.GetEvent(true);
+		ASSERT_EQ(evt.DecayMapFinal.size(), evt.Particles.size());
+		chunk.AddEvent(evt);
+
+		// No decays, each particle is primordial
+		SimpleEvent evtprim = generator.GetEvent(false);
+		chunk.AddEvent(evtprim);
+
+		// Event constructed by hand, no decay map
+		SimpleEvent evtuser;
+		evtuser.Particles.push_back(SimpleParticle(0.1, 0.2, 0.3, 0.13957, 211));
+		evtuser.Particles.push_back(SimpleParticle(0.3, 0.2, 0.1, 0.938272, -2212));
+		chunk.AddEvent(evtuser);
+
+		const EventChunk::Particles& parts = chunk.FinalParticles();
+		ASSERT_EQ(parts.PrimordialPDGID.size(), parts.Size());
+
+		bool hasfeeddown = false;
+		for (size_t i = chunk.EventOffset(0); i < chunk.EventOffset(1); ++i) {
+			const SimpleParticle& part = evt.Particles[i - chunk.EventOffset(0)];
+			EXPECT_EQ(parts.PrimordialPDGID[i], evt.AllParticles[evt.DecayMapFinal[i - chunk.EventOffset(0)]].PDGID);
+			EXPECT_NE(parts.PrimordialPDGID[i], 0);
+			if (part.MotherPDGID == 0)
+				EXPECT_EQ(parts.PrimordialPDGID[i], part.PDGID);
+			else
+				hasfeeddown = true;
+		}
+		EXPECT_TRUE(hasfeeddown);
+
+		for (int k = 1; k < 3; ++k) {
+			ASSERT_GT(chunk.EventSize(k), 0u);
+			for (size_t i = chunk.EventOffset(k); i < chunk.EventOffset(k + 1); ++i) {
+				EXPECT_EQ(parts.PrimordialPDGID[i], parts.PDGID[i]);
+				EXPECT_EQ(parts.MotherPDGID[i], 0);
+				EXPECT_EQ(parts.Epoch[i], 0);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "HRGEventGenerator/SphericalBlastWaveEventGenerator.h"
+#include "gtest/gtest.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace thermalfist;
+
+namespace {
+
+	// User-defined generator overriding only GetMomentum(double), all particles at rest
+	class AtRestMomentumGenerator : public RandomGenerators::SiemensRasmussenMomentumGeneratorGeneralized
+	{
+	public:
+		AtRestMomentumGenerator(double T, double beta, double mass) :
+			RandomGenerators::SiemensRasmussenMomentumGeneratorGeneralized(T, beta, mass) { }
+
+		using RandomGenerators::SiemensRasmussenMomentumGeneratorGeneralized::GetMomentum;
+
+		std::vector<double> GetMomentum(double /*mass*/) const { return std::vector<double>(7, 0.); }
+
+		// Required, the parallel sampling would bypass GetMomentum(double) otherwise
+		bool SupportsRandomGenerator() const { return false; }
+	};
+
+	class AtRestPionsEventGenerator : public SphericalBlastWaveEventGenerator
+	{
+	public:
+		AtRestPionsEventGenerator(ThermalParticleSystem* TPS, const EventGeneratorConfiguration& config) :
+			SphericalBlastWaveEventGenerator(TPS, config, 0.100, 0.5)
+		{
+			int id = TPS->PdgToId(211);
+			delete m_MomentumGens[id];
+			m_MomentumGens[id] = new AtRestMomentumGenerator(0.100, 0.5, TPS->Particles()[id].Mass());
+		}
+	};
+
+	class EventGeneratorBaseTest : public ::testing::Test {
+	protected:
+		EventGeneratorBaseTest() :
+			TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat"),
+			model(&TPS)
+		{
+			model.SetTemperature(0.155);
+			model.SetBaryonChemicalPotential(0.);
+			// Large enough for several blocks of pions in the parallel sampling
+			model.SetVolume(30000.);
+			config.fEnsemble = EventGeneratorConfiguration::GCE;
+			config.fModelType = EventGeneratorConfiguration::PointParticle;
+			config.CFOParameters = model.Parameters();
+		}
+
+		ThermalParticleSystem TPS;
+		ThermalModelIdeal model;
+		EventGeneratorConfiguration config;
+	};
+
+	void ExpectSameEvents(const SimpleEvent& a, const SimpleEvent& b) {
+		ASSERT_EQ(a.Particles.size(), b.Particles.size());
+		for (size_t i = 0; i < a.Particles.size(); ++i) {
+			EXPECT_EQ(a.Particles[i].PDGID, b.Particles[i].PDGID);
+			EXPECT_EQ(a.Particles[i].px, b.Particles[i].px);
+			EXPECT_EQ(a.Particles[i].py, b.Particles[i].py);
+			EXPECT_EQ(a.Particles[i].pz, b.Particles[i].pz);
+			EXPECT_EQ(a.Particles[i].m, b.Particles[i].m);
+		}
+	}
+
+	// With the parallel sampling the events do not depend on the number of threads
+	TEST_F(EventGeneratorBaseTest, ThreadCountIndependence) {
+		SphericalBlastWaveEventGenerator generator(&TPS, config, 0.100, 0.5);
+		generator.SetOMP(true);
+		const int nevents = 2;
+		const int threads[] = { 1, 2, 8 };
+
+		std::vector<SimpleEvent> reference;
+		for (int it = 0; it < 3; ++it) {
+#ifdef USE_OPENMP
+			omp_set_num_threads(threads[it]);
+#endif
+			RandomGenerators::SetSeed(1);
+			for (int i = 0; i < nevents; ++i) {
+				SimpleEvent evt = generator.GetEvent();
+				if (it == 0)
+					reference.push_back(evt);
+				else
+					ExpectSameEvents(evt, reference[i]);
+			}
+		}
+	}
+
+	// A generator not supporting a separate random number generator is sampled serially with GetMomentum(double)
+	TEST_F(EventGeneratorBaseTest, GetMomentumOverride) {
+		AtRestPionsEventGenerator generator(&TPS, config);
+		generator.SetOMP(true);
+		RandomGenerators::SetSeed(1);
+		SimpleEvent evt = generator.GetEvent(false);
+		int pions = 0;
+		for (size_t i = 0; i < evt.Particles.size(); ++i) {
+			const SimpleParticle& part = evt.Particles[i];
+			if (part.PDGID == 211) {
+				pions++;
+				EXPECT_EQ(part.px, 0.);
+				EXPECT_EQ(part.py, 0.);
+				EXPECT_EQ(part.pz, 0.);
+			}
+		}
+		EXPECT_GT(pions, 1000);
+
+		generator.SetOMP(false);
+		RandomGenerators::SetSeed(1);
+		ExpectSameEvents(generator.GetEvent(false), evt);
+	}
+
+}
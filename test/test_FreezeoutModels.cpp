@@ -0,0 +1,116 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include "HRGEventGenerator/FreezeoutModels.h"
+#include "HRGEventGenerator/RandomGenerators.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Exact moments of the blast-wave \zeta distribution with n = 1, p(\zeta) ~ \zeta / sqrt(1 - beta^2 \zeta^2)
+	void ExactMoments(double beta, double& zeta, double& zeta2) {
+		if (beta == 0.) {
+			zeta = 2. / 3.;
+			zeta2 = 1. / 2.;
+			return;
+		}
+		double a = beta * beta, s = sqrt(1. - a);
+		double norm = (1. - s) / a;
+		double m1 = (asin(beta) - beta * s) / (2. * a * beta);
+		double m2 = (4. / 3. - 2. * s + 2. / 3. * s * s * s) / (2. * a * a);
+		zeta = m1 / norm;
+		zeta2 = m2 / norm;
+	}
+
+	TEST(FreezeoutModelsTest, TabulatedZetaMoments) {
+		const double betas[] = { 0., 0.5, 0.8 };
+		for (int ib = 0; ib < 3; ++ib) {
+			CylindricalBlastWaveParametrization model(betas[ib], 1.);
+			model.TabulateZetaDistribution();
+			ASSERT_TRUE(model.IsZetaDistributionTabulated());
+
+			double zetaex, zeta2ex;
+			ExactMoments(betas[ib], zetaex, zeta2ex);
+
+			// Stratified in xi, probes the tabulation itself
+			const int N = 100000;
+			double zeta = 0., zeta2 = 0.;
+			for (int k = 0; k < N; ++k) {
+				double z = model.InverseZetaDistributionTabulated((k + 0.5) / N);
+				zeta += z / N;
+				zeta2 += z * z / N;
+			}
+			EXPECT_NEAR(zeta, zetaex, 1.e-5);
+			EXPECT_NEAR(zeta2, zeta2ex, 1.e-5);
+
+			// Random sample, within 5 standard deviations
+			MTRand rangen(1);
+			const int Nrand = 1000000;
+			zeta = zeta2 = 0.;
+			for (int k = 0; k < Nrand; ++k) {
+				double z = model.InverseZetaDistributionTabulated(rangen.randExc());
+				zeta += z / Nrand;
+				zeta2 += z * z / Nrand;
+			}
+			EXPECT_NEAR(zeta, zetaex, 5. * sqrt((zeta2ex - zetaex * zetaex) / Nrand));
+			EXPECT_NEAR(zeta2, zeta2ex, 5. * sqrt(zeta2ex / Nrand));
+		}
+	}
+
+	TEST(FreezeoutModelsTest, TabulatedZetaEndpoints) {
+		CylindricalBlastWaveParametrization model(0.8, 1.);
+		model.TabulateZetaDistribution(50);
+
+		EXPECT_EQ(model.InverseZetaDistributionTabulated(0.), 0.);
+
+		const double xis[] = { 1. - 1.e-6, 1. - 1.e-12, 1. - 1.e-16, 1. };
+		for (int i = 0; i < 4; ++i) {
+			double zeta = model.InverseZetaDistributionTabulated(xis[i]);
+			EXPECT_LE(zeta, 1.);
+			EXPECT_GT(zeta, 0.999);
+		}
+
+		// Monotonic across all the intervals
+		double prev = 0.;
+		for (int k = 1; k <= 10000; ++k) {
+			double zeta = model.InverseZetaDistributionTabulated(k / 10000.);
+			EXPECT_GE(zeta, prev);
+			prev = zeta;
+		}
+		EXPECT_DOUBLE_EQ(prev, 1.);
+	}
+
+	// A profile whose zeta distribution cannot be tabulated, counts the evaluations of the maximum
+	class UntabulatedProfile : public BoostInvariantFreezeoutParametrization {
+	public:
+		UntabulatedProfile(int *calls) : m_Calls(calls) { }
+		virtual double ZetaProbability(double /*zeta*/) const { return 0.; }
+	protected:
+		virtual double ComputeProbabilitydMaximum() {
+			(*m_Calls)++;
+			return BoostInvariantFreezeoutParametrization::ComputeProbabilitydMaximum();
+		}
+	private:
+		int *m_Calls;
+	};
+
+	// With the fallback to the rejection sampling the maximum is computed by the generator constructor,
+	// before the sampling which may be done in parallel
+	TEST(FreezeoutModelsTest, RejectionSamplingMaximumComputedEagerly) {
+		int calls = 0;
+		UntabulatedProfile *profile = new UntabulatedProfile(&calls);
+		RandomGenerators::BoostInvariantMomentumGenerator generator(profile, 0.100, 1., 0.938);
+		EXPECT_FALSE(profile->IsZetaDistributionTabulated());
+		EXPECT_EQ(calls, 1);
+		profile->ProbabilityMaximum();
+		EXPECT_EQ(calls, 1);
+	}
+
+}
@@ -171,4 +171,54 @@ namespace {
 		EXPECT_LT(abs(IdealGasFunctions::QuantumNumericalIntegrationDensity(-1, 1.000, 0.137, 0.138, 1) / xMath::GeVtoifm3() - MathematicaRef) / MathematicaRef, accuracy);
 	}
 
-}
\ No newline at end of file
+	TEST(IdealGasTest, TemperatureDerivative) {
+		// Cross-checking the temperature derivative of the density against finite differences
+		double accuracy = 1.e-5;
+		double dT = 1.e-5;
+
+		double T = 0.155, mus[] = { 0.000, 0.300, 1.000 };
+		int stats[] = { 0, 1, -1 };
+		IdealGasFunctions::QStatsCalculationType types[] = { IdealGasFunctions::ClusterExpansion, IdealGasFunctions::Quadratures };
+		for (int it = 0; it < 2; ++it) {
+			for (int is = 0; is < 3; ++is) {
+				for (int im = 0; im < 3; ++im) {
+					// No Bose condensation
+					double m = (stats[is] == -1) ? 0.138 : 0.938;
+					double mu = (stats[is] == -1) ? mus[im] * 0.1 : mus[im];
+					int order = 5;
+					double ref = (IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, types[it], stats[is], T + dT, mu, m, 4, order)
+						- IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::ParticleDensity, types[it], stats[is], T - dT, mu, m, 4, order)) / 2. / dT;
+					double val = IdealGasFunctions::IdealGasQuantity(IdealGasFunctions::dndT, types[it], stats[is], T, mu, m, 4, order);
+					EXPECT_LT(abs(val - ref) / ref, accuracy);
+				}
+			}
+		}
+	}
+
+	TEST(IdealGasTest, AdaptiveAccuracy) {
+		// The adaptive method should reproduce the quadratures within the requested accuracy
+		double T = 0.155, ms[] = { 0.494, 0.938, 1.500 }, dmus[] = { -1.000, -0.300 };
+		int stats[] = { 1, -1 };
+		double tolerances[] = { 1.e-3, 1.e-4, 1.e-6 };
+		IdealGasFunctions::Quantity quantities[] = { IdealGasFunctions::ParticleDensity, IdealGasFunctions::Pressure, IdealGasFunctions::EnergyDensity, IdealGasFunctions::chi2, IdealGasFunctions::chi4 };
+		for (int it = 0; it < 3; ++it) {
+			for (int is = 0; is < 2; ++is) {
+				for (int im = 0; im < 3; ++im) {
+					for (int imu = 0; imu < 2; ++imu) {
+						for (int iq = 0; iq < 5; ++iq) {
+							double mu = ms[im] + dmus[imu];
+							double ref = IdealGasFunctions::IdealGasQuantity(quantities[iq], IdealGasFunctions::Quadratures, stats[is], T, mu, ms[im], 1);
+							double val = IdealGasFunctions::IdealGasQuantity(quantities[iq], IdealGasFunctions::Adaptive, stats[is], T, mu, ms[im], 1, 1, tolerances[it]);
+							EXPECT_LT(abs(val - ref) / ref, tolerances[it]);
+						}
+					}
+				}
+			}
+		}
+
+		// Heavy particles far from degeneracy are treated as Maxwell-Boltzmann
+		EXPECT_EQ(IdealGasFunctions::SelectQStatsMethod(IdealGasFunctions::ParticleDensity, 1, T, 0., 2.000, 1.e-4).type, IdealGasFunctions::MethodBoltzmann);
+		// Quadratures are used for mu > m
+		EXPECT_EQ(IdealGasFunctions::SelectQStatsMethod(IdealGasFunctions::ParticleDensity, 1, T, 1.000, 0.938, 1.e-4).type, IdealGasFunctions::MethodQuadratures);
+	}
+}
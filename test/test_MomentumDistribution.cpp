@@ -0,0 +1,116 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <vector>
+#include "HRGEventGenerator/MomentumDistribution.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	const double mpi = 0.13957, mK = 0.493677, mp = 0.938272;
+
+	BoostInvariantMomentumDistribution* BlastWave(int pdgid, double mass, double betaS, bool norm = false) {
+		return new BoostInvariantMomentumDistribution(new CylindricalBlastWaveParametrization(betaS, 1., 10., 6.), pdgid, mass, 0.100, 0.5, norm);
+	}
+
+	std::vector<double> PtValues() {
+		std::vector<double> ret;
+		for (int i = 0; i <= 40; ++i)
+			ret.push_back(0.05 * i);
+		return ret;
+	}
+
+	double dndpt(const BoostInvariantMomentumDistribution* distr, double mass, double pt) {
+		return pt * distr->dnmtdmt(sqrt(pt * pt + mass * mass));
+	}
+
+	void ExpectSameValue(double a, double b) {
+		EXPECT_NEAR(a, b, 1.e-12 * std::abs(b));
+	}
+
+	// The batched functions agree with the pointwise ones
+	TEST(MomentumDistributionTest, BatchedMatchesPointwise) {
+		std::vector<double> pts = PtValues();
+		const int pdgs[] = { 211, 321, 2212 };
+		const double masses[] = { mpi, mK, mp };
+		for (int im = 0; im < 3; ++im) {
+			BoostInvariantMomentumDistribution* distr = BlastWave(pdgs[im], masses[im], 0.6);
+
+			std::vector<double> mts(pts.size());
+			for (size_t i = 0; i < pts.size(); ++i)
+				mts[i] = sqrt(pts[i] * pts[i] + masses[im] * masses[im]);
+			std::vector<double> dnmtdmt = distr->dnmtdmt(mts);
+			ASSERT_EQ(dnmtdmt.size(), mts.size());
+			for (size_t i = 0; i < mts.size(); ++i)
+				ExpectSameValue(dnmtdmt[i], distr->dnmtdmt(mts[i]));
+
+			const double ys[] = { 0., 0.4, 1.5 };
+			for (int iy = 0; iy < 3; ++iy) {
+				std::vector<double> d2ndptdy = distr->d2ndptdy(pts, ys[iy]);
+				ASSERT_EQ(d2ndptdy.size(), pts.size());
+				for (size_t i = 0; i < pts.size(); ++i)
+					ExpectSameValue(d2ndptdy[i], distr->d2ndptdy(pts[i], ys[iy]));
+			}
+
+			delete distr;
+		}
+	}
+
+	// Spectra of several species, including two different freeze-out profiles and an empty entry
+	TEST(MomentumDistributionTest, CalculatePtSpectra) {
+		std::vector<double> pts = PtValues();
+		std::vector<const BoostInvariantMomentumDistribution*> distrs;
+		distrs.push_back(BlastWave(211, mpi, 0.6));
+		distrs.push_back(BlastWave(321, mK, 0.6));
+		distrs.push_back(NULL);
+		distrs.push_back(BlastWave(2212, mp, 0.6));
+		distrs.push_back(BlastWave(2212, mp, 0.4));
+		const double masses[] = { mpi, mK, 0., mp, mp };
+
+		for (int omp = 0; omp < 2; ++omp) {
+			std::vector< std::vector<double> > spectra = BoostInvariantMomentumDistribution::CalculatePtSpectra(distrs, pts, omp == 1);
+			ASSERT_EQ(spectra.size(), distrs.size());
+			for (size_t ind = 0; ind < distrs.size(); ++ind) {
+				if (distrs[ind] == NULL) {
+					EXPECT_TRUE(spectra[ind].empty());
+					continue;
+				}
+				ASSERT_EQ(spectra[ind].size(), pts.size());
+				for (size_t i = 0; i < pts.size(); ++i)
+					ExpectSameValue(spectra[ind][i], dndpt(distrs[ind], masses[ind], pts[i]));
+			}
+		}
+
+		for (size_t ind = 0; ind < distrs.size(); ++ind)
+			delete distrs[ind];
+	}
+
+	// The rapidity integral of d2ndptdy equals dndpt for the normalized distribution.
+	// Without the normalization it carries the factors documented in d2ndptdy():
+	// 2 from the single fireball and 2 etamax from the space-time rapidities.
+	TEST(MomentumDistributionTest, d2ndptdyRapidityIntegral) {
+		const double etamax = 0.5;
+		const double pts[] = { 0.2, 1.0, 2.5 };
+		for (int norm = 0; norm < 2; ++norm) {
+			BoostInvariantMomentumDistribution* distr = BlastWave(2212, mp, 0.6, norm == 1);
+			double factor = (norm == 1) ? 1. : 2. * 2. * etamax;
+			for (int i = 0; i < 3; ++i) {
+				double integral = 0.;
+				const double dy = 0.01;
+				for (double y = -15.; y <= 15. + 1.e-9; y += dy)
+					integral += distr->d2ndptdy(pts[i], y) * dy;
+				EXPECT_GT(integral, 0.);
+				EXPECT_NEAR(integral, factor * dndpt(distr, mp, pts[i]), 1.e-6 * integral) << "norm = " << norm << ", pT = " << pts[i];
+			}
+			delete distr;
+		}
+	}
+
+}
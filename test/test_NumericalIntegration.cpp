@@ -0,0 +1,107 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "HRGBase/NumericalIntegration.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	typedef std::complex<double> cd;
+
+	// Direct evaluation of the multi-dimensional DFT, row-major
+	std::vector<cd> DirectDFT(const std::vector<cd>& data, const std::vector<int>& dims, bool inverse)
+	{
+		const double pi = 3.14159265358979323846;
+		int total = static_cast<int>(data.size());
+		std::vector<cd> ret(total, 0.);
+		std::vector<int> k(dims.size()), n(dims.size());
+		for (int ik = 0; ik < total; ++ik) {
+			for (int d = static_cast<int>(dims.size()) - 1, tmp = ik; d >= 0; --d) {
+				k[d] = tmp % dims[d];
+				tmp /= dims[d];
+			}
+			for (int in = 0; in < total; ++in) {
+				double phase = 0.;
+				for (int d = static_cast<int>(dims.size()) - 1, tmp = in; d >= 0; --d) {
+					n[d] = tmp % dims[d];
+					tmp /= dims[d];
+					phase += static_cast<double>((static_cast<long long>(k[d]) * n[d]) % dims[d]) / dims[d];
+				}
+				double ang = 2. * pi * phase * (inverse ? 1. : -1.);
+				ret[ik] += data[in] * cd(cos(ang), sin(ang));
+			}
+		}
+		return ret;
+	}
+
+	std::vector<cd> TestData(int total)
+	{
+		std::vector<cd> ret(total);
+		for (int i = 0; i < total; ++i)
+			ret[i] = cd(sin(0.37 * i + 0.1) + 0.5 * cos(1.3 * i * i), cos(0.91 * i) - 0.2 * i / total);
+		return ret;
+	}
+
+	void ExpectSameTransform(const std::vector<int>& dims, bool inverse)
+	{
+		int total = 1;
+		for (size_t d = 0; d < dims.size(); ++d)
+			total *= dims[d];
+		std::vector<cd> data = TestData(total);
+		std::vector<cd> ref = DirectDFT(data, dims, inverse);
+		NumericalIntegration::FFT(data, dims, inverse);
+		ASSERT_EQ(data.size(), ref.size());
+		double scale = 0.;
+		for (int i = 0; i < total; ++i)
+			scale = std::max(scale, std::abs(ref[i]));
+		for (int i = 0; i < total; ++i)
+			EXPECT_NEAR(std::abs(data[i] - ref[i]) / scale, 0., 1.e-12) << "bin " << i;
+	}
+
+	TEST(NumericalIntegrationTest, FFTPowerOfTwo) {
+		ExpectSameTransform(std::vector<int>(1, 64), false);
+		ExpectSameTransform(std::vector<int>(1, 64), true);
+		std::vector<int> dims(3);
+		dims[0] = 4; dims[1] = 8; dims[2] = 2;
+		ExpectSameTransform(dims, false);
+		ExpectSameTransform(dims, true);
+	}
+
+	// Sizes other than powers of 2, or not matching the data, are rejected and leave the data unchanged
+	TEST(NumericalIntegrationTest, FFTNonPowerOfTwo) {
+		std::vector<int> dims(3);
+		dims[0] = 4; dims[1] = 6; dims[2] = 2;
+		std::vector<cd> data = TestData(48), orig = data;
+		NumericalIntegration::FFT(data, dims, false);
+		ASSERT_EQ(data.size(), orig.size());
+		for (size_t i = 0; i < data.size(); ++i)
+			EXPECT_EQ(data[i], orig[i]);
+
+		dims[1] = 8;
+		NumericalIntegration::FFT(data, dims, false);
+		for (size_t i = 0; i < data.size(); ++i)
+			EXPECT_EQ(data[i], orig[i]);
+	}
+
+	TEST(NumericalIntegrationTest, FFTRoundTrip) {
+		std::vector<int> dims(2);
+		dims[0] = 8; dims[1] = 16;
+		std::vector<cd> data = TestData(128), orig = data;
+		NumericalIntegration::FFT(data, dims, false);
+		NumericalIntegration::FFT(data, dims, true);
+		for (size_t i = 0; i < data.size(); ++i)
+			EXPECT_NEAR(std::abs(data[i] / 128. - orig[i]), 0., 1.e-13);
+	}
+
+
+}
@@ -0,0 +1,71 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	ThermalModelBase* CreateConfiguredModel(tests::ModelType type, ThermalParticleSystem *TPS)
+	{
+		ThermalModelBase *model = tests::CreateModel(type, TPS);
+		model->SetUseWidth(type == tests::Ideal ? ThermalParticle::eBW : ThermalParticle::ZeroWidth);
+		model->SetTemperature(0.155);
+		model->SetBaryonChemicalPotential(0.100);
+		model->SetElectricChemicalPotential(-0.005);
+		model->SetStrangenessChemicalPotential(0.020);
+		model->SetVolume(200.);
+		model->SetCanonicalVolume(200.);
+		return model;
+	}
+
+	// Densities and thermodynamic functions
+	std::vector<double> Calculate(tests::ModelType type, ThermalParticleSystem *TPS, bool useOpenMP)
+	{
+		ThermalModelBase *model = CreateConfiguredModel(type, TPS);
+		model->SetOMP(useOpenMP);
+		model->CalculateDensities();
+		std::vector<double> ret = model->Densities();
+		ret.insert(ret.end(), model->TotalDensities().begin(), model->TotalDensities().end());
+		ret.push_back(model->Pressure());
+		ret.push_back(model->EnergyDensity());
+		ret.push_back(model->EntropyDensity());
+		delete model;
+		return ret;
+	}
+
+	// The summations over species are done in a fixed order,
+	// the results with and without OpenMP are identical
+	TEST(OpenMPTest, SameResultsWithAndWithoutOpenMP) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withcharm.dat");
+
+#ifdef USE_OPENMP
+		omp_set_num_threads(4);
+#endif
+
+		const tests::ModelType types[] = { tests::Ideal, tests::EVDiagonal, tests::EVCrossterms, tests::VDW, tests::Canonical, tests::CanonicalStrangeness, tests::CanonicalCharm, tests::EVCanonicalStrangeness, tests::VDWCanonicalStrangeness };
+		for (size_t it = 0; it < sizeof(types) / sizeof(types[0]); ++it) {
+			std::vector<double> serial = Calculate(types[it], &TPS, false);
+			std::vector<double> parallel = Calculate(types[it], &TPS, true);
+			ASSERT_EQ(serial.size(), parallel.size());
+			for (size_t i = 0; i < serial.size(); ++i)
+				EXPECT_EQ(serial[i], parallel[i]) << "model " << types[it] << ", entry " << i;
+		}
+	}
+
+}
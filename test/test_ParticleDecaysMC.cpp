@@ -0,0 +1,92 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <vector>
+#include "HRGEventGenerator/ParticleDecaysMC.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Mothers with random momenta, the first one at rest
+	std::vector<SimpleParticle> SampleMothers(int n, double mass, long long pdg, MTRand& rangen) {
+		std::vector<SimpleParticle> ret;
+		ret.push_back(SimpleParticle(0., 0., 0., mass, pdg));
+		for (int i = 1; i < n; ++i) {
+			ret.push_back(SimpleParticle(
+				2. * rangen.rand() - 1.,
+				2. * rangen.rand() - 1.,
+				6. * rangen.rand() - 3.,
+				mass, pdg));
+		}
+		return ret;
+	}
+
+	void CheckBatch(const std::vector<SimpleParticle>& mothers, const std::vector<double>& masses, const std::vector<long long>& pdgs, MTRand& rangen) {
+		std::vector<SimpleParticle> out;
+		ParticleDecaysMC::ManyBodyDecayBatch(mothers, masses, pdgs, out, rangen);
+
+		size_t N = masses.size();
+		ASSERT_EQ(out.size(), mothers.size() * N);
+
+		for (size_t i = 0; i < mothers.size(); ++i) {
+			const SimpleParticle& mo = mothers[i];
+			double p0 = 0., px = 0., py = 0., pz = 0.;
+			for (size_t j = 0; j < N; ++j) {
+				const SimpleParticle& d = out[N * i + j];
+				EXPECT_EQ(d.PDGID, pdgs[j]);
+				EXPECT_EQ(d.MotherPDGID, mo.PDGID);
+				EXPECT_EQ(d.epoch, mo.epoch + 1);
+				EXPECT_NEAR(d.p0, sqrt(d.m * d.m + d.px * d.px + d.py * d.py + d.pz * d.pz), 1.e-10);
+				EXPECT_DOUBLE_EQ(d.m, masses[j]);
+				p0 += d.p0;
+				px += d.px;
+				py += d.py;
+				pz += d.pz;
+			}
+			EXPECT_NEAR(p0, mo.p0, 1.e-10);
+			EXPECT_NEAR(px, mo.px, 1.e-10);
+			EXPECT_NEAR(py, mo.py, 1.e-10);
+			EXPECT_NEAR(pz, mo.pz, 1.e-10);
+		}
+	}
+
+	TEST(ParticleDecaysMCTest, TwoBodyBatch) {
+		MTRand rangen(1);
+		// rho0 -> pi+ pi-
+		std::vector<double> masses = { 0.13957, 0.13957 };
+		std::vector<long long> pdgs = { 211, -211 };
+		CheckBatch(SampleMothers(1000, 0.775, 113, rangen), masses, pdgs, rangen);
+	}
+
+	TEST(ParticleDecaysMCTest, ThreeBodyBatch) {
+		MTRand rangen(1);
+		// omega -> pi+ pi- pi0
+		std::vector<double> masses = { 0.13957, 0.13957, 0.134977 };
+		std::vector<long long> pdgs = { 211, -211, 111 };
+		CheckBatch(SampleMothers(1000, 0.78265, 223, rangen), masses, pdgs, rangen);
+	}
+
+	TEST(ParticleDecaysMCTest, RadiativeBatch) {
+		MTRand rangen(1);
+		// Sigma0 -> Lambda + gamma, the photon is added automatically
+		std::vector<SimpleParticle> mothers = SampleMothers(100, 1.192642, 3212, rangen);
+		std::vector<double> masses(1, 1.115683);
+		std::vector<long long> pdgs(1, 3122);
+		std::vector<SimpleParticle> out;
+		ParticleDecaysMC::ManyBodyDecayBatch(mothers, masses, pdgs, out, rangen);
+		ASSERT_EQ(out.size(), 2 * mothers.size());
+		for (size_t i = 0; i < mothers.size(); ++i) {
+			EXPECT_EQ(out[2 * i].PDGID, 3122);
+			EXPECT_EQ(out[2 * i + 1].PDGID, 22);
+			EXPECT_NEAR(out[2 * i].p0 + out[2 * i + 1].p0, mothers[i].p0, 1.e-10);
+		}
+	}
+
+}
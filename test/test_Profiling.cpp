@@ -0,0 +1,122 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "HRGBase/Profiling.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+// The counters are called directly, the tests do not depend on USE_PROFILING
+namespace {
+
+	void AddCounts(int n) {
+		for (int i = 0; i < n; ++i) {
+			Profiling::AddCount(Profiling::BroydenIterations);
+			Profiling::AddTime(Profiling::BroydenTimer, 0.5);
+		}
+	}
+
+	// The counts of all the threads, including the ones which have finished, enter the report
+	TEST(ProfilingTest, CountsSumOverThreads) {
+		Profiling::Reset();
+		Profiling::AddCount(Profiling::BroydenSolves, 5);
+
+		const int nthreads = 8, n = 1000;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < nthreads; ++i)
+			threads.push_back(std::thread(AddCounts, n));
+		for (int i = 0; i < nthreads; ++i)
+			threads[i].join();
+
+		Profiling::Report report = Profiling::GetReport();
+		EXPECT_EQ(report.Counts[Profiling::BroydenSolves], 5);
+		EXPECT_EQ(report.Counts[Profiling::BroydenIterations], nthreads * n);
+		EXPECT_EQ(report.Calls[Profiling::BroydenTimer], nthreads * n);
+		EXPECT_DOUBLE_EQ(report.Times[Profiling::BroydenTimer], 0.5 * nthreads * n);
+		EXPECT_EQ(report.Counts[Profiling::DecaysPerformed], 0);
+		EXPECT_GE(report.Threads, nthreads + 1);
+
+		Profiling::Reset();
+		report = Profiling::GetReport();
+		for (int i = 0; i < Profiling::NumberOfCounters; ++i)
+			EXPECT_EQ(report.Counts[i], 0) << Profiling::CounterName(static_cast<Profiling::Counter>(i));
+		for (int i = 0; i < Profiling::NumberOfTimers; ++i) {
+			EXPECT_EQ(report.Calls[i], 0) << Profiling::TimerName(static_cast<Profiling::Timer>(i));
+			EXPECT_EQ(report.Times[i], 0.) << Profiling::TimerName(static_cast<Profiling::Timer>(i));
+		}
+	}
+
+	// More threads than the per-thread blocks running at the same time share the overflow block,
+	// and the blocks of the finished threads are reused
+	TEST(ProfilingTest, ManyConcurrentThreads) {
+		Profiling::Reset();
+
+		const int nthreads = 300, n = 1000;
+		std::mutex mutex;
+		std::condition_variable cv;
+		int started = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < nthreads; ++i) {
+			threads.push_back(std::thread([&]() {
+				Profiling::AddCount(Profiling::DecaysPerformed);
+				// Keep all the threads alive until each of them has taken a block
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					started++;
+					cv.notify_all();
+					cv.wait(lock, [&]() { return started == nthreads; });
+				}
+				AddCounts(n);
+			}));
+		}
+		for (int i = 0; i < nthreads; ++i)
+			threads[i].join();
+
+		Profiling::Report report = Profiling::GetReport();
+		EXPECT_EQ(report.Counts[Profiling::DecaysPerformed], nthreads);
+		EXPECT_EQ(report.Counts[Profiling::BroydenIterations], nthreads * n);
+		EXPECT_EQ(report.Calls[Profiling::BroydenTimer], nthreads * n);
+		EXPECT_DOUBLE_EQ(report.Times[Profiling::BroydenTimer], 0.5 * nthreads * n);
+
+		// The blocks are free again
+		for (int i = 0; i < nthreads; ++i) {
+			std::thread thread(AddCounts, 1);
+			thread.join();
+		}
+		report = Profiling::GetReport();
+		EXPECT_EQ(report.Counts[Profiling::BroydenIterations], nthreads * n + nthreads);
+		Profiling::Reset();
+	}
+
+	// The report can be taken while the other threads are counting, the snapshots do not decrease
+	TEST(ProfilingTest, ReportWhileCounting) {
+		Profiling::Reset();
+
+		const int nthreads = 4, n = 200000;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < nthreads; ++i)
+			threads.push_back(std::thread(AddCounts, n));
+
+		long long last = 0;
+		for (int i = 0; i < 100; ++i) {
+			long long count = Profiling::GetReport().Counts[Profiling::BroydenIterations];
+			EXPECT_GE(count, last);
+			EXPECT_LE(count, static_cast<long long>(nthreads) * n);
+			last = count;
+		}
+
+		for (int i = 0; i < nthreads; ++i)
+			threads[i].join();
+		EXPECT_EQ(Profiling::GetReport().Counts[Profiling::BroydenIterations], static_cast<long long>(nthreads) * n);
+		Profiling::Reset();
+	}
+
+}
@@ -0,0 +1,179 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGEventGenerator/EventGeneratorBase.h"
+#include "HRGEventGenerator/ResonanceDecaySpectra.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	ThermalParticleSystem PDG2020List(double mcut = -1.) {
+		return ThermalParticleSystem(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat", true, mcut);
+	}
+
+	ResonanceDecaySpectra::Grid TestGrid() {
+		ResonanceDecaySpectra::Grid grid;
+		grid.PtBins = 60;
+		grid.PtMax = 3.;
+		grid.YBins = 60;
+		grid.YMax = 6.;
+		return grid;
+	}
+
+	// Spectrum of a daughter species from the decays of a single mother species
+	// compared with the Monte Carlo decays of EventGeneratorBase.
+	// The mother has the Siemens-Rasmussen spectrum, yieldPerMother is the mean number of daughters per mother.
+	void CompareWithMonteCarlo(ThermalParticleSystem& TPS, long long motherPdg, long long daughterPdg, double yieldPerMother) {
+		int idmother = TPS.PdgToId(motherPdg), iddaughter = TPS.PdgToId(daughterPdg);
+		ASSERT_NE(idmother, -1);
+		ASSERT_NE(iddaughter, -1);
+		double mass = TPS.Particles()[idmother].Mass();
+		const double T = 0.120, beta = 0.5;
+
+		ResonanceDecaySpectra::Grid grid = TestGrid();
+		ResonanceDecaySpectra spectra(&TPS, grid);
+		SiemensRasmussenDistribution distr(motherPdg, mass, T, beta);
+		spectra.SetPrimordialSpectrum(idmother, distr, 1.);
+		spectra.CalculateFeeddown();
+		std::vector<double> dndpt = spectra.dndpt(iddaughter);
+
+		EXPECT_NEAR(spectra.Yield(iddaughter), yieldPerMother, 1.e-2 * yieldPerMother);
+
+		// Monte Carlo
+		const int nmothers = 200000;
+		MTRand rangen(1);
+		RandomGenerators::SiemensRasmussenMomentumGenerator gen(T, beta, mass);
+		SimpleEvent evt;
+		for (int i = 0; i < nmothers; ++i) {
+			std::vector<double> p = gen.GetMomentum(mass, rangen);
+			evt.Particles.push_back(SimpleParticle(p[0], p[1], p[2], mass, motherPdg));
+		}
+		evt.AllParticles = evt.Particles;
+		evt.DecayMap.assign(nmothers, -1);
+		SimpleEvent decayed = EventGeneratorBase::PerformDecays(evt, &TPS);
+
+		// Coarse bins of 0.25 GeV
+		const int merge = 5;
+		int nbins = grid.PtBins / merge;
+		double dpt = grid.PtMax / nbins;
+		std::vector<double> mc(nbins, 0.);
+		int ndaughters = 0;
+		for (size_t i = 0; i < decayed.Particles.size(); ++i) {
+			const SimpleParticle& part = decayed.Particles[i];
+			if (part.PDGID != daughterPdg)
+				continue;
+			ndaughters++;
+			int ib = static_cast<int>(part.GetPt() / dpt);
+			if (ib < nbins && fabs(part.GetY()) < grid.YMax)
+				mc[ib] += 1.;
+		}
+		EXPECT_NEAR(static_cast<double>(ndaughters) / nmothers, yieldPerMother, 4. * sqrt(static_cast<double>(ndaughters)) / nmothers);
+
+		for (int ib = 0; ib < nbins; ++ib) {
+			double calc = 0.;
+			for (int j = 0; j < merge; ++j)
+				calc += dndpt[ib * merge + j] * grid.PtMax / grid.PtBins;
+			double sample = mc[ib] / nmothers;
+			double err = sqrt(std::max(mc[ib], 1.)) / nmothers;
+			// Statistical uncertainty and 2% for the discretization
+			EXPECT_NEAR(calc, sample, 4. * err + 0.02 * sample) << "bin " << ib;
+		}
+	}
+
+	// Spectrum of pi+ from rho0 -> pi+ pi-, each rho0 gives exactly one pi+
+	TEST(ResonanceDecaySpectraTest, RhoToPiPi) {
+		ThermalParticleSystem TPS = PDG2020List();
+		CompareWithMonteCarlo(TPS, 113, 211, 1.);
+	}
+
+	// Spectra of pi+ and pi0 from omega(782), dominated by the three-body decay
+	// omega -> pi+ pi- pi0 which is integrated over the invariant mass of the other two pions
+	TEST(ResonanceDecaySpectraTest, OmegaThreeBodyDecay) {
+		ThermalParticleSystem TPS = PDG2020List();
+		// omega -> pi+ pi- pi0 (0.898), pi0 gamma (0.086), pi+ pi- (0.016)
+		CompareWithMonteCarlo(TPS, 223, 211, 0.898 + 0.016);
+		CompareWithMonteCarlo(TPS, 223, 111, 0.898 + 0.086);
+	}
+
+	// Spectrum of pi+ from the decay chain a1(1260)+ -> rho pi -> pi pi pi,
+	// the rho mesons are decayed only after they are fed by the a1
+	TEST(ResonanceDecaySpectraTest, TwoStepDecayChain) {
+		ThermalParticleSystem TPS = PDG2020List();
+		// a1+ -> rho+ pi0 (0.5) with rho+ -> pi+ pi0, a1+ -> rho0 pi+ (0.5) with rho0 -> pi+ pi-
+		CompareWithMonteCarlo(TPS, 20213, 211, 0.5 * 1. + 0.5 * 2.);
+	}
+
+	// The tabulated primordial spectrum is normalized to the given yield
+	// regardless of the normalization of the momentum distribution,
+	// the pT shape is the one of the distribution
+	TEST(ResonanceDecaySpectraTest, BoostInvariantPrimordialYield) {
+		ThermalParticleSystem TPS = PDG2020List();
+		int idp = TPS.PdgToId(2212);
+		ASSERT_NE(idp, -1);
+		double mass = TPS.Particles()[idp].Mass();
+		const double yield = 2.5;
+
+		for (int norm = 0; norm < 2; ++norm) {
+			BoostInvariantMomentumDistribution distr(new CylindricalBlastWaveParametrization(0.6, 1., 10., 6.), 2212, mass, 0.100, 0.5, norm == 1);
+			ResonanceDecaySpectra spectra(&TPS, TestGrid());
+			spectra.SetPrimordialSpectrum(idp, distr, yield);
+			EXPECT_NEAR(spectra.Yield(idp, false), yield, 1.e-12 * yield);
+
+			std::vector<double> pts = spectra.PtValues();
+			std::vector<double> dndpt = spectra.dndpt(idp, false);
+			double ratio0 = dndpt[0] / (pts[0] * distr.dnmtdmt(sqrt(pts[0] * pts[0] + mass * mass)));
+			for (size_t i = 1; i < pts.size(); ++i) {
+				double ratio = dndpt[i] / (pts[i] * distr.dnmtdmt(sqrt(pts[i] * pts[i] + mass * mass)));
+				EXPECT_NEAR(ratio, ratio0, 1.e-3 * ratio0) << "pT = " << pts[i];
+			}
+		}
+	}
+
+	// Final yields of the stable hadrons agree with the feeddown in the thermal model
+	TEST(ResonanceDecaySpectraTest, YieldsMatchThermalModelFeeddown) {
+		ThermalParticleSystem TPS = PDG2020List(1.5);
+		ThermalModelIdeal model(&TPS);
+		model.SetUseWidth(ThermalParticle::ZeroWidth);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.);
+		model.SetVolume(1000.);
+		model.CalculateDensities();
+
+		std::vector<MomentumDistributionBase*> distrs(TPS.ComponentsNumber());
+		std::vector<double> yields(TPS.ComponentsNumber());
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+			const ThermalParticle& part = TPS.Particles()[i];
+			distrs[i] = new SiemensRasmussenDistribution(part.PdgId(), part.Mass(), 0.155, 0.5);
+			yields[i] = model.Densities()[i] * model.Volume();
+		}
+
+		ResonanceDecaySpectra spectra(&TPS, TestGrid());
+		spectra.SetPrimordialSpectra(distrs, yields);
+		spectra.CalculateFeeddown();
+
+		const long long pdgs[] = { 211, -211, 111, 321, -321, 2212, -2212, 3122 };
+		for (size_t a = 0; a < sizeof(pdgs) / sizeof(pdgs[0]); ++a) {
+			int i = TPS.PdgToId(pdgs[a]);
+			ASSERT_NE(i, -1);
+			double ref = model.TotalDensities()[i] * model.Volume();
+			EXPECT_NEAR(spectra.Yield(i), ref, 1.e-2 * ref) << "pdg " << pdgs[a];
+			EXPECT_GT(spectra.Yield(i), spectra.Yield(i, false));
+		}
+
+		for (size_t i = 0; i < distrs.size(); ++i)
+			delete distrs[i];
+	}
+
+}
@@ -0,0 +1,209 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGEventGenerator/SpectraAnalysis.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	const double mpi = 0.13957, mp = 0.938272;
+
+	// Event with npi pions at pT = 0.1, 0.2, ... and np protons at rest, all at zero rapidity
+	SimpleEvent MakeEvent(int npi, int np, double weight = 1.) {
+		SimpleEvent evt;
+		for (int i = 0; i < npi; ++i)
+			evt.Particles.push_back(SimpleParticle(0.1 * (i + 1), 0., 0., mpi, 211));
+		for (int i = 0; i < np; ++i)
+			evt.Particles.push_back(SimpleParticle(0., 0., 0., mp, 2212));
+		// Not analyzed
+		evt.Particles.push_back(SimpleParticle(0.3, 0., 0., 0.77, 113));
+		evt.weight = weight;
+		return evt;
+	}
+
+	// The merged sums are accumulated in a different order
+	void ExpectClose(double a, double b) {
+		EXPECT_NEAR(a, b, 1.e-12 * std::abs(b));
+	}
+
+	void ExpectSameResults(const SpectraAnalysis& a, const SpectraAnalysis& b) {
+		ASSERT_EQ(a.NumberOfSpecies(), b.NumberOfSpecies());
+		EXPECT_EQ(a.Events(), b.Events());
+		for (int ind = 0; ind < a.NumberOfSpecies(); ++ind) {
+			ExpectClose(a.MeanMultiplicity(ind), b.MeanMultiplicity(ind));
+			ExpectClose(a.ScaledVariance(ind), b.ScaledVariance(ind));
+			ExpectClose(a.MeanPt(ind), b.MeanPt(ind));
+			const SpectraAnalysis::Species& sa = a.GetSpecies(ind);
+			const SpectraAnalysis::Species& sb = b.GetSpecies(ind);
+			for (int i = 0; i < sa.dndpt.Bins(); ++i) {
+				ExpectClose(sa.dndpt.Entry(i), sb.dndpt.Entry(i));
+				ExpectClose(sa.dndpt.EntryError(i), sb.dndpt.EntryError(i));
+			}
+			for (int i = 0; i < sa.d2ndptdy.Bins(); ++i)
+				ExpectClose(sa.d2ndptdy.Entry(i), sb.d2ndptdy.Entry(i));
+		}
+	}
+
+	TEST(SpectraAnalysisTest, ProcessEvent) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		SpectraAnalysis analysis(&TPS);
+		int ipi = analysis.SpeciesIndex(211), ip = analysis.SpeciesIndex(2212);
+		ASSERT_NE(ipi, -1);
+		ASSERT_NE(ip, -1);
+		EXPECT_EQ(analysis.SpeciesIndex(113), -1);
+		for (int i = 0; i < analysis.NumberOfSpecies(); ++i)
+			EXPECT_EQ(analysis.SpeciesIndex(analysis.GetSpecies(i).PdgId), i);
+
+		// Pion multiplicities 1, 2, 3
+		for (int n = 1; n <= 3; ++n)
+			analysis.ProcessEvent(MakeEvent(n, 2));
+
+		EXPECT_EQ(analysis.Events(), 3);
+		EXPECT_DOUBLE_EQ(analysis.MeanMultiplicity(ipi), 2.);
+		EXPECT_DOUBLE_EQ(analysis.ScaledVariance(ipi), (14. / 3. - 4.) / 2.);
+		EXPECT_DOUBLE_EQ(analysis.MeanPt(ipi), (0.1 + 0.3 + 0.6) / 6.);
+		EXPECT_DOUBLE_EQ(analysis.MeanMultiplicity(ip), 2.);
+		EXPECT_NEAR(analysis.ScaledVariance(ip), 0., 1.e-12);
+		EXPECT_DOUBLE_EQ(analysis.MeanPt(ip), 0.);
+
+		// Three pions with pT = 0.1, two with pT = 0.2, one with pT = 0.3
+		const SpectraHistogram1D& dndpt = analysis.GetSpecies(ipi).dndpt;
+		const double pts[] = { 0.1, 0.2, 0.3 };
+		for (int i = 0; i < 3; ++i) {
+			int bin = dndpt.Bin(pts[i]);
+			ASSERT_NE(bin, -1);
+			EXPECT_DOUBLE_EQ(dndpt.Entry(bin), (3 - i) / 3. / dndpt.BinWidth());
+		}
+
+		double total = 0.;
+		std::vector<double> dndy = analysis.GetSpecies(ipi).dndy.GetYVector();
+		for (size_t i = 0; i < dndy.size(); ++i)
+			total += dndy[i] * analysis.GetSpecies(ipi).dndy.BinWidth();
+		EXPECT_NEAR(total, 2., 1.e-12);
+	}
+
+	TEST(SpectraAnalysisTest, Merge) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		SpectraAnalysis full(&TPS), first(&TPS), second(&TPS);
+		for (int n = 0; n < 10; ++n) {
+			SimpleEvent evt = MakeEvent(n % 4, (n * 7) % 3, 0.5 + 0.1 * n);
+			full.ProcessEvent(evt);
+			if (n < 4)
+				first.ProcessEvent(evt);
+			else
+				second.ProcessEvent(evt);
+		}
+		first.Merge(second);
+		ExpectSameResults(first, full);
+	}
+
+	TEST(SpectraAnalysisTest, MergeIncompatible) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		SpectraAnalysis analysis(&TPS), reference(&TPS);
+		analysis.ProcessEvent(MakeEvent(2, 1));
+		reference.ProcessEvent(MakeEvent(2, 1));
+
+		// Different species
+		SpectraAnalysis allspecies(&TPS, SpectraAnalysis::Binning(), false);
+		allspecies.ProcessEvent(MakeEvent(1, 1));
+		analysis.Merge(allspecies);
+		ExpectSameResults(analysis, reference);
+
+		// Same number of bins, different ranges
+		SpectraAnalysis::Binning binning;
+		binning.PtMax = 5.;
+		SpectraAnalysis otherrange(&TPS, binning);
+		otherrange.ProcessEvent(MakeEvent(1, 1));
+		analysis.Merge(otherrange);
+		ExpectSameResults(analysis, reference);
+
+		// Different 2D binning only
+		binning = SpectraAnalysis::Binning();
+		binning.Pt2DMax = 3.;
+		SpectraAnalysis other2d(&TPS, binning);
+		other2d.ProcessEvent(MakeEvent(1, 1));
+		analysis.Merge(other2d);
+		ExpectSameResults(analysis, reference);
+	}
+
+	TEST(SpectraAnalysisTest, Histogram2D) {
+		SpectraHistogram2D hist(-1., 1., 4, 0., 3., 3);
+		EXPECT_EQ(hist.BinsX(), 4);
+		EXPECT_EQ(hist.BinsY(), 3);
+		hist.Fill(0.1, 2.5);
+		hist.Fill(0.1, 2.5);
+		hist.Fill(-0.9, 0.5);
+		hist.Fill(0.1, 3.5);
+		hist.FinishEvent();
+
+		std::vector<double> xs = hist.GetXCenterVector(), ys = hist.GetYCenterVector(), zs = hist.GetZVector();
+		ASSERT_EQ(xs.size(), 12u);
+		ASSERT_EQ(ys.size(), 12u);
+		ASSERT_EQ(zs.size(), 12u);
+		double total = 0.;
+		for (size_t i = 0; i < zs.size(); ++i) {
+			if (xs[i] == 0.25 && ys[i] == 2.5)
+				EXPECT_DOUBLE_EQ(zs[i], 2. / 0.5 / 1.);
+			else if (xs[i] == -0.75 && ys[i] == 0.5)
+				EXPECT_DOUBLE_EQ(zs[i], 1. / 0.5 / 1.);
+			else
+				EXPECT_EQ(zs[i], 0.);
+			total += zs[i] * 0.5 * 1.;
+		}
+		EXPECT_DOUBLE_EQ(total, 3.);
+
+		SpectraHistogram2D other(-1., 1., 4, 0., 6., 3);
+		EXPECT_FALSE(hist.SameBinning(other));
+		other.FinishEvent();
+		hist.Merge(other);
+		EXPECT_EQ(hist.Events(), 1);
+	}
+
+	// A 2D histogram is not a 1D one, so it cannot be merged through the 1D interface
+	// which ignores the y axis
+	static_assert(!std::is_convertible<SpectraHistogram2D*, SpectraHistogram1D*>::value,
+		"SpectraHistogram2D must not be usable as SpectraHistogram1D");
+	static_assert(!std::is_convertible<SpectraHistogram2D&, const SpectraHistogram1D&>::value,
+		"SpectraHistogram2D must not be usable as SpectraHistogram1D");
+
+	TEST(SpectraAnalysisTest, Histogram2DMergeDifferentY) {
+		// Same x binning and same total number of bins, different y binning
+		SpectraHistogram2D hist(-1., 1., 4, 0., 3., 3);
+		hist.Fill(0.1, 2.5);
+		hist.FinishEvent();
+		std::vector<double> before = hist.GetZVector();
+
+		const double ymaxs[] = { 6., 3., 3. };
+		const double ymins[] = { 0., -3., 0. };
+		const int binsys[] = { 3, 3, 6 };
+		for (int i = 0; i < 3; ++i) {
+			SpectraHistogram2D other(-1., 1., 4, ymins[i], ymaxs[i], binsys[i]);
+			other.Fill(0.1, 0.5);
+			other.FinishEvent();
+			EXPECT_FALSE(hist.SameBinning(other));
+			hist.Merge(other);
+			EXPECT_EQ(hist.Events(), 1);
+			EXPECT_EQ(hist.GetZVector(), before);
+		}
+
+		SpectraHistogram2D same(-1., 1., 4, 0., 3., 3);
+		same.Fill(0.1, 2.5);
+		same.FinishEvent();
+		EXPECT_TRUE(hist.SameBinning(same));
+		hist.Merge(same);
+		EXPECT_EQ(hist.Events(), 2);
+		EXPECT_EQ(hist.GetZVector(), before);
+	}
+
+}
@@ -0,0 +1,306 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelCanonical.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	void SetupModel(ThermalModelCanonical& model, bool conserveQ) {
+		model.ConserveElectricCharge(conserveQ);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.);
+		model.SetVolumeRadius(2.5);
+		model.SetCanonicalVolumeRadius(2.5);
+		model.SetBaryonCharge(2);
+		model.SetElectricCharge(1);
+		model.SetStrangeness(0);
+		model.SetCharm(0);
+	}
+
+	// The FFT evaluation of the partition functions agrees with the nested quadratures
+	TEST(ThermalModelCanonicalTest, FFTMatchesQuadratures) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		for (int iq = 0; iq < 2; ++iq) {
+			ThermalModelCanonical quad(&TPS), fft(&TPS);
+			SetupModel(quad, iq == 0);
+			SetupModel(fft, iq == 0);
+			fft.SetUseFFT(true);
+
+			quad.CalculatePrimordialDensities();
+			fft.CalculatePrimordialDensities();
+			quad.CalculateFluctuations();
+			fft.CalculateFluctuations();
+
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+				tests::ExpectClose(fft.Densities()[i], quad.Densities()[i], 1.e-8);
+				tests::ExpectClose(fft.ParticleScaledVariance(i), quad.ParticleScaledVariance(i), 1.e-7);
+			}
+			tests::ExpectClose(fft.CalculatePressure(), quad.CalculatePressure(), 1.e-8);
+			tests::ExpectClose(fft.CalculateEnergyDensity(), quad.CalculateEnergyDensity(), 1.e-8);
+			tests::ExpectClose(fft.CalculateEntropyDensity(), quad.CalculateEntropyDensity(), 1.e-8);
+		}
+	}
+
+	// Exposes the primordial particle number correlators
+	class CorrelationsProbe : public ThermalModelCanonical {
+	public:
+		CorrelationsProbe(ThermalParticleSystem* TPS) : ThermalModelCanonical(TPS) {}
+		double PrimordialCorrelation(int i, int j) const { return m_PrimCorrel[i][j]; }
+	};
+
+	// Yields and correlations of pions, kaons, protons and Lambdas agree with the values
+	// computed by the previous implementation, which looked up the canonical
+	// partition functions through a map of all quantum numbers instead of the per-charge masks.
+	// Configuration 0 conserves B, Q, and S; configuration 1 treats Q grand-canonically.
+	TEST(ThermalModelCanonicalTest, ReferenceYieldsAndCorrelations) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		const long long pdgs[8] = { 211, -211, 321, -321, 2212, -2212, 3122, -3122 };
+
+		// Densities and scaled variances
+		const double refYields0[8][2] = {
+			{ 0.04231231490155949, 0.75955056093483542 },
+			{ 0.042429202837642052, 0.75861336499092991 },
+			{ 0.012573743565136922, 0.82885547930654069 },
+			{ 0.0091669317278462083, 0.88218587039481566 },
+			{ 0.010897966024135881, 0.65600984079341373 },
+			{ 0.0004903882137898527, 0.99112092903484283 },
+			{ 0.0035896228550110891, 0.88057742177645615 },
+			{ 0.00022188243520172875, 0.99556506906619024 }
+		};
+
+		const double refYields1[8][2] = {
+			{ 0.042455496792974466, 1.1071093471336433 },
+			{ 0.049040769261771915, 1.1288143856541979 },
+			{ 0.012358494978335006, 0.85141955505547939 },
+			{ 0.009620841012846949, 0.89130558224471135 },
+			{ 0.010526735096967025, 0.6792973746358657 },
+			{ 0.00052158440330475674, 0.99114882789465486 },
+			{ 0.0035380751160456383, 0.88292647589052053 },
+			{ 0.00022574071252115123, 0.99550242645552767 }
+		};
+
+		// Primordial correlators
+		const double refCorrel0[8][8] = {
+			{ 0.20734414527697428, 0.1064847158595006, -0.012883981906886959, 0.010095521831470933, -0.011910391893376941, 0.00053806336829684482, -0.00013170837236699438, 9.181468094638716e-06 },
+			{ 0.10648471585950094, 0.2076603892809453, 0.01391715367668056, -0.0092991508387599564, 0.011777386841190157, -0.00046170861017093951, -0.00015098690321721335, 1.0991889315021618e-05 },
+			{ -0.012883981906886992, 0.013917153676680552, 0.067237524189413519, 0.013732238663955605, -0.0060548135314142399, 0.00027533581182027185, 0.0031036784479454016, -0.00014834799640995894 },
+			{ 0.010095521831470921, -0.0092991508387599807, 0.01373223866395561, 0.05217379125922491, 0.0041989054638599255, -0.0001558362997992616, -0.0019655843520095702, 0.00013473201015731987 },
+			{ -0.011910391893376927, 0.011777386841190252, -0.006054813531414239, 0.004198905463859935, 0.046123696493325234, 0.0012038899669020193, -0.0069856361793297437, 0.00039698132535993265 },
+			{ 0.00053806336829684471, -0.00046170861017093989, 0.00027533581182027158, -0.00015583629979926136, 0.0012038899669020193, 0.003135703367994425, 0.00029489039083128928, -9.4285045430141375e-06 },
+			{ -0.00013170837236698547, -0.00015098690321720709, 0.003103678447945402, -0.0019655843520095719, -0.0069856361793297428, 0.00029489039083128922, 0.020393166702035521, 0.00020646899331459544 },
+			{ 9.1814680946387685e-06, 1.0991889315021755e-05, -0.00014834799640995903, 0.00013473201015731979, 0.00039698132535993282, -9.4285045430141392e-06, 0.00020646899331459544, 0.0014251509801689265 }
+		};
+
+		const double refCorrel1[8][8] = {
+			{ 0.30324436991422227, 0., 0., 0., 0., 0., 0., 0. },
+			{ 0., 0.35714790855636341, 0., 0., 0., 0., 0., 0. },
+			{ 0., 0., 0.067885576100705572, 0.012211110666230061, -0.004289739228993633, 0.00020669018571771572, 0.0029468778695160925, -0.00014637668213900282 },
+			{ 0., 0., 0.012211110666230074, 0.055323285810576425, 0.0029728308710776537, -0.00012376873371339021, -0.0019906654742934747, 0.00014040378518781642 },
+			{ 0., 0., -0.0042897392289936217, 0.0029728308710776472, 0.046134087192625323, 0.0011423918316115253, -0.0066299880207747247, 0.00039018461592041847 },
+			{ 0., 0., 0.00020669018571771566, -0.00012376873371339035, 0.0011423918316115251, 0.0033352759353783394, 0.00030974696034471864, -1.025529386020726e-05 },
+			{ 0., 0., 0.0029468778695160907, -0.0019906654742934773, -0.0066299880207747264, 0.00030974696034471858, 0.020153936733200768, 0.00020553976496918584 },
+			{ 0., 0., -0.00014637668213900279, 0.00014040378518781637, 0.00039018461592041842, -1.0255293860207253e-05, 0.00020553976496918581, 0.0014498414649329406 }
+		};
+
+		for (int iq = 0; iq < 2; ++iq) {
+			CorrelationsProbe model(&TPS);
+			SetupModel(model, iq == 0);
+			model.SetStatistics(true);
+			model.SetElectricChemicalPotential(iq == 0 ? 0. : -0.01);
+			model.CalculatePrimordialDensities();
+			model.CalculateFluctuations();
+
+			const double (*refYields)[2] = (iq == 0) ? refYields0 : refYields1;
+			const double (*refCorrel)[8] = (iq == 0) ? refCorrel0 : refCorrel1;
+			for (int a = 0; a < 8; ++a) {
+				int i = TPS.PdgToId(pdgs[a]);
+				ASSERT_NE(i, -1);
+				tests::ExpectClose(model.Densities()[i], refYields[a][0]);
+				tests::ExpectClose(model.ParticleScaledVariance(i), refYields[a][1]);
+				for (int b = 0; b < 8; ++b)
+					tests::ExpectClose(model.PrimordialCorrelation(i, TPS.PdgToId(pdgs[b])), refCorrel[a][b]);
+			}
+
+			if (iq == 0) {
+				tests::ExpectClose(model.CalculatePressure(), 0.043229622064907144);
+				tests::ExpectClose(model.CalculateEnergyDensity(), 0.22606451532459776);
+				tests::ExpectClose(model.CalculateEntropyDensity(), 1.6368712944684651);
+			}
+			else {
+				tests::ExpectClose(model.Susc(ConservedCharge::ElectricCharge, ConservedCharge::ElectricCharge), 0.31213232238495647);
+			}
+		}
+	}
+
+	// Two-particle correlations evaluated on the quantum-number classes agree with the pairwise
+	// evaluation of the previous implementation, both for Boltzmann statistics,
+	// where the per-species terms are rank-one, and for quantum statistics with
+	// strangeness treated grand-canonically
+	TEST(ThermalModelCanonicalTest, ReferenceCorrelationsOnChargeClasses) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		const long long pdgs[8] = { 211, -211, 321, -321, 2212, -2212, 3122, -3122 };
+
+		// Densities and scaled variances
+		const double refYields0[8][2] = {
+			{ 0.038829912077809822, 0.7089808510748532 },
+			{ 0.038939794329644124, 0.70805752714748182 },
+			{ 0.01243850149537358, 0.8200822625389631 },
+			{ 0.009060919783131274, 0.87501233079760643 },
+			{ 0.010913641872372001, 0.65484806950601193 },
+			{ 0.00048929203152408846, 0.99119364925538311 },
+			{ 0.0035881700951233188, 0.88077098041013713 },
+			{ 0.00022188523053948787, 0.99559275297082672 }
+		};
+
+		const double refYields1[8][2] = {
+			{ 0.039928659455958804, 0.80802942124148203 },
+			{ 0.045657990675158147, 0.77009761457998804 },
+			{ 0.012387732571441677, 0.93490382367477787 },
+			{ 0.010807845420593308, 0.94236848338817258 },
+			{ 0.0055915889279927675, 0.72265242657776385 },
+			{ 0.00077231000979304128, 0.98250446108563105 },
+			{ 0.0021075284293862479, 0.89655964321636827 },
+			{ 0.00033273043735004517, 0.99295246903938794 }
+		};
+
+		// Primordial correlators
+		const double refCorrel0[8][8] = {
+			{ 0.17761073620701504, 0.083213344439746637, -0.011965796757957016, 0.0093185329723091299, -0.0113256922045107, 0.00050198045594145361, -0.00011541264042949433, 7.9486272469177775e-06 },
+			{ 0.083213344439746623, 0.17788138374631829, 0.012831794950860386, -0.0086513423608726402, 0.011211947707902391, -0.00043596826817610406, -0.00013356130109040969, 9.6447339651517557e-06 },
+			{ -0.011965796757957017, 0.012831794950860391, 0.065810286767227388, 0.013518851783103768, -0.0061739369773634763, 0.00027903654376608709, 0.0030871692266770724, -0.00014747144291930948 },
+			{ 0.0093185329723091403, -0.0086513423608726575, 0.013518851783103769, 0.051151074442631221, 0.0043146770229550513, -0.0001584338083440038, -0.0019628637116134618, 0.00013438775469132015 },
+			{ -0.011325692204510684, 0.011211947707902405, -0.0061739369773634728, 0.0043146770229550626, 0.046108240718727621, 0.001215670119894876, -0.0069950014834366083, 0.00039713813882162466 },
+			{ 0.00050198045594145523, -0.00043596826817610313, 0.0002790365437660866, -0.00015843380834400353, 0.0012156701198948758, 0.0031289235759867171, 0.00029282500756909908, -9.3518734082649547e-06 },
+			{ -0.00011541264042949978, -0.00013356130109041045, 0.0030871692266770719, -0.00196286371161346, -0.0069950014834366083, 0.00029282500756909908, 0.020389394145549036, 0.00020703002262950209 },
+			{ 7.9486272469177301e-06, 9.6447339651517574e-06, -0.00014747144291930953, 0.00013438775469132031, 0.00039713813882162494, -9.3518734082649632e-06, 0.00020703002262950211, 0.0014252085646217761 }
+		};
+
+		const double refCorrel1[8][8] = {
+			{ 0.20815181671707567, 0.096497714325401843, -0.020819730067325362, 0.020738916070067295, -0.0068718427198879916, 0.00098256205969098715, 0.0011719395773967158, -0.00016364064671490838 },
+			{ 0.096497714325401718, 0.22684586906745038, 0.027656487478193045, -0.021298947170412273, 0.008322135023521542, -0.00099200459395920224, -0.0014726315009339951, 0.00022812777776128081 },
+			{ -0.020819730067325376, 0.027656487478193052, 0.074718313210976856, 0.0059568767698388106, -0.001996567585440377, 0.00028180363737158537, 0.00034157384627519555, -4.7949140111715576e-05 },
+			{ 0.020738916070067292, -0.02129894717041228, 0.0059568767698388097, 0.065709502565795636, 0.0018081976852885812, -0.00021831446439840666, -0.00031939147146250855, 4.898434744761284e-05 },
+			{ -0.0068718427198879882, 0.0083221350235215506, -0.0019965675854403809, 0.0018081976852885812, 0.02606951811122148, 0.0016414362133204323, -0.0036856623167420988, 0.00061110898425638664 },
+			{ 0.00098256205969098759, -0.00099200459395920376, 0.0002818036373715844, -0.00021831446439840655, 0.0016414362133204321, 0.0048954711610500043, 0.00053394344953861775, -3.2702745042984812e-05 },
+			{ 0.0011719395773967145, -0.0014726315009340005, 0.0003415738462751955, -0.00031939147146250926, -0.0036856623167420988, 0.00053394344953861775, 0.0121904834627025, 0.00024683717719445672 },
+			{ -0.00016364064671490821, 0.00022812777776128136, -4.7949140111715562e-05, 4.8984347447612386e-05, 0.00061110898425638664, -3.2702745042984792e-05, 0.00024683717719445677, 0.0021315194147824685 }
+		};
+
+		for (int ic = 0; ic < 2; ++ic) {
+			CorrelationsProbe model(&TPS);
+			model.ConserveStrangeness(ic == 0);
+			model.SetStatistics(ic == 1);
+			model.SetTemperature(0.155);
+			model.SetBaryonChemicalPotential(0.);
+			model.SetStrangenessChemicalPotential(ic == 0 ? 0. : 0.02);
+			model.SetVolumeRadius(2.5);
+			model.SetCanonicalVolumeRadius(2.5);
+			model.SetBaryonCharge(ic == 0 ? 2 : 1);
+			model.SetElectricCharge(ic == 0 ? 1 : 0);
+			model.SetStrangeness(0);
+			model.SetCharm(0);
+			model.CalculateQuantumNumbersRange(true);
+			model.CalculatePrimordialDensities();
+			model.CalculateFluctuations();
+
+			const double (*refYields)[2] = (ic == 0) ? refYields0 : refYields1;
+			const double (*refCorrel)[8] = (ic == 0) ? refCorrel0 : refCorrel1;
+			for (int a = 0; a < 8; ++a) {
+				int i = TPS.PdgToId(pdgs[a]);
+				ASSERT_NE(i, -1);
+				tests::ExpectClose(model.Densities()[i], refYields[a][0]);
+				tests::ExpectClose(model.ParticleScaledVariance(i), refYields[a][1]);
+				for (int b = 0; b < 8; ++b)
+					tests::ExpectClose(model.PrimordialCorrelation(i, TPS.PdgToId(pdgs[b])), refCorrel[a][b]);
+			}
+
+			if (ic == 1)
+				tests::ExpectClose(model.Susc(ConservedCharge::StrangenessCharge, ConservedCharge::StrangenessCharge), 0.13479669624476692);
+		}
+	}
+
+	// In Boltzmann statistics the canonical corrections scale the particle and energy densities
+	// of a species by the same factor, thus P = T * n and e = sum_i n_i * (e_i / n_i)_GCE.
+	// This holds also when some of the charges are treated grand-canonically.
+	TEST(ThermalModelCanonicalTest, BoltzmannThermodynamicsWithGrandCanonicalCharge) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		for (int iq = 0; iq < 2; ++iq) {
+			ThermalModelCanonical model(&TPS);
+			SetupModel(model, iq == 0);
+			model.SetStatistics(false);
+			model.SetElectricChemicalPotential(iq == 0 ? 0. : -0.01);
+			model.CalculatePrimordialDensities();
+
+			double ntot = 0., etot = 0.;
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+				const ThermalParticle& part = TPS.Particles()[i];
+				double nid = part.Density(model.Parameters(), IdealGasFunctions::ParticleDensity, false, model.ChemicalPotential(i));
+				double eid = part.Density(model.Parameters(), IdealGasFunctions::EnergyDensity, false, model.ChemicalPotential(i));
+				ntot += model.Densities()[i];
+				if (nid > 0.)
+					etot += model.Densities()[i] * eid / nid;
+			}
+
+			tests::ExpectClose(model.CalculatePressure(), model.Parameters().T * ntot, 1.e-10);
+			tests::ExpectClose(model.CalculateEnergyDensity(), etot, 1.e-10);
+		}
+	}
+
+	// The exactly conserved charges do not fluctuate: the mean charges equal the fixed values,
+	// and the correlator of any particle number with a conserved charge, sum_j q_j <dN_i dN_j>, vanishes
+	TEST(ThermalModelCanonicalTest, ConservationSums) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		const int N = TPS.ComponentsNumber();
+		for (int iconf = 0; iconf < 4; ++iconf) {
+			const bool conserveQ = (iconf % 2 == 0);
+			CorrelationsProbe model(&TPS);
+			SetupModel(model, conserveQ);
+			model.SetStatistics(iconf >= 2);
+			model.SetUseFFT(true);
+			model.CalculateQuantumNumbersRange(true);
+			model.CalculatePrimordialDensities();
+			model.CalculateFluctuations();
+
+			const double V = model.CanonicalVolume();
+			double meanB = 0., meanQ = 0., meanS = 0.;
+			for (int i = 0; i < N; ++i) {
+				meanB += V * TPS.Particle(i).BaryonCharge() * model.Densities()[i];
+				meanQ += V * TPS.Particle(i).ElectricCharge() * model.Densities()[i];
+				meanS += V * TPS.Particle(i).Strangeness() * model.Densities()[i];
+			}
+			EXPECT_NEAR(meanB, 2., 1.e-9);
+			EXPECT_NEAR(meanS, 0., 1.e-9);
+			if (conserveQ)
+				EXPECT_NEAR(meanQ, 1., 1.e-9);
+
+			for (int i = 0; i < N; ++i) {
+				double corrB = 0., corrQ = 0., corrS = 0., scale = 0.;
+				for (int j = 0; j < N; ++j) {
+					const ThermalParticle& part = TPS.Particle(j);
+					corrB += part.BaryonCharge() * model.PrimordialCorrelation(i, j);
+					corrQ += part.ElectricCharge() * model.PrimordialCorrelation(i, j);
+					corrS += part.Strangeness() * model.PrimordialCorrelation(i, j);
+					scale += std::abs(model.PrimordialCorrelation(i, j));
+				}
+				EXPECT_NEAR(corrB, 0., 1.e-9 * scale) << "species " << TPS.Particle(i).PdgId();
+				EXPECT_NEAR(corrS, 0., 1.e-9 * scale) << "species " << TPS.Particle(i).PdgId();
+				if (conserveQ)
+					EXPECT_NEAR(corrQ, 0., 1.e-9 * scale) << "species " << TPS.Particle(i).PdgId();
+			}
+		}
+	}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelCanonicalStrangeness.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "HRGBase/xMath.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Gives access to the partial sums and the partition functions
+	class ZsumProbe : public ThermalModelCanonicalStrangeness
+	{
+	public:
+		ZsumProbe(ThermalParticleSystem *TPS) : ThermalModelCanonicalStrangeness(TPS) { }
+
+		// Partition function for net strangeness S, including the common factor
+		double Z(int S) { return m_Zsum[m_StrMap[S]] * exp(m_ZsumLogFactor); }
+
+		// The fixed 41x41 double Bessel series used before the adaptive truncation
+		double ZPreviousSeries(int S) {
+			std::vector<double> xi(3), yi(3);
+			for (int i = 0; i < 3; ++i) {
+				xi[i] = 2. * sqrt(m_partialS[m_StrMap[i + 1]] * m_partialS[m_StrMap[-(i + 1)]]);
+				yi[i] = sqrt(m_partialS[m_StrMap[i + 1]] / m_partialS[m_StrMap[-(i + 1)]]);
+			}
+			int iters = 20;
+			double res = 0.;
+			for (int m = -iters; m <= iters; ++m)
+				for (int n = -iters; n <= iters; ++n) {
+					double tmp = xMath::BesselI(std::abs(3 * m + 2 * n - S), xi[0]) *
+						xMath::BesselI(std::abs(n), xi[1]) *
+						xMath::BesselI(std::abs(m), xi[2]) *
+						pow(yi[0], S - 3 * m - 2 * n) *
+						pow(yi[1], n) *
+						pow(yi[2], m);
+					if (tmp != tmp) continue;
+					res += tmp;
+				}
+			return res;
+		}
+	};
+
+	void SetupModel(ThermalModelBase& model, double muB, double R) {
+		model.SetStatistics(false);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(muB);
+		model.SetElectricChemicalPotential(0.);
+		model.SetVolumeRadius(R);
+		model.SetCanonicalVolumeRadius(R);
+	}
+
+	// At small volumes the truncated series agrees with the previous fixed series
+	TEST(ThermalModelCanonicalStrangenessTest, ZsumPreviousSeries) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+		const double muBs[] = { 0., 0.3 };
+		const double Rs[] = { 1., 2., 3. };
+		for (int imu = 0; imu < 2; ++imu) {
+			for (int iR = 0; iR < 3; ++iR) {
+				ZsumProbe model(&TPS);
+				SetupModel(model, muBs[imu], Rs[iR]);
+				model.CalculateDensities();
+				for (int S = -3; S <= 3; ++S)
+					EXPECT_NEAR(model.Z(S) / model.ZPreviousSeries(S), 1., 1.e-6)
+						<< "S = " << S << ", muB = " << muBs[imu] << ", R = " << Rs[iR];
+			}
+		}
+	}
+
+	// At large volumes the yields approach the grand-canonical ones at vanishing net strangeness
+	TEST(ThermalModelCanonicalStrangenessTest, GrandCanonicalLimit) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+		double muB = 0.2;
+		ThermalModelIdeal gce(&TPS);
+		SetupModel(gce, muB, 10.);
+		gce.ConstrainMuQ(false);
+		gce.ConstrainMuS(true);
+		gce.ConstrainMuC(false);
+		gce.ConstrainChemicalPotentials();
+		gce.CalculatePrimordialDensities();
+
+		int idOmega = TPS.PdgToId(3334);
+		int idKplus = TPS.PdgToId(321);
+		ASSERT_GE(idOmega, 0);
+		ASSERT_GE(idKplus, 0);
+
+		double prevdev = 1.;
+		const double Rs[] = { 5., 15., 50. };
+		for (int iR = 0; iR < 3; ++iR) {
+			ThermalModelCanonicalStrangeness model(&TPS);
+			SetupModel(model, muB, Rs[iR]);
+			model.FillChemicalPotentials();
+			model.CalculatePrimordialDensities();
+			EXPECT_TRUE(model.IsLastSolutionOK());
+			// With Boltzmann statistics the saddle point is the grand-canonical muS / T at any volume
+			EXPECT_NEAR(model.StrangenessSaddlePoint(), gce.Parameters().muS / gce.Parameters().T, 1.e-6);
+
+			double maxdev = 0.;
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+				// Zero degeneracy, e.g. K0L and K0S
+				if (gce.Densities()[i] == 0.)
+					continue;
+				double ratio = model.Densities()[i] / gce.Densities()[i];
+				ASSERT_TRUE(ratio == ratio) << "particle " << i;
+				maxdev = std::max(maxdev, std::abs(ratio - 1.));
+			}
+			// Canonical suppression of the multi-strange hadrons is the largest
+			EXPECT_LT(model.Densities()[idOmega] / gce.Densities()[idOmega], model.Densities()[idKplus] / gce.Densities()[idKplus]);
+			EXPECT_LT(maxdev, prevdev);
+			prevdev = maxdev;
+			EXPECT_NEAR(model.CalculateEntropyDensity() / gce.CalculateEntropyDensity(), 1., 2. * maxdev);
+		}
+		EXPECT_LT(prevdev, 2.e-3);
+	}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	ThermalModelBase* CreateConfiguredModel(tests::ModelType type, ThermalParticleSystem *TPS)
+	{
+		ThermalModelBase *model = tests::CreateModel(type, TPS);
+		model->SetTemperature(0.155);
+		model->SetBaryonChemicalPotential(0.);
+		model->SetVolumeRadius(3.);
+		model->SetCanonicalVolumeRadius(3.);
+		return model;
+	}
+
+	// Densities, thermodynamic functions, and scaled variances at given T and muB
+	void Evaluate(ThermalModelBase *model, double T, double muB, std::vector<double> *ret)
+	{
+		model->SetTemperature(T);
+		model->SetBaryonChemicalPotential(muB);
+		model->CalculateDensities();
+		model->CalculateFluctuations();
+		*ret = model->Densities();
+		ret->push_back(model->Pressure());
+		ret->push_back(model->EnergyDensity());
+		ret->push_back(model->EntropyDensity());
+		for (int i = 0; i < model->TPS()->ComponentsNumber(); ++i)
+			ret->push_back(model->ParticleScaledVariance(i));
+	}
+
+	// Two clones sharing the particle list evaluated concurrently give the same results
+	// as the clones evaluated one after another
+	TEST(ThermalModelCloneTest, ConcurrentClonesMatchSerial) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+
+		const tests::ModelType types[] = { tests::Ideal, tests::EVDiagonal, tests::EVCrossterms, tests::VDW, tests::Canonical };
+		for (size_t it = 0; it < sizeof(types) / sizeof(types[0]); ++it) {
+			ThermalModelBase *model = CreateConfiguredModel(types[it], &TPS);
+
+			std::vector<double> serial1, serial2;
+			{
+				ThermalModelBase *clone1 = model->Clone(), *clone2 = model->Clone();
+				ASSERT_TRUE(clone1 != NULL);
+				ASSERT_TRUE(clone2 != NULL);
+				Evaluate(clone1, 0.145, 0.100, &serial1);
+				Evaluate(clone2, 0.160, 0.300, &serial2);
+				delete clone1;
+				delete clone2;
+			}
+
+			std::vector<double> parallel1, parallel2;
+			{
+				ThermalModelBase *clone1 = model->Clone(), *clone2 = model->Clone();
+				std::thread thread1(Evaluate, clone1, 0.145, 0.100, &parallel1);
+				std::thread thread2(Evaluate, clone2, 0.160, 0.300, &parallel2);
+				thread1.join();
+				thread2.join();
+				delete clone1;
+				delete clone2;
+			}
+
+			ASSERT_EQ(serial1.size(), parallel1.size());
+			ASSERT_EQ(serial2.size(), parallel2.size());
+			for (size_t i = 0; i < serial1.size(); ++i) {
+				EXPECT_EQ(serial1[i], parallel1[i]) << "model " << types[it] << ", entry " << i;
+				EXPECT_EQ(serial2[i], parallel2[i]) << "model " << types[it] << ", entry " << i;
+			}
+
+			// The calculations on the clones leave the original model untouched
+			EXPECT_EQ(model->Parameters().T, 0.155);
+			EXPECT_EQ(model->Parameters().muB, 0.);
+
+			delete model;
+		}
+	}
+
+	// Evaluates the ideal gas at given muQ and reports whether Bose-Einstein condensation was encountered
+	void EvaluateBEC(ThermalModelBase *model, double muQ, bool *hadBECIssue)
+	{
+		IdealGasFunctions::calculationHadBECIssue = false;
+		model->SetElectricChemicalPotential(muQ);
+		model->CalculatePrimordialDensities();
+		*hadBECIssue = IdealGasFunctions::calculationHadBECIssue;
+	}
+
+	// The Bose-Einstein condensation flag is set per thread,
+	// a condensing calculation in one thread does not mark the one in another thread
+	TEST(ThermalModelCloneTest, BECIssueFlagIsPerThread) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		ThermalModelBase *model = CreateConfiguredModel(tests::Ideal, &TPS);
+		ThermalModelBase *clone1 = model->Clone(), *clone2 = model->Clone();
+
+		// muQ above the pion mass
+		bool bec1 = false, bec2 = true;
+		std::thread thread1(EvaluateBEC, clone1, 0.200, &bec1);
+		std::thread thread2(EvaluateBEC, clone2, 0., &bec2);
+		thread1.join();
+		thread2.join();
+
+		EXPECT_TRUE(bec1);
+		EXPECT_FALSE(bec2);
+
+		delete clone1;
+		delete clone2;
+		delete model;
+	}
+
+}
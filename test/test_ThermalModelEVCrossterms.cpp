@@ -0,0 +1,187 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGEV.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Configuration 0: r = 0.3 fm for all species, no meson-meson excluded volume.
+	// Configuration 1: r = 0.5 fm for baryons, r = 0.4 fm for antibaryons, r = 0.2 fm for mesons.
+	void SetupModel(ThermalModelEVCrossterms& model, int config) {
+		const ThermalParticleSystem* TPS = model.TPS();
+		if (config == 0) {
+			model.SetRadius(0.3);
+			for (int i = 0; i < TPS->ComponentsNumber(); ++i)
+				for (int j = 0; j < TPS->ComponentsNumber(); ++j)
+					if (TPS->Particle(i).BaryonCharge() == 0 && TPS->Particle(j).BaryonCharge() == 0)
+						model.SetVirial(i, j, 0.);
+		}
+		else {
+			std::vector<double> radii(TPS->ComponentsNumber());
+			for (int i = 0; i < TPS->ComponentsNumber(); ++i) {
+				int B = TPS->Particle(i).BaryonCharge();
+				radii[i] = (B > 0) ? 0.5 : ((B < 0) ? 0.4 : 0.2);
+			}
+			model.FillVirial(radii);
+		}
+		model.SetStatistics(true);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.3);
+	}
+
+	std::vector<double> BaryonCharges(const ThermalParticleSystem& TPS) {
+		std::vector<double> ret(TPS.ComponentsNumber());
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i)
+			ret[i] = TPS.Particle(i).BaryonCharge();
+		return ret;
+	}
+
+	// Densities reconstructed on the EV-component space agree with the values
+	// computed by the previous implementation, which solved an N x N system for each species.
+	// Pinned are P, e, s, the pi+, K+, p, pbar, and Lambda densities, and chi1, chi2 of the baryon number.
+	TEST(ThermalModelEVCrosstermsTest, ReferenceEVComponents) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		const long long pdgs[5] = { 211, 321, 2212, -2212, 3122 };
+		const std::vector<double> chgs = BaryonCharges(TPS);
+		const double ref[2][10] = {
+			{ 0.06318421164528075, 0.3932986163703866, 2.7296898659171855, 0.040282837438483057, 0.010818155513270155, 0.013651254447421386, 0.00028562628009999618, 0.005415991486136011, 0.22958381685642948, 0.21844896095955563 },
+			{ 0.057141915566357657, 0.31882721390009972, 2.2820430698635015, 0.037449176794304193, 0.010039168327617708, 0.0091645760914328377, 0.00024663230791475684, 0.0036327156913329873, 0.15304570650965352, 0.11662177709645834 }
+		};
+
+		for (int ic = 0; ic < 2; ++ic) {
+			ThermalModelEVCrossterms model(&TPS);
+			SetupModel(model, ic);
+			model.CalculateDensities();
+
+			ThermalModelBase& base = model;
+			tests::ExpectClose(base.Pressure(), ref[ic][0]);
+			tests::ExpectClose(base.EnergyDensity(), ref[ic][1]);
+			tests::ExpectClose(base.EntropyDensity(), ref[ic][2]);
+			for (int a = 0; a < 5; ++a)
+				tests::ExpectClose(model.Densities()[TPS.PdgToId(pdgs[a])], ref[ic][3 + a]);
+
+			std::vector<double> chi = model.CalculateChargeFluctuations(chgs, 2);
+			tests::ExpectClose(chi[0], ref[ic][8]);
+			tests::ExpectClose(chi[1], ref[ic][9]);
+		}
+	}
+
+	// chi2 of the baryon number is the derivative of chi1 with respect to muB/T,
+	// and the baryon density is the derivative of the pressure with respect to muB
+	TEST(ThermalModelEVCrosstermsTest, BaryonSusceptibilityMatchesDerivative) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		const std::vector<double> chgs = BaryonCharges(TPS);
+		const double muB = 0.3, dmu = 1.e-4;
+
+		for (int ic = 0; ic < 2; ++ic) {
+			ThermalModelEVCrossterms model(&TPS);
+			SetupModel(model, ic);
+			const double T = model.Parameters().T;
+
+			double chi1[2], P[2];
+			for (int k = 0; k < 2; ++k) {
+				model.SetBaryonChemicalPotential(muB + (2 * k - 1) * dmu);
+				model.CalculateDensities();
+				chi1[k] = model.CalculateChargeFluctuations(chgs, 1)[0];
+				P[k] = model.CalculatePressure();
+			}
+
+			model.SetBaryonChemicalPotential(muB);
+			model.CalculateDensities();
+			double chi2 = model.CalculateChargeFluctuations(chgs, 2)[1];
+			EXPECT_NEAR(chi2, (chi1[1] - chi1[0]) / (2. * dmu / T), 1.e-6 * chi2);
+			double nB = model.CalculateBaryonDensity();
+			EXPECT_NEAR(nB, (P[1] - P[0]) / (2. * dmu), 1.e-6 * nB);
+		}
+	}
+
+	// With equal radii for all species the crossterms model reduces to the diagonal EV model
+	TEST(ThermalModelEVCrosstermsTest, EqualRadiiMatchDiagonal) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+		const std::vector<double> chgs = BaryonCharges(TPS);
+
+		ThermalModelEVCrossterms crossterms(&TPS);
+		ThermalModelEVDiagonal diagonal(&TPS);
+		ThermalModelBase* models[2] = { &crossterms, &diagonal };
+		std::vector<double> chi[2];
+		for (int im = 0; im < 2; ++im) {
+			models[im]->SetRadius(0.3);
+			models[im]->SetStatistics(true);
+			models[im]->SetTemperature(0.155);
+			models[im]->SetBaryonChemicalPotential(0.3);
+			models[im]->CalculateDensities();
+			chi[im] = models[im]->CalculateChargeFluctuations(chgs, 2);
+		}
+
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i)
+			tests::ExpectClose(crossterms.Densities()[i], diagonal.Densities()[i], 1.e-8);
+		tests::ExpectClose(crossterms.CalculatePressure(), diagonal.CalculatePressure(), 1.e-8);
+		tests::ExpectClose(crossterms.CalculateEnergyDensity(), diagonal.CalculateEnergyDensity(), 1.e-8);
+		tests::ExpectClose(crossterms.CalculateEntropyDensity(), diagonal.CalculateEntropyDensity(), 1.e-8);
+		tests::ExpectClose(chi[0][0], chi[1][0], 1.e-8);
+		tests::ExpectClose(chi[0][1], chi[1][1], 1.e-8);
+	}
+
+	// The grouping of species into EV components is rebuilt after the virial coefficients change
+	TEST(ThermalModelEVCrosstermsTest, VirialChangeAfterCalculation) {
+		ThermalParticleSystem TPS = tests::PDG2014List();
+
+		ThermalModelEVCrossterms model(&TPS);
+		SetupModel(model, 0);
+		model.CalculateDensities();
+
+		std::vector<double> radii(TPS.ComponentsNumber());
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+			int B = TPS.Particle(i).BaryonCharge();
+			radii[i] = (B > 0) ? 0.5 : ((B < 0) ? 0.4 : 0.2);
+		}
+		model.FillVirial(radii);
+		model.CalculateDensities();
+
+		ThermalModelEVCrossterms fresh(&TPS);
+		SetupModel(fresh, 1);
+		fresh.CalculateDensities();
+
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i)
+			EXPECT_NEAR(model.Densities()[i], fresh.Densities()[i], 1.e-9 * fresh.Densities()[i] + 1.e-15);
+		EXPECT_NEAR(model.CalculatePressure(), fresh.CalculatePressure(), 1.e-9 * fresh.CalculatePressure());
+	}
+
+	// The 2N x 2N system for the susceptibilities is fully initialized,
+	// the result does not depend on the contents of the reused memory
+	TEST(ThermalModelEVCrosstermsTest, SusceptibilitiesOnReusedMemory) {
+		ThermalParticleSystem TPS = tests::LightHadrons();
+		const int N = TPS.ComponentsNumber();
+		std::vector<double> chgs(N);
+		for (int i = 0; i < N; ++i)
+			chgs[i] = TPS.Particle(i).BaryonCharge();
+
+		ThermalModelEVCrossterms model(&TPS);
+		model.SetRadius(0.3);
+		model.SetStatistics(true);
+		model.SetTemperature(0.155);
+		model.SetBaryonChemicalPotential(0.3);
+		model.CalculateDensities();
+		double chi2 = model.CalculateChargeFluctuations(chgs, 2)[1];
+
+		tests::PoisonFreedMemory(4 * N * N);
+		double chi2reused = model.CalculateChargeFluctuations(chgs, 2)[1];
+		EXPECT_TRUE(std::isfinite(chi2reused));
+		EXPECT_EQ(chi2, chi2reused);
+	}
+
+}
@@ -0,0 +1,145 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <string>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGEV/ThermalModelEVDiagonal.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Gives access to the pressure solver
+	class PressureProbe : public ThermalModelEVDiagonal
+	{
+	public:
+		PressureProbe(ThermalParticleSystem *TPS) : ThermalModelEVDiagonal(TPS) { }
+
+		double SolvedPressure() const { return m_Pressure; }
+
+		// Right-hand side of the equation p = sum_i p_i^id(T, mu_i - v_i p)
+		double PressureRHS(double P) { return Pressure(P); }
+
+		// The upper end of the bracket, the ideal gas pressure, and the first Halley step from it
+		double UpperBracket() {
+			double f, df, d2f;
+			EVPressureAndDerivatives(0., f, df, d2f);
+			return f;
+		}
+		double HalleyStep(double P) {
+			double f, df, d2f;
+			EVPressureAndDerivatives(P, f, df, d2f);
+			double h = P - f, dh = 1. - df;
+			double dP = -h / dh;
+			double denom = 1. - 0.5 * dP * d2f / dh;
+			if (denom > 0.5)
+				dP /= denom;
+			return P + dP;
+		}
+	};
+
+	void SetupModel(ThermalModelBase& model, double radius, double T, double muB) {
+		model.SetRadius(radius);
+		model.SetStatistics(true);
+		model.SetTemperature(T);
+		model.SetBaryonChemicalPotential(muB);
+		model.FillChemicalPotentials();
+	}
+
+	TEST(ThermalModelEVDiagonalTest, PressureFixedPoint) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+		const double Ts[] = { 0.08, 0.12, 0.16, 0.20 };
+		const double muBs[] = { 0., 0.3, 0.6, 0.9 };
+		const double radii[] = { 0.3, 0.5 };
+		for (int ir = 0; ir < 2; ++ir) {
+			for (int iT = 0; iT < 4; ++iT) {
+				for (int imu = 0; imu < 4; ++imu) {
+					PressureProbe model(&TPS);
+					SetupModel(model, radii[ir], Ts[iT], muBs[imu]);
+					model.CalculatePrimordialDensities();
+					EXPECT_TRUE(model.IsLastSolutionOK());
+					double P = model.SolvedPressure();
+					EXPECT_GT(P, 0.);
+					EXPECT_NEAR(model.PressureRHS(P) / P, 1., 1.e-9)
+						<< "r = " << radii[ir] << ", T = " << Ts[iT] << ", muB = " << muBs[imu];
+					EXPECT_DOUBLE_EQ(model.CalculatePressure(), P);
+				}
+			}
+		}
+	}
+
+	// Warm-started solves along a scan agree with the solves from the ideal gas pressure
+	TEST(ThermalModelEVDiagonalTest, WarmStart) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+		PressureProbe warm(&TPS);
+		warm.SetPressureWarmStart(true);
+		EXPECT_TRUE(warm.PressureWarmStart());
+		for (int iT = 0; iT <= 20; ++iT) {
+			double T = 0.100 + 0.005 * iT;
+			SetupModel(warm, 0.4, T, 0.5);
+			warm.CalculatePrimordialDensities();
+
+			PressureProbe cold(&TPS);
+			SetupModel(cold, 0.4, T, 0.5);
+			cold.CalculatePrimordialDensities();
+
+			EXPECT_TRUE(warm.IsLastSolutionOK());
+			EXPECT_NEAR(warm.SolvedPressure() / cold.SolvedPressure(), 1., 1.e-9) << "T = " << T;
+			for (int i = 0; i < TPS.ComponentsNumber(); ++i)
+				EXPECT_NEAR(warm.Densities()[i], cold.Densities()[i], 1.e-9 * cold.Densities()[i]);
+		}
+	}
+
+	// For large eigenvolumes the first Halley step leaves the bracket,
+	// the solver has to fall back to the bisection
+	TEST(ThermalModelEVDiagonalTest, BisectionFallback) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat");
+		double Pprev = 1.e10;
+		const double radii[] = { 1.5, 3., 5. };
+		for (int ir = 0; ir < 3; ++ir) {
+			PressureProbe model(&TPS);
+			SetupModel(model, radii[ir], 0.16, 0.9);
+			double Phi = model.UpperBracket();
+			double Pstep = model.HalleyStep(Phi);
+			EXPECT_FALSE(Pstep > 0. && Pstep < Phi) << "r = " << radii[ir];
+
+			model.CalculatePrimordialDensities();
+			EXPECT_TRUE(model.IsLastSolutionOK());
+			double P = model.SolvedPressure();
+			EXPECT_GT(P, 0.);
+			EXPECT_LT(P, Pprev);
+			EXPECT_NEAR(model.PressureRHS(P) / P, 1., 1.e-9) << "r = " << radii[ir];
+			Pprev = P;
+		}
+	}
+
+
+	// The 2N x 2N system for the susceptibilities is fully initialized,
+	// the result does not depend on the contents of the reused memory
+	TEST(ThermalModelEVDiagonalTest, SusceptibilitiesOnReusedMemory) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list.dat", true, 1.2);
+		const int N = TPS.ComponentsNumber();
+		std::vector<double> chgs(N);
+		for (int i = 0; i < N; ++i)
+			chgs[i] = TPS.Particle(i).BaryonCharge();
+
+		ThermalModelEVDiagonal model(&TPS);
+		SetupModel(model, 0.3, 0.155, 0.3);
+		model.CalculateDensities();
+		double chi2 = model.CalculateChargeFluctuations(chgs, 2)[1];
+
+		tests::PoisonFreedMemory(4 * N * N);
+		double chi2reused = model.CalculateChargeFluctuations(chgs, 2)[1];
+		EXPECT_TRUE(std::isfinite(chi2reused));
+		EXPECT_EQ(chi2, chi2reused);
+	}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <string>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGFit.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Fits T, R, and gammaS at muB = 0 to the 0-10% ALICE data
+	ThermalModelFitParameters Fit(ThermalModelBase *model, bool analyticGradient, bool asymmErrors = false) {
+		ThermalModelFit fitter(model);
+		ThermalModelFitParameters params = fitter.Parameters();
+		params.SetParameter("T", 0.155, 0.010, 0.100, 0.200);
+		params.SetParameter("R", 10.0, 1.0, 0.0, 30.0);
+		params.SetParameterFitFlag("gammaS", true);
+		params.SetParameterValue("muB", 0.);
+		params.SetParameterFitFlag("muB", false);
+		fitter.SetParameters(params);
+		fitter.SetQuantities(ThermalModelFit::loadExpDataFromFile(std::string(ThermalFIST_INPUT_FOLDER) + "/data/ALICE/ALICE-PbPb2.76TeV-0-10-all-symmetrized.dat"));
+		fitter.UseAnalyticGradient(analyticGradient);
+		return fitter.PerformFit(false, asymmErrors);
+	}
+
+	// The fit with the analytic gradient finds the same minimum as the one with MINUIT's numerical derivatives,
+	// the errors from the finite differences of the gradient agree with the ones of MnHesse
+	TEST(ThermalModelFitTest, AnalyticGradientMatchesPlainFit) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+		ThermalModelBase *model = tests::CreateModel(tests::Ideal, &TPS);
+		model->SetUseWidth(ThermalParticle::ZeroWidth);
+		ASSERT_TRUE(model->CalculateDensitiesDerivatives());
+
+		ThermalModelFitParameters plain = Fit(model, false);
+		ThermalModelFitParameters gradient = Fit(model, true);
+
+		EXPECT_NEAR(gradient.chi2, plain.chi2, 1.e-4 * plain.chi2);
+		const std::string names[3] = { "T", "R", "gammaS" };
+		for (int i = 0; i < 3; ++i) {
+			const FitParameter& a = plain.GetParameter(names[i]);
+			const FitParameter& b = gradient.GetParameter(names[i]);
+			EXPECT_NEAR(b.value, a.value, 0.01 * a.error) << names[i];
+			EXPECT_GT(b.error, 0.) << names[i];
+			EXPECT_NEAR(b.error, a.error, 0.02 * a.error) << names[i];
+		}
+
+		// The fixed parameters keep their values and errors
+		EXPECT_EQ(gradient.muB.value, plain.muB.value);
+		EXPECT_EQ(gradient.muB.error, plain.muB.error);
+
+		delete model;
+	}
+
+	// With the asymmetric errors requested the errors come from MnHesse and MINOS for both fits
+	TEST(ThermalModelFitTest, AnalyticGradientAsymmetricErrors) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+		ThermalModelBase *model = tests::CreateModel(tests::Ideal, &TPS);
+		model->SetUseWidth(ThermalParticle::ZeroWidth);
+
+		ThermalModelFitParameters plain = Fit(model, false, true);
+		ThermalModelFitParameters gradient = Fit(model, true, true);
+
+		const std::string names[3] = { "T", "R", "gammaS" };
+		for (int i = 0; i < 3; ++i) {
+			const FitParameter& a = plain.GetParameter(names[i]);
+			const FitParameter& b = gradient.GetParameter(names[i]);
+			EXPECT_NEAR(b.error, a.error, 0.02 * a.error) << names[i];
+			EXPECT_GT(b.errp, 0.) << names[i];
+			EXPECT_NEAR(b.errp, a.errp, 0.02 * a.errp) << names[i];
+			EXPECT_NEAR(b.errm, a.errm, 0.02 * a.errm) << names[i];
+		}
+
+		delete model;
+	}
+
+}
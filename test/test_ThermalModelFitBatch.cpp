@@ -0,0 +1,141 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase.h"
+#include "HRGFit.h"
+#include "gtest/gtest.h"
+#include "TestHelpers.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	std::string DataFile(const std::string& centrality) {
+		return std::string(ThermalFIST_INPUT_FOLDER) + "/data/ALICE/ALICE-PbPb2.76TeV-" + centrality + "-all-symmetrized.dat";
+	}
+
+	const char* centralities[] = { "0-10", "10-20", "20-40", "40-60" };
+	const int NDS = 4;
+
+	// Fits T, R, and gammaS at muB = 0
+	void SetupParameters(ThermalModelFitParameters& params) {
+		params.SetParameter("T", 0.155, 0.010, 0.100, 0.200);
+		params.SetParameter("R", 10.0, 1.0, 0.0, 30.0);
+		params.SetParameterFitFlag("gammaS", true);
+		params.SetParameterValue("muB", 0.);
+		params.SetParameterFitFlag("muB", false);
+	}
+
+	ThermalModelFitParameters FitSingle(ThermalModelBase *model, const std::string& centrality) {
+		ThermalModelFit fitter(model);
+		ThermalModelFitParameters params = fitter.Parameters();
+		SetupParameters(params);
+		fitter.SetParameters(params);
+		fitter.SetQuantities(ThermalModelFit::loadExpDataFromFile(DataFile(centrality)));
+		return fitter.PerformFit(false);
+	}
+
+	void FitSingleTo(ThermalModelBase *model, std::string centrality, ThermalModelFitParameters *result) {
+		*result = FitSingle(model, centrality);
+	}
+
+	void SetupBatch(ThermalModelFitBatch& batch) {
+		ThermalModelFitParameters params = batch.Parameters();
+		SetupParameters(params);
+		batch.SetParameters(params);
+		for (int i = 0; i < NDS; ++i)
+			batch.AddDatasetFromFile(DataFile(centralities[i]), centralities[i]);
+	}
+
+	// Without the warm start, the batch fits reproduce the independent fits to each data set
+	TEST(ThermalModelFitBatchTest, MatchesIndependentFits) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+
+		ThermalModelFitBatch batch(&TPS, tests::CreateModel<tests::Ideal>);
+		SetupBatch(batch);
+		batch.SetNumberOfWorkers(2);
+		batch.UseWarmStart(false);
+		const std::vector<ThermalModelFitParameters>& results = batch.PerformFits(false);
+		ASSERT_EQ(static_cast<int>(results.size()), NDS);
+
+		for (int i = 0; i < NDS; ++i) {
+			ThermalModelBase *model = tests::CreateModel(tests::Ideal, &TPS);
+			ThermalModelFitParameters single = FitSingle(model, centralities[i]);
+			delete model;
+
+			EXPECT_NEAR(results[i].T.value, single.T.value, 1.e-9);
+			EXPECT_NEAR(results[i].R.value, single.R.value, 1.e-7);
+			EXPECT_NEAR(results[i].gammaS.value, single.gammaS.value, 1.e-9);
+			EXPECT_NEAR(results[i].chi2, single.chi2, 1.e-7 * single.chi2);
+		}
+	}
+
+	// With the warm start, splitting the data sets among several workers
+	// leads to the same minima as a single worker
+	TEST(ThermalModelFitBatchTest, WorkersMatchSingleWorker) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+
+		ThermalModelFitBatch serial(&TPS, tests::CreateModel<tests::Ideal>);
+		SetupBatch(serial);
+		serial.SetNumberOfWorkers(1);
+		serial.PerformFits(false);
+
+		ThermalModelFitBatch blocks(&TPS, tests::CreateModel<tests::Ideal>);
+		SetupBatch(blocks);
+		blocks.SetNumberOfWorkers(3);
+		blocks.PerformFits(false);
+
+		for (int i = 0; i < NDS; ++i) {
+			const ThermalModelFitParameters& a = serial.Results()[i];
+			const ThermalModelFitParameters& b = blocks.Results()[i];
+			EXPECT_NEAR(a.T.value, b.T.value, 0.01 * a.T.error);
+			EXPECT_NEAR(a.R.value, b.R.value, 0.01 * a.R.error);
+			EXPECT_NEAR(a.gammaS.value, b.gammaS.value, 0.01 * a.gammaS.error);
+			EXPECT_NEAR(a.chi2, b.chi2, 1.e-4 * a.chi2);
+		}
+	}
+
+	// Two fits on clones of the same model, sharing the particle list, performed
+	// concurrently in two threads give the same results as the fits performed one after another
+	TEST(ThermalModelFitBatchTest, ConcurrentFitsOnClones) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2014/list-withnuclei.dat");
+		ThermalModelBase *model = tests::CreateModel(tests::Ideal, &TPS);
+
+		ThermalModelFitParameters serial[2], parallel[2];
+		{
+			ThermalModelBase *clone1 = model->Clone(), *clone2 = model->Clone();
+			serial[0] = FitSingle(clone1, centralities[0]);
+			serial[1] = FitSingle(clone2, centralities[3]);
+			delete clone1;
+			delete clone2;
+		}
+		{
+			ThermalModelBase *clone1 = model->Clone(), *clone2 = model->Clone();
+			std::thread thread1(FitSingleTo, clone1, std::string(centralities[0]), &parallel[0]);
+			std::thread thread2(FitSingleTo, clone2, std::string(centralities[3]), &parallel[1]);
+			thread1.join();
+			thread2.join();
+			delete clone1;
+			delete clone2;
+		}
+
+		for (int i = 0; i < 2; ++i) {
+			EXPECT_EQ(serial[i].T.value, parallel[i].T.value);
+			EXPECT_EQ(serial[i].R.value, parallel[i].R.value);
+			EXPECT_EQ(serial[i].gammaS.value, parallel[i].gammaS.value);
+			EXPECT_EQ(serial[i].chi2, parallel[i].chi2);
+		}
+
+		delete model;
+	}
+
+}
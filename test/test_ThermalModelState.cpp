@@ -0,0 +1,112 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "ThermalFISTConfig.h"
+#include "HRGBase/ThermalModelIdeal.h"
+#include "HRGEV/ThermalModelEVDiagonal.h"
+#include "HRGVDW/ThermalModelVDW.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Equal up to the rounding of the text output, nan matches nan
+	void ExpectSameValue(double a, double b) {
+		if (a != a) {
+			EXPECT_TRUE(b != b);
+			return;
+		}
+		if (std::isinf(a)) {
+			EXPECT_EQ(a, b);
+			return;
+		}
+		EXPECT_NEAR(a, b, 1.e-14 * std::abs(a));
+	}
+
+	TEST(ThermalModelStateTest, SaveLoadAfterFluctuations) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+
+		ThermalModelIdeal model(&TPS);
+		model.SetTemperature(0.150);
+		model.SetBaryonChemicalPotential(0.);
+		model.CalculatePrimordialDensities();
+		model.CalculateFluctuations();
+
+		std::string filename = "test_ThermalModelState.dat";
+		ASSERT_TRUE(model.SaveState(filename));
+
+		ThermalModelIdeal model2(&TPS);
+		ASSERT_TRUE(model2.LoadState(filename));
+		std::remove(filename.c_str());
+
+		EXPECT_TRUE(model2.IsCalculated());
+		EXPECT_TRUE(model2.IsFluctuationsCalculated());
+		ExpectSameValue(model.Parameters().T, model2.Parameters().T);
+
+		for (int i = 0; i < model.ComponentsNumber(); ++i) {
+			ExpectSameValue(model.Densities()[i], model2.Densities()[i]);
+			ExpectSameValue(model.TotalDensities()[i], model2.TotalDensities()[i]);
+			ExpectSameValue(model.ScaledVariancePrimordial(i), model2.ScaledVariancePrimordial(i));
+			// Includes inf for the total width of stable particles and nan for zero densities
+			ExpectSameValue(model.ScaledVarianceTotal(i), model2.ScaledVarianceTotal(i));
+			ExpectSameValue(model.SkewnessTotal(i), model2.SkewnessTotal(i));
+		}
+
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				ExpectSameValue(model.Susc(static_cast<ConservedCharge::Name>(i), static_cast<ConservedCharge::Name>(j)),
+					model2.Susc(static_cast<ConservedCharge::Name>(i), static_cast<ConservedCharge::Name>(j)));
+	}
+
+	// With the eBW widths the thermal branching ratios are evaluated anew when the state is restored,
+	// this has to use the restored chemical potential shifts of the interacting models
+	void CheckSaveLoadEBW(ThermalModelBase& model, ThermalModelBase& model2) {
+		model.SetUseWidth(ThermalParticle::eBW);
+		model.SetTemperature(0.150);
+		model.SetBaryonChemicalPotential(0.100);
+		model.CalculatePrimordialDensities();
+
+		std::string filename = "test_ThermalModelState_eBW.dat";
+		ASSERT_TRUE(model.SaveState(filename));
+
+		model2.SetUseWidth(ThermalParticle::eBW);
+		ASSERT_TRUE(model2.LoadState(filename));
+		std::remove(filename.c_str());
+
+		for (int i = 0; i < model.ComponentsNumber(); ++i)
+			EXPECT_NEAR(model.TotalDensities()[i], model2.TotalDensities()[i], 1.e-12 * model.TotalDensities()[i]);
+	}
+
+	TEST(ThermalModelStateTest, SaveLoadEBWExcludedVolume) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelEVDiagonal model(&TPS), model2(&TPS);
+		model.FillVirial(std::vector<double>(TPS.ComponentsNumber(), 0.3));
+		model2.FillVirial(std::vector<double>(TPS.ComponentsNumber(), 0.3));
+		CheckSaveLoadEBW(model, model2);
+	}
+
+	TEST(ThermalModelStateTest, SaveLoadEBWVanDerWaals) {
+		ThermalParticleSystem TPS(std::string(ThermalFIST_INPUT_FOLDER) + "/list/PDG2020/list.dat");
+		ThermalModelVDW model(&TPS), model2(&TPS);
+		for (int i = 0; i < TPS.ComponentsNumber(); ++i) {
+			for (int j = 0; j < TPS.ComponentsNumber(); ++j) {
+				if (TPS.Particles()[i].BaryonCharge() * TPS.Particles()[j].BaryonCharge() > 0) {
+					model.SetVirial(i, j, 3.42);
+					model.SetAttraction(i, j, 0.329);
+					model2.SetVirial(i, j, 3.42);
+					model2.SetAttraction(i, j, 0.329);
+				}
+			}
+		}
+		CheckSaveLoadEBW(model, model2);
+	}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Thermal-FIST package
+ *
+ * Copyright (c) 2021 Volodymyr Vovchenko
+ *
+ * GNU General Public License (GPLv3 or later)
+ */
+#include <cmath>
+#include <vector>
+#include "HRGBase/xMath.h"
+#include "gtest/gtest.h"
+
+using namespace thermalfist;
+
+namespace {
+
+	// Large-x asymptotic expansion of e^{-x} I_n(x)
+	double BesselIexpAsymptotic(int n, double x) {
+		double mu = 4. * n * n;
+		double term = 1., ret = 1.;
+		for (int k = 1; k <= 12; ++k) {
+			term *= -(mu - (2. * k - 1.) * (2. * k - 1.)) / (k * 8. * x);
+			ret += term;
+		}
+		return ret / sqrt(2. * xMath::Pi() * x);
+	}
+
+	// The sequence agrees with the per-order functions, whose accuracy
+	// is limited by the polynomial approximations of I_0 and I_1
+	TEST(xMathTest, BesselIexpSequenceTermByTerm) {
+		const int nmax = 60;
+		const double xs[] = { 1.e-3, 0.1, 0.5, 1., 3., 10., 30., 50., 200., 1000., 5000. };
+		for (size_t ix = 0; ix < sizeof(xs) / sizeof(xs[0]); ++ix) {
+			std::vector<double> seq = xMath::BesselIexpSequence(nmax, xs[ix]);
+			ASSERT_EQ(seq.size(), static_cast<size_t>(nmax + 1));
+			for (int n = 0; n <= nmax; ++n) {
+				double ref = xMath::BesselIexp(n, xs[ix]);
+				// Skip values below the double precision range of the series
+				if (ref < 1.e-250)
+					continue;
+				EXPECT_NEAR(seq[n] / ref, 1., 1.e-6) << "n = " << n << ", x = " << xs[ix];
+			}
+		}
+	}
+
+	TEST(xMathTest, BesselIexpSequenceLargeArgument) {
+		const double xs[] = { 500., 1000., 5000., 20000. };
+		for (size_t ix = 0; ix < sizeof(xs) / sizeof(xs[0]); ++ix) {
+			std::vector<double> seq = xMath::BesselIexpSequence(10, xs[ix]);
+			for (int n = 0; n <= 10; ++n)
+				EXPECT_NEAR(seq[n] / BesselIexpAsymptotic(n, xs[ix]), 1., 1.e-12) << "n = " << n << ", x = " << xs[ix];
+		}
+	}
+
+	TEST(xMathTest, BesselIexpSequenceSmallArgument) {
+		// I_n(x) = (x/2)^n / n! (1 + x^2 / (4 (n+1)) + ...)
+		double x = 1.e-4;
+		std::vector<double> seq = xMath::BesselIexpSequence(5, x);
+		double fact = 1.;
+		for (int n = 0; n <= 5; ++n) {
+			if (n > 0)
+				fact *= n;
+			double ref = exp(-x) * pow(x / 2., n) / fact * (1. + x * x / 4. / (n + 1.));
+			EXPECT_NEAR(seq[n] / ref, 1., 1.e-12) << "n = " << n;
+		}
+		EXPECT_EQ(xMath::BesselIexpSequence(3, 0.)[0], 1.);
+		EXPECT_EQ(xMath::BesselIexpSequence(3, 0.)[2], 0.);
+	}
+
+	// Negative arguments, I_n(-x) = (-1)^n I_n(x)
+	TEST(xMathTest, BesselIexpSequenceNegativeArgument) {
+		std::vector<double> pos = xMath::BesselIexpSequence(8, 2.5), neg = xMath::BesselIexpSequence(8, -2.5);
+		for (int n = 0; n <= 8; ++n)
+			EXPECT_DOUBLE_EQ(neg[n], (n % 2 == 0 ? 1. : -1.) * pos[n]);
+	}
+
+}